@@ -0,0 +1,154 @@
+// Actor messaging benchmark.
+//
+// Reports heap allocations and wall time per message for the runtime's actor
+// and callback entry points. Global operator new is replaced with a counting
+// shim, so every allocation made by the runtime, the standard library, and the
+// carrier threads is included.
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/actor-messages.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<uint64_t> allocation_count{0};
+}
+
+// Kept out of line: once GCC inlines a replacement delete, it pairs the free()
+// with the builtin operator new and reports -Wmismatched-new-delete.
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+BENCH_NOINLINE void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+    throw std::bad_alloc();
+}
+
+BENCH_NOINLINE void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+BENCH_NOINLINE void operator delete(void* memory) noexcept { std::free(memory); }
+BENCH_NOINLINE void operator delete[](void* memory) noexcept { std::free(memory); }
+BENCH_NOINLINE void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+BENCH_NOINLINE void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+
+struct Counter {
+    int64_t total = 0;
+    explicit Counter(int64_t start) : total(start) {}
+    void add(int64_t n) { total += n; }
+    int64_t get() const { return total; }
+};
+
+struct Sample {
+    const char* name;
+    int64_t messages;
+    uint64_t allocations;
+    double nanoseconds;
+};
+
+template <typename F>
+Sample measure(const char* name, int64_t messages, F&& body) {
+    const uint64_t before = allocation_count.load();
+    const auto started = std::chrono::steady_clock::now();
+    body();
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    return Sample{
+        name,
+        messages,
+        allocation_count.load() - before,
+        std::chrono::duration<double, std::nano>(elapsed).count(),
+    };
+}
+
+void report(const Sample& sample) {
+    std::printf("%-24s %10.2f %10.1f\n",
+        sample.name,
+        static_cast<double>(sample.allocations) / static_cast<double>(sample.messages),
+        sample.nanoseconds / static_cast<double>(sample.messages));
+}
+
+// Messages are sent in windows no deeper than a typical mailbox backlog, so
+// the steady-state cost is measured rather than the cost of growing a queue.
+constexpr int64_t window = 64;
+
+int64_t message_count() {
+    if (const char* configured = std::getenv("DOOF_BENCH_MESSAGES")) {
+        const long long parsed = std::atoll(configured);
+        if (parsed > 0) return parsed;
+    }
+    return 100000;
+}
+
+} // namespace
+
+int main() {
+    const int64_t messages = message_count();
+    auto& application = doof::detail::ApplicationDomain::shared();
+    doof::detail::ActiveActorScope scope(&application);
+
+    auto actor = std::make_shared<doof::Actor<Counter>>(int64_t{0});
+    // Warm the carrier pool and any runtime caches before measuring.
+    for (int i = 0; i < 1000; ++i) {
+        (void)actor->template call_async<void>([](Counter& c) { c.add(1); }).get();
+    }
+
+    std::printf("%-24s %10s %10s\n", "scenario", "allocs/msg", "ns/msg");
+
+    report(measure("call_async<void>", messages, [&] {
+        for (int64_t i = 0; i < messages; ++i) {
+            (void)actor->template call_async<void>([i](Counter& c) { c.add(i); });
+            if (i % window == window - 1) {
+                (void)actor->template call_sync<int64_t>([](Counter& c) { return c.get(); });
+            }
+        }
+        (void)actor->template call_sync<int64_t>([](Counter& c) { return c.get(); });
+    }));
+
+    report(measure("call_async<int>.get", messages, [&] {
+        for (int64_t i = 0; i < messages; ++i) {
+            auto reply = actor->template call_async<int64_t>([i](Counter& c) { c.add(i); return c.get(); });
+            (void)reply.get();
+        }
+    }));
+
+    report(measure("call_sync<int>", messages, [&] {
+        for (int64_t i = 0; i < messages; ++i) {
+            (void)actor->template call_sync<int64_t>([i](Counter& c) { c.add(i); return c.get(); });
+        }
+    }));
+
+    int64_t delivered = 0;
+    doof::callback<int64_t(int64_t)> accumulate([&delivered](int64_t n) { delivered += n; return delivered; });
+    doof::callback<void(int64_t)> notify([&delivered](int64_t n) { delivered += n; });
+
+    report(measure("callback.dispatch", messages, [&] {
+        for (int64_t i = 0; i < messages; ++i) {
+            notify.dispatch(i);
+            if (i % window == window - 1) application.drain_ready();
+        }
+        application.drain_ready();
+    }));
+
+    report(measure("callback.post", messages, [&] {
+        for (int64_t i = 0; i < messages; ++i) {
+            (void)accumulate.post(i);
+            if (i % window == window - 1) application.drain_ready();
+        }
+        application.drain_ready();
+    }));
+
+    actor->retire();
+    return delivered == 0 ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+// Array pipeline benchmark.
+//
+// Reports ns per element for filter -> map -> some over an int array,
+// chained through the per-call helpers with doof::callback stages against
+// the fused doof::array_pipeline lowering with inline functors.
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/array-pipeline.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+int64_t configured(const char* variable, int64_t fallback) {
+    if (const char* value = std::getenv(variable)) {
+        const long long parsed = std::atoll(value);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+template <typename F>
+void report(const char* name, int64_t iterations, int64_t elements, F&& body) {
+    int64_t sink = 0;
+    const auto started = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < iterations; ++i) sink += body() ? 1 : 0;
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    std::printf("%-24s %12lld %10.3f   (%lld hits)\n",
+        name,
+        static_cast<long long>(iterations * elements),
+        nanoseconds / static_cast<double>(iterations * elements),
+        static_cast<long long>(sink));
+}
+
+} // namespace
+
+int main() {
+    const int64_t elements = configured("DOOF_BENCH_ELEMENTS", 100000);
+    const int64_t iterations = configured("DOOF_BENCH_ITERATIONS", 50);
+
+    auto values = std::make_shared<std::vector<int32_t>>();
+    values->reserve(static_cast<size_t>(elements));
+    for (int64_t i = 0; i < elements; ++i) values->push_back(static_cast<int32_t>(i % 1000));
+
+    std::printf("%-24s %12s %10s\n", "scenario", "elements", "ns/elem");
+    report("callbacks", iterations, elements, [&]() {
+        auto evens = doof::array_filter(values, doof::callback<bool(int32_t)>([](int32_t it) -> bool { return it % 2 == 0; }), __FILE__, __LINE__);
+        auto scaled = doof::array_map(evens, doof::callback<int32_t(int32_t)>([](int32_t it) -> int32_t { return it * 10; }), __FILE__, __LINE__);
+        return doof::array_some(scaled, doof::callback<bool(int32_t)>([](int32_t it) -> bool { return it > 1000000; }), __FILE__, __LINE__);
+    });
+    report("fused", iterations, elements, [&]() {
+        return doof::array_pipeline(values, "filter", __FILE__, __LINE__)
+            .filter([](int32_t it) -> bool { return it % 2 == 0; })
+            .map([](int32_t it) -> int32_t { return it * 10; })
+            .some([](int32_t it) -> bool { return it > 1000000; });
+    });
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Callback parameter benchmark.
+//
+// Reports ns per element for a helper that sums a callback over an int array,
+// taking the callback as an owning doof::callback, as a borrowed
+// doof::callback_ref bound to an inline lambda, and as a bare functor passed
+// to doof::array_some.
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/callback-ref.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+int64_t configured(const char* variable, int64_t fallback) {
+    if (const char* value = std::getenv(variable)) {
+        const long long parsed = std::atoll(value);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+template <typename F>
+void report(const char* name, int64_t iterations, int64_t elements, F&& body) {
+    int64_t sink = 0;
+    const auto started = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < iterations; ++i) sink += body();
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    std::printf("%-24s %12lld %10.3f   (%lld sink)\n",
+        name,
+        static_cast<long long>(iterations * elements),
+        nanoseconds / static_cast<double>(iterations * elements),
+        static_cast<long long>(sink));
+}
+
+int64_t sumOwning(const std::shared_ptr<std::vector<int32_t>>& values, doof::callback<int32_t(int32_t)> f) {
+    int64_t total = 0;
+    for (const auto& it : *values) total += f.call(it);
+    return total;
+}
+
+int64_t sumBorrowed(const std::shared_ptr<std::vector<int32_t>>& values, doof::callback_ref<int32_t(int32_t)> f) {
+    int64_t total = 0;
+    for (const auto& it : *values) total += f.call(it);
+    return total;
+}
+
+} // namespace
+
+int main() {
+    const int64_t elements = configured("DOOF_BENCH_ELEMENTS", 100000);
+    const int64_t iterations = configured("DOOF_BENCH_ITERATIONS", 50);
+
+    auto values = std::make_shared<std::vector<int32_t>>();
+    values->reserve(static_cast<size_t>(elements));
+    for (int64_t i = 0; i < elements; ++i) values->push_back(static_cast<int32_t>(i % 1000));
+    const int32_t offset = static_cast<int32_t>(configured("DOOF_BENCH_OFFSET", 7));
+
+    std::printf("%-24s %12s %10s\n", "scenario", "elements", "ns/elem");
+    report("owning callback", iterations, elements, [&]() {
+        return sumOwning(values, doof::callback<int32_t(int32_t)>([offset](int32_t it) -> int32_t { return it + offset; }));
+    });
+    report("callback_ref", iterations, elements, [&]() {
+        return sumBorrowed(values, [offset](int32_t it) -> int32_t { return it + offset; });
+    });
+    report("some callback", iterations, elements, [&]() {
+        return doof::array_some(values, doof::callback<bool(int32_t)>([offset](int32_t it) -> bool { return it > offset + 1000; }), __FILE__, __LINE__) ? 1 : 0;
+    });
+    report("some functor", iterations, elements, [&]() {
+        return doof::array_some(values, [offset](int32_t it) -> bool { return it > offset + 1000; }, __FILE__, __LINE__) ? 1 : 0;
+    });
+    return 0;
+}
@@ -0,0 +1,60 @@
+// String interpolation benchmark.
+//
+// Reports ns per log line built with doof::concat, the lowering of Doof
+// string interpolation, and per to_string of a small nested collection.
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/concat.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+int64_t configured(const char* variable, int64_t fallback) {
+    if (const char* value = std::getenv(variable)) {
+        const long long parsed = std::atoll(value);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+template <typename F>
+void report(const char* name, int64_t iterations, F&& body) {
+    size_t sink = 0;
+    const auto started = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < iterations; ++i) sink += body(i).size();
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    std::printf("%-24s %12lld %10.2f   (%zu bytes)\n",
+        name,
+        static_cast<long long>(iterations),
+        nanoseconds / static_cast<double>(iterations),
+        sink);
+}
+
+} // namespace
+
+int main() {
+    const int64_t iterations = configured("DOOF_BENCH_OPERATIONS", 2000000);
+    const std::string route = "/api/orders";
+
+    auto matrix = std::make_shared<std::vector<std::shared_ptr<std::vector<int32_t>>>>();
+    for (int32_t row = 0; row < 8; ++row) {
+        matrix->push_back(std::make_shared<std::vector<int32_t>>(std::vector<int32_t>{row, row * 10, row * 100, row * 1000}));
+    }
+
+    std::printf("%-24s %12s %10s\n", "scenario", "ops", "ns/op");
+    report("log_line", iterations, [&](int64_t i) {
+        return doof::concat("request ", i, " route=", route, " status=", 200, " bytes=", i * 31, " took=", 0.25 * static_cast<double>(i % 97), "ms");
+    });
+    report("to_string_int", iterations, [](int64_t i) {
+        return doof::to_string(static_cast<int32_t>(i));
+    });
+    report("to_string_nested_array", iterations / 10, [&](int64_t) {
+        return doof::to_string(matrix);
+    });
+    return 0;
+}
@@ -0,0 +1,144 @@
+// JSON reader / writer throughput benchmark.
+//
+// Generates twitter.json- and citm_catalog.json-shaped documents and reports
+// MB/s for building (and freeing) a JsonValue tree, the structural index on
+// its own for each stage-1 kernel, a two-stage JsonDocument next to the
+// reader-driven one, skipping the document without building it, and writing
+// the tree back into a reused buffer.  Kernels this build or CPU lacks are
+// skipped.  Build once more with -DDOOF_JSON_NO_SIMD to compare against the
+// scalar scan loops.
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/json.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+int64_t configured(const char* variable, int64_t fallback) {
+    if (const char* value = std::getenv(variable)) {
+        const long long parsed = std::atoll(value);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+// Long free-text strings with occasional escapes and \u sequences, 64-bit
+// ids and nested user objects, written compactly.
+std::string twitter_corpus(int64_t statuses) {
+    std::string text = "{\"statuses\":[";
+    for (int64_t i = 0; i < statuses; ++i) {
+        if (i) text += ',';
+        text += "{\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"id\":";
+        text += std::to_string(505874924095815681LL + i);
+        text += ",\"text\":\"@aym0566x \\n\\nhello \\u540d\\u524d: what a lovely day to benchmark a json parser, "
+                "isn't it? RT if you agree \\ud83d\\ude00 http:\\/\\/t.co\\/abcdef\",";
+        text += "\"truncated\":false,\"in_reply_to_status_id\":null,\"user\":{\"id\":";
+        text += std::to_string(1186275104 + i);
+        text += ",\"name\":\"AYUMI\",\"screen_name\":\"ayuu0123\",\"location\":\"\",\"description\":"
+                "\"\\u5143\\u91ce\\u7403\\u90e8\\u30de\\u30cd\\u30fc\\u30b8\\u30e3\\u30fc\\u2764\\ufe0e\","
+                "\"followers_count\":262,\"friends_count\":252,\"verified\":false,\"lang\":\"ja\"},"
+                "\"retweet_count\":0,\"favorite_count\":0,\"entities\":{\"hashtags\":[],\"urls\":[],"
+                "\"user_mentions\":[{\"screen_name\":\"aym0566x\",\"id\":866260188,\"indices\":[0,9]}]},"
+                "\"favorited\":false,\"lang\":\"ja\"}";
+    }
+    text += "]}";
+    return text;
+}
+
+// Deeply indented, mostly numeric: performance ids, price arrays and small
+// keyed objects.
+std::string citm_corpus(int64_t performances) {
+    std::string text = "{\n    \"performances\": [\n";
+    for (int64_t i = 0; i < performances; ++i) {
+        if (i) text += ",\n";
+        text += "        {\n            \"eventId\": " + std::to_string(138586341 + i) + ",\n";
+        text += "            \"id\": " + std::to_string(339887544 + i) + ",\n";
+        text += "            \"logo\": null,\n            \"name\": null,\n";
+        text += "            \"prices\": [\n";
+        for (int price = 0; price < 4; ++price) {
+            if (price) text += ",\n";
+            text += "                {\n                    \"amount\": " + std::to_string(90250 - price * 10000)
+                + ",\n                    \"audienceSubCategoryId\": 337100890,\n"
+                  "                    \"seatCategoryId\": " + std::to_string(338937295 + price) + "\n                }";
+        }
+        text += "\n            ],\n            \"start\": 1372701600000,\n            \"venueCode\": \"PLEYEL_PLEYEL\"\n        }";
+    }
+    text += "\n    ]\n}\n";
+    return text;
+}
+
+template <typename F>
+void report(const char* corpus, const char* scenario, size_t bytes, int64_t rounds, F&& body) {
+    body();
+    const auto started = std::chrono::steady_clock::now();
+    for (int64_t round = 0; round < rounds; ++round) body();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const double megabytes = static_cast<double>(bytes) * static_cast<double>(rounds) / (1024.0 * 1024.0);
+    std::printf("%-10s %-10s %10.1f\n", corpus, scenario, megabytes / seconds);
+}
+
+void run(const char* corpus, const std::string& text, int64_t rounds) {
+    report(corpus, "parse", text.size(), rounds, [&] {
+        doof::JsonReader reader(text);
+        const doof::JsonValue value = reader.read_value();
+        if (!reader.finish()) doof::panic(reader.error());
+    });
+
+    std::vector<uint32_t> index;
+    const auto index_with = [&](const char* scenario, doof::JsonIndexKernel kernel) {
+        report(corpus, scenario, text.size(), rounds, [&] {
+            if (!doof::detail::json_build_index(text, index, kernel)) doof::panic("unterminated string");
+        });
+    };
+    index_with("index-scal", doof::JsonIndexKernel::Scalar);
+#if defined(DOOF_JSON_SSE2)
+    index_with("index-sse2", doof::JsonIndexKernel::Sse2);
+#endif
+#if defined(DOOF_JSON_AVX2)
+    if (doof::detail::json_default_index_kernel() == doof::JsonIndexKernel::Avx2) {
+        index_with("index-avx2", doof::JsonIndexKernel::Avx2);
+    }
+#endif
+#if defined(DOOF_JSON_NEON)
+    index_with("index-neon", doof::JsonIndexKernel::Neon);
+#endif
+
+    report(corpus, "document", text.size(), rounds, [&] {
+        const auto document = doof::JsonDocument::parse_view(text);
+        if (!doof::is_success(document)) doof::panic(doof::failure_error(document));
+    });
+    report(corpus, "doc-reader", text.size(), rounds, [&] {
+        const auto document = doof::JsonDocument::parse_view(text, doof::JsonIndexKernel::None);
+        if (!doof::is_success(document)) doof::panic(doof::failure_error(document));
+    });
+    report(corpus, "skip", text.size(), rounds, [&] {
+        doof::JsonReader reader(text);
+        if (!reader.skip_value() || !reader.finish()) doof::panic(reader.error());
+    });
+
+    doof::JsonReader reader(text);
+    const doof::JsonValue value = reader.read_value();
+    std::string out;
+    doof::json_write(out, value);
+    report(corpus, "write", out.size(), rounds, [&] {
+        out.clear();
+        doof::json_write(out, value);
+    });
+}
+
+} // namespace
+
+int main() {
+    const int64_t documents = configured("DOOF_BENCH_DOCUMENTS", 20000);
+    const int64_t rounds = configured("DOOF_BENCH_ROUNDS", 5);
+
+    std::printf("%-10s %-10s %10s\n", "corpus", "scenario", "MB/s");
+    run("twitter", twitter_corpus(documents), rounds);
+    run("citm", citm_corpus(documents), rounds);
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Metrics recording benchmark.
+//
+// Reports wall time per update while several threads record into the same
+// counters and histograms, through pre-registered handles and through the
+// by-name entry point that dynamic Doof metric names use.
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/metrics.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+struct Sample {
+    const char* name;
+    int64_t operations;
+    double nanoseconds;
+};
+
+int64_t configured(const char* variable, int64_t fallback) {
+    if (const char* value = std::getenv(variable)) {
+        const long long parsed = std::atoll(value);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+// Runs `body(thread, iterations)` on every thread at once and reports the
+// wall time divided by the total number of updates.
+template <typename F>
+Sample measure(const char* name, int64_t threads, int64_t iterations, F&& body) {
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<size_t>(threads));
+    const auto started = std::chrono::steady_clock::now();
+    for (int64_t thread = 0; thread < threads; ++thread) {
+        workers.emplace_back([&body, thread, iterations] { body(thread, iterations); });
+    }
+    for (auto& worker : workers) worker.join();
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    return Sample{name, threads * iterations, std::chrono::duration<double, std::nano>(elapsed).count()};
+}
+
+void report(const Sample& sample) {
+    std::printf("%-24s %12lld %10.2f\n",
+        sample.name,
+        static_cast<long long>(sample.operations),
+        sample.nanoseconds / static_cast<double>(sample.operations));
+}
+
+} // namespace
+
+int main() {
+    const int64_t threads = configured("DOOF_BENCH_THREADS", 4);
+    const int64_t iterations = configured("DOOF_BENCH_OPERATIONS", 1000000);
+
+    std::printf("%-24s %12s %10s\n", "scenario", "ops", "ns/op");
+
+    const doof::metrics::Counter requests = doof::metrics::counter("bench_requests_total");
+    report(measure("counter_handle", threads, iterations, [&](int64_t, int64_t count) {
+        for (int64_t i = 0; i < count; ++i) requests.add(1);
+    }));
+
+    report(measure("counter_by_name", threads, iterations, [](int64_t, int64_t count) {
+        const std::string name = "bench_named_total{route=\"/health\"}";
+        for (int64_t i = 0; i < count; ++i) doof::metrics::increment_counter(name, 1);
+    }));
+
+    const doof::metrics::Histogram latency = doof::metrics::histogram("bench_latency_us");
+    report(measure("histogram_record", threads, iterations, [&](int64_t thread, int64_t count) {
+        for (int64_t i = 0; i < count; ++i) latency.record((i * 37 + thread) % 5000);
+    }));
+
+    // Snapshots merge every shard; keep one running against live writers.
+    std::atomic<bool> writing{true};
+    std::thread scraper([&] {
+        while (writing.load(std::memory_order_relaxed)) {
+            (void)doof::metrics::snapshot_prometheus();
+        }
+    });
+    report(measure("counter_while_scraped", threads, iterations, [&](int64_t, int64_t count) {
+        for (int64_t i = 0; i < count; ++i) requests.add(1);
+    }));
+    writing.store(false, std::memory_order_relaxed);
+    scraper.join();
+
+    const auto totals = doof::metrics::snapshot_pairs();
+    return totals.empty() ? 1 : 0;
+}
@@ -0,0 +1,227 @@
+// Ordered collection erase benchmark.
+//
+// Reports wall time per operation for erase-heavy ordered_map workloads: an
+// LRU-style table that evicts its oldest entry on every insert, random
+// deletion until empty, and a set with key churn.
+//
+// Each workload also runs against two references:
+// - vector+index is the layout ordered_map used before tombstones.  Entries
+//   sit in a std::vector and a std::unordered_map holds their positions, so
+//   erase shifts the vector and re-points every later entry.  Its erase is
+//   O(n), so it runs only DOOF_BENCH_REFERENCE_OPS operations (default 200)
+//   against a table of the full size, and only that erase phase is timed.
+// - unordered is std::unordered_map / std::unordered_set.  It keeps no
+//   insertion order, so it is the floor an ordered container can approach.
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/ordered-erase.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct Sample {
+    const char* name;
+    int64_t operations;
+    double nanoseconds;
+};
+
+template <typename F>
+Sample measure(const char* name, int64_t operations, F&& body) {
+    const auto started = std::chrono::steady_clock::now();
+    body();
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    return Sample{name, operations, std::chrono::duration<double, std::nano>(elapsed).count()};
+}
+
+void report(const Sample& sample) {
+    std::printf("%-24s %10lld %12.1f\n",
+        sample.name,
+        static_cast<long long>(sample.operations),
+        sample.nanoseconds / static_cast<double>(sample.operations));
+}
+
+int64_t configured(const char* variable, int64_t fallback) {
+    if (const char* value = std::getenv(variable)) {
+        const long long parsed = std::atoll(value);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+// The pre-tombstone ordered_map layout, kept here as the erase baseline.
+template <typename K, typename V>
+class VectorIndexMap {
+    std::vector<std::pair<K, V>> entries_;
+    std::unordered_map<K, size_t> index_;
+
+public:
+    void insert_or_assign(const K& key, V value) {
+        const auto found = index_.find(key);
+        if (found != index_.end()) {
+            entries_[found->second].second = std::move(value);
+            return;
+        }
+        index_.emplace(key, entries_.size());
+        entries_.emplace_back(key, std::move(value));
+    }
+
+    size_t erase(const K& key) {
+        const auto found = index_.find(key);
+        if (found == index_.end()) return 0;
+        const size_t position = found->second;
+        index_.erase(found);
+        entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(position));
+        for (size_t current = position; current < entries_.size(); ++current) {
+            index_[entries_[current].first] = current;
+        }
+        return 1;
+    }
+
+    const std::pair<K, V>& front() const { return entries_.front(); }
+    size_t size() const { return entries_.size(); }
+};
+
+std::string session_key(int64_t id) {
+    return "session-" + std::to_string(id);
+}
+
+} // namespace
+
+int main() {
+    const int64_t entries = configured("DOOF_BENCH_ENTRIES", 100000);
+    const int64_t reference_ops = std::min(entries, configured("DOOF_BENCH_REFERENCE_OPS", 200));
+    std::mt19937_64 rng(42);
+    int64_t checksum = 0;
+
+    std::printf("%-24s %10s %12s\n", "scenario", "ops", "ns/op");
+
+    report(measure("lru_evict_oldest", entries, [&] {
+        doof::ordered_map<std::string, int64_t> sessions;
+        for (int64_t i = 0; i < entries; ++i) {
+            sessions.insert_or_assign(session_key(i), i);
+        }
+        for (int64_t i = 0; i < entries; ++i) {
+            const std::string oldest = sessions.begin()->first;
+            sessions.erase(oldest);
+            sessions.insert_or_assign(session_key(entries + i), i);
+        }
+        checksum += static_cast<int64_t>(sessions.size());
+    }));
+
+    {
+        VectorIndexMap<std::string, int64_t> sessions;
+        for (int64_t i = 0; i < entries; ++i) {
+            sessions.insert_or_assign(session_key(i), i);
+        }
+        report(measure("  vector+index", reference_ops, [&] {
+            for (int64_t i = 0; i < reference_ops; ++i) {
+                const std::string oldest = sessions.front().first;
+                sessions.erase(oldest);
+                sessions.insert_or_assign(session_key(entries + i), i);
+            }
+        }));
+        checksum += static_cast<int64_t>(sessions.size());
+    }
+
+    report(measure("  unordered", entries, [&] {
+        // No insertion order to ask for, so evict by the known oldest id.
+        std::unordered_map<std::string, int64_t> sessions;
+        for (int64_t i = 0; i < entries; ++i) {
+            sessions.insert_or_assign(session_key(i), i);
+        }
+        for (int64_t i = 0; i < entries; ++i) {
+            sessions.erase(session_key(i));
+            sessions.insert_or_assign(session_key(entries + i), i);
+        }
+        checksum += static_cast<int64_t>(sessions.size());
+    }));
+
+    std::vector<int64_t> keys;
+    keys.reserve(static_cast<size_t>(entries));
+    for (int64_t i = 0; i < entries; ++i) keys.push_back(i);
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    report(measure("random_erase_all", entries, [&] {
+        doof::ordered_map<int64_t, int64_t> table;
+        for (int64_t i = 0; i < entries; ++i) {
+            table.insert_or_assign(i, i);
+        }
+        for (int64_t key : keys) {
+            checksum += static_cast<int64_t>(table.erase(key));
+        }
+    }));
+
+    {
+        VectorIndexMap<int64_t, int64_t> table;
+        for (int64_t i = 0; i < entries; ++i) {
+            table.insert_or_assign(i, i);
+        }
+        report(measure("  vector+index", reference_ops, [&] {
+            for (int64_t i = 0; i < reference_ops; ++i) {
+                checksum += static_cast<int64_t>(table.erase(keys[static_cast<size_t>(i)]));
+            }
+        }));
+    }
+
+    report(measure("  unordered", entries, [&] {
+        std::unordered_map<int64_t, int64_t> table;
+        for (int64_t i = 0; i < entries; ++i) {
+            table.insert_or_assign(i, i);
+        }
+        for (int64_t key : keys) {
+            checksum += static_cast<int64_t>(table.erase(key));
+        }
+    }));
+
+    std::uniform_int_distribution<int64_t> pick(0, entries - 1);
+    std::vector<int64_t> churn;
+    churn.reserve(static_cast<size_t>(entries));
+    for (int64_t i = 0; i < entries; ++i) churn.push_back(pick(rng));
+
+    report(measure("set_churn", entries, [&] {
+        doof::ordered_set<int64_t> live;
+        for (int64_t i = 0; i < entries; ++i) {
+            live.insert(i);
+        }
+        for (int64_t key : churn) {
+            if (live.erase(key) == 0) live.insert(key);
+        }
+        for (int64_t value : live) checksum += value & 1;
+    }));
+
+    {
+        VectorIndexMap<int64_t, bool> live;
+        for (int64_t i = 0; i < entries; ++i) {
+            live.insert_or_assign(i, true);
+        }
+        report(measure("  vector+index", reference_ops, [&] {
+            for (int64_t i = 0; i < reference_ops; ++i) {
+                const int64_t key = churn[static_cast<size_t>(i)];
+                if (live.erase(key) == 0) live.insert_or_assign(key, true);
+            }
+        }));
+        checksum += static_cast<int64_t>(live.size());
+    }
+
+    report(measure("  unordered", entries, [&] {
+        std::unordered_set<int64_t> live;
+        for (int64_t i = 0; i < entries; ++i) {
+            live.insert(i);
+        }
+        for (int64_t key : churn) {
+            if (live.erase(key) == 0) live.insert(key);
+        }
+        for (int64_t value : live) checksum += value & 1;
+    }));
+
+    return checksum == 0 ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+// Parallel array benchmark.
+//
+// Reports ns per element for a CPU-bound scoring map, a filter and a sort
+// over a readonly array, serially through the fused pipeline / std::sort and
+// in parallel through the doof::array_parallel* helpers.
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/parallel-array.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+int64_t configured(const char* variable, int64_t fallback) {
+    if (const char* value = std::getenv(variable)) {
+        const long long parsed = std::atoll(value);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+template <typename F>
+void report(const char* name, int64_t elements, F&& body) {
+    const auto started = std::chrono::steady_clock::now();
+    const size_t sink = body();
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    std::printf("%-24s %12lld %10.3f   (%zu)\n",
+        name,
+        static_cast<long long>(elements),
+        nanoseconds / static_cast<double>(elements),
+        sink);
+}
+
+double score(int32_t value) {
+    double acc = value;
+    for (int round = 0; round < 64; ++round) acc = acc * 0.999 + std::sqrt(acc + round);
+    return acc;
+}
+
+} // namespace
+
+int main() {
+    const int64_t elements = configured("DOOF_BENCH_ELEMENTS", 2000000);
+    auto values = std::make_shared<std::vector<int32_t>>();
+    values->reserve(static_cast<size_t>(elements));
+    for (int64_t i = 0; i < elements; ++i) values->push_back(static_cast<int32_t>((i * 2654435761u) % 1000003));
+
+    const auto scoreFn = [](int32_t it) -> double { return score(it); };
+    const auto keep = [](int32_t it) -> bool { return it % 3 == 0; };
+    const auto compare = [](int32_t a, int32_t b) -> int32_t { return a < b ? -1 : (a > b ? 1 : 0); };
+
+    std::printf("carriers: %zu\n", doof::detail::parallel_width());
+    std::printf("%-24s %12s %10s\n", "scenario", "elements", "ns/elem");
+    report("map_serial", elements, [&]() {
+        return doof::array_pipeline(values, "map", __FILE__, __LINE__).map(scoreFn).collect()->size();
+    });
+    report("map_parallel", elements, [&]() {
+        return doof::array_parallelMap(values, scoreFn, __FILE__, __LINE__)->size();
+    });
+    report("filter_serial", elements, [&]() {
+        return doof::array_pipeline(values, "filter", __FILE__, __LINE__).filter(keep).collect()->size();
+    });
+    report("filter_parallel", elements, [&]() {
+        return doof::array_parallelFilter(values, keep, __FILE__, __LINE__)->size();
+    });
+    report("sort_serial", elements, [&]() {
+        auto copy = *values;
+        std::stable_sort(copy.begin(), copy.end());
+        return copy.size();
+    });
+    report("sort_parallel", elements, [&]() {
+        return doof::array_parallelSort(values, compare, __FILE__, __LINE__)->size();
+    });
+    return 0;
+}
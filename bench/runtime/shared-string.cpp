@@ -0,0 +1,83 @@
+// Shared immutable string benchmark.
+//
+// Reports ns per fan-out of a readonly array of long strings (the copy
+// array_cloneMutable and callback packing make), per long substring and per
+// split of a CSV-style line, for std::string against doof::SharedString (the
+// `"strings": "shared"` build profile).
+//
+// Build and run through `npm run bench:runtime`, or directly:
+//   c++ -std=c++17 -O2 -pthread -I. bench/runtime/shared-string.cpp
+
+#include "doof_runtime.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+int64_t configured(const char* variable, int64_t fallback) {
+    if (const char* value = std::getenv(variable)) {
+        const long long parsed = std::atoll(value);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+template <typename F>
+void report(const char* name, int64_t iterations, F&& body) {
+    size_t sink = 0;
+    const auto started = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < iterations; ++i) sink += body(i);
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    std::printf("%-24s %12lld %10.2f   (%zu bytes)\n",
+        name,
+        static_cast<long long>(iterations),
+        nanoseconds / static_cast<double>(iterations),
+        sink);
+}
+
+} // namespace
+
+int main() {
+    const int64_t iterations = configured("DOOF_BENCH_OPERATIONS", 200000);
+    const int64_t width = configured("DOOF_BENCH_STRING_BYTES", 256);
+
+    std::vector<std::string> plain;
+    std::vector<doof::SharedString> shared;
+    std::string line;
+    for (int32_t i = 0; i < 16; ++i) {
+        if (i > 0) line += ',';
+        line += doof::concat("field number ", i, " with a long enough value");
+    }
+    const doof::SharedString shared_line(line);
+    for (int32_t i = 0; i < 64; ++i) {
+        std::string text = doof::concat("line ", i, ": ");
+        text.resize(static_cast<size_t>(width), static_cast<char>('a' + i % 26));
+        plain.push_back(text);
+        shared.emplace_back(text);
+    }
+
+    std::printf("%-24s %12s %10s\n", "scenario", "ops", "ns/op");
+    report("copy_array_std", iterations, [&](int64_t) {
+        std::vector<std::string> copy = plain;
+        return copy.back().size();
+    });
+    report("copy_array_shared", iterations, [&](int64_t) {
+        std::vector<doof::SharedString> copy = shared;
+        return copy.back().size();
+    });
+    report("substring_std", iterations * 10, [&](int64_t i) {
+        return doof::string_substring(plain[static_cast<size_t>(i & 63)], 4, static_cast<int32_t>(width) - 4).size();
+    });
+    report("substring_shared", iterations * 10, [&](int64_t i) {
+        return doof::string_substring(shared[static_cast<size_t>(i & 63)], 4, static_cast<int32_t>(width) - 4).size();
+    });
+    report("split_std", iterations, [&](int64_t) {
+        return doof::string_split(line, ",")->back().size();
+    });
+    report("split_shared", iterations, [&](int64_t) {
+        return doof::string_split(shared_line, ",")->back().size();
+    });
+    return 0;
+}
@@ -0,0 +1,140 @@
+// doof_bench.hpp — measurement support for `doof bench` harnesses
+//
+// The bench runner copies this header into the harness build directory, and
+// the generated harness module is its only includer. It replaces global
+// operator new with a counting shim, so it must be included by exactly one
+// translation unit of the benchmark binary.
+//
+// Each run warms the body up, sizes a batch so that one sample takes about
+// DOOF_BENCH_SAMPLE_NS, then times DOOF_BENCH_SAMPLES batches. Results are
+// printed as one `__BENCH__ {json}` line carrying the per-iteration time of
+// every sample; the runner computes the summary statistics.
+
+#pragma once
+
+#include "doof_runtime_core.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace doof_bench {
+
+inline std::atomic<uint64_t> allocation_count{0};
+
+} // namespace doof_bench
+
+void* operator new(std::size_t size) {
+    doof_bench::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace doof_bench {
+
+inline int64_t env_or(const char* name, int64_t fallback) {
+    if (const char* configured = std::getenv(name)) {
+        const long long parsed = std::atoll(configured);
+        if (parsed > 0) return parsed;
+    }
+    return fallback;
+}
+
+inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void write_json_string(std::string& out, const std::string& value) {
+    out += '"';
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+/// Measure `body` and print its `__BENCH__` result line.
+template <typename F>
+void run(const std::string& id, const F& body) {
+    const int64_t samples = env_or("DOOF_BENCH_SAMPLES", 30);
+    const int64_t sample_ns = env_or("DOOF_BENCH_SAMPLE_NS", 10000000);
+    const int64_t warmup_ns = env_or("DOOF_BENCH_WARMUP_NS", 100000000);
+
+    // Warm caches and lazily initialised state, and estimate the cost of one
+    // iteration so short bodies are batched above the clock's resolution.
+    int64_t warmup_iterations = 0;
+    const int64_t warmup_started = now_ns();
+    int64_t warmup_elapsed = 0;
+    do {
+        doof::detail::invoke_callable(body);
+        ++warmup_iterations;
+        warmup_elapsed = now_ns() - warmup_started;
+    } while (warmup_elapsed < warmup_ns);
+    const int64_t per_iteration = std::max<int64_t>(1, warmup_elapsed / warmup_iterations);
+    const int64_t batch = std::max<int64_t>(1, sample_ns / per_iteration);
+
+    std::vector<double> sample_times;
+    sample_times.reserve(static_cast<size_t>(samples));
+    const auto counters_before = doof::metrics::snapshot_pairs();
+    const uint64_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+    for (int64_t sample = 0; sample < samples; ++sample) {
+        const int64_t started = now_ns();
+        for (int64_t i = 0; i < batch; ++i) {
+            doof::detail::invoke_callable(body);
+        }
+        const int64_t elapsed = now_ns() - started;
+        sample_times.push_back(static_cast<double>(elapsed) / static_cast<double>(batch));
+    }
+    const uint64_t allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+    const auto counters_after = doof::metrics::snapshot_pairs();
+
+    std::string out = "__BENCH__ {\"id\":";
+    write_json_string(out, id);
+    out += ",\"iterations\":" + std::to_string(batch * samples);
+    out += ",\"allocations\":" + std::to_string(allocations);
+    out += ",\"samples\":[";
+    for (size_t i = 0; i < sample_times.size(); ++i) {
+        char formatted[32];
+        std::snprintf(formatted, sizeof(formatted), "%.3f", sample_times[i]);
+        if (i > 0) out += ',';
+        out += formatted;
+    }
+    out += "],\"metrics\":{";
+    bool first = true;
+    for (const auto& counter : counters_after) {
+        int64_t before = 0;
+        for (const auto& previous : counters_before) {
+            if (previous.first == counter.first) before = previous.second;
+        }
+        if (counter.second == before) continue;
+        if (!first) out += ',';
+        first = false;
+        write_json_string(out, counter.first);
+        out += ':' + std::to_string(counter.second - before);
+    }
+    out += "}}";
+    std::puts(out.c_str());
+    std::fflush(stdout);
+}
+
+} // namespace doof_bench
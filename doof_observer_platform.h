@@ -1,3 +1,5 @@
+#include <chrono>
+
 #if defined(_WIN32)
 #define NOMINMAX
 #include <winsock2.h>
@@ -5,7 +7,9 @@
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #endif
@@ -50,17 +50,59 @@ inline std::string json_escape(const std::string& value) {
     return out.str();
 }
 
-inline std::string snapshot_metrics_json() {
-    const auto snapshot = metrics::snapshot_pairs();
-    std::ostringstream out;
-    out << '[';
-    for (size_t index = 0; index < snapshot.size(); ++index) {
-        if (index > 0) out << ',';
-        out << "{\"name\":" << json_escape(snapshot[index].first)
-            << ",\"value\":" << snapshot[index].second << '}';
+// One JSON object per metric, keyed by name, so the event stream can diff
+// successive snapshots and push only the entries that changed.
+inline std::vector<std::pair<std::string, std::string>> snapshot_metric_entries() {
+    std::vector<std::pair<std::string, std::string>> entries;
+    for (const auto& item : metrics::snapshot_pairs()) {
+        std::ostringstream out;
+        out << "{\"name\":" << json_escape(item.first)
+            << ",\"value\":" << item.second << '}';
+        entries.emplace_back(item.first, out.str());
     }
-    out << ']';
-    return out.str();
+    for (const auto& item : metrics::snapshot_gauges()) {
+        std::ostringstream out;
+        out << "{\"name\":" << json_escape(item.first) << ",\"type\":\"gauge\",\"value\":";
+        if (std::isfinite(item.second)) {
+            out << item.second;
+        } else {
+            out << "null";
+        }
+        out << '}';
+        entries.emplace_back(item.first, out.str());
+    }
+    for (const auto& histogram : metrics::snapshot_histograms()) {
+        std::ostringstream out;
+        out << "{\"name\":" << json_escape(histogram.name)
+            << ",\"type\":\"histogram\",\"value\":" << histogram.count
+            << ",\"count\":" << histogram.count
+            << ",\"sum\":" << histogram.sum
+            << ",\"p50\":" << histogram.quantile(0.5)
+            << ",\"p99\":" << histogram.quantile(0.99)
+            << ",\"buckets\":[";
+        for (size_t index = 0; index < histogram.buckets.size(); ++index) {
+            if (index > 0) out << ',';
+            out << "{\"le\":" << histogram.buckets[index].first
+                << ",\"count\":" << histogram.buckets[index].second << '}';
+        }
+        out << "]}";
+        entries.emplace_back(histogram.name, out.str());
+    }
+    return entries;
+}
+
+inline std::string join_metric_entries(const std::vector<std::pair<std::string, std::string>>& entries) {
+    std::string out = "[";
+    for (size_t index = 0; index < entries.size(); ++index) {
+        if (index > 0) out += ',';
+        out += entries[index].second;
+    }
+    out += ']';
+    return out;
+}
+
+inline std::string snapshot_metrics_json() {
+    return join_metric_entries(snapshot_metric_entries());
 }
 
 inline void launch_browser(const std::string& url) {
@@ -91,26 +133,59 @@ inline std::string reason_phrase(int status) {
     }
 }
 
-inline void send_response(socket_handle client, int status, const std::string& content_type, const std::string& body) {
+// The observer runs one thread that multiplexes every connection with poll():
+// dashboards keep their sockets alive between refreshes, and event-stream
+// clients receive metric deltas without re-requesting full snapshots.
+inline constexpr int _tick_ms = 1000;
+inline constexpr int _heartbeat_ticks = 15;
+inline constexpr size_t _max_connections = 64;
+inline constexpr size_t _max_request_bytes = 16 * 1024;
+inline constexpr auto _idle_timeout = std::chrono::seconds(30);
+
+struct Connection {
+    socket_handle socket = invalid_socket_handle;
+    std::string input{};
+    std::string output{};
+    bool close_after_write = false;
+    bool streaming = false;
+    std::unordered_map<std::string, std::string> streamed{};
+    std::chrono::steady_clock::time_point last_active = std::chrono::steady_clock::now();
+};
+
+inline bool set_nonblocking(socket_handle socket) {
+#if defined(_WIN32)
+    u_long enabled = 1;
+    return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+#else
+    const int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+inline bool last_error_would_block() {
+#if defined(_WIN32)
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+inline int poll_sockets(std::vector<pollfd>& descriptors, int timeout_ms) {
+#if defined(_WIN32)
+    return WSAPoll(descriptors.data(), static_cast<ULONG>(descriptors.size()), timeout_ms);
+#else
+    return poll(descriptors.data(), static_cast<nfds_t>(descriptors.size()), timeout_ms);
+#endif
+}
+
+inline std::string build_response(int status, const std::string& content_type, const std::string& body, bool keep_alive) {
     std::ostringstream header;
     header << "HTTP/1.1 " << status << ' ' << reason_phrase(status) << "\r\n"
         << "Content-Type: " << content_type << "\r\n"
         << "Content-Length: " << body.size() << "\r\n"
         << "Cache-Control: no-store\r\n"
-        << "Connection: close\r\n\r\n";
-    const std::string response = header.str() + body;
-    const char* data = response.data();
-    size_t remaining = response.size();
-    while (remaining > 0) {
-#if defined(_WIN32)
-        const int sent = send(client, data, static_cast<int>(remaining > INT_MAX ? INT_MAX : remaining), 0);
-#else
-        const ssize_t sent = send(client, data, remaining, 0);
-#endif
-        if (sent <= 0) return;
-        data += sent;
-        remaining -= static_cast<size_t>(sent);
-    }
+        << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n\r\n";
+    return header.str() + body;
 }
 
 inline std::string request_path(const std::string& request) {
@@ -125,55 +200,213 @@ inline bool request_is_get(const std::string& request) {
     return request.rfind("GET ", 0) == 0;
 }
 
-inline void handle_client(socket_handle client) {
-    char buffer[4096];
-#if defined(_WIN32)
-    const int received = recv(client, buffer, static_cast<int>(sizeof(buffer) - 1), 0);
-#else
-    const ssize_t received = recv(client, buffer, sizeof(buffer) - 1, 0);
-#endif
-    if (received <= 0) {
-        close_socket(client);
-        return;
+// HTTP/1.1 connections persist unless the client asks to close; HTTP/1.0
+// connections persist only when the client asks to keep them alive.
+inline bool request_keeps_alive(const std::string& request) {
+    std::string lowered(request.size(), '\0');
+    std::transform(request.begin(), request.end(), lowered.begin(), [](unsigned char ch) {
+        return static_cast<char>(std::tolower(ch));
+    });
+    const std::string request_line = lowered.substr(0, lowered.find("\r\n"));
+    if (lowered.find("\r\nconnection: close") != std::string::npos) return false;
+    if (request_line.find("http/1.0") != std::string::npos) {
+        return lowered.find("\r\nconnection: keep-alive") != std::string::npos;
+    }
+    return true;
+}
+
+inline void stream_metric_deltas(Connection& connection, bool heartbeat) {
+    std::vector<std::pair<std::string, std::string>> changed;
+    for (auto& entry : snapshot_metric_entries()) {
+        auto& previous = connection.streamed[entry.first];
+        if (previous != entry.second) {
+            previous = entry.second;
+            changed.push_back(std::move(entry));
+        }
+    }
+    if (!changed.empty()) {
+        connection.output += "event: delta\ndata: " + join_metric_entries(changed) + "\n\n";
+    } else if (heartbeat) {
+        connection.output += ": keep-alive\n\n";
+    }
+}
+
+inline void start_metric_stream(Connection& connection) {
+    connection.streaming = true;
+    connection.output += "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-store\r\n"
+        "Connection: keep-alive\r\n\r\n"
+        "retry: 2000\n\n";
+    auto entries = snapshot_metric_entries();
+    connection.output += "event: snapshot\ndata: " + join_metric_entries(entries) + "\n\n";
+    for (auto& entry : entries) {
+        connection.streamed.emplace(std::move(entry.first), std::move(entry.second));
     }
-    buffer[received] = '\0';
-    const std::string request(buffer, static_cast<size_t>(received));
+}
+
+inline void respond(Connection& connection, const std::string& request) {
+    const bool keep_alive = request_keeps_alive(request);
     if (!request_is_get(request)) {
-        send_response(client, 405, "text/plain; charset=utf-8", "Only GET is supported.\n");
-        close_socket(client);
+        // Any request body is left unread, so the connection cannot be reused.
+        connection.output += build_response(405, "text/plain; charset=utf-8", "Only GET is supported.\n", false);
+        connection.close_after_write = true;
         return;
     }
 
     const std::string path = request_path(request);
+    if (path == "/api/metrics/stream") {
+        start_metric_stream(connection);
+        return;
+    }
     if (path == "/" || path == "/index.html") {
-        send_response(client, 200, "text/html; charset=utf-8", _asset_html);
+        connection.output += build_response(200, "text/html; charset=utf-8", _asset_html, keep_alive);
     } else if (path == "/assets/app.css") {
-        send_response(client, 200, "text/css; charset=utf-8", _asset_css);
+        connection.output += build_response(200, "text/css; charset=utf-8", _asset_css, keep_alive);
     } else if (path == "/assets/app.js") {
-        send_response(client, 200, "application/javascript; charset=utf-8", _asset_js);
+        connection.output += build_response(200, "application/javascript; charset=utf-8", _asset_js, keep_alive);
     } else if (path == "/api/metrics") {
-        send_response(client, 200, "application/json; charset=utf-8", snapshot_metrics_json());
+        connection.output += build_response(200, "application/json; charset=utf-8", snapshot_metrics_json(), keep_alive);
     } else if (path == "/api/metrics/prometheus") {
-        send_response(client, 200, "text/plain; charset=utf-8", metrics::snapshot_prometheus());
+        connection.output += build_response(200, "text/plain; charset=utf-8", metrics::snapshot_prometheus(), keep_alive);
+    } else if (path == "/api/trace") {
+#if defined(DOOF_PROFILE)
+        connection.output += build_response(200, "application/json; charset=utf-8", profile::snapshot_trace_json(), keep_alive);
+#else
+        connection.output += build_response(200, "application/json; charset=utf-8", "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[]}", keep_alive);
+#endif
     } else {
-        send_response(client, 404, "text/plain; charset=utf-8", "Not found.\n");
+        connection.output += build_response(404, "text/plain; charset=utf-8", "Not found.\n", keep_alive);
     }
-    close_socket(client);
+    connection.close_after_write = !keep_alive;
 }
 
-inline void serve_loop(socket_handle server) {
+// Returns false once the peer has gone away or the request was malformed.
+inline bool read_requests(Connection& connection) {
+    char buffer[4096];
     while (true) {
-        sockaddr_in client_addr {};
 #if defined(_WIN32)
-        int client_len = sizeof(client_addr);
+        const int received = recv(connection.socket, buffer, static_cast<int>(sizeof(buffer)), 0);
 #else
-        socklen_t client_len = sizeof(client_addr);
+        const ssize_t received = recv(connection.socket, buffer, sizeof(buffer), 0);
 #endif
-        socket_handle client = accept(server, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
-        if (client == invalid_socket_handle) {
+        if (received == 0) return false;
+        if (received < 0) {
+            if (last_error_would_block()) break;
+            return false;
+        }
+        // Streaming clients have nothing more to say; drain and ignore it.
+        if (!connection.streaming) connection.input.append(buffer, static_cast<size_t>(received));
+    }
+
+    while (!connection.streaming && !connection.close_after_write) {
+        const size_t end = connection.input.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            if (connection.input.size() > _max_request_bytes) return false;
+            break;
+        }
+        const std::string request = connection.input.substr(0, end + 4);
+        connection.input.erase(0, end + 4);
+        respond(connection, request);
+    }
+    return true;
+}
+
+inline bool write_pending(Connection& connection) {
+    while (!connection.output.empty()) {
+#if defined(_WIN32)
+        const int sent = send(connection.socket, connection.output.data(),
+            static_cast<int>(connection.output.size() > INT_MAX ? INT_MAX : connection.output.size()), 0);
+#elif defined(MSG_NOSIGNAL)
+        const ssize_t sent = send(connection.socket, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+#else
+        const ssize_t sent = send(connection.socket, connection.output.data(), connection.output.size(), 0);
+#endif
+        if (sent < 0 && last_error_would_block()) return true;
+        if (sent <= 0) return false;
+        connection.output.erase(0, static_cast<size_t>(sent));
+    }
+    return !connection.close_after_write;
+}
+
+inline void accept_connections(socket_handle server, std::vector<Connection>& connections) {
+    while (true) {
+        socket_handle client = accept(server, nullptr, nullptr);
+        if (client == invalid_socket_handle) return;
+        if (connections.size() >= _max_connections || !set_nonblocking(client)) {
+            close_socket(client);
             continue;
         }
-        std::thread(handle_client, client).detach();
+#if defined(SO_NOSIGPIPE)
+        int no_sigpipe = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+        connections.push_back(Connection{client});
+    }
+}
+
+inline void serve_loop(socket_handle server) {
+    std::vector<Connection> connections;
+    std::vector<pollfd> descriptors;
+    auto next_tick = std::chrono::steady_clock::now() + std::chrono::milliseconds(_tick_ms);
+    int ticks = 0;
+    while (true) {
+        descriptors.clear();
+        descriptors.push_back(pollfd{server, POLLIN, 0});
+        for (const auto& connection : connections) {
+            const short events = static_cast<short>(POLLIN | (connection.output.empty() ? 0 : POLLOUT));
+            descriptors.push_back(pollfd{connection.socket, events, 0});
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const int timeout = next_tick > now
+            ? static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(next_tick - now).count()) + 1
+            : 0;
+        if (poll_sockets(descriptors, timeout) < 0 && !last_error_would_block()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        const bool tick = std::chrono::steady_clock::now() >= next_tick;
+        if (tick) {
+            next_tick += std::chrono::milliseconds(_tick_ms);
+            ticks = (ticks + 1) % _heartbeat_ticks;
+        }
+
+        // Poll results line up with the connections that existed before accept.
+        const size_t polled = connections.size();
+        for (size_t index = 0; index < polled; ++index) {
+            Connection& connection = connections[index];
+            const short revents = descriptors[index + 1].revents;
+            bool open = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                open = read_requests(connection);
+                connection.last_active = std::chrono::steady_clock::now();
+            }
+            if (open && tick && connection.streaming && connection.output.empty()) {
+                stream_metric_deltas(connection, ticks == 0);
+            }
+            if (open && !connection.output.empty()) {
+                open = write_pending(connection);
+            } else if (open && connection.close_after_write) {
+                open = false;
+            }
+            if (open && !connection.streaming
+                && std::chrono::steady_clock::now() - connection.last_active > _idle_timeout) {
+                open = false;
+            }
+            if (!open) {
+                close_socket(connection.socket);
+                connection.socket = invalid_socket_handle;
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(), [](const Connection& connection) {
+            return connection.socket == invalid_socket_handle;
+        }), connections.end());
+
+        if (descriptors[0].revents & POLLIN) {
+            accept_connections(server, connections);
+        }
     }
 }
 
@@ -205,7 +438,7 @@ inline void start_server() {
             close_socket(server);
             return;
         }
-        if (listen(server, 16) != 0) {
+        if (listen(server, 16) != 0 || !set_nonblocking(server)) {
             std::cerr << "[doof] warning: failed to listen on observer socket" << std::endl;
             close_socket(server);
             return;
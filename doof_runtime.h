@@ -4,17 +4,24 @@
 // Source template for the generated doof_runtime.hpp header.
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cctype>
+#include <charconv>
 #include <climits>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <condition_variable>
 #include <cmath>
+#include <deque>
 #include <exception>
 #include <functional>
 #include <future>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -23,6 +30,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <tuple>
 #include <type_traits>
@@ -32,33 +40,305 @@
 #include <variant>
 #include <vector>
 
+#if !defined(DOOF_JSON_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define DOOF_JSON_SSE2 1
+#elif !defined(DOOF_JSON_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DOOF_JSON_NEON 1
+#endif
+
+// The JsonDocument structural index also has a 32-byte AVX2 kernel.  GCC and
+// Clang compile it with a per-function target attribute and pick it at run
+// time from cpuid, so a baseline x86-64 build still uses it where available.
+#if defined(DOOF_JSON_SSE2) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define DOOF_JSON_AVX2 1
+#define DOOF_JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Branch hints for generated code. C++17 has no [[likely]], so GCC-like
+// compilers get __builtin_expect and MSVC keeps the plain condition. Hints
+// go on the branch itself: Clang drops an expectation that is returned
+// through an inline helper before it reaches the caller's branch.
+#if defined(__GNUC__) || defined(__clang__)
+#define DOOF_LIKELY(condition) __builtin_expect(!!(condition), 1)
+#define DOOF_UNLIKELY(condition) __builtin_expect(!!(condition), 0)
+#define DOOF_COLD __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+#define DOOF_LIKELY(condition) (condition)
+#define DOOF_UNLIKELY(condition) (condition)
+#define DOOF_COLD __declspec(noinline)
+#else
+#define DOOF_LIKELY(condition) (condition)
+#define DOOF_UNLIKELY(condition) (condition)
+#define DOOF_COLD
+#endif
+
+#if defined(DOOF_PROFILE)
+#include <chrono>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+#endif
+
 /* __DOOF_OBSERVER_PLATFORM_SUPPORT__ */
+/* __DOOF_STRING_REPRESENTATION__ */
 
 namespace doof {
 
 [[noreturn]] inline void panic(const std::string& msg);
 
 // ============================================================================
-// Metrics — process-local counters
+// Metrics — process-local counters, gauges and latency histograms
 // ============================================================================
 
 namespace metrics {
 
-inline std::unordered_map<std::string, int64_t> _counters;
-inline std::mutex _counters_mutex;
+// Every counter and histogram bucket is a cell index. Each thread owns a
+// shard of cells and is the only writer to it, so recording is a relaxed
+// load/store on a thread-local cache line; snapshots merge all live shards
+// plus the totals folded in by threads that have already exited.
+inline constexpr uint32_t _cells_per_block = 512;
+inline constexpr uint32_t _max_blocks = 256;
+inline constexpr uint32_t _max_cells = _cells_per_block * _max_blocks;
+
+// Log-linear buckets: exact below 8, then 8 sub-buckets per power of two,
+// which bounds the relative error of any reported quantile to 12.5%.
+inline constexpr uint32_t _histogram_buckets = 488;
+inline constexpr uint32_t _histogram_cells = _histogram_buckets + 1;
+
+enum class _Kind : uint8_t { Counter, Histogram, Gauge };
+
+struct _Shard;
+
+struct _Registry {
+    struct Entry {
+        _Kind kind;
+        uint32_t index;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> by_name;
+    std::vector<std::pair<std::string, uint32_t>> counters;
+    std::vector<std::pair<std::string, uint32_t>> histograms;
+    std::deque<std::pair<std::string, std::atomic<double>>> gauges;
+    std::vector<_Shard*> shards;
+    std::vector<int64_t> retired;
+    uint32_t next_cell = 0;
+};
+
+// Leaked so thread-exit folding never races static destruction.
+inline _Registry& _registry() {
+    static _Registry* registry = new _Registry();
+    return *registry;
+}
+
+struct _Shard {
+    std::atomic<std::atomic<int64_t>*> blocks[_max_blocks] = {};
+
+    _Shard() {
+        auto& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.shards.push_back(this);
+    }
+
+    ~_Shard() {
+        auto& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (uint32_t block = 0; block < _max_blocks; ++block) {
+            std::atomic<int64_t>* cells = blocks[block].load(std::memory_order_relaxed);
+            if (cells == nullptr) continue;
+            const uint32_t base = block * _cells_per_block;
+            for (uint32_t offset = 0; offset < _cells_per_block && base + offset < registry.retired.size(); ++offset) {
+                registry.retired[base + offset] += cells[offset].load(std::memory_order_relaxed);
+            }
+            delete[] cells;
+        }
+        registry.shards.erase(std::find(registry.shards.begin(), registry.shards.end(), this));
+    }
+
+    _Shard(const _Shard&) = delete;
+    _Shard& operator=(const _Shard&) = delete;
+
+    std::atomic<int64_t>& cell(uint32_t index) {
+        std::atomic<int64_t>* cells = blocks[index / _cells_per_block].load(std::memory_order_relaxed);
+        if (cells == nullptr) {
+            cells = new std::atomic<int64_t>[_cells_per_block];
+            for (uint32_t offset = 0; offset < _cells_per_block; ++offset) {
+                cells[offset].store(0, std::memory_order_relaxed);
+            }
+            blocks[index / _cells_per_block].store(cells, std::memory_order_release);
+        }
+        return cells[index % _cells_per_block];
+    }
+
+    int64_t read(uint32_t index) const {
+        const std::atomic<int64_t>* cells = blocks[index / _cells_per_block].load(std::memory_order_acquire);
+        return cells == nullptr ? 0 : cells[index % _cells_per_block].load(std::memory_order_relaxed);
+    }
+};
+
+inline _Shard& _local_shard() {
+    thread_local _Shard shard;
+    return shard;
+}
+
+inline void _add(uint32_t index, int64_t value) {
+    std::atomic<int64_t>& cell = _local_shard().cell(index);
+    cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Caller holds the registry mutex.
+inline int64_t _merged(const _Registry& registry, uint32_t index) {
+    int64_t total = registry.retired[index];
+    for (const _Shard* shard : registry.shards) {
+        total += shard->read(index);
+    }
+    return total;
+}
+
+inline _Registry::Entry _register(const std::string& name, _Kind kind, uint32_t cells) {
+    auto& registry = _registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    const auto found = registry.by_name.find(name);
+    if (found != registry.by_name.end()) {
+        if (found->second.kind != kind) {
+            panic("metric '" + name + "' is already registered with a different kind");
+        }
+        return found->second;
+    }
+
+    _Registry::Entry entry{kind, 0};
+    if (kind == _Kind::Gauge) {
+        entry.index = static_cast<uint32_t>(registry.gauges.size());
+        registry.gauges.emplace_back(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(0.0));
+    } else {
+        if (_max_cells - registry.next_cell < cells) {
+            panic("too many metrics registered");
+        }
+        entry.index = registry.next_cell;
+        registry.next_cell += cells;
+        registry.retired.resize(registry.next_cell, 0);
+        (kind == _Kind::Counter ? registry.counters : registry.histograms).emplace_back(name, entry.index);
+    }
+    registry.by_name.emplace(name, entry);
+    return entry;
+}
+
+inline uint32_t _histogram_bucket(int64_t value) {
+    if (value < 8) return value < 0 ? 0 : static_cast<uint32_t>(value);
+#if defined(__GNUC__) || defined(__clang__)
+    const uint32_t width = 64 - static_cast<uint32_t>(__builtin_clzll(static_cast<uint64_t>(value)));
+#else
+    uint32_t width = 0;
+    for (uint64_t rest = static_cast<uint64_t>(value); rest != 0; rest >>= 1) ++width;
+#endif
+    return (width - 3) * 8 + static_cast<uint32_t>((static_cast<uint64_t>(value) >> (width - 4)) & 7);
+}
+
+// Largest value that lands in `bucket`, used as the Prometheus `le` bound.
+// The last bucket's next power of two is 2^63, so it is clamped to the max.
+inline int64_t _histogram_upper_bound(uint32_t bucket) {
+    if (bucket < 8) return static_cast<int64_t>(bucket);
+    if (bucket + 1 >= _histogram_buckets) return std::numeric_limits<int64_t>::max();
+    const uint32_t shift = bucket / 8 - 1;
+    const uint64_t next = static_cast<uint64_t>(8 + bucket % 8 + 1) << shift;
+    return static_cast<int64_t>(next - 1);
+}
+
+/// Counter handle: register once by name, then add without touching the registry.
+struct Counter {
+    uint32_t cell;
+
+    void add(int64_t value) const { _add(cell, value); }
+};
+
+/// Histogram handle for non-negative integer observations such as latencies.
+struct Histogram {
+    uint32_t first_cell;
+
+    void record(int64_t value) const {
+        _add(first_cell + _histogram_bucket(value), 1);
+        _add(first_cell + _histogram_buckets, value < 0 ? 0 : value);
+    }
+};
+
+/// Gauge handle: last write wins across threads.
+struct Gauge {
+    std::atomic<double>* slot;
+
+    void set(double value) const { slot->store(value, std::memory_order_relaxed); }
+};
+
+inline Counter counter(const std::string& name) {
+    return Counter{_register(name, _Kind::Counter, 1).index};
+}
+
+inline Histogram histogram(const std::string& name) {
+    return Histogram{_register(name, _Kind::Histogram, _histogram_cells).index};
+}
+
+inline Gauge gauge(const std::string& name) {
+    const uint32_t index = _register(name, _Kind::Gauge, 0).index;
+    auto& registry = _registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return Gauge{&registry.gauges[index].second};
+}
 
+// Dynamic names resolve through a per-thread cache so the steady state never
+// takes the registry lock.
 inline void increment_counter(const std::string& key, int64_t value) {
-    std::lock_guard<std::mutex> lock(_counters_mutex);
-    _counters[key] += value;
+    thread_local std::unordered_map<std::string, Counter> cache;
+    auto found = cache.find(key);
+    if (found == cache.end()) {
+        found = cache.emplace(key, counter(key)).first;
+    }
+    found->second.add(value);
+}
+
+inline void observe(const std::string& key, int64_t value) {
+    thread_local std::unordered_map<std::string, Histogram> cache;
+    auto found = cache.find(key);
+    if (found == cache.end()) {
+        found = cache.emplace(key, histogram(key)).first;
+    }
+    found->second.record(value);
+}
+
+inline void set_gauge(const std::string& key, double value) {
+    thread_local std::unordered_map<std::string, Gauge> cache;
+    auto found = cache.find(key);
+    if (found == cache.end()) {
+        found = cache.emplace(key, gauge(key)).first;
+    }
+    found->second.set(value);
 }
 
 inline std::vector<std::pair<std::string, int64_t>> snapshot_pairs() {
     std::vector<std::pair<std::string, int64_t>> snapshot;
     {
-        std::lock_guard<std::mutex> lock(_counters_mutex);
-        snapshot.reserve(_counters.size());
-        for (const auto& item : _counters) {
-            snapshot.push_back(item);
+        auto& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        snapshot.reserve(registry.counters.size());
+        for (const auto& item : registry.counters) {
+            snapshot.emplace_back(item.first, _merged(registry, item.second));
+        }
+    }
+
+    std::sort(snapshot.begin(), snapshot.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    return snapshot;
+}
+
+inline std::vector<std::pair<std::string, double>> snapshot_gauges() {
+    std::vector<std::pair<std::string, double>> snapshot;
+    {
+        auto& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& item : registry.gauges) {
+            snapshot.emplace_back(item.first, item.second.load(std::memory_order_relaxed));
         }
     }
 
@@ -68,17 +348,368 @@ inline std::vector<std::pair<std::string, int64_t>> snapshot_pairs() {
     return snapshot;
 }
 
+struct HistogramSnapshot {
+    std::string name;
+    int64_t count = 0;
+    int64_t sum = 0;
+    /// Non-empty buckets in ascending order as (upper bound, observations).
+    std::vector<std::pair<int64_t, int64_t>> buckets;
+
+    /// Upper bound of the bucket holding the q-th quantile, or 0 when empty.
+    int64_t quantile(double q) const {
+        if (count == 0) return 0;
+        const double clamped = q < 0 ? 0 : (q > 1 ? 1 : q);
+        const int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(clamped * static_cast<double>(count))));
+        int64_t seen = 0;
+        for (const auto& bucket : buckets) {
+            seen += bucket.second;
+            if (seen >= rank) return bucket.first;
+        }
+        return buckets.back().first;
+    }
+};
+
+inline std::vector<HistogramSnapshot> snapshot_histograms() {
+    std::vector<HistogramSnapshot> snapshot;
+    {
+        auto& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        snapshot.reserve(registry.histograms.size());
+        for (const auto& item : registry.histograms) {
+            HistogramSnapshot histogram;
+            histogram.name = item.first;
+            for (uint32_t bucket = 0; bucket < _histogram_buckets; ++bucket) {
+                const int64_t observations = _merged(registry, item.second + bucket);
+                if (observations == 0) continue;
+                histogram.count += observations;
+                histogram.buckets.emplace_back(_histogram_upper_bound(bucket), observations);
+            }
+            histogram.sum = _merged(registry, item.second + _histogram_buckets);
+            snapshot.push_back(std::move(histogram));
+        }
+    }
+
+    std::sort(snapshot.begin(), snapshot.end(), [](const auto& a, const auto& b) {
+        return a.name < b.name;
+    });
+    return snapshot;
+}
+
+// Splits `name{labels}` so histogram series can add their own suffix and `le`.
+inline std::pair<std::string, std::string> _split_labels(const std::string& name) {
+    const size_t open = name.find('{');
+    if (open == std::string::npos || name.back() != '}') return {name, ""};
+    return {name.substr(0, open), name.substr(open + 1, name.size() - open - 2)};
+}
+
 inline std::string snapshot_prometheus() {
-    const auto snapshot = snapshot_pairs();
     std::ostringstream out;
-    for (const auto& item : snapshot) {
+    for (const auto& item : snapshot_pairs()) {
+        out << item.first << " " << item.second << "\n";
+    }
+    for (const auto& item : snapshot_gauges()) {
+        out << "# TYPE " << _split_labels(item.first).first << " gauge\n";
         out << item.first << " " << item.second << "\n";
     }
+    for (const auto& histogram : snapshot_histograms()) {
+        const auto [base, labels] = _split_labels(histogram.name);
+        const std::string prefix = labels.empty() ? "" : labels + ",";
+        const std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+        out << "# TYPE " << base << " histogram\n";
+        int64_t cumulative = 0;
+        for (const auto& bucket : histogram.buckets) {
+            // The unbounded top bucket is reported by the +Inf series below.
+            if (bucket.first == std::numeric_limits<int64_t>::max()) break;
+            cumulative += bucket.second;
+            out << base << "_bucket{" << prefix << "le=\"" << bucket.first << "\"} " << cumulative << "\n";
+        }
+        out << base << "_bucket{" << prefix << "le=\"+Inf\"} " << histogram.count << "\n";
+        out << base << "_sum" << suffix << " " << histogram.sum << "\n";
+        out << base << "_count" << suffix << " " << histogram.count << "\n";
+    }
     return out.str();
 }
 
 } // namespace metrics
 
+// ============================================================================
+// Profiling — function spans and actor service time (activated with -DDOOF_PROFILE)
+// ============================================================================
+
+#if defined(DOOF_PROFILE)
+
+namespace profile {
+
+// Each thread appends to its own fixed ring and overwrites its oldest events
+// once full. Fields are relaxed atomics so a reader can copy a ring while its
+// owner keeps writing, then drop whatever the owner lapped during the copy.
+inline constexpr uint64_t _ring_capacity = 1u << 14;
+
+enum class _Phase : uint8_t { Complete, Counter };
+
+struct _Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<const void*> series{nullptr};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<int64_t> value{0};
+    std::atomic<uint8_t> phase{0};
+};
+
+struct _Ring {
+    std::atomic<uint64_t> head{0};
+    std::unique_ptr<_Slot[]> slots{new _Slot[_ring_capacity]};
+    // (first event index, tid) for each thread that has owned the ring,
+    // oldest first, so recycled events keep their writer's id. Guarded by
+    // the registry mutex.
+    std::vector<std::pair<uint64_t, uint32_t>> owners;
+};
+
+struct _Registry {
+    std::mutex mutex;
+    std::vector<_Ring*> rings;
+    // Rings of exited threads keep their events and are handed to new threads.
+    std::vector<_Ring*> idle;
+    uint32_t next_tid = 1;
+};
+
+inline _Registry& _registry() {
+    static _Registry* registry = new _Registry();
+    return *registry;
+}
+
+inline uint64_t now_ns() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+struct _RingLease {
+    _Ring* ring;
+
+    _RingLease() {
+        auto& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (registry.idle.empty()) {
+            ring = new _Ring();
+            registry.rings.push_back(ring);
+        } else {
+            ring = registry.idle.back();
+            registry.idle.pop_back();
+        }
+        const uint64_t head = ring->head.load(std::memory_order_relaxed);
+        const uint64_t oldest = head > _ring_capacity ? head - _ring_capacity : 0;
+        auto& owners = ring->owners;
+        if (!owners.empty() && owners.back().first == head) owners.pop_back();
+        while (owners.size() > 1 && owners[1].first <= oldest) owners.erase(owners.begin());
+        owners.emplace_back(head, registry.next_tid++);
+    }
+
+    ~_RingLease() {
+        auto& registry = _registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.idle.push_back(ring);
+    }
+
+    _RingLease(const _RingLease&) = delete;
+    _RingLease& operator=(const _RingLease&) = delete;
+};
+
+inline void _record(_Phase phase, const char* name, const void* series, uint64_t start_ns, int64_t value) {
+    thread_local _RingLease lease;
+    _Ring& ring = *lease.ring;
+    const uint64_t index = ring.head.load(std::memory_order_relaxed);
+    _Slot& slot = ring.slots[index % _ring_capacity];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.series.store(series, std::memory_order_relaxed);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.phase.store(static_cast<uint8_t>(phase), std::memory_order_relaxed);
+    ring.head.store(index + 1, std::memory_order_release);
+}
+
+/// Records the enclosing scope as one complete trace event. `name` must
+/// outlive the process's last trace snapshot; emitted code passes literals.
+class Span {
+public:
+    explicit Span(const char* name) noexcept : name_(name), start_ns_(now_ns()) {}
+    ~Span() {
+        _record(_Phase::Complete, name_, nullptr, start_ns_, static_cast<int64_t>(now_ns() - start_ns_));
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_ns_;
+};
+
+inline void record_counter(const char* name, const void* series, int64_t value) {
+    _record(_Phase::Counter, name, series, now_ns(), value);
+}
+
+/// Display names for one actor type's service spans and mailbox-depth counter.
+struct ActorLabels {
+    std::string service;
+    std::string mailbox;
+};
+
+template <typename T>
+const ActorLabels& actor_labels() {
+    static const ActorLabels labels = [] {
+        std::string name = typeid(T).name();
+#if defined(__GNUG__)
+        int status = 0;
+        if (char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status)) {
+            if (status == 0) name = demangled;
+            std::free(demangled);
+        }
+#endif
+        return ActorLabels{"actor " + name, "mailbox " + name};
+    }();
+    return labels;
+}
+
+// Service time of one mailbox message, plus the depth left behind it.
+class ServiceScope {
+public:
+    ServiceScope(const ActorLabels& labels, const void* actor, int64_t remaining) noexcept
+        : span_(labels.service.c_str()) {
+        record_counter(labels.mailbox.c_str(), actor, remaining);
+    }
+
+private:
+    Span span_;
+};
+
+inline void _append_json_string(std::string& out, const char* value) {
+    out += '"';
+    for (const char* ch = value; *ch != '\0'; ++ch) {
+        const unsigned char c = static_cast<unsigned char>(*ch);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += *ch;
+        } else if (c < 0x20) {
+            static constexpr char HEX[] = "0123456789abcdef";
+            out += "\\u00";
+            out += HEX[(c >> 4) & 0x0F];
+            out += HEX[c & 0x0F];
+        } else {
+            out += *ch;
+        }
+    }
+    out += '"';
+}
+
+inline void _append_micros(std::string& out, uint64_t nanoseconds) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%llu.%03llu",
+        static_cast<unsigned long long>(nanoseconds / 1000),
+        static_cast<unsigned long long>(nanoseconds % 1000));
+    out += buffer;
+}
+
+/// Current ring contents in Chrome trace-event JSON, loadable by
+/// chrome://tracing and Perfetto.
+inline std::string snapshot_trace_json() {
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto& registry = _registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const _Ring* ring : registry.rings) {
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        const uint64_t begin = head > _ring_capacity ? head - _ring_capacity : 0;
+        std::vector<std::tuple<const char*, const void*, uint64_t, int64_t, uint8_t>> copied;
+        copied.reserve(static_cast<size_t>(head - begin));
+        for (uint64_t index = begin; index < head; ++index) {
+            const _Slot& slot = ring->slots[index % _ring_capacity];
+            copied.emplace_back(
+                slot.name.load(std::memory_order_relaxed),
+                slot.series.load(std::memory_order_relaxed),
+                slot.start_ns.load(std::memory_order_relaxed),
+                slot.value.load(std::memory_order_relaxed),
+                slot.phase.load(std::memory_order_relaxed));
+        }
+        // While head == after the writer may be mid-way through slot
+        // after % capacity, which is index after - capacity; anything at or
+        // below it may have been overwritten mid-read.
+        const uint64_t after = ring->head.load(std::memory_order_acquire);
+        const uint64_t valid = after + 1 > _ring_capacity ? after + 1 - _ring_capacity : 0;
+        size_t owner = 0;
+        for (uint64_t index = std::max(begin, valid); index < head; ++index) {
+            const auto& [name, series, start_ns, value, phase] = copied[static_cast<size_t>(index - begin)];
+            if (name == nullptr) continue;
+            while (owner + 1 < ring->owners.size() && ring->owners[owner + 1].first <= index) ++owner;
+            out += first ? "" : ",";
+            first = false;
+            out += "{\"name\":";
+            _append_json_string(out, name);
+            out += ",\"pid\":1,\"tid\":" + std::to_string(ring->owners[owner].second) + ",\"ts\":";
+            _append_micros(out, start_ns);
+            if (phase == static_cast<uint8_t>(_Phase::Complete)) {
+                out += ",\"ph\":\"X\",\"dur\":";
+                _append_micros(out, static_cast<uint64_t>(value));
+            } else {
+                char series_id[32];
+                std::snprintf(series_id, sizeof(series_id), "%p", series);
+                out += ",\"ph\":\"C\",\"id\":\"";
+                out += series_id;
+                out += "\",\"args\":{\"depth\":" + std::to_string(value) + "}";
+            }
+            out += '}';
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+} // namespace profile
+
+#define DOOF_PROFILE_SCOPE(name) ::doof::profile::Span _doof_profile_span(name)
+#else
+#define DOOF_PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
+
+// ============================================================================
+// Copy counting — value-struct copies and moves (activated with -DDOOF_COUNT_COPIES)
+// ============================================================================
+
+#if defined(DOOF_COUNT_COPIES)
+
+namespace copies {
+
+inline std::atomic<uint64_t> _copies{0};
+inline std::atomic<uint64_t> _moves{0};
+inline std::once_flag _report_once;
+
+inline void _report() {
+    std::fprintf(stderr, "doof copy-count: copies=%llu moves=%llu\n",
+        static_cast<unsigned long long>(_copies.load(std::memory_order_relaxed)),
+        static_cast<unsigned long long>(_moves.load(std::memory_order_relaxed)));
+}
+
+inline void _count(std::atomic<uint64_t>& counter) {
+    std::call_once(_report_once, []() { std::atexit(_report); });
+    counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline uint64_t copy_count() { return _copies.load(std::memory_order_relaxed); }
+inline uint64_t move_count() { return _moves.load(std::memory_order_relaxed); }
+
+/// Embedded in every emitted value struct; copying or moving the struct
+/// copies or moves this member, which tallies the operation.
+struct Counter {
+    Counter() noexcept = default;
+    Counter(const Counter&) noexcept { _count(_copies); }
+    Counter(Counter&&) noexcept { _count(_moves); }
+    Counter& operator=(const Counter&) noexcept { _count(_copies); return *this; }
+    Counter& operator=(Counter&&) noexcept { _count(_moves); return *this; }
+};
+
+} // namespace copies
+
+#endif
+
 /* __DOOF_OBSERVER_RUNTIME_SUPPORT__ */
 
 // ============================================================================
@@ -136,10 +767,174 @@ struct SourceLocation {
 };
 
 namespace detail {
+// Recycled storage for mailbox messages.
+//
+// Messages are usually allocated by the sending thread and freed by the
+// receiving one, so each thread keeps a small cache per size class and hands
+// overflow to a shared recycle stack. A thread whose cache runs dry takes the
+// whole recycle stack with one exchange, which keeps the shared stack free of
+// ABA hazards without locks. Oversized messages use plain operator new.
+class MessagePool {
+public:
+    static constexpr std::size_t granule = 64;
+    static constexpr std::size_t class_count = 4;
+    static constexpr std::size_t cached_per_class = 128;
+    static constexpr std::size_t recycled_per_class = 4096;
+
+    static void* allocate(std::size_t size) {
+        const std::size_t index = class_index(size);
+        if (index < class_count) {
+            if (Cache* cache = local()) {
+                if (cache->heads[index] == nullptr) {
+                    cache->counts[index] = adopt_recycled(index, cache->heads[index]);
+                }
+                if (Block* block = cache->heads[index]) {
+                    cache->heads[index] = block->next;
+                    --cache->counts[index];
+                    return block;
+                }
+            }
+            return ::operator new((index + 1) * granule);
+        }
+        return ::operator new(size);
+    }
+
+    static void release(void* memory, std::size_t size) noexcept {
+        const std::size_t index = class_index(size);
+        if (index >= class_count) {
+            ::operator delete(memory);
+            return;
+        }
+        Block* block = static_cast<Block*>(memory);
+        Cache* cache = local();
+        if (cache != nullptr && cache->counts[index] < cached_per_class) {
+            block->next = cache->heads[index];
+            cache->heads[index] = block;
+            ++cache->counts[index];
+            return;
+        }
+        Shared& pool = shared();
+        if (pool.recycled_count[index].fetch_add(1, std::memory_order_relaxed) >= recycled_per_class) {
+            pool.recycled_count[index].fetch_sub(1, std::memory_order_relaxed);
+            ::operator delete(memory);
+            return;
+        }
+        Block* top = pool.recycled[index].load(std::memory_order_relaxed);
+        do {
+            block->next = top;
+        } while (!pool.recycled[index].compare_exchange_weak(
+            top, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    struct Block { Block* next; };
+
+    struct Cache {
+        Block* heads[class_count] = {};
+        std::size_t counts[class_count] = {};
+
+        ~Cache() {
+            // Messages released by later thread-exit cleanup bypass the cache.
+            cache_retired() = true;
+            for (Block* head : heads) {
+                while (head != nullptr) {
+                    Block* next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+    };
+
+    struct Shared {
+        std::atomic<Block*> recycled[class_count] = {};
+        std::atomic<std::size_t> recycled_count[class_count] = {};
+    };
+
+    static std::size_t class_index(std::size_t size) {
+        return size == 0 ? 0 : (size - 1) / granule;
+    }
+
+    // Takes the whole recycle stack and returns how many blocks it held.
+    // Releasers count a block before pushing it, so subtracting exactly what
+    // was taken keeps pushes that race with the exchange accounted for.
+    static std::size_t adopt_recycled(std::size_t index, Block*& head) {
+        Shared& pool = shared();
+        head = pool.recycled[index].exchange(nullptr, std::memory_order_acquire);
+        std::size_t taken = 0;
+        for (Block* block = head; block != nullptr; block = block->next) ++taken;
+        if (taken != 0) pool.recycled_count[index].fetch_sub(taken, std::memory_order_relaxed);
+        return taken;
+    }
+
+    static bool& cache_retired() {
+        static thread_local bool retired = false;
+        return retired;
+    }
+
+    static Cache* local() {
+        if (cache_retired()) return nullptr;
+        static thread_local Cache cache;
+        return &cache;
+    }
+
+    // Leaked so messages freed during static destruction stay valid.
+    static Shared& shared() {
+        static Shared* pool = new Shared();
+        return *pool;
+    }
+};
+
+// One queued message. Nodes are linked intrusively so pushing a message costs
+// a recycled allocation and a single compare-and-swap.
+class MailboxNode {
+public:
+    virtual ~MailboxNode() = default;
+
+    // Runs the message and releases it; the node must not be touched again.
+    virtual void invoke() = 0;
+
+    // Releases a message that will never run.
+    virtual void discard() noexcept { delete this; }
+
+    static void* operator new(std::size_t size) { return MessagePool::allocate(size); }
+    static void operator delete(void* memory, std::size_t size) noexcept { MessagePool::release(memory, size); }
+
+    MailboxNode* next = nullptr;
+};
+
+// Fire-and-forget message that stores its closure inline.
+template <typename F>
+class MailboxTask final : public MailboxNode {
+    F task_;
+public:
+    explicit MailboxTask(F task) : task_(std::move(task)) {}
+
+    void invoke() override {
+        std::unique_ptr<MailboxTask> owned(this);
+        task_();
+    }
+};
+
+template <typename F>
+MailboxNode* make_mailbox_task(F&& task) {
+    return new MailboxTask<std::decay_t<F>>(std::forward<F>(task));
+}
+
 class CallbackDomain {
 public:
     virtual ~CallbackDomain() = default;
-    virtual void enqueue_callback(std::function<void()> task) = 0;
+
+    // Takes ownership of the message; discards it if the domain is closed.
+    virtual void enqueue_message(MailboxNode* message) = 0;
+
+    void enqueue_callback(std::function<void()> task) {
+        enqueue_message(make_mailbox_task(std::move(task)));
+    }
+
+    // Shared owner of the domain, if it has one. Messages queued long after
+    // they were prepared hold it weakly so a destroyed domain is detected.
+    virtual std::shared_ptr<void> lifetime_anchor() { return nullptr; }
 };
 
 inline thread_local CallbackDomain* active_actor_domain = nullptr;
@@ -157,63 +952,161 @@ public:
     }
 };
 
-class ApplicationDomain final : public CallbackDomain {
+// Lock-free multi-producer/single-consumer mailbox.
+//
+// Producers push onto an intrusive stack; the consumer detaches the whole
+// pending batch with one exchange and replays it oldest first. The head also
+// records whether a consumer is attached: it starts at `idle_marker()`, a
+// push that replaces the marker reports the empty-to-ready transition (the
+// only push that needs to wake anyone), and the consumer parks the mailbox
+// again with `try_park()` once its batch and the stack are both empty.
+class MpscMailbox {
+    std::atomic<MailboxNode*> head_;
+    MailboxNode* batch_ = nullptr;
+
+    // Sentinel address only; never dereferenced.
+    static inline char idle_tag_ = 0;
+    static MailboxNode* idle_marker() { return reinterpret_cast<MailboxNode*>(&idle_tag_); }
+
 public:
-    static ApplicationDomain& shared() {
-        static ApplicationDomain domain;
-        return domain;
+    MpscMailbox() : head_(idle_marker()) {}
+    MpscMailbox(const MpscMailbox&) = delete;
+    MpscMailbox& operator=(const MpscMailbox&) = delete;
+
+    ~MpscMailbox() {
+        discard(batch_);
+        MailboxNode* pending = head_.exchange(idle_marker());
+        if (pending != idle_marker()) discard(pending);
+    }
+
+    // Returns true when this push woke a parked mailbox.
+    bool push(MailboxNode* node) {
+        MailboxNode* top = head_.load();
+        do {
+            node->next = top == idle_marker() ? nullptr : top;
+        } while (!head_.compare_exchange_weak(top, node));
+        return top == idle_marker();
+    }
+
+    bool parked() const { return head_.load() == idle_marker(); }
+
+    // Consumer only: next message in arrival order, or nullptr once the
+    // detached batch and the shared stack are both empty.
+    MailboxNode* pop() {
+        if (batch_ == nullptr) {
+            if (head_.load() == idle_marker()) return nullptr;
+            MailboxNode* top = head_.exchange(nullptr);
+            while (top != nullptr) {
+                MailboxNode* next = top->next;
+                top->next = batch_;
+                batch_ = top;
+                top = next;
+            }
+            if (batch_ == nullptr) return nullptr;
+        }
+        MailboxNode* node = batch_;
+        batch_ = node->next;
+        node->next = nullptr;
+        return node;
     }
 
-    static bool is_application_domain(CallbackDomain* domain) {
-        return domain == &shared();
+    // Consumer only: park an empty mailbox. Fails when a producer pushed
+    // after the last pop, in which case the consumer keeps draining.
+    bool try_park() {
+        if (batch_ != nullptr) return false;
+        MailboxNode* expected = nullptr;
+        return head_.compare_exchange_strong(expected, idle_marker()) || expected == idle_marker();
     }
 
-    void enqueue_callback(std::function<void()> task) override {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            mailbox_.push(std::move(task));
+private:
+    static void discard(MailboxNode* node) {
+        while (node != nullptr) {
+            MailboxNode* next = node->next;
+            node->discard();
+            node = next;
+        }
+    }
+};
+
+// Runs one popped message; the message releases itself, even when it throws.
+inline void run_mailbox_node(MailboxNode* node) {
+    node->invoke();
+}
+
+class ApplicationDomain final : public CallbackDomain {
+public:
+    static ApplicationDomain& shared() {
+        static ApplicationDomain domain;
+        return domain;
+    }
+
+    static bool is_application_domain(CallbackDomain* domain) {
+        return domain == &shared();
+    }
+
+    void enqueue_message(MailboxNode* message) override {
+        if (mailbox_.push(message)) {
+            notify_ready();
         }
-        notify_ready();
     }
 
+    // The host drains the application mailbox from one thread at a time.
     int32_t drain_ready() {
         int32_t dispatched = 0;
-        while (true) {
-            std::function<void()> task;
-            {
-                std::lock_guard<std::mutex> lock(mutex_);
-                if (mailbox_.empty()) {
-                    return dispatched;
-                }
-                task = std::move(mailbox_.front());
-                mailbox_.pop();
-            }
-
+        while (MailboxNode* node = next_ready()) {
             ActiveActorScope active(this);
-            task();
+            run_mailbox_node(node);
             ++dispatched;
         }
+        return dispatched;
     }
 
     bool wait_and_dispatch_one() {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            ready_.wait(lock, [this] {
-                return !mailbox_.empty() || keep_alive_count_ == 0;
-            });
-            if (mailbox_.empty()) {
+        MailboxNode* node = next_ready();
+        if (node == nullptr) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] {
+                    return !mailbox_.parked() || keep_alive_count_ == 0;
+                });
+            }
+            node = next_ready();
+            if (node == nullptr) {
                 return false;
             }
-            task = std::move(mailbox_.front());
-            mailbox_.pop();
         }
 
         ActiveActorScope active(this);
-        task();
+        run_mailbox_node(node);
         return true;
     }
 
+    // Dispatches callbacks on the calling thread until `settle_waiter` sets
+    // `done`. Used when the domain's own thread waits on a promise.
+    void dispatch_until(const bool& done) {
+        try {
+            while (true) {
+                drain_ready();
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [&] { return done || !mailbox_.parked(); });
+                if (done) return;
+            }
+        } catch (...) {
+            // The caller's waiter stays linked until settlement; outlive it.
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [&] { return done; });
+            throw;
+        }
+    }
+
+    void settle_waiter(bool& done) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done = true;
+        }
+        ready_.notify_all();
+    }
+
     void add_keep_alive_source(bool keeps_alive) {
         if (!keeps_alive) {
             return;
@@ -243,6 +1136,13 @@ public:
 private:
     ApplicationDomain() = default;
 
+    MailboxNode* next_ready() {
+        while (true) {
+            if (MailboxNode* node = mailbox_.pop()) return node;
+            if (mailbox_.try_park()) return nullptr;
+        }
+    }
+
     void notify_ready() {
         std::function<void()> wake_handler;
         {
@@ -256,9 +1156,9 @@ private:
         }
     }
 
+    MpscMailbox mailbox_;
     std::mutex mutex_;
     std::condition_variable ready_;
-    std::queue<std::function<void()>> mailbox_;
     int64_t keep_alive_count_ = 0;
     std::function<void()> wake_handler_;
 };
@@ -277,11 +1177,57 @@ class callback;
 namespace detail {
 template <typename R, typename... Args>
 R call_callback_unchecked(const doof::callback<R(Args...)>& cb, Args... args);
+
+// Type-erased callback body. The closure lives in the same block as the
+// refcount, so a callback costs one allocation and copies never allocate.
+template <typename Signature>
+class CallbackTarget;
+
+template <typename R, typename... Args>
+class CallbackTarget<R(Args...)> {
+public:
+    virtual ~CallbackTarget() = default;
+    virtual R invoke(Args... args) const = 0;
+};
+
+template <typename F, typename R, typename... Args>
+class CallbackTargetOf final : public CallbackTarget<R(Args...)> {
+    // Invoked as a non-const lvalue, matching std::function.
+    mutable F fn_;
+
+public:
+    template <typename G>
+    explicit CallbackTargetOf(G&& fn) : fn_(std::forward<G>(fn)) {}
+
+    R invoke(Args... args) const override {
+        if constexpr (std::is_void_v<R>) {
+            std::invoke(fn_, std::forward<Args>(args)...);
+        } else {
+            return std::invoke(fn_, std::forward<Args>(args)...);
+        }
+    }
+};
+
+template <typename T>
+struct is_std_function : std::false_type {};
+
+template <typename Signature>
+struct is_std_function<std::function<Signature>> : std::true_type {};
+
+template <typename F>
+bool callback_target_empty(const F& fn) {
+    if constexpr (std::is_pointer_v<F> || std::is_member_pointer_v<F> || is_std_function<F>::value) {
+        return !fn;
+    } else {
+        return false;
+    }
+}
 }
 
 template <typename R, typename... Args>
 class callback<R(Args...)> {
-    std::function<R(Args...)> fn_;
+    // Shared so posting a message copies a reference, not the closure.
+    std::shared_ptr<const detail::CallbackTarget<R(Args...)>> fn_;
     detail::CallbackDomain* owner_ = nullptr;
 
 public:
@@ -292,13 +1238,24 @@ public:
         typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, callback>>
     >
     callback(F&& f)
-        : fn_(std::forward<F>(f)),
-          owner_(doof::current_actor_domain()) {}
+        : owner_(doof::current_actor_domain()) {
+        if constexpr (!std::is_null_pointer_v<std::decay_t<F>>) {
+            using Target = detail::CallbackTargetOf<std::decay_t<F>, R, Args...>;
+            if (!detail::callback_target_empty(f)) {
+                fn_ = std::make_shared<const Target>(std::forward<F>(f));
+            }
+        }
+    }
 
     explicit operator bool() const {
         return static_cast<bool>(fn_);
     }
 
+    // Domain the callback was created in; null outside any actor domain.
+    detail::CallbackDomain* owner_domain() const {
+        return owner_;
+    }
+
     R call(Args... args) const {
         if (!fn_) {
             doof::panic("callback invoked before initialization");
@@ -307,9 +1264,9 @@ public:
             doof::panic("callback invoked outside owning actor domain");
         }
         if constexpr (std::is_void_v<R>) {
-            fn_(std::forward<Args>(args)...);
+            fn_->invoke(std::forward<Args>(args)...);
         } else {
-            return fn_(std::forward<Args>(args)...);
+            return fn_->invoke(std::forward<Args>(args)...);
         }
     }
 
@@ -339,11 +1296,11 @@ public:
 
         auto self = *this;
         auto packedArgs = std::make_tuple(std::forward<Args>(args)...);
-        owner_->enqueue_callback([self, packedArgs = std::move(packedArgs)]() mutable {
+        owner_->enqueue_message(detail::make_mailbox_task([self, packedArgs = std::move(packedArgs)]() mutable {
             std::apply([&](auto&&... unpacked) {
                 self.call(std::forward<decltype(unpacked)>(unpacked)...);
             }, std::move(packedArgs));
-        });
+        }));
     }
 
 private:
@@ -355,9 +1312,9 @@ private:
             doof::panic("callback invoked before initialization");
         }
         if constexpr (std::is_void_v<R>) {
-            fn_(std::forward<Args>(args)...);
+            fn_->invoke(std::forward<Args>(args)...);
         } else {
-            return fn_(std::forward<Args>(args)...);
+            return fn_->invoke(std::forward<Args>(args)...);
         }
     }
 };
@@ -369,6 +1326,62 @@ R call_callback_unchecked(const doof::callback<R(Args...)>& cb, Args... args) {
 }
 }
 
+template <typename Signature>
+class callback_ref;
+
+namespace detail {
+
+template <typename T>
+struct is_doof_callback : std::false_type {};
+
+template <typename Signature>
+struct is_doof_callback<callback<Signature>> : std::true_type {};
+
+template <typename Signature>
+struct is_doof_callback<callback_ref<Signature>> : std::true_type {};
+
+// Invoke either a `doof::callback` (through its checked `call`) or a bare
+// functor the emitter passed for a non-escaping lambda.
+template <typename F, typename... Args>
+decltype(auto) invoke_callable(const F& f, Args&&... args) {
+    if constexpr (is_doof_callback<F>::value) {
+        return f.call(std::forward<Args>(args)...);
+    } else {
+        return f(std::forward<Args>(args)...);
+    }
+}
+
+} // namespace detail
+
+/**
+ * Non-owning reference to a callable, used for function-typed parameters the
+ * emitter has proven never escape the call: they are only invoked directly,
+ * never stored, captured, posted or dispatched. Binding a lambda costs no
+ * allocation, and binding a `doof::callback` forwards to `callback::call`, so
+ * the owning-domain check is kept. The referenced callable must outlive the
+ * reference, which holds for a by-value parameter bound at the call site.
+ */
+template <typename R, typename... Args>
+class callback_ref<R(Args...)> {
+    const void* target_;
+    R (*invoke_)(const void*, Args...);
+
+public:
+    template <
+        typename F,
+        typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, callback_ref>>
+    >
+    callback_ref(const F& f) noexcept
+        : target_(std::addressof(f)),
+          invoke_([](const void* target, Args... args) -> R {
+              return detail::invoke_callable(*static_cast<const F*>(target), std::forward<Args>(args)...);
+          }) {}
+
+    R call(Args... args) const {
+        return invoke_(target_, std::forward<Args>(args)...);
+    }
+};
+
 [[noreturn]] inline void panic_ordered_collection_invariant(
     const char* collection,
     const char* context,
@@ -387,241 +1400,604 @@ R call_callback_unchecked(const doof::callback<R(Args...)>& cb, Args... args) {
 // Ordered collections — insertion-order preserving Map/Set runtime types
 // ============================================================================
 
-template <typename K, typename V>
-class ordered_map {
+namespace detail {
+
+// Forward iterator over the live slots of an ordered collection, skipping
+// erased slots.
+template <typename Slot, typename Value>
+class ordered_slot_iterator {
 public:
-    using value_type = std::pair<K, V>;
-    using storage_type = std::vector<value_type>;
-    using iterator = typename storage_type::iterator;
-    using const_iterator = typename storage_type::const_iterator;
-    using size_type = typename storage_type::size_type;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<Value>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
 
-    ordered_map() = default;
+    ordered_slot_iterator() = default;
+    ordered_slot_iterator(Slot* slot, Slot* end) : slot_(slot), end_(end) {
+        skip_erased();
+    }
 
-    ordered_map(std::initializer_list<value_type> init) {
-        for (const auto& entry : init) {
-            insert_or_assign(entry.first, entry.second);
+    template <
+        typename OtherSlot,
+        typename OtherValue,
+        typename = std::enable_if_t<std::is_convertible_v<OtherSlot*, Slot*>>
+    >
+    ordered_slot_iterator(const ordered_slot_iterator<OtherSlot, OtherValue>& other)
+        : slot_(other.slot_), end_(other.end_) {}
+
+    reference operator*() const { return **slot_; }
+    pointer operator->() const { return &**slot_; }
+
+    ordered_slot_iterator& operator++() {
+        ++slot_;
+        skip_erased();
+        return *this;
+    }
+
+    ordered_slot_iterator operator++(int) {
+        ordered_slot_iterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    friend bool operator==(const ordered_slot_iterator& lhs, const ordered_slot_iterator& rhs) {
+        return lhs.slot_ == rhs.slot_;
+    }
+
+    friend bool operator!=(const ordered_slot_iterator& lhs, const ordered_slot_iterator& rhs) {
+        return lhs.slot_ != rhs.slot_;
+    }
+
+private:
+    template <typename, typename>
+    friend class ordered_slot_iterator;
+
+    void skip_erased() {
+        while (slot_ != end_ && !slot_->has_value()) {
+            ++slot_;
         }
-        validate_invariants("ordered_map::initializer_list");
     }
 
-    ordered_map(const ordered_map& other)
-        : entries_(other.entries_) {
-        rebuild_index();
-        validate_invariants("ordered_map::copy_ctor");
+    Slot* slot_ = nullptr;
+    Slot* end_ = nullptr;
+};
+
+// Dense insertion-ordered storage shared by ordered_map and ordered_set.
+// Erasing leaves a tombstone, so positions of later entries stay valid; the
+// owner compacts once tombstones outnumber live entries, which keeps erase
+// amortized O(1). `first_` skips the erased prefix left by FIFO-style erasure.
+template <typename T>
+class ordered_slots {
+public:
+    using slot_type = std::optional<T>;
+    using iterator = ordered_slot_iterator<slot_type, T>;
+    using const_iterator = ordered_slot_iterator<const slot_type, const T>;
+    using size_type = std::size_t;
+
+    ordered_slots() = default;
+    ordered_slots(const ordered_slots&) = default;
+    ordered_slots& operator=(const ordered_slots&) = default;
+
+    ordered_slots(ordered_slots&& other) noexcept
+        : slots_(std::move(other.slots_)), live_(other.live_), first_(other.first_) {
+        other.clear();
     }
 
-    ordered_map& operator=(const ordered_map& other) {
+    ordered_slots& operator=(ordered_slots&& other) noexcept {
         if (this != &other) {
-            entries_ = other.entries_;
-            rebuild_index();
-            validate_invariants("ordered_map::copy_assign");
+            slots_ = std::move(other.slots_);
+            live_ = other.live_;
+            first_ = other.first_;
+            other.clear();
         }
         return *this;
     }
 
-    ordered_map(ordered_map&&) = default;
-    ordered_map& operator=(ordered_map&&) = default;
+    iterator begin() { return at_slot(first_); }
+    iterator end() { return at_slot(slots_.size()); }
+    const_iterator begin() const { return at_slot(first_); }
+    const_iterator end() const { return at_slot(slots_.size()); }
 
-    iterator begin() {
-        validate_invariants("ordered_map::begin");
-        return entries_.begin();
+    iterator at_slot(size_type slot) {
+        slot_type* data = slots_.data();
+        return iterator(data + slot, data + slots_.size());
     }
-    iterator end() {
-        validate_invariants("ordered_map::end");
-        return entries_.end();
+
+    const_iterator at_slot(size_type slot) const {
+        const slot_type* data = slots_.data();
+        return const_iterator(data + slot, data + slots_.size());
     }
-    const_iterator begin() const {
-        validate_invariants("ordered_map::begin const");
-        return entries_.begin();
+
+    [[nodiscard]] size_type size() const { return live_; }
+    [[nodiscard]] size_type slot_count() const { return slots_.size(); }
+    [[nodiscard]] size_type first_slot() const { return first_; }
+    [[nodiscard]] bool live(size_type slot) const { return slots_[slot].has_value(); }
+
+    T& operator[](size_type slot) { return *slots_[slot]; }
+    const T& operator[](size_type slot) const { return *slots_[slot]; }
+
+    size_type push_back(T value) {
+        slots_.emplace_back(std::move(value));
+        ++live_;
+        return slots_.size() - 1;
     }
-    const_iterator end() const {
-        validate_invariants("ordered_map::end const");
-        return entries_.end();
+
+    void erase(size_type slot) {
+        slots_[slot].reset();
+        --live_;
+        while (first_ < slots_.size() && !slots_[first_].has_value()) {
+            ++first_;
+        }
     }
-    const_iterator cbegin() const {
-        validate_invariants("ordered_map::cbegin");
-        return entries_.cbegin();
+
+    [[nodiscard]] bool wants_compaction() const {
+        const size_type erased = slots_.size() - live_;
+        return erased >= min_compaction && erased > live_;
     }
-    const_iterator cend() const {
-        validate_invariants("ordered_map::cend");
-        return entries_.cend();
+
+    // Moves live entries to the front, preserving order, and returns each old
+    // slot's new position (erased slots map to `moved_out`).
+    std::vector<uint32_t> compact() {
+        std::vector<uint32_t> remap(slots_.size(), moved_out);
+        size_type target = 0;
+        for (size_type slot = first_; slot < slots_.size(); ++slot) {
+            if (!slots_[slot].has_value()) continue;
+            if (target != slot) {
+                slots_[target] = std::move(slots_[slot]);
+                slots_[slot].reset();
+            }
+            remap[slot] = static_cast<uint32_t>(target);
+            ++target;
+        }
+        slots_.resize(target);
+        first_ = 0;
+        return remap;
     }
 
-    [[nodiscard]] bool empty() const { return entries_.empty(); }
-    [[nodiscard]] size_type size() const { return entries_.size(); }
+    void clear() noexcept {
+        slots_.clear();
+        live_ = 0;
+        first_ = 0;
+    }
 
-    void clear() {
-        entries_.clear();
-        index_.clear();
-        validate_invariants("ordered_map::clear");
+    static constexpr uint32_t moved_out = UINT32_MAX;
+
+private:
+    static constexpr size_type min_compaction = 16;
+
+    std::vector<slot_type> slots_;
+    size_type live_ = 0;
+    size_type first_ = 0;
+};
+
+// Open-addressing index over ordered_slots. Buckets hold a 32-bit slot number
+// and 32 bits of the key's hash, never the key itself, so keys are stored once
+// and growing or copying the index never rehashes a key. Linear probing with
+// backward-shift deletion keeps the table free of tombstones.
+class ordered_index {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    ordered_index() = default;
+    ordered_index(const ordered_index&) = default;
+    ordered_index& operator=(const ordered_index&) = default;
+
+    ordered_index(ordered_index&& other) noexcept
+        : buckets_(std::move(other.buckets_)), count_(other.count_) {
+        other.clear();
     }
 
-    iterator find(const K& key) {
-        validate_invariants("ordered_map::find");
-        const auto pos = index_.find(key);
-        if (pos == index_.end()) {
-            return entries_.end();
+    ordered_index& operator=(ordered_index&& other) noexcept {
+        if (this != &other) {
+            buckets_ = std::move(other.buckets_);
+            count_ = other.count_;
+            other.clear();
         }
-        return entries_.begin() + static_cast<typename storage_type::difference_type>(pos->second);
+        return *this;
     }
 
-    const_iterator find(const K& key) const {
-        validate_invariants("ordered_map::find const");
-        const auto pos = index_.find(key);
-        if (pos == index_.end()) {
-            return entries_.end();
-        }
-        return entries_.begin() + static_cast<typename storage_type::difference_type>(pos->second);
+    // Spreads weak hashes (std::hash<int> is the identity) across the bits
+    // used for bucket selection.
+    template <typename Key>
+    static uint32_t hash_of(const Key& key) {
+        const uint64_t raw = static_cast<uint64_t>(std::hash<Key>{}(key));
+        return static_cast<uint32_t>((raw * 0x9E3779B97F4A7C15ull) >> 32);
     }
 
-    [[nodiscard]] size_type count(const K& key) const {
-        validate_invariants("ordered_map::count");
-        return index_.count(key);
+    [[nodiscard]] std::size_t size() const { return count_; }
+
+    // Slot whose stored hash equals `hash` and for which `matches(slot)` holds.
+    template <typename Matches>
+    uint32_t find(uint32_t hash, Matches&& matches) const {
+        const std::size_t bucket = find_bucket(hash, matches);
+        return bucket == missing ? npos : buckets_[bucket].slot;
     }
 
-    V& operator[](const K& key) {
-        validate_invariants("ordered_map::operator[] pre");
-        const auto pos = index_.find(key);
-        if (pos != index_.end()) {
-            return entries_[pos->second].second;
+    // Records a key known to be absent.
+    void insert(uint32_t hash, uint32_t slot) {
+        if ((count_ + 1) * 4 > buckets_.size() * 3) {
+            grow();
         }
-
-        const auto newIndex = entries_.size();
-        entries_.push_back(value_type{key, V{}});
-        try {
-            index_.emplace(entries_.back().first, newIndex);
-        } catch (...) {
-            entries_.pop_back();
-            throw;
+        place(Bucket{slot, hash});
+        ++count_;
+    }
+
+    template <typename Matches>
+    uint32_t erase(uint32_t hash, Matches&& matches) {
+        std::size_t hole = find_bucket(hash, matches);
+        if (hole == missing) return npos;
+        const uint32_t slot = buckets_[hole].slot;
+        const std::size_t mask = buckets_.size() - 1;
+        for (std::size_t next = (hole + 1) & mask; buckets_[next].slot != npos; next = (next + 1) & mask) {
+            const std::size_t home = buckets_[next].hash & mask;
+            // Shift back any entry whose probe run passes through the hole.
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                buckets_[hole] = buckets_[next];
+                hole = next;
+            }
         }
-        validate_invariants("ordered_map::operator[] post");
-        return entries_.back().second;
+        buckets_[hole].slot = npos;
+        --count_;
+        return slot;
     }
 
-    void insert_or_assign(const K& key, const V& value) {
-        validate_invariants("ordered_map::insert_or_assign pre");
-        const auto pos = index_.find(key);
-        if (pos != index_.end()) {
-            entries_[pos->second].second = value;
-            validate_invariants("ordered_map::insert_or_assign update");
-            return;
+    // Rewrites slot numbers after ordered_slots::compact.
+    void remap(const std::vector<uint32_t>& moved) {
+        for (Bucket& bucket : buckets_) {
+            if (bucket.slot != npos) bucket.slot = moved[bucket.slot];
         }
+    }
 
-        const auto newIndex = entries_.size();
-        entries_.push_back(value_type{key, value});
-        try {
-            index_.emplace(entries_.back().first, newIndex);
-        } catch (...) {
-            entries_.pop_back();
-            throw;
-        }
-        validate_invariants("ordered_map::insert_or_assign insert");
+    void clear() noexcept {
+        buckets_.clear();
+        count_ = 0;
     }
 
-    size_type erase(const K& key) {
-        validate_invariants("ordered_map::erase pre");
-        const auto pos = index_.find(key);
-        if (pos == index_.end()) {
-            return 0;
+    // Calls `visit(slot, hash)` for every indexed entry.
+    template <typename Visit>
+    void for_each(Visit&& visit) const {
+        for (const Bucket& bucket : buckets_) {
+            if (bucket.slot != npos) visit(bucket.slot, bucket.hash);
         }
+    }
+
+private:
+    struct Bucket {
+        uint32_t slot;
+        uint32_t hash;
+    };
 
-        const auto index = pos->second;
-        index_.erase(pos);
-        entries_.erase(entries_.begin() + static_cast<typename storage_type::difference_type>(index));
-        for (size_type current = index; current < entries_.size(); ++current) {
-            index_[entries_[current].first] = current;
+    static constexpr std::size_t missing = SIZE_MAX;
+
+    template <typename Matches>
+    std::size_t find_bucket(uint32_t hash, Matches& matches) const {
+        if (buckets_.empty()) return missing;
+        const std::size_t mask = buckets_.size() - 1;
+        for (std::size_t bucket = hash & mask;; bucket = (bucket + 1) & mask) {
+            const Bucket& candidate = buckets_[bucket];
+            if (candidate.slot == npos) return missing;
+            if (candidate.hash == hash && matches(candidate.slot)) return bucket;
         }
-        validate_invariants("ordered_map::erase post");
-        return 1;
     }
 
-    void validate_invariants(const char* context = "ordered_map") const {
-#if defined(DOOF_RUNTIME_VALIDATE_ORDERED_COLLECTIONS)
-        if (index_.size() != entries_.size()) {
-            panic_ordered_collection_invariant("ordered_map", context, "index size does not match entry count");
-        }
-        for (size_type index = 0; index < entries_.size(); ++index) {
-            const auto pos = index_.find(entries_[index].first);
-            if (pos == index_.end()) {
-                panic_ordered_collection_invariant("ordered_map", context, "entry key missing from index");
-            }
-            if (pos->second != index) {
-                panic_ordered_collection_invariant("ordered_map", context, "entry key mapped to stale position");
-            }
-        }
-        for (const auto& [key, index] : index_) {
-            if (index >= entries_.size()) {
-                panic_ordered_collection_invariant("ordered_map", context, "index points past end of entries");
-            }
-            if (!(entries_[index].first == key)) {
-                panic_ordered_collection_invariant("ordered_map", context, "index points at mismatched entry key");
-            }
+    void place(Bucket entry) {
+        const std::size_t mask = buckets_.size() - 1;
+        std::size_t bucket = entry.hash & mask;
+        while (buckets_[bucket].slot != npos) {
+            bucket = (bucket + 1) & mask;
         }
-#else
-        (void)context;
-#endif
+        buckets_[bucket] = entry;
     }
 
-private:
-    void rebuild_index() {
-        index_.clear();
-        for (size_type index = 0; index < entries_.size(); ++index) {
-            index_[entries_[index].first] = index;
+    void grow() {
+        std::vector<Bucket> previous(buckets_.empty() ? 8 : buckets_.size() * 2, Bucket{npos, 0});
+        previous.swap(buckets_);
+        for (const Bucket& bucket : previous) {
+            if (bucket.slot != npos) place(bucket);
         }
     }
 
-    storage_type entries_;
-    std::unordered_map<K, size_type> index_;
+    std::vector<Bucket> buckets_;
+    std::size_t count_ = 0;
 };
 
-template <typename K, typename V>
-ordered_map(std::initializer_list<std::pair<K, V>>) -> ordered_map<K, V>;
-
-template <typename T>
-class ordered_set {
+// Insertion-ordered hash table behind ordered_map and ordered_set: the dense
+// slots own every value and the index finds a key's slot.
+template <typename Key, typename Value, typename KeyOf>
+class ordered_table {
 public:
-    using value_type = T;
-    using storage_type = std::vector<T>;
+    using storage_type = ordered_slots<Value>;
     using iterator = typename storage_type::iterator;
     using const_iterator = typename storage_type::const_iterator;
     using size_type = typename storage_type::size_type;
 
-    ordered_set() = default;
+    iterator begin() { return slots_.begin(); }
+    iterator end() { return slots_.end(); }
+    const_iterator begin() const { return slots_.begin(); }
+    const_iterator end() const { return slots_.end(); }
 
-    ordered_set(std::initializer_list<T> init) {
-        for (const auto& value : init) {
-            insert(value);
-        }
-        validate_invariants("ordered_set::initializer_list");
+    [[nodiscard]] size_type size() const { return slots_.size(); }
+
+    iterator find(const Key& key) {
+        const uint32_t slot = find_slot(ordered_index::hash_of(key), key);
+        return slot == ordered_index::npos ? slots_.end() : slots_.at_slot(slot);
     }
 
-    ordered_set(const ordered_set& other)
-        : values_(other.values_) {
-        rebuild_index();
-        validate_invariants("ordered_set::copy_ctor");
+    const_iterator find(const Key& key) const {
+        const uint32_t slot = find_slot(ordered_index::hash_of(key), key);
+        return slot == ordered_index::npos ? slots_.end() : slots_.at_slot(slot);
     }
 
-    ordered_set& operator=(const ordered_set& other) {
+    [[nodiscard]] bool contains(const Key& key) const {
+        return find_slot(ordered_index::hash_of(key), key) != ordered_index::npos;
+    }
+
+    // Returns the value stored under `key`, appending `make()` when absent.
+    template <typename Make>
+    std::pair<Value*, bool> find_or_append(const Key& key, Make&& make) {
+        const uint32_t hash = ordered_index::hash_of(key);
+        const uint32_t slot = find_slot(hash, key);
+        if (slot != ordered_index::npos) {
+            return {&slots_[slot], false};
+        }
+        if (slots_.slot_count() >= max_slots) {
+            panic("ordered collection exceeds its maximum entry count");
+        }
+        const size_type appended = slots_.push_back(make());
+        try {
+            index_.insert(hash, static_cast<uint32_t>(appended));
+        } catch (...) {
+            slots_.erase(appended);
+            throw;
+        }
+        return {&slots_[appended], true};
+    }
+
+    size_type erase(const Key& key) {
+        const uint32_t slot = index_.erase(ordered_index::hash_of(key), matcher(key));
+        if (slot == ordered_index::npos) {
+            return 0;
+        }
+        slots_.erase(slot);
+        if (slots_.wants_compaction()) {
+            index_.remap(slots_.compact());
+        }
+        return 1;
+    }
+
+    void clear() noexcept {
+        slots_.clear();
+        index_.clear();
+    }
+
+    void validate(const char* collection, const char* context) const {
+        if (index_.size() != slots_.size()) {
+            panic_ordered_collection_invariant(collection, context, "index size does not match entry count");
+        }
+        size_type live = 0;
+        for (size_type slot = 0; slot < slots_.slot_count(); ++slot) {
+            if (!slots_.live(slot)) {
+                continue;
+            }
+            if (slot < slots_.first_slot()) {
+                panic_ordered_collection_invariant(collection, context, "live entry before first slot");
+            }
+            ++live;
+            const Key& key = KeyOf{}(slots_[slot]);
+            const uint32_t found = find_slot(ordered_index::hash_of(key), key);
+            if (found == ordered_index::npos) {
+                panic_ordered_collection_invariant(collection, context, "entry key missing from index");
+            }
+            if (found != slot) {
+                panic_ordered_collection_invariant(collection, context, "entry key mapped to stale position");
+            }
+        }
+        if (live != slots_.size()) {
+            panic_ordered_collection_invariant(collection, context, "live entry count does not match size");
+        }
+        index_.for_each([&](uint32_t slot, uint32_t hash) {
+            if (slot >= slots_.slot_count()) {
+                panic_ordered_collection_invariant(collection, context, "index points past end of entries");
+            }
+            if (!slots_.live(slot)) {
+                panic_ordered_collection_invariant(collection, context, "index points at erased entry");
+            }
+            if (ordered_index::hash_of(KeyOf{}(slots_[slot])) != hash) {
+                panic_ordered_collection_invariant(collection, context, "index points at mismatched entry key");
+            }
+        });
+    }
+
+private:
+    static constexpr size_type max_slots = ordered_index::npos - 1;
+
+    auto matcher(const Key& key) const {
+        return [this, &key](uint32_t slot) { return KeyOf{}(slots_[slot]) == key; };
+    }
+
+    uint32_t find_slot(uint32_t hash, const Key& key) const {
+        return index_.find(hash, matcher(key));
+    }
+
+    storage_type slots_;
+    ordered_index index_;
+};
+
+struct ordered_map_key {
+    template <typename K, typename V>
+    const K& operator()(const std::pair<K, V>& entry) const { return entry.first; }
+};
+
+struct ordered_set_key {
+    template <typename T>
+    const T& operator()(const T& value) const { return value; }
+};
+
+} // namespace detail
+
+template <typename K, typename V>
+class ordered_map {
+public:
+    using value_type = std::pair<K, V>;
+    using storage_type = detail::ordered_table<K, value_type, detail::ordered_map_key>;
+    using iterator = typename storage_type::iterator;
+    using const_iterator = typename storage_type::const_iterator;
+    using size_type = typename storage_type::size_type;
+
+    ordered_map() = default;
+
+    ordered_map(std::initializer_list<value_type> init) {
+        for (const auto& entry : init) {
+            insert_or_assign(entry.first, entry.second);
+        }
+        validate_invariants("ordered_map::initializer_list");
+    }
+
+    // Copies keep the source's slot layout, so the index is copied rather
+    // than rebuilt.
+    ordered_map(const ordered_map& other)
+        : entries_(other.entries_) {
+        validate_invariants("ordered_map::copy_ctor");
+    }
+
+    ordered_map& operator=(const ordered_map& other) {
         if (this != &other) {
-            values_ = other.values_;
-            rebuild_index();
-            validate_invariants("ordered_set::copy_assign");
+            entries_ = other.entries_;
+            validate_invariants("ordered_map::copy_assign");
         }
         return *this;
     }
 
-    ordered_set(ordered_set&&) = default;
-    ordered_set& operator=(ordered_set&&) = default;
+    ordered_map(ordered_map&&) = default;
+    ordered_map& operator=(ordered_map&&) = default;
 
     iterator begin() {
-        validate_invariants("ordered_set::begin");
-        return values_.begin();
+        validate_invariants("ordered_map::begin");
+        return entries_.begin();
     }
     iterator end() {
-        validate_invariants("ordered_set::end");
-        return values_.end();
+        validate_invariants("ordered_map::end");
+        return entries_.end();
+    }
+    const_iterator begin() const {
+        validate_invariants("ordered_map::begin const");
+        return entries_.begin();
+    }
+    const_iterator end() const {
+        validate_invariants("ordered_map::end const");
+        return entries_.end();
+    }
+    const_iterator cbegin() const {
+        validate_invariants("ordered_map::cbegin");
+        return entries_.begin();
+    }
+    const_iterator cend() const {
+        validate_invariants("ordered_map::cend");
+        return entries_.end();
+    }
+
+    [[nodiscard]] bool empty() const { return entries_.size() == 0; }
+    [[nodiscard]] size_type size() const { return entries_.size(); }
+
+    void clear() {
+        entries_.clear();
+        validate_invariants("ordered_map::clear");
+    }
+
+    iterator find(const K& key) {
+        validate_invariants("ordered_map::find");
+        return entries_.find(key);
+    }
+
+    const_iterator find(const K& key) const {
+        validate_invariants("ordered_map::find const");
+        return entries_.find(key);
+    }
+
+    [[nodiscard]] size_type count(const K& key) const {
+        validate_invariants("ordered_map::count");
+        return entries_.contains(key) ? 1 : 0;
+    }
+
+    V& operator[](const K& key) {
+        validate_invariants("ordered_map::operator[] pre");
+        auto [entry, inserted] = entries_.find_or_append(key, [&] { return value_type{key, V{}}; });
+        if (inserted) {
+            validate_invariants("ordered_map::operator[] post");
+        }
+        return entry->second;
+    }
+
+    void insert_or_assign(const K& key, const V& value) {
+        validate_invariants("ordered_map::insert_or_assign pre");
+        auto [entry, inserted] = entries_.find_or_append(key, [&] { return value_type{key, value}; });
+        if (!inserted) {
+            entry->second = value;
+            validate_invariants("ordered_map::insert_or_assign update");
+            return;
+        }
+        validate_invariants("ordered_map::insert_or_assign insert");
+    }
+
+    // Amortized O(1): the entry becomes a tombstone until the next compaction.
+    // Like insertion, erasing may invalidate iterators.
+    size_type erase(const K& key) {
+        validate_invariants("ordered_map::erase pre");
+        const size_type erased = entries_.erase(key);
+        validate_invariants("ordered_map::erase post");
+        return erased;
+    }
+
+    void validate_invariants(const char* context = "ordered_map") const {
+#if defined(DOOF_RUNTIME_VALIDATE_ORDERED_COLLECTIONS)
+        entries_.validate("ordered_map", context);
+#else
+        (void)context;
+#endif
+    }
+
+private:
+    storage_type entries_;
+};
+
+template <typename K, typename V>
+ordered_map(std::initializer_list<std::pair<K, V>>) -> ordered_map<K, V>;
+
+template <typename T>
+class ordered_set {
+public:
+    using value_type = T;
+    using storage_type = detail::ordered_table<T, T, detail::ordered_set_key>;
+    using iterator = typename storage_type::const_iterator;
+    using const_iterator = typename storage_type::const_iterator;
+    using size_type = typename storage_type::size_type;
+
+    ordered_set() = default;
+
+    ordered_set(std::initializer_list<T> init) {
+        for (const auto& value : init) {
+            insert(value);
+        }
+        validate_invariants("ordered_set::initializer_list");
+    }
+
+    ordered_set(const ordered_set& other)
+        : values_(other.values_) {
+        validate_invariants("ordered_set::copy_ctor");
+    }
+
+    ordered_set& operator=(const ordered_set& other) {
+        if (this != &other) {
+            values_ = other.values_;
+            validate_invariants("ordered_set::copy_assign");
+        }
+        return *this;
     }
+
+    ordered_set(ordered_set&&) = default;
+    ordered_set& operator=(ordered_set&&) = default;
+
     const_iterator begin() const {
         validate_invariants("ordered_set::begin const");
         return values_.begin();
@@ -632,111 +2008,59 @@ public:
     }
     const_iterator cbegin() const {
         validate_invariants("ordered_set::cbegin");
-        return values_.cbegin();
+        return values_.begin();
     }
     const_iterator cend() const {
         validate_invariants("ordered_set::cend");
-        return values_.cend();
+        return values_.end();
     }
 
-    [[nodiscard]] bool empty() const { return values_.empty(); }
+    [[nodiscard]] bool empty() const { return values_.size() == 0; }
     [[nodiscard]] size_type size() const { return values_.size(); }
 
     void clear() {
         values_.clear();
-        index_.clear();
         validate_invariants("ordered_set::clear");
     }
 
-    iterator find(const T& value) {
-        validate_invariants("ordered_set::find");
-        const auto pos = index_.find(value);
-        if (pos == index_.end()) {
-            return values_.end();
-        }
-        return values_.begin() + static_cast<typename storage_type::difference_type>(pos->second);
-    }
-
     const_iterator find(const T& value) const {
         validate_invariants("ordered_set::find const");
-        const auto pos = index_.find(value);
-        if (pos == index_.end()) {
-            return values_.end();
-        }
-        return values_.begin() + static_cast<typename storage_type::difference_type>(pos->second);
+        return values_.find(value);
     }
 
     [[nodiscard]] size_type count(const T& value) const {
         validate_invariants("ordered_set::count");
-        return index_.count(value);
+        return values_.contains(value) ? 1 : 0;
     }
 
     bool insert(const T& value) {
         validate_invariants("ordered_set::insert pre");
-        if (index_.count(value) > 0) {
-            return false;
+        const bool inserted = values_.find_or_append(value, [&] { return value; }).second;
+        if (inserted) {
+            validate_invariants("ordered_set::insert post");
         }
-
-        index_[value] = values_.size();
-        values_.push_back(value);
-        validate_invariants("ordered_set::insert post");
-        return true;
+        return inserted;
     }
 
+    // Amortized O(1): the value becomes a tombstone until the next compaction.
+    // Like insertion, erasing may invalidate iterators.
     size_type erase(const T& value) {
         validate_invariants("ordered_set::erase pre");
-        const auto pos = index_.find(value);
-        if (pos == index_.end()) {
-            return 0;
-        }
-
-        const auto index = pos->second;
-        index_.erase(pos);
-        values_.erase(values_.begin() + static_cast<typename storage_type::difference_type>(index));
-        for (size_type current = index; current < values_.size(); ++current) {
-            index_[values_[current]] = current;
-        }
+        const size_type erased = values_.erase(value);
         validate_invariants("ordered_set::erase post");
-        return 1;
+        return erased;
     }
 
     void validate_invariants(const char* context = "ordered_set") const {
 #if defined(DOOF_RUNTIME_VALIDATE_ORDERED_COLLECTIONS)
-        if (index_.size() != values_.size()) {
-            panic_ordered_collection_invariant("ordered_set", context, "index size does not match value count");
-        }
-        for (size_type index = 0; index < values_.size(); ++index) {
-            const auto pos = index_.find(values_[index]);
-            if (pos == index_.end()) {
-                panic_ordered_collection_invariant("ordered_set", context, "value missing from index");
-            }
-            if (pos->second != index) {
-                panic_ordered_collection_invariant("ordered_set", context, "value mapped to stale position");
-            }
-        }
-        for (const auto& [value, index] : index_) {
-            if (index >= values_.size()) {
-                panic_ordered_collection_invariant("ordered_set", context, "index points past end of values");
-            }
-            if (!(values_[index] == value)) {
-                panic_ordered_collection_invariant("ordered_set", context, "index points at mismatched value");
-            }
-        }
+        values_.validate("ordered_set", context);
 #else
         (void)context;
 #endif
     }
 
 private:
-    void rebuild_index() {
-        index_.clear();
-        for (size_type index = 0; index < values_.size(); ++index) {
-            index_[values_[index]] = index;
-        }
-    }
-
     storage_type values_;
-    std::unordered_map<T, size_type> index_;
 };
 
 template <typename T>
@@ -751,21 +2075,45 @@ template <> struct Success<void> {};
 template <typename E> struct Failure { E error; };
 template <> struct Failure<void> {};
 
+// Success is always alternative 0, and a two-alternative variant stores a
+// one-byte index, so the checks below compare a single byte.
 template <typename T, typename E>
 using Result = std::variant<Success<T>, Failure<E>>;
 
+namespace detail {
+
+// Generated code reads an arm only after checking it, so release builds skip
+// std::get's bad_variant_access path. Debug builds keep the checked access.
+template <size_t Index, typename Variant>
+inline auto& result_arm(Variant& result) {
+#if defined(NDEBUG)
+    return *std::get_if<Index>(&result);
+#else
+    return std::get<Index>(result);
+#endif
+}
+
+} // namespace detail
+
 template <typename T, typename E>
-inline bool is_success(const Result<T, E>& result) { return std::holds_alternative<Success<T>>(result); }
+inline bool is_success(const Result<T, E>& result) { return result.index() == 0; }
 template <typename T, typename E>
-inline bool is_failure(const Result<T, E>& result) { return std::holds_alternative<Failure<E>>(result); }
+inline bool is_failure(const Result<T, E>& result) { return result.index() != 0; }
 template <typename T, typename E>
-inline T& success_value(Result<T, E>& result) { return std::get<Success<T>>(result).value; }
+inline T& success_value(Result<T, E>& result) { return detail::result_arm<0>(result).value; }
 template <typename T, typename E>
-inline const T& success_value(const Result<T, E>& result) { return std::get<Success<T>>(result).value; }
+inline const T& success_value(const Result<T, E>& result) { return detail::result_arm<0>(result).value; }
 template <typename T, typename E>
-inline E& failure_error(Result<T, E>& result) { return std::get<Failure<E>>(result).error; }
+inline E& failure_error(Result<T, E>& result) { return detail::result_arm<1>(result).error; }
 template <typename T, typename E>
-inline const E& failure_error(const Result<T, E>& result) { return std::get<Failure<E>>(result).error; }
+inline const E& failure_error(const Result<T, E>& result) { return detail::result_arm<1>(result).error; }
+
+// Builds the failure arm a `try` returns to its caller. Kept out of line so
+// the propagation path stays off the hot path of the enclosing function.
+template <typename Arm, typename E>
+DOOF_COLD Arm propagate_failure(E& error) { return Arm{std::move(error)}; }
+template <typename Arm>
+DOOF_COLD Arm propagate_failure() { return Arm{}; }
 
 template <typename T>
 struct StreamBase {
@@ -875,45 +2223,288 @@ inline std::optional<ParseError> ParseError_fromValue(int32_t value) {
 }
 
 // ============================================================================
-// JsonValue — first-class JSON runtime value
+// Shared immutable strings
 // ============================================================================
 
-struct JsonValue;
+/**
+ * Immutable string whose copies and substrings are O(1).
+ *
+ * Text of up to `inline_capacity` bytes is stored inline; longer text lives in
+ * a single refcounted heap block that copies and `substr` views share, so
+ * fanning a readonly string out into arrays, maps or callbacks never copies
+ * the characters. A view keeps its whole parent block alive — call `compact()`
+ * before storing a small slice of a large buffer long-term.
+ *
+ * It converts implicitly to and from std::string, so runtime helpers and
+ * native code written against std::string keep working, at the cost of a copy.
+ */
+class SharedString {
+public:
+    static constexpr size_t inline_capacity = 23;
 
-using JsonArray = std::shared_ptr<std::vector<JsonValue>>;
-using JsonObject = std::shared_ptr<ordered_map<std::string, JsonValue>>;
-using JsonStorage = std::variant<std::monostate, bool, int32_t, int64_t, float, double, std::string, JsonArray, JsonObject>;
+    SharedString() noexcept { set_inline(std::string_view()); }
 
-struct JsonValue : JsonStorage {
-    using JsonStorage::JsonStorage;
+    SharedString(std::string_view text) {
+        if (text.size() <= inline_capacity) {
+            set_inline(text);
+            return;
+        }
+        Block* block = Block::allocate(text.size());
+        std::copy_n(text.data(), text.size(), block->chars());
+        heap_ = Heap{block, block->chars(), text.size()};
+        tag_ = heap_tag;
+    }
 
-    JsonValue() : JsonStorage(std::monostate{}) {}
-    JsonValue(std::nullptr_t) : JsonStorage(std::monostate{}) {}
-    JsonValue(const char* v) : JsonStorage(std::string(v)) {}
-};
+    SharedString(const std::string& text) : SharedString(std::string_view(text)) {}
+    SharedString(const char* text) : SharedString(std::string_view(text)) {}
 
-template <typename T>
-inline JsonValue json_value(T&& value) {
-    return JsonValue(std::forward<T>(value));
-}
+    SharedString(const SharedString& other) noexcept { copy_from(other); }
 
-inline const JsonStorage& json_storage(const JsonValue& value) {
-    return static_cast<const JsonStorage&>(value);
-}
+    SharedString(SharedString&& other) noexcept {
+        copy_bytes(other);
+        other.set_inline(std::string_view());
+    }
 
-inline JsonStorage& json_storage(JsonValue& value) {
-    return static_cast<JsonStorage&>(value);
-}
+    SharedString& operator=(const SharedString& other) noexcept {
+        if (this != &other) {
+            release();
+            copy_from(other);
+        }
+        return *this;
+    }
 
-inline bool json_is_null(const JsonValue& value) {
-    return std::holds_alternative<std::monostate>(json_storage(value));
-}
+    SharedString& operator=(SharedString&& other) noexcept {
+        if (this != &other) {
+            release();
+            copy_bytes(other);
+            other.set_inline(std::string_view());
+        }
+        return *this;
+    }
 
-inline bool json_is_boolean(const JsonValue& value) {
-    return std::holds_alternative<bool>(json_storage(value));
-}
+    ~SharedString() { release(); }
 
-inline bool json_is_number(const JsonValue& value) {
+    const char* data() const noexcept { return is_heap() ? heap_.data : small_; }
+    size_t size() const noexcept { return is_heap() ? heap_.size : tag_; }
+    size_t length() const noexcept { return size(); }
+    bool empty() const noexcept { return size() == 0; }
+    char operator[](size_t index) const noexcept { return data()[index]; }
+    const char* begin() const noexcept { return data(); }
+    const char* end() const noexcept { return data() + size(); }
+
+    std::string_view view() const noexcept { return std::string_view(data(), size()); }
+    operator std::string_view() const noexcept { return view(); }
+    operator std::string() const { return str(); }
+    std::string str() const { return std::string(data(), size()); }
+
+    /** True when the text lives in a heap block shared with other copies. */
+    bool is_shared() const noexcept {
+        return is_heap() && heap_.block->refs.load(std::memory_order_acquire) > 1;
+    }
+
+    /** Substring view of `count` bytes from `pos`, clamped like std::string_view::substr. */
+    SharedString substr(size_t pos, size_t count = std::string_view::npos) const {
+        const size_t length = size();
+        if (pos > length) pos = length;
+        if (count > length - pos) count = length - pos;
+        if (!is_heap() || count <= inline_capacity) {
+            return SharedString(std::string_view(data() + pos, count));
+        }
+        SharedString result(*this);
+        result.heap_.data += pos;
+        result.heap_.size = count;
+        return result;
+    }
+
+    /** Copy of this text in its own storage, releasing any larger parent block. */
+    SharedString compact() const {
+        if (!is_heap() || heap_.size == heap_.block->size) return *this;
+        return SharedString(view());
+    }
+
+    /** `a` followed by `b`, written once into the result's storage. */
+    static SharedString concat(std::string_view a, std::string_view b) {
+        const size_t size = a.size() + b.size();
+        SharedString result;
+        char* out;
+        if (size <= inline_capacity) {
+            out = result.small_;
+            result.tag_ = static_cast<unsigned char>(size);
+            result.small_[size] = 0;
+        } else {
+            Block* block = Block::allocate(size);
+            out = block->chars();
+            result.heap_ = Heap{block, out, size};
+            result.tag_ = heap_tag;
+        }
+        std::copy_n(b.data(), b.size(), std::copy_n(a.data(), a.size(), out));
+        return result;
+    }
+
+    SharedString& operator+=(std::string_view other) { return *this = concat(view(), other); }
+
+    friend bool operator==(const SharedString& a, const SharedString& b) noexcept {
+        if (a.is_heap() && b.is_heap() && a.heap_.data == b.heap_.data) return a.heap_.size == b.heap_.size;
+        return a.view() == b.view();
+    }
+    friend bool operator!=(const SharedString& a, const SharedString& b) noexcept { return !(a == b); }
+    friend bool operator<(const SharedString& a, const SharedString& b) noexcept { return a.view() < b.view(); }
+    friend bool operator>(const SharedString& a, const SharedString& b) noexcept { return a.view() > b.view(); }
+    friend bool operator<=(const SharedString& a, const SharedString& b) noexcept { return a.view() <= b.view(); }
+    friend bool operator>=(const SharedString& a, const SharedString& b) noexcept { return a.view() >= b.view(); }
+
+    friend SharedString operator+(const SharedString& a, const SharedString& b) { return concat(a.view(), b.view()); }
+
+    friend std::ostream& operator<<(std::ostream& os, const SharedString& s) { return os << s.view(); }
+
+private:
+    struct Block {
+        std::atomic<size_t> refs;
+        size_t size;
+
+        char* chars() noexcept { return reinterpret_cast<char*>(this + 1); }
+
+        static Block* allocate(size_t size) {
+            void* memory = ::operator new(sizeof(Block) + size);
+            return new (memory) Block{{1}, size};
+        }
+    };
+
+    struct Heap {
+        Block* block;
+        const char* data;
+        size_t size;
+    };
+
+    static constexpr unsigned char heap_tag = 0xFF;
+
+    bool is_heap() const noexcept { return tag_ == heap_tag; }
+
+    void set_inline(std::string_view text) noexcept {
+        std::copy_n(text.data(), text.size(), small_);
+        small_[text.size()] = 0;
+        tag_ = static_cast<unsigned char>(text.size());
+    }
+
+    void copy_bytes(const SharedString& other) noexcept {
+        if (other.is_heap()) {
+            heap_ = other.heap_;
+        } else {
+            std::copy_n(other.small_, sizeof(small_), small_);
+        }
+        tag_ = other.tag_;
+    }
+
+    void copy_from(const SharedString& other) noexcept {
+        copy_bytes(other);
+        if (is_heap()) heap_.block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept {
+        if (!is_heap()) return;
+        if (heap_.block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            heap_.block->~Block();
+            ::operator delete(heap_.block);
+        }
+    }
+
+    union {
+        Heap heap_;
+        char small_[inline_capacity + 1];
+    };
+    unsigned char tag_;
+};
+
+// Mixed comparisons and concatenation.  Both operands are deduced so the
+// SharedString side must match exactly: neither std::string nor a literal
+// converts either way, and std::string_view comparisons stay unambiguous.
+template <typename S, typename T>
+using enable_if_shared_text_t = std::enable_if_t<
+    std::is_same_v<S, SharedString> && !std::is_same_v<std::decay_t<T>, SharedString> &&
+    std::is_convertible_v<const T&, std::string_view>, int>;
+
+template <typename S, typename T, enable_if_shared_text_t<S, T> = 0>
+inline bool operator==(const S& a, const T& b) { return a.view() == std::string_view(b); }
+template <typename T, typename S, enable_if_shared_text_t<S, T> = 0>
+inline bool operator==(const T& a, const S& b) { return std::string_view(a) == b.view(); }
+template <typename S, typename T, enable_if_shared_text_t<S, T> = 0>
+inline bool operator!=(const S& a, const T& b) { return a.view() != std::string_view(b); }
+template <typename T, typename S, enable_if_shared_text_t<S, T> = 0>
+inline bool operator!=(const T& a, const S& b) { return std::string_view(a) != b.view(); }
+template <typename S, typename T, enable_if_shared_text_t<S, T> = 0>
+inline bool operator<(const S& a, const T& b) { return a.view() < std::string_view(b); }
+template <typename T, typename S, enable_if_shared_text_t<S, T> = 0>
+inline bool operator<(const T& a, const S& b) { return std::string_view(a) < b.view(); }
+template <typename S, typename T, enable_if_shared_text_t<S, T> = 0>
+inline SharedString operator+(const S& a, const T& b) { return SharedString::concat(a.view(), b); }
+template <typename T, typename S, enable_if_shared_text_t<S, T> = 0>
+inline SharedString operator+(const T& a, const S& b) { return SharedString::concat(a, b.view()); }
+
+// The representation emitted code uses for Doof `string`: std::string by
+// default, SharedString when the package's doof.json selects
+// `"strings": "shared"` (which defines DOOF_SHARED_STRINGS).
+#if defined(DOOF_SHARED_STRINGS)
+using string = SharedString;
+#else
+using string = std::string;
+#endif
+
+} // namespace doof
+
+namespace std {
+template <>
+struct hash<doof::SharedString> {
+    size_t operator()(const doof::SharedString& s) const noexcept {
+        return hash<string_view>{}(s.view());
+    }
+};
+} // namespace std
+
+namespace doof {
+
+// ============================================================================
+// JsonValue — first-class JSON runtime value
+// ============================================================================
+
+struct JsonValue;
+struct JsonNode;
+
+using JsonArray = std::shared_ptr<std::vector<JsonValue>>;
+using JsonObject = std::shared_ptr<ordered_map<string, JsonValue>>;
+using JsonStorage = std::variant<std::monostate, bool, int32_t, int64_t, float, double, string, JsonArray, JsonObject>;
+
+struct JsonValue : JsonStorage {
+    using JsonStorage::JsonStorage;
+
+    JsonValue() : JsonStorage(std::monostate{}) {}
+    JsonValue(std::nullptr_t) : JsonStorage(std::monostate{}) {}
+    JsonValue(const char* v) : JsonStorage(string(v)) {}
+    // Copies a JsonDocument subtree out into an owning value (defined with JsonDocument).
+    explicit JsonValue(const JsonNode& node);
+};
+
+template <typename T>
+inline JsonValue json_value(T&& value) {
+    return JsonValue(std::forward<T>(value));
+}
+
+inline const JsonStorage& json_storage(const JsonValue& value) {
+    return static_cast<const JsonStorage&>(value);
+}
+
+inline JsonStorage& json_storage(JsonValue& value) {
+    return static_cast<JsonStorage&>(value);
+}
+
+inline bool json_is_null(const JsonValue& value) {
+    return std::holds_alternative<std::monostate>(json_storage(value));
+}
+
+inline bool json_is_boolean(const JsonValue& value) {
+    return std::holds_alternative<bool>(json_storage(value));
+}
+
+inline bool json_is_number(const JsonValue& value) {
     return std::holds_alternative<int32_t>(json_storage(value))
         || std::holds_alternative<int64_t>(json_storage(value))
         || std::holds_alternative<float>(json_storage(value))
@@ -921,7 +2512,7 @@ inline bool json_is_number(const JsonValue& value) {
 }
 
 inline bool json_is_string(const JsonValue& value) {
-    return std::holds_alternative<std::string>(json_storage(value));
+    return std::holds_alternative<string>(json_storage(value));
 }
 
 inline bool json_is_array(const JsonValue& value) {
@@ -955,7 +2546,7 @@ inline const JsonObject::element_type* json_as_object(const JsonValue& value) {
 }
 
 inline JsonValue json_error(int32_t code, std::string message) {
-    auto object = std::make_shared<ordered_map<std::string, JsonValue>>();
+    auto object = std::make_shared<ordered_map<string, JsonValue>>();
     (*object)["code"] = json_value(code);
     (*object)["message"] = json_value(std::move(message));
     return json_value(std::move(object));
@@ -999,8 +2590,8 @@ inline double json_as_double(const JsonValue& value) {
     panic("Expected JSON number");
 }
 
-inline const std::string& json_as_string(const JsonValue& value) {
-    const auto* result = std::get_if<std::string>(&json_storage(value));
+inline const string& json_as_string(const JsonValue& value) {
+    const auto* result = std::get_if<string>(&json_storage(value));
     if (result == nullptr) panic("Expected JSON string");
     return *result;
 }
@@ -1066,8 +2657,8 @@ inline double json_as_double_lenient(const JsonValue& value) {
     return json_as_double(value);
 }
 
-inline std::string json_as_string_lenient(const JsonValue& value) {
-    if (json_is_null(value)) return std::string();
+inline string json_as_string_lenient(const JsonValue& value) {
+    if (json_is_null(value)) return string();
     if (json_is_string(value)) return json_as_string(value);
     if (json_is_boolean(value)) return json_as_bool(value) ? "true" : "false";
     if (const auto* result = std::get_if<int32_t>(&json_storage(value))) return std::to_string(*result);
@@ -1085,898 +2676,3634 @@ inline std::string json_as_string_lenient(const JsonValue& value) {
     panic("Expected lenient JSON string");
 }
 
-
 // ============================================================================
-// String utilities
+// JsonReader — pull-based JSON tokenizer for direct text-to-struct decoding
 // ============================================================================
+//
+// Generated fromJsonText / fromJsonReader methods walk the input with this
+// reader instead of parsing into a JsonValue tree first.  Objects and arrays
+// are consumed in place; only scalar leaves (and JsonValue-typed fields) are
+// materialised, so the same json_is_* / json_as_* helpers keep the lenient
+// and strict semantics identical to fromJsonValue.
 
-// Convert any streamable value to string
-template <typename T>
-inline std::string to_string(const T& val) {
-    if constexpr (std::is_same_v<T, std::string>) {
-        return val;
-    } else if constexpr (std::is_same_v<T, const char*>) {
-        return std::string(val);
-    } else if constexpr (std::is_same_v<T, bool>) {
-        return val ? "true" : "false";
-    } else if constexpr (std::is_same_v<T, uint8_t>) {
-        return std::to_string(static_cast<uint32_t>(val));
-    } else if constexpr (std::is_same_v<T, char32_t>) {
-        // Simple ASCII conversion for now
-        std::string result;
-        result += static_cast<char>(val);
-        return result;
-    } else {
-        std::ostringstream oss;
-        oss << val;
-        return oss.str();
-    }
+namespace detail {
+
+// Vector scans for the JSON reader and writer.  16-byte SSE2 / NEON blocks
+// are baseline on x86-64 and AArch64, so these are selected at compile time;
+// DOOF_JSON_NO_SIMD forces the scalar loops (used to benchmark and test them).
+// JsonDocument's structural index, further down, works on 64-byte blocks.
+
+inline bool json_string_stop(unsigned char ch) {
+    return ch == '"' || ch == '\\' || ch < 0x20;
 }
 
-template <typename T>
-inline std::string to_string(const std::shared_ptr<std::vector<T>>& val) {
-    if (!val) return "null";
-    std::string result = "[";
-    for (size_t i = 0; i < val->size(); ++i) {
-        if (i > 0) result += ", ";
-        result += to_string((*val)[i]);
-    }
-    result += "]";
-    return result;
+inline bool json_whitespace(char ch) {
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
 }
 
-template <typename K, typename V>
-inline std::string to_string(const std::shared_ptr<ordered_map<K, V>>& val) {
-    if (!val) return "null";
-    std::string result = "{";
-    bool first = true;
-    for (const auto& entry : *val) {
-        if (!first) result += ", ";
-        first = false;
-        result += to_string(entry.first) + ": " + to_string(entry.second);
-    }
-    result += "}";
-    return result;
+#if defined(DOOF_JSON_SSE2)
+inline uint32_t json_block_string_stops(const char* block) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    const __m128i quote = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'));
+    const __m128i backslash = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'));
+    const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quote, backslash), control)));
 }
 
-template <typename T>
-inline std::string to_string(const std::shared_ptr<ordered_set<T>>& val) {
-    if (!val) return "null";
-    std::string result = "{";
-    bool first = true;
-    for (const auto& item : *val) {
-        if (!first) result += ", ";
-        first = false;
-        result += to_string(item);
-    }
-    result += "}";
-    return result;
+inline uint32_t json_block_non_whitespace(const char* block) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    const __m128i space = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))));
+    return static_cast<uint32_t>(~_mm_movemask_epi8(space)) & 0xFFFFu;
 }
 
-template <typename... Ts, std::size_t... Is>
-inline std::string tuple_to_string_impl(const std::tuple<Ts...>& val, std::index_sequence<Is...>) {
-    std::string result = "(";
-    ((result += (Is == 0 ? "" : ", ") + to_string(std::get<Is>(val))), ...);
-    result += ")";
-    return result;
+inline size_t json_block_first(uint32_t mask) {
+    return static_cast<size_t>(__builtin_ctz(mask));
+}
+#elif defined(DOOF_JSON_NEON)
+// NEON has no movemask; narrowing by 4 bits per lane gives a 64-bit mask
+// whose trailing zero count / 4 is the first matching lane.
+inline uint64_t json_neon_mask(uint8x16_t matches) {
+    const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
 }
 
-template <typename... Ts>
-inline std::string to_string(const std::tuple<Ts...>& val) {
-    return tuple_to_string_impl(val, std::index_sequence_for<Ts...>{});
+inline uint64_t json_block_string_stops(const char* block) {
+    const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(block));
+    const uint8x16_t stops = vorrq_u8(
+        vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('"')), vceqq_u8(bytes, vdupq_n_u8('\\'))),
+        vcltq_u8(bytes, vdupq_n_u8(0x20)));
+    return json_neon_mask(stops);
 }
 
-template <typename T, typename E>
-inline std::string to_string(const Result<T, E>& val) {
-    if (is_success(val)) {
-        return "Success(" + to_string(success_value(val)) + ")";
+inline uint64_t json_block_non_whitespace(const char* block) {
+    const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(block));
+    const uint8x16_t space = vorrq_u8(
+        vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(' ')), vceqq_u8(bytes, vdupq_n_u8('\n'))),
+        vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('\r')), vceqq_u8(bytes, vdupq_n_u8('\t'))));
+    return json_neon_mask(vmvnq_u8(space));
+}
+
+inline size_t json_block_first(uint64_t mask) {
+    return static_cast<size_t>(__builtin_ctzll(mask) >> 2);
+}
+#endif
+
+// First index at or after `pos` holding '"', '\\' or a control character.
+inline size_t json_scan_string(const char* data, size_t pos, size_t size) {
+#if defined(DOOF_JSON_SSE2) || defined(DOOF_JSON_NEON)
+    while (pos + 16 <= size) {
+        const auto mask = json_block_string_stops(data + pos);
+        if (mask != 0) return pos + json_block_first(mask);
+        pos += 16;
     }
-    return "Failure(" + to_string(failure_error(val)) + ")";
+#endif
+    while (pos < size && !json_string_stop(static_cast<unsigned char>(data[pos]))) ++pos;
+    return pos;
 }
 
-template <typename E>
-inline std::string to_string(const Result<void, E>& val) {
-    if (is_success(val)) {
-        return "Success()";
+// First index at or after `pos` that is not JSON whitespace.  Most gaps are
+// zero or one byte, so the vector loop only starts on a longer run.
+inline size_t json_skip_whitespace(const char* data, size_t pos, size_t size) {
+    if (pos < size && !json_whitespace(data[pos])) return pos;
+    if (pos + 1 < size && !json_whitespace(data[pos + 1])) return pos + 1;
+#if defined(DOOF_JSON_SSE2) || defined(DOOF_JSON_NEON)
+    while (pos + 16 <= size) {
+        const auto mask = json_block_non_whitespace(data + pos);
+        if (mask != 0) return pos + json_block_first(mask);
+        pos += 16;
     }
-    return "Failure(" + to_string(failure_error(val)) + ")";
+#endif
+    while (pos < size && json_whitespace(data[pos])) ++pos;
+    return pos;
+}
+
+// Advances `pos` past the JSON number that starts there.  On a malformed
+// number returns false with `pos` at the offending byte.  `integral` is
+// cleared when the number has a fraction or an exponent.
+inline bool json_scan_number(const char* data, size_t& pos, size_t size, bool& integral) {
+    const auto digits = [&] {
+        const size_t start = pos;
+        while (pos < size && data[pos] >= '0' && data[pos] <= '9') ++pos;
+        return pos != start;
+    };
+    integral = true;
+    if (pos < size && data[pos] == '-') ++pos;
+    if (pos < size && data[pos] == '0') {
+        ++pos;
+    } else if (!digits()) {
+        return false;
+    }
+    if (pos < size && data[pos] == '.') {
+        integral = false;
+        ++pos;
+        if (!digits()) return false;
+    }
+    if (pos < size && (data[pos] == 'e' || data[pos] == 'E')) {
+        integral = false;
+        ++pos;
+        if (pos < size && (data[pos] == '+' || data[pos] == '-')) ++pos;
+        if (!digits()) return false;
+    }
+    return true;
 }
 
-template <typename T>
-inline std::string to_string(const std::optional<T>& val) {
-    return val.has_value() ? to_string(*val) : std::string("null");
+// Hands the value of number text accepted by json_scan_number to `sink` as
+// int32_t when it fits, int64_t for wider integers, and double otherwise.
+template <typename Sink>
+inline void json_decode_number(const char* first, const char* last, bool integral, Sink&& sink) {
+    if (integral) {
+        int64_t value = 0;
+        const auto parsed = std::from_chars(first, last, value);
+        if (parsed.ec == std::errc() && parsed.ptr == last) {
+            if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max()) {
+                sink(static_cast<int32_t>(value));
+            } else {
+                sink(value);
+            }
+            return;
+        }
+    }
+    // strtod needs a terminated buffer; numbers are short so this stays on the SSO path.
+    const std::string digits(first, last);
+    sink(std::strtod(digits.c_str(), nullptr));
 }
 
-inline std::string to_string(std::monostate) {
-    return "null";
+inline bool json_read_hex4(const char* data, size_t& pos, size_t size, uint32_t& code) {
+    if (pos + 4 > size) return false;
+    for (int i = 0; i < 4; ++i) {
+        const char ch = data[pos++];
+        code <<= 4;
+        if (ch >= '0' && ch <= '9') code |= static_cast<uint32_t>(ch - '0');
+        else if (ch >= 'a' && ch <= 'f') code |= static_cast<uint32_t>(ch - 'a' + 10);
+        else if (ch >= 'A' && ch <= 'F') code |= static_cast<uint32_t>(ch - 'A' + 10);
+        else return false;
+    }
+    return true;
 }
 
-template <typename... Ts>
-inline std::string to_string(const std::variant<Ts...>& val) {
-    return std::visit([](const auto& inner) -> std::string {
-        using Inner = std::decay_t<decltype(inner)>;
-        if constexpr (std::is_same_v<Inner, std::monostate>) {
-            return std::string("null");
+inline void json_append_utf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
+
+// Decodes a string whose first escape or control byte is at `pos`; the plain
+// run before it starts at `start`.  On success `out` holds the text and `pos`
+// is past the closing quote.  On failure returns the error message with `pos`
+// where the reader reports it.
+inline const char* json_unescape_string(const char* data, size_t& pos, size_t size, size_t start, std::string& out) {
+    out.assign(data + start, pos - start);
+    while (pos < size) {
+        const size_t run = pos;
+        pos = json_scan_string(data, pos, size);
+        out.append(data + run, pos - run);
+        if (pos >= size) break;
+        const char ch = data[pos++];
+        if (ch == '"') return nullptr;
+        if (ch != '\\') return "control character in string";
+        if (pos >= size) break;
+        switch (data[pos++]) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t code = 0;
+                if (!json_read_hex4(data, pos, size, code)) return "invalid unicode escape";
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    uint32_t low = 0;
+                    if (std::string_view(data + pos, std::min<size_t>(2, size - pos)) != "\\u") return "unpaired surrogate";
+                    pos += 2;
+                    if (!json_read_hex4(data, pos, size, low)) return "invalid unicode escape";
+                    if (low < 0xDC00 || low > 0xDFFF) return "unpaired surrogate";
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return "unpaired surrogate";
+                }
+                json_append_utf8(out, code);
+                break;
+            }
+            default:
+                return "invalid escape";
         }
-        return to_string(inner);
-    }, val);
+    }
+    return "unterminated string";
 }
 
-inline std::string to_string(ParseError val) {
-    return ParseError_name(val);
-}
+} // namespace detail
 
+enum class JsonToken { Null, Boolean, Number, String, Array, Object, End, Invalid };
 
-// Variadic string concatenation for string interpolation
-inline std::string concat() { return ""; }
+class JsonReader {
+public:
+    static constexpr int max_depth = 512;
+
+    explicit JsonReader(std::string_view text) : text_(text) {}
+
+    bool failed() const { return !error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    JsonToken peek() {
+        if (failed()) return JsonToken::Invalid;
+        skip_whitespace();
+        if (pos_ >= text_.size()) return JsonToken::End;
+        switch (text_[pos_]) {
+            case 'n': return JsonToken::Null;
+            case 't': case 'f': return JsonToken::Boolean;
+            case '"': return JsonToken::String;
+            case '[': return JsonToken::Array;
+            case '{': return JsonToken::Object;
+            case '-': case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                return JsonToken::Number;
+            default: return JsonToken::Invalid;
+        }
+    }
 
-template <typename T>
-inline std::string concat(const T& val) {
-    return to_string(val);
-}
+    // Same vocabulary as json_type_name so mismatch messages read identically.
+    const char* peek_type_name() {
+        switch (peek()) {
+            case JsonToken::Null: return "null";
+            case JsonToken::Boolean: return "boolean";
+            case JsonToken::Number: return "number";
+            case JsonToken::String: return "string";
+            case JsonToken::Array: return "array";
+            case JsonToken::Object: return "object";
+            default: return "unknown";
+        }
+    }
 
-template <typename T, typename... Args>
-inline std::string concat(const T& first, const Args&... rest) {
-    return to_string(first) + concat(rest...);
-}
+    bool begin_object() { return begin_container('{', JsonToken::Object); }
+    bool begin_array() { return begin_container('[', JsonToken::Array); }
 
-inline bool string_has_outer_whitespace(const std::string& s) {
-    if (s.empty()) return false;
-    const auto first = static_cast<unsigned char>(s.front());
-    const auto last = static_cast<unsigned char>(s.back());
-    return std::isspace(first) || std::isspace(last);
-}
+    // Advances to the next member of the innermost object, leaving the
+    // reader positioned on its value.  Returns false at '}' or on error.
+    // The key view is valid until the next read.
+    bool next_key(std::string_view& key) {
+        if (!next_entry('}')) return false;
+        if (peek() != JsonToken::String) return fail("expected object key");
+        if (!read_string_view(key)) return false;
+        skip_whitespace();
+        if (pos_ >= text_.size() || text_[pos_] != ':') return fail("expected ':'");
+        ++pos_;
+        return true;
+    }
 
-inline Result<int32_t, ParseError> parse_int(const std::string& s) {
-    if (s.empty()) return Failure<ParseError>{ParseError::EmptyInput};
-    if (string_has_outer_whitespace(s)) return Failure<ParseError>{ParseError::InvalidFormat};
+    // Advances to the next element of the innermost array.
+    bool next_element() { return next_entry(']'); }
 
-    errno = 0;
-    char* end = nullptr;
-    const long long value = std::strtoll(s.c_str(), &end, 10);
-    if (end == s.c_str() || (end != nullptr && *end != 0)) {
-        return Failure<ParseError>{ParseError::InvalidFormat};
+    // Reads a string value.  Like next_key, the view points into the input
+    // when the string has no escapes and is otherwise valid until the next read.
+    bool read_string(std::string_view& out) {
+        if (peek() != JsonToken::String) return fail("expected string");
+        return read_string_view(out);
     }
-    if (errno == ERANGE || value > std::numeric_limits<int32_t>::max()) {
-        return Failure<ParseError>{ParseError::Overflow};
+
+    bool read_null() {
+        skip_whitespace();
+        return consume_literal("null");
     }
-    if (errno == ERANGE || value < std::numeric_limits<int32_t>::min()) {
-        return Failure<ParseError>{ParseError::Underflow};
+
+    JsonValue read_value() {
+        switch (peek()) {
+            case JsonToken::Null:
+                read_null();
+                return JsonValue(nullptr);
+            case JsonToken::Boolean:
+                if (text_[pos_] == 't') return consume_literal("true") ? JsonValue(true) : JsonValue();
+                return consume_literal("false") ? JsonValue(false) : JsonValue();
+            case JsonToken::Number:
+                return read_number();
+            case JsonToken::String: {
+                std::string_view view;
+                if (!read_string_view(view)) return JsonValue();
+                return JsonValue(string(view));
+            }
+            case JsonToken::Array: {
+                auto array = std::make_shared<std::vector<JsonValue>>();
+                if (!begin_array()) return JsonValue();
+                while (next_element()) {
+                    array->push_back(read_value());
+                }
+                return failed() ? JsonValue() : JsonValue(std::move(array));
+            }
+            case JsonToken::Object: {
+                auto object = std::make_shared<ordered_map<string, JsonValue>>();
+                std::string_view key;
+                if (!begin_object()) return JsonValue();
+                while (next_key(key)) {
+                    string name(key);
+                    (*object)[name] = read_value();
+                }
+                return failed() ? JsonValue() : JsonValue(std::move(object));
+            }
+            case JsonToken::End:
+                fail("unexpected end of input");
+                return JsonValue();
+            default:
+                fail("unexpected character");
+                return JsonValue();
+        }
     }
-    return Success<int32_t>{static_cast<int32_t>(value)};
-}
 
-inline Result<uint8_t, ParseError> parse_byte(const std::string& s) {
-    const auto parsed = parse_int(s);
-    if (is_failure(parsed)) {
-        return Failure<ParseError>{failure_error(parsed)};
+    // Consumes one value of any shape without building it.
+    bool skip_value() {
+        switch (peek()) {
+            case JsonToken::Array:
+                if (!begin_array()) return false;
+                while (next_element()) {
+                    if (!skip_value()) return false;
+                }
+                return !failed();
+            case JsonToken::Object: {
+                std::string_view key;
+                if (!begin_object()) return false;
+                while (next_key(key)) {
+                    if (!skip_value()) return false;
+                }
+                return !failed();
+            }
+            case JsonToken::String:
+                return skip_string();
+            default:
+                read_value();
+                return !failed();
+        }
     }
 
-    const int32_t value = success_value(parsed);
-    if (value < 0) {
-        return Failure<ParseError>{ParseError::Underflow};
+    // Succeeds when only whitespace follows the decoded value.
+    bool finish() {
+        if (failed()) return false;
+        skip_whitespace();
+        if (pos_ != text_.size()) return fail("unexpected trailing characters");
+        return true;
     }
-    if (value > 255) {
-        return Failure<ParseError>{ParseError::Overflow};
+
+    // Failure text for a value of the wrong shape.  Malformed input reports
+    // the syntax error instead, so a truncated payload never reads as a type
+    // mismatch.
+    std::string mismatch(const std::string& expected, bool with_actual = true) {
+        const JsonToken token = peek();
+        if (token == JsonToken::End) fail("unexpected end of input");
+        if (token == JsonToken::Invalid) fail("unexpected character");
+        if (failed()) return error_;
+        if (!with_actual) return expected;
+        return expected + " but got " + peek_type_name();
     }
 
-    return Success<uint8_t>{static_cast<uint8_t>(value)};
-}
+    bool fail(const char* message) {
+        if (!failed()) {
+            error_ = std::string("Invalid JSON at offset ") + std::to_string(pos_) + ": " + message;
+        }
+        return false;
+    }
 
-inline Result<int64_t, ParseError> parse_long(const std::string& s) {
-    if (s.empty()) return Failure<ParseError>{ParseError::EmptyInput};
-    if (string_has_outer_whitespace(s)) return Failure<ParseError>{ParseError::InvalidFormat};
+private:
+    void skip_whitespace() {
+        pos_ = detail::json_skip_whitespace(text_.data(), pos_, text_.size());
+    }
 
-    errno = 0;
-    char* end = nullptr;
-    const long long value = std::strtoll(s.c_str(), &end, 10);
-    if (end == s.c_str() || (end != nullptr && *end != 0)) {
-        return Failure<ParseError>{ParseError::InvalidFormat};
+    bool begin_container(char open, JsonToken token) {
+        if (peek() != token) return fail(open == '{' ? "expected '{'" : "expected '['");
+        if (depth_ >= max_depth) return fail("nesting too deep");
+        ++pos_;
+        ++depth_;
+        first_ = true;
+        return true;
     }
-    if (errno == ERANGE) {
-        return Failure<ParseError>{value < 0 ? ParseError::Underflow : ParseError::Overflow};
+
+    bool next_entry(char close) {
+        if (failed()) return false;
+        skip_whitespace();
+        if (pos_ < text_.size() && text_[pos_] == close) {
+            ++pos_;
+            --depth_;
+            first_ = false;
+            return false;
+        }
+        if (!first_) {
+            if (pos_ >= text_.size() || text_[pos_] != ',') {
+                return fail(close == '}' ? "expected ',' or '}'" : "expected ',' or ']'");
+            }
+            ++pos_;
+        }
+        first_ = false;
+        return true;
     }
-    return Success<int64_t>{static_cast<int64_t>(value)};
-}
 
-inline Result<float, ParseError> parse_float(const std::string& s) {
-    if (s.empty()) return Failure<ParseError>{ParseError::EmptyInput};
-    if (string_has_outer_whitespace(s)) return Failure<ParseError>{ParseError::InvalidFormat};
-
-    errno = 0;
-    char* end = nullptr;
-    const float value = std::strtof(s.c_str(), &end);
-    if (end == s.c_str() || (end != nullptr && *end != 0)) {
-        return Failure<ParseError>{ParseError::InvalidFormat};
-    }
-    if (errno == ERANGE) {
-        return Failure<ParseError>{value == 0.0f ? ParseError::Underflow : ParseError::Overflow};
+    bool consume_literal(std::string_view literal) {
+        if (text_.substr(pos_, literal.size()) != literal) return fail("invalid literal");
+        pos_ += literal.size();
+        return true;
     }
-    return Success<float>{value};
-}
 
-inline Result<double, ParseError> parse_double(const std::string& s) {
-    if (s.empty()) return Failure<ParseError>{ParseError::EmptyInput};
-    if (string_has_outer_whitespace(s)) return Failure<ParseError>{ParseError::InvalidFormat};
+    JsonValue read_number() {
+        const size_t start = pos_;
+        bool integral = true;
+        if (!detail::json_scan_number(text_.data(), pos_, text_.size(), integral)) {
+            fail("invalid number");
+            return JsonValue();
+        }
+        JsonValue result;
+        detail::json_decode_number(text_.data() + start, text_.data() + pos_, integral, [&result](auto value) {
+            result = JsonValue(value);
+        });
+        return result;
+    }
 
-    errno = 0;
-    char* end = nullptr;
-    const double value = std::strtod(s.c_str(), &end);
-    if (end == s.c_str() || (end != nullptr && *end != 0)) {
-        return Failure<ParseError>{ParseError::InvalidFormat};
+    // Strings without escapes are returned as views into the input; escaped
+    // strings are decoded into a scratch buffer owned by the reader.
+    bool read_string_view(std::string_view& out) {
+        ++pos_;
+        const size_t start = pos_;
+        pos_ = detail::json_scan_string(text_.data(), pos_, text_.size());
+        if (pos_ < text_.size() && text_[pos_] == '"') {
+            out = text_.substr(start, pos_ - start);
+            ++pos_;
+            return true;
+        }
+        if (const char* error = detail::json_unescape_string(text_.data(), pos_, text_.size(), start, scratch_)) {
+            return fail(error);
+        }
+        out = scratch_;
+        return true;
     }
-    if (errno == ERANGE) {
-        return Failure<ParseError>{value == 0.0 ? ParseError::Underflow : ParseError::Overflow};
+
+    // Validates a string without decoding it into the scratch buffer.
+    bool skip_string() {
+        ++pos_;
+        while (true) {
+            pos_ = detail::json_scan_string(text_.data(), pos_, text_.size());
+            if (pos_ >= text_.size()) return fail("unterminated string");
+            const char ch = text_[pos_++];
+            if (ch == '"') return true;
+            if (ch != '\\') return fail("control character in string");
+            if (pos_ >= text_.size()) return fail("unterminated string");
+            const char escape = text_[pos_++];
+            if (escape == 'u') {
+                uint32_t code = 0;
+                if (!detail::json_read_hex4(text_.data(), pos_, text_.size(), code)) return fail("invalid unicode escape");
+            } else if (std::string_view("\"\\/bfnrt").find(escape) == std::string_view::npos) {
+                return fail("invalid escape");
+            }
+        }
     }
-    return Success<double>{value};
-}
+
+    std::string_view text_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+    bool first_ = false;
+    std::string scratch_;
+    std::string error_;
+};
 
 // ============================================================================
-// String methods
+// JSON text output — appends to a caller-owned, reusable buffer
 // ============================================================================
 
-inline int32_t string_indexOf(const std::string& s, const std::string& search) {
-    auto pos = s.find(search);
-    return pos == std::string::npos ? -1 : static_cast<int32_t>(pos);
+inline void json_write_string(std::string& out, std::string_view value) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    out.push_back('"');
+    size_t pos = 0;
+    while (pos < value.size()) {
+        const size_t run = pos;
+        pos = detail::json_scan_string(value.data(), pos, value.size());
+        out.append(value.data() + run, pos - run);
+        if (pos >= value.size()) break;
+        const unsigned char ch = static_cast<unsigned char>(value[pos++]);
+        switch (ch) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default: {
+                const char escaped[] = {'\\', 'u', '0', '0', HEX[(ch >> 4) & 0x0F], HEX[ch & 0x0F]};
+                out.append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+// Shortest of %.15g / %.17g that reads back exactly; non-finite values have
+// no JSON spelling and are written as null.
+inline void json_write_double(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out.append("null");
+        return;
+    }
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    if (std::strtod(buffer, nullptr) != value) {
+        length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    out.append(buffer, static_cast<size_t>(length));
+}
+
+template <typename Integer>
+inline void json_write_integer(std::string& out, Integer value) {
+    char buffer[24];
+    const auto written = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, static_cast<size_t>(written.ptr - buffer));
+}
+
+inline void json_write(std::string& out, const JsonValue& value) {
+    std::visit([&out](const auto& item) {
+        using T = std::decay_t<decltype(item)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+            out.append("null");
+        } else if constexpr (std::is_same_v<T, bool>) {
+            out.append(item ? "true" : "false");
+        } else if constexpr (std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t>) {
+            json_write_integer(out, item);
+        } else if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+            json_write_double(out, static_cast<double>(item));
+        } else if constexpr (std::is_same_v<T, string>) {
+            json_write_string(out, item);
+        } else if constexpr (std::is_same_v<T, JsonArray>) {
+            if (!item) {
+                out.append("null");
+                return;
+            }
+            out.push_back('[');
+            bool first = true;
+            for (const auto& element : *item) {
+                if (!first) out.push_back(',');
+                first = false;
+                json_write(out, element);
+            }
+            out.push_back(']');
+        } else {
+            if (!item) {
+                out.append("null");
+                return;
+            }
+            out.push_back('{');
+            bool first = true;
+            for (const auto& entry : *item) {
+                if (!first) out.push_back(',');
+                first = false;
+                json_write_string(out, entry.first);
+                out.push_back(':');
+                json_write(out, entry.second);
+            }
+            out.push_back('}');
+        }
+    }, json_storage(value));
 }
 
-inline bool string_contains(const std::string& s, const std::string& search) {
-    return s.find(search) != std::string::npos;
+inline std::string json_format(const JsonValue& value) {
+    std::string out;
+    json_write(out, value);
+    return out;
 }
 
-inline bool string_startsWith(const std::string& s, const std::string& prefix) {
-    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
-}
+// ============================================================================
+// JsonDocument — arena-backed, read-only parsed JSON
+// ============================================================================
+//
+// JsonDocument::parse places every node of a document in one bump arena.
+// Strings that need no unescaping are views into the document's input; only
+// escaped strings are copied, and those go into the arena as well.  Nodes are
+// trivially destructible, so destroying a document frees its handful of arena
+// chunks without visiting a single node.
+//
+// Nodes borrow from their document and are only handed out by reference.
+// The json_is_* / json_as_* helpers have JsonNode overloads with the same
+// semantics as the JsonValue ones, so generated fromJsonValue overloads decode
+// a document directly; JsonValue(node) copies a subtree out when an owning
+// value is needed.
+
+struct JsonMember;
+
+enum class JsonNodeKind : uint8_t { Null, Boolean, Int, Long, Double, String, Array, Object };
+
+struct JsonNodeString {
+    const char* data;
+    size_t size;
+
+    std::string_view view() const { return std::string_view(data, size); }
+};
 
-inline bool string_endsWith(const std::string& s, const std::string& suffix) {
-    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
-}
+struct JsonNodeArray {
+    const JsonNode* items;
+    size_t count;
 
-inline std::string string_substring(const std::string& s, int32_t start, int32_t end) {
-    if (start < 0) start = 0;
-    if (end > static_cast<int32_t>(s.size())) end = static_cast<int32_t>(s.size());
-    if (start >= end) return "";
-    return s.substr(static_cast<size_t>(start), static_cast<size_t>(end - start));
-}
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const JsonNode* begin() const { return items; }
+    const JsonNode* end() const;
+    const JsonNode& operator[](size_t index) const;
+};
 
-inline std::string string_slice(const std::string& s, int32_t start) {
-    if (start < 0) start = 0;
-    if (start >= static_cast<int32_t>(s.size())) return "";
-    return s.substr(static_cast<size_t>(start));
-}
+// Members keep document order.  find() scans linearly, which beats hashing
+// for the short objects JSON payloads are made of.
+struct JsonNodeObject {
+    const JsonMember* members;
+    size_t count;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const JsonMember* begin() const { return members; }
+    const JsonMember* end() const;
+    const JsonMember* find(std::string_view key) const;
+};
 
-inline std::string string_padStart(const std::string& s, int32_t length, char fill) {
-    if (length <= static_cast<int32_t>(s.size())) return s;
-    return std::string(static_cast<size_t>(length - static_cast<int32_t>(s.size())), fill) + s;
-}
+struct JsonNode {
+    JsonNodeKind kind;
+    union {
+        bool boolean;
+        int32_t int_value;
+        int64_t long_value;
+        double double_value;
+        JsonNodeString string;
+        JsonNodeArray array;
+        JsonNodeObject object;
+    };
+};
 
-inline std::string string_trim(const std::string& s) {
-    auto start = s.find_first_not_of(" \t\n\r\f\v");
-    if (start == std::string::npos) return "";
-    auto end = s.find_last_not_of(" \t\n\r\f\v");
-    return s.substr(start, end - start + 1);
-}
+// Named like an ordered_map entry so generated code reads `it->second` for both.
+struct JsonMember {
+    std::string_view first;
+    JsonNode second;
+};
 
-inline std::string string_trimStart(const std::string& s) {
-    auto start = s.find_first_not_of(" \t\n\r\f\v");
-    if (start == std::string::npos) return "";
-    return s.substr(start);
-}
+static_assert(std::is_trivially_destructible_v<JsonNode> && std::is_trivially_destructible_v<JsonMember>,
+              "JsonDocument releases nodes without running destructors");
 
-inline std::string string_trimEnd(const std::string& s) {
-    auto end = s.find_last_not_of(" \t\n\r\f\v");
-    if (end == std::string::npos) return "";
-    return s.substr(0, end + 1);
-}
+inline const JsonNode* JsonNodeArray::end() const { return items + count; }
+inline const JsonNode& JsonNodeArray::operator[](size_t index) const { return items[index]; }
+inline const JsonMember* JsonNodeObject::end() const { return members + count; }
 
-inline std::string string_trimEnd(const std::string& s, char fill) {
-    auto end = s.find_last_not_of(fill);
-    if (end == std::string::npos) return "";
-    return s.substr(0, end + 1);
+// A repeated key resolves to its last value, as it does when read into a JsonValue.
+inline const JsonMember* JsonNodeObject::find(std::string_view key) const {
+    for (size_t index = count; index > 0; --index) {
+        if (members[index - 1].first == key) return members + index - 1;
+    }
+    return end();
 }
 
-inline std::string string_toUpperCase(const std::string& s) {
-    std::string result = s;
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c) { return std::toupper(c); });
-    return result;
-}
+namespace detail {
 
-inline std::string string_toLowerCase(const std::string& s) {
-    std::string result = s;
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
-    return result;
-}
+// Bump allocator behind JsonDocument.  Everything placed in it is trivially
+// destructible, so it only ever frees whole chunks.
+class JsonArena {
+public:
+    static constexpr size_t min_chunk = 4096;
+    static constexpr size_t max_chunk = size_t(64) << 20;
+
+    explicit JsonArena(size_t first_chunk = min_chunk)
+        : next_chunk_(std::min(std::max(first_chunk, min_chunk), max_chunk)) {}
+
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "JsonArena never runs destructors");
+        const size_t bytes = sizeof(T) * count;
+        uintptr_t start = (reinterpret_cast<uintptr_t>(cursor_) + alignof(T) - 1) & ~(uintptr_t(alignof(T)) - 1);
+        if (cursor_ == nullptr || start + bytes > reinterpret_cast<uintptr_t>(limit_)) {
+            grow(bytes);
+            start = reinterpret_cast<uintptr_t>(cursor_);
+        }
+        cursor_ = reinterpret_cast<char*>(start + bytes);
+        return reinterpret_cast<T*>(start);
+    }
 
-inline std::string string_replace(const std::string& s, const std::string& search, const std::string& replacement) {
-    if (search.empty()) return s;
-    auto pos = s.find(search);
-    if (pos == std::string::npos) return s;
-    std::string result = s;
-    result.replace(pos, search.size(), replacement);
-    return result;
-}
+    size_t reserved_bytes() const { return reserved_; }
 
-inline std::string string_replaceAll(const std::string& s, const std::string& search, const std::string& replacement) {
-    if (search.empty()) return s;
-    std::string result = s;
-    size_t pos = 0;
-    while ((pos = result.find(search, pos)) != std::string::npos) {
-        result.replace(pos, search.size(), replacement);
-        pos += replacement.size();
-    }
-    return result;
-}
+private:
+    void grow(size_t bytes) {
+        const size_t size = std::max(next_chunk_, bytes);
+        chunks_.emplace_back(new char[size]);
+        cursor_ = chunks_.back().get();
+        limit_ = cursor_ + size;
+        reserved_ += size;
+        next_chunk_ = std::min(next_chunk_ * 2, max_chunk);
+    }
+
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char* cursor_ = nullptr;
+    char* limit_ = nullptr;
+    size_t next_chunk_;
+    size_t reserved_ = 0;
+};
 
-inline std::shared_ptr<std::vector<std::string>> string_split(const std::string& s, const std::string& delimiter) {
-    auto result = std::make_shared<std::vector<std::string>>();
-    if (delimiter.empty()) {
-        for (char c : s) result->push_back(std::string(1, c));
-        return result;
-    }
-    size_t start = 0;
-    size_t pos;
-    while ((pos = s.find(delimiter, start)) != std::string::npos) {
-        result->push_back(s.substr(start, pos - start));
-        start = pos + delimiter.size();
+// Reads one value from a JsonReader into arena nodes.  Container children are
+// collected on reusable stacks and copied into one contiguous arena block when
+// the container closes.
+class JsonDocumentBuilder {
+public:
+    JsonDocumentBuilder(JsonArena& arena, std::string_view text) : arena_(arena), text_(text) {}
+
+    bool read(JsonReader& reader, JsonNode& out) {
+        switch (reader.peek()) {
+            case JsonToken::String: {
+                std::string_view view;
+                if (!reader.read_string(view)) return false;
+                out.kind = JsonNodeKind::String;
+                out.string = intern(view);
+                return true;
+            }
+            case JsonToken::Array: {
+                if (!reader.begin_array()) return false;
+                const size_t base = elements_.size();
+                while (reader.next_element()) {
+                    JsonNode element;
+                    if (!read(reader, element)) return false;
+                    elements_.push_back(element);
+                }
+                if (reader.failed()) return false;
+                const size_t count = elements_.size() - base;
+                JsonNode* items = arena_.allocate<JsonNode>(count);
+                std::uninitialized_copy_n(elements_.begin() + static_cast<std::ptrdiff_t>(base), count, items);
+                elements_.resize(base);
+                out.kind = JsonNodeKind::Array;
+                out.array = JsonNodeArray{items, count};
+                return true;
+            }
+            case JsonToken::Object: {
+                if (!reader.begin_object()) return false;
+                const size_t base = members_.size();
+                std::string_view key;
+                while (reader.next_key(key)) {
+                    JsonMember member;
+                    // The key may sit in the reader's scratch buffer, which the value overwrites.
+                    member.first = intern(key).view();
+                    if (!read(reader, member.second)) return false;
+                    members_.push_back(member);
+                }
+                if (reader.failed()) return false;
+                const size_t count = members_.size() - base;
+                JsonMember* members = arena_.allocate<JsonMember>(count);
+                std::uninitialized_copy_n(members_.begin() + static_cast<std::ptrdiff_t>(base), count, members);
+                members_.resize(base);
+                out.kind = JsonNodeKind::Object;
+                out.object = JsonNodeObject{members, count};
+                return true;
+            }
+            default: {
+                const JsonValue scalar = reader.read_value();
+                if (reader.failed()) return false;
+                const JsonStorage& storage = json_storage(scalar);
+                if (const auto* value = std::get_if<bool>(&storage)) {
+                    out.kind = JsonNodeKind::Boolean;
+                    out.boolean = *value;
+                } else if (const auto* value = std::get_if<int32_t>(&storage)) {
+                    out.kind = JsonNodeKind::Int;
+                    out.int_value = *value;
+                } else if (const auto* value = std::get_if<int64_t>(&storage)) {
+                    out.kind = JsonNodeKind::Long;
+                    out.long_value = *value;
+                } else if (const auto* value = std::get_if<double>(&storage)) {
+                    out.kind = JsonNodeKind::Double;
+                    out.double_value = *value;
+                } else {
+                    out.kind = JsonNodeKind::Null;
+                }
+                return true;
+            }
+        }
     }
-    result->push_back(s.substr(start));
-    return result;
-}
 
-inline char32_t string_at(const std::string& s, int32_t index, const char* file, int32_t line) {
-    if (index < 0 || index >= static_cast<int32_t>(s.size())) {
-        panic_at(file, line, "Index out of bounds: " + to_string(index));
+private:
+    // Views into the input are kept as they are; decoded escapes are copied.
+    JsonNodeString intern(std::string_view view) {
+        const std::less_equal<const char*> at_or_before;
+        if (at_or_before(text_.data(), view.data()) && at_or_before(view.data() + view.size(), text_.data() + text_.size())) {
+            return JsonNodeString{view.data(), view.size()};
+        }
+        char* copy = arena_.allocate<char>(view.size());
+        std::copy_n(view.data(), view.size(), copy);
+        return JsonNodeString{copy, view.size()};
     }
-    return static_cast<char32_t>(static_cast<unsigned char>(s[static_cast<size_t>(index)]));
-}
 
-inline std::string string_repeat(const std::string& s, int32_t count) {
-    if (count <= 0) return "";
-    std::string result;
-    result.reserve(s.size() * static_cast<size_t>(count));
-    for (int32_t i = 0; i < count; ++i) result += s;
-    return result;
-}
+    JsonArena& arena_;
+    std::string_view text_;
+    std::vector<JsonNode> elements_;
+    std::vector<JsonMember> members_;
+};
 
-// Representation-dependent helpers used by both emitters. Operations whose
-// receiver representation is statically known are lowered directly instead.
-template <typename T>
-bool is_null(const std::shared_ptr<T>& value) {
-    return value == nullptr;
-}
+} // namespace detail
 
-template <typename T>
-bool is_null(const std::optional<T>& value) {
-    return !value.has_value();
-}
+// Stage-1 kernel for JsonDocument::parse_view.  `None` skips the structural
+// index and builds the document straight from a JsonReader.  Kernels that are
+// not compiled into this build run the scalar loop.
+enum class JsonIndexKernel : uint8_t { None, Scalar, Sse2, Avx2, Neon };
 
-template <typename... T>
-bool is_null(const std::variant<std::monostate, T...>& value) {
-    return std::holds_alternative<std::monostate>(value);
-}
+namespace detail {
 
-template <typename... T>
-std::string kind(const std::variant<std::shared_ptr<T>...>& value) {
-    return std::visit([](const auto& item) { return item->kind; }, value);
-}
+// ----------------------------------------------------------------------------
+// Structural index (stage 1)
+// ----------------------------------------------------------------------------
+//
+// Classifies 64 input bytes at a time into bitmasks, resolves backslash
+// escapes and string spans with carries between blocks, and records the
+// offset of every '{', '}', '[', ']', ':', ',' and opening quote outside a
+// string, plus the first byte of every bare scalar (number or literal).
+// Stage 2 then walks these offsets instead of rescanning whitespace.
+
+struct JsonBlockMasks {
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t op;
+    uint64_t whitespace;
+};
 
-template <typename... T>
-std::string kind(const std::variant<std::monostate, std::shared_ptr<T>...>& value) {
-    return std::visit([](const auto& item) {
-        using Item = std::decay_t<decltype(item)>;
-        if constexpr (std::is_same_v<Item, std::monostate>) {
-            return std::string("null");
-        } else {
-            return item->kind;
+inline JsonBlockMasks json_classify_scalar(const char* block) {
+    JsonBlockMasks masks{0, 0, 0, 0};
+    for (size_t index = 0; index < 64; ++index) {
+        const uint64_t bit = uint64_t(1) << index;
+        switch (block[index]) {
+            case '\\': masks.backslash |= bit; break;
+            case '"': masks.quote |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': masks.op |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': masks.whitespace |= bit; break;
+            default: break;
         }
-    }, value);
+    }
+    return masks;
 }
 
-template <typename T>
-auto kind(const std::shared_ptr<T>& value) -> decltype(value->kind) {
-    return value->kind;
+#if defined(DOOF_JSON_SSE2)
+// OR-ing in 0x20 folds '[' onto '{' and ']' onto '}', so the six operators
+// take four compares.
+inline JsonBlockMasks json_classify_sse2(const char* block) {
+    JsonBlockMasks masks{0, 0, 0, 0};
+    for (int lane = 0; lane < 4; ++lane) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * lane));
+        const __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+        const auto mask = [](__m128i matches) {
+            return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(matches)));
+        };
+        const int shift = 16 * lane;
+        masks.backslash |= mask(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))) << shift;
+        masks.quote |= mask(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'))) << shift;
+        masks.op |= mask(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(','))))) << shift;
+        masks.whitespace |= mask(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))))) << shift;
+    }
+    return masks;
 }
+#endif
 
-template <typename... T>
-auto span(const std::variant<std::shared_ptr<T>...>& value) {
-    return std::visit([](const auto& item) { return item->span; }, value);
+#if defined(DOOF_JSON_AVX2)
+DOOF_JSON_TARGET_AVX2 inline JsonBlockMasks json_classify_avx2(const char* block) {
+    JsonBlockMasks masks{0, 0, 0, 0};
+    for (int lane = 0; lane < 2; ++lane) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * lane));
+        const __m256i folded = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+        const int shift = 32 * lane;
+        const auto mask = [](__m256i matches) DOOF_JSON_TARGET_AVX2 {
+            return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(matches)));
+        };
+        masks.backslash |= mask(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))) << shift;
+        masks.quote |= mask(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"'))) << shift;
+        masks.op |= mask(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))))) << shift;
+        masks.whitespace |= mask(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))))) << shift;
+    }
+    return masks;
 }
+#endif
 
-template <typename T>
-auto span(const std::shared_ptr<T>& value) {
-    return value->span;
+#if defined(DOOF_JSON_NEON)
+// Weights each lane by its bit and folds four 16-lane compare results into
+// one 64-bit mask with three pairwise adds.
+inline uint64_t json_neon_movemask64(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) {
+    const uint8x16_t weights = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t low = vpaddq_u8(vandq_u8(m0, weights), vandq_u8(m1, weights));
+    const uint8x16_t high = vpaddq_u8(vandq_u8(m2, weights), vandq_u8(m3, weights));
+    uint8x16_t sum = vpaddq_u8(low, high);
+    sum = vpaddq_u8(sum, sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+
+inline JsonBlockMasks json_classify_neon(const char* block) {
+    uint8x16_t backslash[4], quote[4], op[4], whitespace[4];
+    for (int lane = 0; lane < 4; ++lane) {
+        const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(block + 16 * lane));
+        const uint8x16_t folded = vorrq_u8(bytes, vdupq_n_u8(0x20));
+        backslash[lane] = vceqq_u8(bytes, vdupq_n_u8('\\'));
+        quote[lane] = vceqq_u8(bytes, vdupq_n_u8('"'));
+        op[lane] = vorrq_u8(
+            vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))),
+            vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(':')), vceqq_u8(bytes, vdupq_n_u8(','))));
+        whitespace[lane] = vorrq_u8(
+            vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(' ')), vceqq_u8(bytes, vdupq_n_u8('\t'))),
+            vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('\n')), vceqq_u8(bytes, vdupq_n_u8('\r'))));
+    }
+    return JsonBlockMasks{
+        json_neon_movemask64(backslash[0], backslash[1], backslash[2], backslash[3]),
+        json_neon_movemask64(quote[0], quote[1], quote[2], quote[3]),
+        json_neon_movemask64(op[0], op[1], op[2], op[3]),
+        json_neon_movemask64(whitespace[0], whitespace[1], whitespace[2], whitespace[3]),
+    };
 }
+#endif
 
-template <typename Candidate, typename Variant>
-struct is_variant_alternative : std::is_same<Candidate, Variant> {};
+// Turns classified blocks into structural offsets.  The carries let strings
+// and backslash runs cross block boundaries.
+class JsonIndexer {
+public:
+    explicit JsonIndexer(std::vector<uint32_t>& out) : out_(out) {}
 
-template <typename Candidate, typename... Alternatives>
-struct is_variant_alternative<Candidate, std::variant<Alternatives...>>
-    : std::bool_constant<(std::is_same_v<Candidate, Alternatives> || ...)> {};
+    void block(const JsonBlockMasks& masks, uint32_t offset) {
+        const uint64_t quotes = masks.quote & ~escaped(masks.backslash);
+        const uint64_t in_string = prefix_xor(quotes) ^ in_string_;
+        in_string_ = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+        const uint64_t scalar = ~(masks.op | masks.whitespace | quotes | in_string);
+        const uint64_t scalar_starts = scalar & ~((scalar << 1) | scalar_carry_);
+        scalar_carry_ = scalar >> 63;
+        flatten((masks.op & ~in_string) | (quotes & in_string) | scalar_starts, offset);
+    }
 
-template <typename Target, typename... Source>
-bool variant_is(const std::variant<Source...>& value) {
-    return std::visit([](const auto& item) {
-        using Item = std::decay_t<decltype(item)>;
-        return is_variant_alternative<Item, Target>::value;
-    }, value);
-}
+    // False when the input ends inside a string.
+    bool finish() {
+        out_.resize(count_);
+        return in_string_ == 0;
+    }
 
-template <typename Target, typename... Source>
-Target variant_narrow(const std::variant<Source...>& value) {
-    return std::visit([](const auto& item) -> Target {
-        using Item = std::decay_t<decltype(item)>;
-        if constexpr (is_variant_alternative<Item, Target>::value) {
-            return item;
-        } else {
-            throw std::runtime_error("variant does not hold a requested alternative");
+private:
+    // Bytes preceded by an odd-length run of backslashes.  Runs are told apart
+    // by the parity of their start: adding a run's start bit to the run
+    // carries out just past its end, and odd-from-even or even-from-odd ends
+    // mark odd lengths.
+    uint64_t escaped(uint64_t backslash) {
+        if (backslash == 0 && backslash_carry_ == 0) return 0;
+        constexpr uint64_t even_bits = 0x5555555555555555ULL;
+        constexpr uint64_t odd_bits = ~even_bits;
+        const uint64_t starts = backslash & ~(backslash << 1);
+        const uint64_t even_start_mask = even_bits ^ backslash_carry_;
+        const uint64_t even_starts = starts & even_start_mask;
+        const uint64_t odd_starts = starts & ~even_start_mask;
+        const uint64_t even_carries = backslash + even_starts;
+        uint64_t odd_carries = backslash + odd_starts;
+        const bool ends_odd = odd_carries < backslash;
+        odd_carries |= backslash_carry_;
+        backslash_carry_ = ends_odd ? 1 : 0;
+        return ((even_carries & ~backslash) & odd_bits) | ((odd_carries & ~backslash) & even_bits);
+    }
+
+    // Bit i of the result is the XOR of bits 0..i: set inside quoted spans.
+    static uint64_t prefix_xor(uint64_t bits) {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+    void flatten(uint64_t bits, uint32_t offset) {
+        if (count_ + 64 > out_.size()) out_.resize(std::max(out_.size() * 2, count_ + 64));
+        uint32_t* slot = out_.data() + count_;
+        while (bits != 0) {
+            *slot++ = offset + static_cast<uint32_t>(json_ctz64(bits));
+            bits &= bits - 1;
         }
-    }, value);
-}
+        count_ = static_cast<size_t>(slot - out_.data());
+    }
 
-template <typename Target, typename... Source>
-Target variant_promote(const std::variant<Source...>& value) {
-    return std::visit([](const auto& item) -> Target { return item; }, value);
-}
+    static unsigned json_ctz64(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+        unsigned index = 0;
+        while ((bits & 1) == 0) {
+            bits >>= 1;
+            ++index;
+        }
+        return index;
+#endif
+    }
 
-template <typename Target, typename Source>
-Target variant_promote(const Source& value) {
-    return Target{value};
+    std::vector<uint32_t>& out_;
+    size_t count_ = 0;
+    uint64_t backslash_carry_ = 0;
+    uint64_t in_string_ = 0;
+    uint64_t scalar_carry_ = 0;
+};
+
+// The final partial block is padded with spaces, which never index.
+template <JsonBlockMasks (*Classify)(const char*)>
+inline bool json_index_blocks(std::string_view text, std::vector<uint32_t>& out) {
+    JsonIndexer indexer(out);
+    const char* data = text.data();
+    size_t pos = 0;
+    for (; pos + 64 <= text.size(); pos += 64) {
+        indexer.block(Classify(data + pos), static_cast<uint32_t>(pos));
+    }
+    if (pos < text.size()) {
+        char tail[64];
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, data + pos, text.size() - pos);
+        indexer.block(Classify(tail), static_cast<uint32_t>(pos));
+    }
+    return indexer.finish();
+}
+
+// The widest kernel this CPU runs, probed once.  The scalar index costs more
+// than it saves over reading directly, so builds without a vector kernel use
+// the reader.
+inline JsonIndexKernel json_default_index_kernel() {
+#if defined(DOOF_JSON_AVX2)
+    static const JsonIndexKernel kernel = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? JsonIndexKernel::Avx2 : JsonIndexKernel::Sse2;
+    }();
+    return kernel;
+#elif defined(DOOF_JSON_SSE2)
+    return JsonIndexKernel::Sse2;
+#elif defined(DOOF_JSON_NEON)
+    return JsonIndexKernel::Neon;
+#else
+    return JsonIndexKernel::None;
+#endif
 }
 
-template <typename T>
-decltype(auto) resolved_type(const std::shared_ptr<T>& value) {
-    return (value->resolvedType);
+// Fills `out` with the structural offsets of `text`.  False when a string is
+// left open; stage 2 catches every other error.
+inline bool json_build_index(std::string_view text, std::vector<uint32_t>& out, JsonIndexKernel kernel) {
+    switch (kernel) {
+#if defined(DOOF_JSON_AVX2)
+        case JsonIndexKernel::Avx2: return json_index_blocks<json_classify_avx2>(text, out);
+#endif
+#if defined(DOOF_JSON_SSE2)
+        case JsonIndexKernel::Sse2: return json_index_blocks<json_classify_sse2>(text, out);
+#endif
+#if defined(DOOF_JSON_NEON)
+        case JsonIndexKernel::Neon: return json_index_blocks<json_classify_neon>(text, out);
+#endif
+        default: return json_index_blocks<json_classify_scalar>(text, out);
+    }
 }
 
-template <typename... T>
-decltype(auto) resolved_type(const std::variant<T...>& value) {
-    return std::visit([](const auto& item) -> decltype(auto) { return (item->resolvedType); }, value);
+// ----------------------------------------------------------------------------
+// Node tape (stage 2)
+// ----------------------------------------------------------------------------
+//
+// Walks the structural offsets and writes the same arena nodes as
+// JsonDocumentBuilder: each container's children land in one contiguous
+// arena block.  It only decides accept or reject; on reject the caller
+// re-parses with the reader, so messages and edge cases match fromJsonText.
+class JsonIndexedBuilder {
+public:
+    JsonIndexedBuilder(JsonArena& arena, std::string_view text, const std::vector<uint32_t>& index)
+        : arena_(arena), text_(text), index_(index.data()), count_(index.size()) {}
+
+    bool read_document(JsonNode& root) {
+        return read(root, 0) && cursor_ == count_;
+    }
+
+private:
+    bool read(JsonNode& out, int depth) {
+        if (cursor_ >= count_) return false;
+        const size_t pos = index_[cursor_++];
+        switch (text_[pos]) {
+            case '{': return read_object(out, depth);
+            case '[': return read_array(out, depth);
+            case '"':
+                out.kind = JsonNodeKind::String;
+                return read_string(pos, out.string);
+            case 't':
+                out.kind = JsonNodeKind::Boolean;
+                out.boolean = true;
+                return read_literal(pos, "true");
+            case 'f':
+                out.kind = JsonNodeKind::Boolean;
+                out.boolean = false;
+                return read_literal(pos, "false");
+            case 'n':
+                out.kind = JsonNodeKind::Null;
+                return read_literal(pos, "null");
+            default:
+                return read_number(pos, out);
+        }
+    }
+
+    bool read_array(JsonNode& out, int depth) {
+        if (depth >= JsonReader::max_depth) return false;
+        const size_t base = elements_.size();
+        if (!take(']')) {
+            do {
+                JsonNode element;
+                if (!read(element, depth + 1)) return false;
+                elements_.push_back(element);
+            } while (take(','));
+            if (!take(']')) return false;
+        }
+        const size_t count = elements_.size() - base;
+        JsonNode* items = arena_.allocate<JsonNode>(count);
+        std::uninitialized_copy_n(elements_.begin() + static_cast<std::ptrdiff_t>(base), count, items);
+        elements_.resize(base);
+        out.kind = JsonNodeKind::Array;
+        out.array = JsonNodeArray{items, count};
+        return true;
+    }
+
+    bool read_object(JsonNode& out, int depth) {
+        if (depth >= JsonReader::max_depth) return false;
+        const size_t base = members_.size();
+        if (!take('}')) {
+            do {
+                if (cursor_ >= count_ || text_[index_[cursor_]] != '"') return false;
+                JsonMember member;
+                JsonNodeString key;
+                if (!read_string(index_[cursor_++], key) || !take(':')) return false;
+                member.first = key.view();
+                if (!read(member.second, depth + 1)) return false;
+                members_.push_back(member);
+            } while (take(','));
+            if (!take('}')) return false;
+        }
+        const size_t count = members_.size() - base;
+        JsonMember* members = arena_.allocate<JsonMember>(count);
+        std::uninitialized_copy_n(members_.begin() + static_cast<std::ptrdiff_t>(base), count, members);
+        members_.resize(base);
+        out.kind = JsonNodeKind::Object;
+        out.object = JsonNodeObject{members, count};
+        return true;
+    }
+
+    bool take(char op) {
+        if (cursor_ < count_ && text_[index_[cursor_]] == op) {
+            ++cursor_;
+            return true;
+        }
+        return false;
+    }
+
+    // A bare scalar must run up to the next structural, or to the end of input,
+    // with nothing but whitespace after it: `[1x]` and `truex` are rejected.
+    bool scalar_ends_at(size_t end) const {
+        const size_t next = cursor_ < count_ ? index_[cursor_] : text_.size();
+        return json_skip_whitespace(text_.data(), end, text_.size()) == next;
+    }
+
+    bool read_literal(size_t pos, std::string_view literal) const {
+        return text_.compare(pos, literal.size(), literal) == 0 && scalar_ends_at(pos + literal.size());
+    }
+
+    bool read_number(size_t pos, JsonNode& out) const {
+        const size_t start = pos;
+        bool integral = true;
+        if (!json_scan_number(text_.data(), pos, text_.size(), integral) || !scalar_ends_at(pos)) return false;
+        json_decode_number(text_.data() + start, text_.data() + pos, integral, [&out](auto value) {
+            using T = decltype(value);
+            if constexpr (std::is_same_v<T, int32_t>) {
+                out.kind = JsonNodeKind::Int;
+                out.int_value = value;
+            } else if constexpr (std::is_same_v<T, int64_t>) {
+                out.kind = JsonNodeKind::Long;
+                out.long_value = value;
+            } else {
+                out.kind = JsonNodeKind::Double;
+                out.double_value = value;
+            }
+        });
+        return true;
+    }
+
+    // Plain strings stay views into the input; escaped ones are decoded into
+    // the arena.  Stage 1 already matched the closing quote, so the scan
+    // cannot overrun into the next token.
+    bool read_string(size_t quote, JsonNodeString& out) {
+        const size_t start = quote + 1;
+        size_t pos = json_scan_string(text_.data(), start, text_.size());
+        if (pos < text_.size() && text_[pos] == '"') {
+            out = JsonNodeString{text_.data() + start, pos - start};
+            return true;
+        }
+        if (json_unescape_string(text_.data(), pos, text_.size(), start, scratch_) != nullptr) return false;
+        char* copy = arena_.allocate<char>(scratch_.size());
+        std::copy_n(scratch_.data(), scratch_.size(), copy);
+        out = JsonNodeString{copy, scratch_.size()};
+        return true;
+    }
+
+    JsonArena& arena_;
+    std::string_view text_;
+    const uint32_t* index_;
+    size_t count_;
+    size_t cursor_ = 0;
+    std::vector<JsonNode> elements_;
+    std::vector<JsonMember> members_;
+    std::string scratch_;
+};
+
+} // namespace detail
+
+class JsonDocument {
+public:
+    // Parses `text` into a document that keeps the text alive for its views.
+    static Result<JsonDocument, string> parse(std::string text) {
+        auto owned = std::make_unique<std::string>(std::move(text));
+        auto document = parse_view(*owned);
+        if (is_success(document)) success_value(document).text_ = std::move(owned);
+        return document;
+    }
+
+    // Parses without copying: node strings view `text`, which must outlive the document.
+    // Valid input goes through the structural index; input it rejects is read
+    // again with a JsonReader, which reports the error.
+    static Result<JsonDocument, string> parse_view(std::string_view text) {
+        return parse_view(text, detail::json_default_index_kernel());
+    }
+
+    // As parse_view, with an explicit stage-1 kernel (for benchmarks and tests).
+    static Result<JsonDocument, string> parse_view(std::string_view text, JsonIndexKernel kernel) {
+        // Nodes take roughly as many bytes as the text they came from.
+        JsonDocument document(text.size());
+        JsonNode root;
+        if (kernel != JsonIndexKernel::None && text.size() <= std::numeric_limits<uint32_t>::max()) {
+            thread_local std::vector<uint32_t> index;
+            if (detail::json_build_index(text, index, kernel)) {
+                detail::JsonIndexedBuilder builder(document.arena_, text, index);
+                if (builder.read_document(root)) return document.finish(root);
+            }
+            document = JsonDocument(text.size());
+        }
+        JsonReader reader(text);
+        detail::JsonDocumentBuilder builder(document.arena_, text);
+        if (!builder.read(reader, root) || !reader.finish()) {
+            return Failure<string>{reader.error()};
+        }
+        return document.finish(root);
+    }
+
+    JsonDocument(JsonDocument&&) noexcept = default;
+    JsonDocument& operator=(JsonDocument&&) noexcept = default;
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    const JsonNode& root() const { return *root_; }
+
+    // Bytes reserved for nodes and escaped strings.
+    size_t arena_bytes() const { return arena_.reserved_bytes(); }
+
+private:
+    explicit JsonDocument(size_t first_chunk) : arena_(first_chunk) {}
+
+    Result<JsonDocument, string> finish(const JsonNode& root) {
+        JsonNode* stored = arena_.allocate<JsonNode>(1);
+        root_ = new (stored) JsonNode(root);
+        return Success<JsonDocument>{std::move(*this)};
+    }
+
+    std::unique_ptr<std::string> text_;
+    detail::JsonArena arena_;
+    const JsonNode* root_ = nullptr;
+};
+
+inline bool json_is_null(const JsonNode& node) { return node.kind == JsonNodeKind::Null; }
+inline bool json_is_boolean(const JsonNode& node) { return node.kind == JsonNodeKind::Boolean; }
+inline bool json_is_string(const JsonNode& node) { return node.kind == JsonNodeKind::String; }
+inline bool json_is_array(const JsonNode& node) { return node.kind == JsonNodeKind::Array; }
+inline bool json_is_object(const JsonNode& node) { return node.kind == JsonNodeKind::Object; }
+
+inline bool json_is_number(const JsonNode& node) {
+    return node.kind == JsonNodeKind::Int || node.kind == JsonNodeKind::Long || node.kind == JsonNodeKind::Double;
 }
 
-template <typename... T>
-const std::variant<std::monostate, T...>& optional_value(const std::variant<std::monostate, T...>& value) {
-    return value;
+inline const char* json_type_name(const JsonNode& node) {
+    switch (node.kind) {
+        case JsonNodeKind::Null: return "null";
+        case JsonNodeKind::Boolean: return "boolean";
+        case JsonNodeKind::Int:
+        case JsonNodeKind::Long:
+        case JsonNodeKind::Double: return "number";
+        case JsonNodeKind::String: return "string";
+        case JsonNodeKind::Array: return "array";
+        case JsonNodeKind::Object: return "object";
+    }
+    return "unknown";
 }
 
-template <typename... T>
-std::variant<std::monostate, T...> optional_value(const std::variant<T...>& value) {
-    return std::visit([](const auto& item) -> std::variant<std::monostate, T...> { return item; }, value);
+inline const JsonNodeArray* json_as_array(const JsonNode& node) {
+    return node.kind == JsonNodeKind::Array ? &node.array : nullptr;
 }
 
-template <typename... T>
-std::variant<T...> unwrap_optional(const std::variant<std::monostate, T...>& value) {
-    return std::visit([](const auto& item) -> std::variant<T...> {
-        using Item = std::decay_t<decltype(item)>;
-        if constexpr (std::is_same_v<Item, std::monostate>) {
-            throw std::runtime_error("unexpected null optional");
-        } else {
-            return item;
+inline const JsonNodeObject* json_as_object(const JsonNode& node) {
+    return node.kind == JsonNodeKind::Object ? &node.object : nullptr;
+}
+
+inline bool json_as_bool(const JsonNode& node) {
+    if (node.kind != JsonNodeKind::Boolean) panic("Expected JSON boolean");
+    return node.boolean;
+}
+
+template <typename Number>
+inline Number json_node_number(const JsonNode& node) {
+    switch (node.kind) {
+        case JsonNodeKind::Int: return static_cast<Number>(node.int_value);
+        case JsonNodeKind::Long: return static_cast<Number>(node.long_value);
+        case JsonNodeKind::Double: return static_cast<Number>(node.double_value);
+        default: panic("Expected JSON number");
+    }
+}
+
+inline int32_t json_as_int(const JsonNode& node) { return json_node_number<int32_t>(node); }
+inline int64_t json_as_long(const JsonNode& node) { return json_node_number<int64_t>(node); }
+inline float json_as_float(const JsonNode& node) { return json_node_number<float>(node); }
+inline double json_as_double(const JsonNode& node) { return json_node_number<double>(node); }
+
+// The string without copying it; valid while the document lives.
+inline std::string_view json_string_view(const JsonNode& node) {
+    if (node.kind != JsonNodeKind::String) panic("Expected JSON string");
+    return node.string.view();
+}
+
+// A copy, so the JsonValue and JsonNode spellings of generated code agree on type.
+inline string json_as_string(const JsonNode& node) {
+    return string(json_string_view(node));
+}
+
+inline bool json_is_lenient_number(const JsonNode& node) {
+    return json_is_number(node) || json_is_boolean(node);
+}
+
+inline bool json_is_lenient_string(const JsonNode& node) {
+    return json_is_null(node) || json_is_string(node) || json_is_boolean(node) || json_is_number(node);
+}
+
+inline bool json_is_lenient_boolean(const JsonNode& node) {
+    if (json_is_boolean(node) || json_is_number(node)) return true;
+    if (!json_is_string(node)) return false;
+    std::string lowered = json_as_string(node);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char ch) {
+        return static_cast<char>(std::tolower(ch));
+    });
+    return lowered == "true" || lowered == "false" || lowered == "1" || lowered == "0";
+}
+
+inline bool json_as_bool_lenient(const JsonNode& node) {
+    switch (node.kind) {
+        case JsonNodeKind::Boolean: return node.boolean;
+        case JsonNodeKind::Int: return node.int_value != 0;
+        case JsonNodeKind::Long: return node.long_value != 0;
+        case JsonNodeKind::Double: return node.double_value != 0.0;
+        case JsonNodeKind::String: {
+            std::string lowered = json_as_string(node);
+            std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char ch) {
+                return static_cast<char>(std::tolower(ch));
+            });
+            if (lowered == "true" || lowered == "1") return true;
+            if (lowered == "false" || lowered == "0") return false;
+            break;
         }
-    }, value);
+        default:
+            break;
+    }
+    panic("Expected lenient JSON boolean");
 }
 
-template <typename T>
-std::shared_ptr<T> unwrap_optional(const std::shared_ptr<T>& value) {
-    return value;
+inline int32_t json_as_int_lenient(const JsonNode& node) {
+    if (json_is_boolean(node)) return node.boolean ? 1 : 0;
+    return json_as_int(node);
 }
 
-template <typename T>
-T unwrap_optional(const std::optional<T>& value) {
-    return value.value();
+inline int64_t json_as_long_lenient(const JsonNode& node) {
+    if (json_is_boolean(node)) return node.boolean ? 1 : 0;
+    return json_as_long(node);
+}
+
+inline float json_as_float_lenient(const JsonNode& node) {
+    if (json_is_boolean(node)) return node.boolean ? 1.0f : 0.0f;
+    return json_as_float(node);
+}
+
+inline double json_as_double_lenient(const JsonNode& node) {
+    if (json_is_boolean(node)) return node.boolean ? 1.0 : 0.0;
+    return json_as_double(node);
+}
+
+inline string json_as_string_lenient(const JsonNode& node) {
+    switch (node.kind) {
+        case JsonNodeKind::Null: return string();
+        case JsonNodeKind::String: return json_as_string(node);
+        case JsonNodeKind::Boolean: return node.boolean ? "true" : "false";
+        case JsonNodeKind::Int: return std::to_string(node.int_value);
+        case JsonNodeKind::Long: return std::to_string(node.long_value);
+        case JsonNodeKind::Double: {
+            std::ostringstream oss;
+            oss << node.double_value;
+            return oss.str();
+        }
+        default:
+            panic("Expected lenient JSON string");
+    }
+}
+
+inline JsonValue::JsonValue(const JsonNode& node) : JsonStorage(std::monostate{}) {
+    JsonStorage& storage = json_storage(*this);
+    switch (node.kind) {
+        case JsonNodeKind::Null: break;
+        case JsonNodeKind::Boolean: storage = node.boolean; break;
+        case JsonNodeKind::Int: storage = node.int_value; break;
+        case JsonNodeKind::Long: storage = node.long_value; break;
+        case JsonNodeKind::Double: storage = node.double_value; break;
+        case JsonNodeKind::String: storage = string(node.string.view()); break;
+        case JsonNodeKind::Array: {
+            auto array = std::make_shared<std::vector<JsonValue>>();
+            array->reserve(node.array.size());
+            for (const JsonNode& element : node.array) array->emplace_back(element);
+            storage = std::move(array);
+            break;
+        }
+        case JsonNodeKind::Object: {
+            auto object = std::make_shared<ordered_map<string, JsonValue>>();
+            for (const JsonMember& member : node.object) (*object)[string(member.first)] = JsonValue(member.second);
+            storage = std::move(object);
+            break;
+        }
+    }
+}
+
+inline void json_write(std::string& out, const JsonNode& node) {
+    switch (node.kind) {
+        case JsonNodeKind::Null: out.append("null"); break;
+        case JsonNodeKind::Boolean: out.append(node.boolean ? "true" : "false"); break;
+        case JsonNodeKind::Int: json_write_integer(out, node.int_value); break;
+        case JsonNodeKind::Long: json_write_integer(out, node.long_value); break;
+        case JsonNodeKind::Double: json_write_double(out, node.double_value); break;
+        case JsonNodeKind::String: json_write_string(out, node.string.view()); break;
+        case JsonNodeKind::Array: {
+            out.push_back('[');
+            bool first = true;
+            for (const JsonNode& element : node.array) {
+                if (!first) out.push_back(',');
+                first = false;
+                json_write(out, element);
+            }
+            out.push_back(']');
+            break;
+        }
+        case JsonNodeKind::Object: {
+            out.push_back('{');
+            bool first = true;
+            for (const JsonMember& member : node.object) {
+                if (!first) out.push_back(',');
+                first = false;
+                json_write_string(out, member.first);
+                out.push_back(':');
+                json_write(out, member.second);
+            }
+            out.push_back('}');
+            break;
+        }
+    }
 }
 
 // ============================================================================
-// Collection helpers
+// String utilities
 // ============================================================================
 
-// Wrap a value in a shared_ptr (used for collection literals with CTAD)
+// Values are rendered by appending to one buffer: scalars are formatted in
+// place (std::to_chars for integers, %g for floating point, matching the
+// ostream output of earlier releases) and containers append their elements
+// rather than concatenating nested temporaries.
+namespace detail {
+
 template <typename T>
-std::shared_ptr<std::decay_t<T>> share(T&& val) {
-    return std::make_shared<std::decay_t<T>>(std::forward<T>(val));
-}
+inline constexpr bool is_text_scalar_v =
+    std::is_same_v<T, std::string>
+    || std::is_convertible_v<const T&, std::string_view>
+    || std::is_arithmetic_v<T>
+    || std::is_same_v<T, char32_t>;
 
 template <typename T>
-T& array_at(const std::shared_ptr<std::vector<T>>& arr, int32_t index, const char* file, int32_t line) {
-    if (!arr) {
-        panic_at(file, line, "Attempted to index null array");
+inline void append_scalar(std::string& out, const T& val) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        out += val;
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        out += std::string_view(val);
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out += val ? "true" : "false";
+    } else if constexpr (std::is_same_v<T, char32_t> || std::is_same_v<T, char> || std::is_same_v<T, signed char>) {
+        // Simple ASCII conversion for now
+        out += static_cast<char>(val);
+    } else if constexpr (std::is_integral_v<T>) {
+        char buffer[24];
+        const auto written = std::to_chars(buffer, buffer + sizeof(buffer), val);
+        out.append(buffer, static_cast<size_t>(written.ptr - buffer));
+    } else {
+        char buffer[32];
+        const int length = std::snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(val));
+        out.append(buffer, static_cast<size_t>(length));
     }
-    if (index < 0 || index >= static_cast<int32_t>(arr->size())) {
-        panic_at(file, line, "Index out of bounds: " + to_string(index));
+}
+
+// Upper bound on the rendered size of a concat() part, or 0 when unknown.
+template <typename T>
+inline size_t to_string_size_hint(const T& val) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        return val.size();
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        return std::string_view(val).size();
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return 24;
+    } else {
+        return 0;
     }
-    return (*arr)[static_cast<size_t>(index)];
 }
 
+} // namespace detail
+
+// Convert any streamable value to string
 template <typename T>
-void array_require_min_size(const std::shared_ptr<std::vector<T>>& arr, int32_t count, const char* file, int32_t line) {
-    if (!arr) {
-        panic_at(file, line, "Attempted to destructure null array");
+inline std::string to_string(const T& val) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        return val;
+    } else if constexpr (detail::is_text_scalar_v<T>) {
+        std::string result;
+        detail::append_scalar(result, val);
+        return result;
+    } else {
+        std::ostringstream oss;
+        oss << val;
+        return oss.str();
     }
-    const auto size = static_cast<int32_t>(arr->size());
-    if (size < count) {
-        panic_at(file, line, "Array destructuring expected at least " + to_string(count) + " elements, got " + to_string(size));
+}
+
+inline std::string to_string(ParseError val) {
+    return ParseError_name(val);
+}
+
+// Append `val` as to_string(val) would render it.  Types without a
+// dedicated overload fall back to their to_string overload.
+template <typename T>
+inline void append_to_string(std::string& out, const T& val) {
+    if constexpr (detail::is_text_scalar_v<T>) {
+        detail::append_scalar(out, val);
+    } else {
+        out += to_string(val);
     }
 }
 
+// Declared up front so nested containers resolve each other's overloads
+// regardless of definition order.
 template <typename T>
-void array_reserve(const std::shared_ptr<std::vector<T>>& arr, int32_t capacity) {
-    if (!arr) {
-        panic("Attempted to reserve capacity on a null array");
+void append_to_string(std::string& out, const std::shared_ptr<std::vector<T>>& val);
+template <typename K, typename V>
+void append_to_string(std::string& out, const std::shared_ptr<ordered_map<K, V>>& val);
+template <typename T>
+void append_to_string(std::string& out, const std::shared_ptr<ordered_set<T>>& val);
+template <typename... Ts>
+void append_to_string(std::string& out, const std::tuple<Ts...>& val);
+template <typename T, typename E>
+void append_to_string(std::string& out, const Result<T, E>& val);
+template <typename E>
+void append_to_string(std::string& out, const Result<void, E>& val);
+template <typename T>
+void append_to_string(std::string& out, const std::optional<T>& val);
+template <typename... Ts>
+void append_to_string(std::string& out, const std::variant<Ts...>& val);
+inline void append_to_string(std::string& out, std::monostate);
+
+template <typename T>
+inline void append_to_string(std::string& out, const std::shared_ptr<std::vector<T>>& val) {
+    if (!val) {
+        out += "null";
+        return;
     }
-    if (capacity > 0) {
-        arr->reserve(static_cast<size_t>(capacity));
+    out += '[';
+    for (size_t i = 0; i < val->size(); ++i) {
+        if (i > 0) out += ", ";
+        append_to_string(out, (*val)[i]);
     }
+    out += ']';
 }
 
-template <typename T>
-Result<T, std::string> array_pop(const std::shared_ptr<std::vector<T>>& arr) {
-    if (!arr) {
-        return Failure<std::string>{"Attempted to pop from null array"};
+template <typename K, typename V>
+inline void append_to_string(std::string& out, const std::shared_ptr<ordered_map<K, V>>& val) {
+    if (!val) {
+        out += "null";
+        return;
     }
-    if (arr->empty()) {
-        return Failure<std::string>{"Attempted to pop from empty array"};
+    out += '{';
+    bool first = true;
+    for (const auto& entry : *val) {
+        if (!first) out += ", ";
+        first = false;
+        append_to_string(out, entry.first);
+        out += ": ";
+        append_to_string(out, entry.second);
     }
-    T value = arr->back();
-    arr->pop_back();
-    return Success<T>{std::move(value)};
+    out += '}';
 }
 
 template <typename T>
-bool array_contains(const std::shared_ptr<std::vector<T>>& arr, const T& element, const char* file, int32_t line) {
-    if (!arr) {
-        panic_at(file, line, "Attempted to search null array");
+inline void append_to_string(std::string& out, const std::shared_ptr<ordered_set<T>>& val) {
+    if (!val) {
+        out += "null";
+        return;
     }
-    return std::find(arr->begin(), arr->end(), element) != arr->end();
+    out += '{';
+    bool first = true;
+    for (const auto& item : *val) {
+        if (!first) out += ", ";
+        first = false;
+        append_to_string(out, item);
+    }
+    out += '}';
+}
+
+template <typename... Ts, std::size_t... Is>
+inline void tuple_append_to_string_impl(std::string& out, const std::tuple<Ts...>& val, std::index_sequence<Is...>) {
+    ((out += (Is == 0 ? "" : ", "), append_to_string(out, std::get<Is>(val))), ...);
+}
+
+template <typename... Ts>
+inline void append_to_string(std::string& out, const std::tuple<Ts...>& val) {
+    out += '(';
+    tuple_append_to_string_impl(out, val, std::index_sequence_for<Ts...>{});
+    out += ')';
+}
+
+template <typename T, typename E>
+inline void append_to_string(std::string& out, const Result<T, E>& val) {
+    if (is_success(val)) {
+        out += "Success(";
+        append_to_string(out, success_value(val));
+    } else {
+        out += "Failure(";
+        append_to_string(out, failure_error(val));
+    }
+    out += ')';
+}
+
+template <typename E>
+inline void append_to_string(std::string& out, const Result<void, E>& val) {
+    if (is_success(val)) {
+        out += "Success()";
+        return;
+    }
+    out += "Failure(";
+    append_to_string(out, failure_error(val));
+    out += ')';
 }
 
 template <typename T>
-int32_t array_indexOf(const std::shared_ptr<std::vector<T>>& arr, const T& element, const char* file, int32_t line) {
-    if (!arr) {
-        panic_at(file, line, "Attempted to search null array");
+inline void append_to_string(std::string& out, const std::optional<T>& val) {
+    if (val.has_value()) {
+        append_to_string(out, *val);
+    } else {
+        out += "null";
     }
-    const auto size = static_cast<int32_t>(arr->size());
-    for (int32_t i = 0; i < size; i++) {
-        if ((*arr)[static_cast<size_t>(i)] == element) {
-            return i;
+}
+
+inline void append_to_string(std::string& out, std::monostate) {
+    out += "null";
+}
+
+template <typename... Ts>
+inline void append_to_string(std::string& out, const std::variant<Ts...>& val) {
+    std::visit([&out](const auto& inner) {
+        using Inner = std::decay_t<decltype(inner)>;
+        if constexpr (std::is_same_v<Inner, std::monostate>) {
+            out += "null";
+        } else {
+            append_to_string(out, inner);
         }
-    }
-    return -1;
+    }, val);
+}
+
+template <typename T>
+inline std::string to_string(const std::shared_ptr<std::vector<T>>& val) {
+    std::string result;
+    append_to_string(result, val);
+    return result;
+}
+
+template <typename K, typename V>
+inline std::string to_string(const std::shared_ptr<ordered_map<K, V>>& val) {
+    std::string result;
+    append_to_string(result, val);
+    return result;
+}
+
+template <typename T>
+inline std::string to_string(const std::shared_ptr<ordered_set<T>>& val) {
+    std::string result;
+    append_to_string(result, val);
+    return result;
+}
+
+template <typename... Ts>
+inline std::string to_string(const std::tuple<Ts...>& val) {
+    std::string result;
+    append_to_string(result, val);
+    return result;
+}
+
+template <typename T, typename E>
+inline std::string to_string(const Result<T, E>& val) {
+    std::string result;
+    append_to_string(result, val);
+    return result;
+}
+
+template <typename E>
+inline std::string to_string(const Result<void, E>& val) {
+    std::string result;
+    append_to_string(result, val);
+    return result;
+}
+
+template <typename T>
+inline std::string to_string(const std::optional<T>& val) {
+    std::string result;
+    append_to_string(result, val);
+    return result;
+}
+
+inline std::string to_string(std::monostate) {
+    return "null";
+}
+
+template <typename... Ts>
+inline std::string to_string(const std::variant<Ts...>& val) {
+    std::string result;
+    append_to_string(result, val);
+    return result;
+}
+
+// Variadic string concatenation for string interpolation: sizes the result
+// once from the parts that know their length, then appends each in place.
+inline std::string concat() { return ""; }
+
+template <typename... Args>
+inline std::string concat(const Args&... parts) {
+    std::string result;
+    result.reserve((detail::to_string_size_hint(parts) + ...));
+    (append_to_string(result, parts), ...);
+    return result;
+}
+
+inline bool string_has_outer_whitespace(const std::string& s) {
+    if (s.empty()) return false;
+    const auto first = static_cast<unsigned char>(s.front());
+    const auto last = static_cast<unsigned char>(s.back());
+    return std::isspace(first) || std::isspace(last);
+}
+
+inline Result<int32_t, ParseError> parse_int(const std::string& s) {
+    if (s.empty()) return Failure<ParseError>{ParseError::EmptyInput};
+    if (string_has_outer_whitespace(s)) return Failure<ParseError>{ParseError::InvalidFormat};
+
+    errno = 0;
+    char* end = nullptr;
+    const long long value = std::strtoll(s.c_str(), &end, 10);
+    if (end == s.c_str() || (end != nullptr && *end != 0)) {
+        return Failure<ParseError>{ParseError::InvalidFormat};
+    }
+    if (errno == ERANGE || value > std::numeric_limits<int32_t>::max()) {
+        return Failure<ParseError>{ParseError::Overflow};
+    }
+    if (errno == ERANGE || value < std::numeric_limits<int32_t>::min()) {
+        return Failure<ParseError>{ParseError::Underflow};
+    }
+    return Success<int32_t>{static_cast<int32_t>(value)};
+}
+
+inline Result<uint8_t, ParseError> parse_byte(const std::string& s) {
+    const auto parsed = parse_int(s);
+    if (is_failure(parsed)) {
+        return Failure<ParseError>{failure_error(parsed)};
+    }
+
+    const int32_t value = success_value(parsed);
+    if (value < 0) {
+        return Failure<ParseError>{ParseError::Underflow};
+    }
+    if (value > 255) {
+        return Failure<ParseError>{ParseError::Overflow};
+    }
+
+    return Success<uint8_t>{static_cast<uint8_t>(value)};
+}
+
+inline Result<int64_t, ParseError> parse_long(const std::string& s) {
+    if (s.empty()) return Failure<ParseError>{ParseError::EmptyInput};
+    if (string_has_outer_whitespace(s)) return Failure<ParseError>{ParseError::InvalidFormat};
+
+    errno = 0;
+    char* end = nullptr;
+    const long long value = std::strtoll(s.c_str(), &end, 10);
+    if (end == s.c_str() || (end != nullptr && *end != 0)) {
+        return Failure<ParseError>{ParseError::InvalidFormat};
+    }
+    if (errno == ERANGE) {
+        return Failure<ParseError>{value < 0 ? ParseError::Underflow : ParseError::Overflow};
+    }
+    return Success<int64_t>{static_cast<int64_t>(value)};
+}
+
+inline Result<float, ParseError> parse_float(const std::string& s) {
+    if (s.empty()) return Failure<ParseError>{ParseError::EmptyInput};
+    if (string_has_outer_whitespace(s)) return Failure<ParseError>{ParseError::InvalidFormat};
+
+    errno = 0;
+    char* end = nullptr;
+    const float value = std::strtof(s.c_str(), &end);
+    if (end == s.c_str() || (end != nullptr && *end != 0)) {
+        return Failure<ParseError>{ParseError::InvalidFormat};
+    }
+    if (errno == ERANGE) {
+        return Failure<ParseError>{value == 0.0f ? ParseError::Underflow : ParseError::Overflow};
+    }
+    return Success<float>{value};
+}
+
+inline Result<double, ParseError> parse_double(const std::string& s) {
+    if (s.empty()) return Failure<ParseError>{ParseError::EmptyInput};
+    if (string_has_outer_whitespace(s)) return Failure<ParseError>{ParseError::InvalidFormat};
+
+    errno = 0;
+    char* end = nullptr;
+    const double value = std::strtod(s.c_str(), &end);
+    if (end == s.c_str() || (end != nullptr && *end != 0)) {
+        return Failure<ParseError>{ParseError::InvalidFormat};
+    }
+    if (errno == ERANGE) {
+        return Failure<ParseError>{value == 0.0 ? ParseError::Underflow : ParseError::Overflow};
+    }
+    return Success<double>{value};
+}
+
+// ============================================================================
+// String methods
+// ============================================================================
+
+// Queries take views so the emitter can hand them a trimmed or sliced
+// receiver without materialising it.
+inline int32_t string_indexOf(std::string_view s, std::string_view search) {
+    auto pos = s.find(search);
+    return pos == std::string_view::npos ? -1 : static_cast<int32_t>(pos);
+}
+
+inline bool string_contains(std::string_view s, std::string_view search) {
+    return s.find(search) != std::string_view::npos;
+}
+
+inline bool string_startsWith(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+inline bool string_endsWith(std::string_view s, std::string_view suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+inline std::string string_substring(const std::string& s, int32_t start, int32_t end) {
+    if (start < 0) start = 0;
+    if (end > static_cast<int32_t>(s.size())) end = static_cast<int32_t>(s.size());
+    if (start >= end) return "";
+    return s.substr(static_cast<size_t>(start), static_cast<size_t>(end - start));
+}
+
+inline std::string string_slice(const std::string& s, int32_t start) {
+    if (start < 0) start = 0;
+    if (start >= static_cast<int32_t>(s.size())) return "";
+    return s.substr(static_cast<size_t>(start));
+}
+
+inline std::string string_padStart(const std::string& s, int32_t length, char fill) {
+    if (length <= static_cast<int32_t>(s.size())) return s;
+    return std::string(static_cast<size_t>(length - static_cast<int32_t>(s.size())), fill) + s;
+}
+
+inline std::string string_trim(const std::string& s) {
+    auto start = s.find_first_not_of(" \t\n\r\f\v");
+    if (start == std::string::npos) return "";
+    auto end = s.find_last_not_of(" \t\n\r\f\v");
+    return s.substr(start, end - start + 1);
+}
+
+inline std::string string_trimStart(const std::string& s) {
+    auto start = s.find_first_not_of(" \t\n\r\f\v");
+    if (start == std::string::npos) return "";
+    return s.substr(start);
+}
+
+inline std::string string_trimEnd(const std::string& s) {
+    auto end = s.find_last_not_of(" \t\n\r\f\v");
+    if (end == std::string::npos) return "";
+    return s.substr(0, end + 1);
+}
+
+inline std::string string_trimEnd(const std::string& s, char fill) {
+    auto end = s.find_last_not_of(fill);
+    if (end == std::string::npos) return "";
+    return s.substr(0, end + 1);
+}
+
+inline std::string string_toUpperCase(const std::string& s) {
+    std::string result = s;
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+    return result;
+}
+
+inline std::string string_toLowerCase(const std::string& s) {
+    std::string result = s;
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return result;
+}
+
+inline std::string string_replace(const std::string& s, const std::string& search, const std::string& replacement) {
+    if (search.empty()) return s;
+    auto pos = s.find(search);
+    if (pos == std::string::npos) return s;
+    std::string result = s;
+    result.replace(pos, search.size(), replacement);
+    return result;
+}
+
+inline std::string string_replaceAll(const std::string& s, const std::string& search, const std::string& replacement) {
+    if (search.empty()) return s;
+    std::string result = s;
+    size_t pos = 0;
+    while ((pos = result.find(search, pos)) != std::string::npos) {
+        result.replace(pos, search.size(), replacement);
+        pos += replacement.size();
+    }
+    return result;
+}
+
+inline std::shared_ptr<std::vector<std::string>> string_split(const std::string& s, const std::string& delimiter) {
+    auto result = std::make_shared<std::vector<std::string>>();
+    if (delimiter.empty()) {
+        for (char c : s) result->push_back(std::string(1, c));
+        return result;
+    }
+    size_t start = 0;
+    size_t pos;
+    while ((pos = s.find(delimiter, start)) != std::string::npos) {
+        result->push_back(s.substr(start, pos - start));
+        start = pos + delimiter.size();
+    }
+    result->push_back(s.substr(start));
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// SharedString overloads. Substrings, slices, trims and split fields share the
+// receiver's buffer instead of copying it.
+// ----------------------------------------------------------------------------
+
+inline SharedString string_substring(const SharedString& s, int32_t start, int32_t end) {
+    if (start < 0) start = 0;
+    if (end > static_cast<int32_t>(s.size())) end = static_cast<int32_t>(s.size());
+    if (start >= end) return SharedString();
+    return s.substr(static_cast<size_t>(start), static_cast<size_t>(end - start));
+}
+
+inline SharedString string_slice(const SharedString& s, int32_t start) {
+    if (start < 0) start = 0;
+    if (start >= static_cast<int32_t>(s.size())) return SharedString();
+    return s.substr(static_cast<size_t>(start));
+}
+
+inline SharedString string_trim(const SharedString& s) {
+    const std::string_view text = s.view();
+    auto start = text.find_first_not_of(" \t\n\r\f\v");
+    if (start == std::string_view::npos) return SharedString();
+    auto end = text.find_last_not_of(" \t\n\r\f\v");
+    return s.substr(start, end - start + 1);
+}
+
+inline SharedString string_trimStart(const SharedString& s) {
+    auto start = s.view().find_first_not_of(" \t\n\r\f\v");
+    if (start == std::string_view::npos) return SharedString();
+    return s.substr(start);
+}
+
+inline SharedString string_trimEnd(const SharedString& s) {
+    auto end = s.view().find_last_not_of(" \t\n\r\f\v");
+    if (end == std::string_view::npos) return SharedString();
+    return s.substr(0, end + 1);
+}
+
+inline SharedString string_trimEnd(const SharedString& s, char fill) {
+    auto end = s.view().find_last_not_of(fill);
+    if (end == std::string_view::npos) return SharedString();
+    return s.substr(0, end + 1);
+}
+
+inline std::shared_ptr<std::vector<SharedString>> string_split(const SharedString& s, std::string_view delimiter) {
+    auto result = std::make_shared<std::vector<SharedString>>();
+    const std::string_view text = s.view();
+    if (delimiter.empty()) {
+        for (char c : text) result->push_back(SharedString(std::string_view(&c, 1)));
+        return result;
+    }
+    size_t start = 0;
+    size_t pos;
+    while ((pos = text.find(delimiter, start)) != std::string_view::npos) {
+        result->push_back(s.substr(start, pos - start));
+        start = pos + delimiter.size();
+    }
+    result->push_back(s.substr(start));
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// View-returning variants. The emitter uses these only where the result is
+// consumed before the source string can change or die (a query on a trimmed
+// receiver, a comparison, a for-of over split), so nothing is copied.
+// ----------------------------------------------------------------------------
+
+inline std::string_view string_substring_view(std::string_view s, int32_t start, int32_t end) {
+    if (start < 0) start = 0;
+    if (end > static_cast<int32_t>(s.size())) end = static_cast<int32_t>(s.size());
+    if (start >= end) return std::string_view();
+    return s.substr(static_cast<size_t>(start), static_cast<size_t>(end - start));
+}
+
+inline std::string_view string_slice_view(std::string_view s, int32_t start) {
+    if (start < 0) start = 0;
+    if (start >= static_cast<int32_t>(s.size())) return std::string_view();
+    return s.substr(static_cast<size_t>(start));
+}
+
+inline std::string_view string_trim_view(std::string_view s) {
+    auto start = s.find_first_not_of(" \t\n\r\f\v");
+    if (start == std::string_view::npos) return std::string_view();
+    auto end = s.find_last_not_of(" \t\n\r\f\v");
+    return s.substr(start, end - start + 1);
+}
+
+inline std::string_view string_trimStart_view(std::string_view s) {
+    auto start = s.find_first_not_of(" \t\n\r\f\v");
+    if (start == std::string_view::npos) return std::string_view();
+    return s.substr(start);
+}
+
+inline std::string_view string_trimEnd_view(std::string_view s) {
+    auto end = s.find_last_not_of(" \t\n\r\f\v");
+    if (end == std::string_view::npos) return std::string_view();
+    return s.substr(0, end + 1);
+}
+
+/**
+ * Lazy `split` for range-for loops. Yields the same fields as string_split,
+ * one at a time, through a single reused buffer, so a loop over a line's
+ * fields allocates nothing once the buffer has grown. The source and
+ * delimiter must outlive the loop.
+ */
+class StringSplitRange {
+public:
+    class iterator {
+    public:
+        using value_type = std::string;
+
+        const std::string& operator*() const { return range_->field_; }
+        iterator& operator++() {
+            if (!range_->advance()) range_ = nullptr;
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return range_ == other.range_; }
+        bool operator!=(const iterator& other) const { return range_ != other.range_; }
+
+    private:
+        friend class StringSplitRange;
+        explicit iterator(StringSplitRange* range) : range_(range) {}
+        StringSplitRange* range_;
+    };
+
+    StringSplitRange(std::string_view source, std::string_view delimiter)
+        : source_(source), delimiter_(delimiter) {}
+
+    iterator begin() {
+        cursor_ = 0;
+        done_ = false;
+        return iterator(advance() ? this : nullptr);
+    }
+    iterator end() { return iterator(nullptr); }
+
+private:
+    bool advance() {
+        if (done_) return false;
+        if (delimiter_.empty()) {
+            if (cursor_ >= source_.size()) return false;
+            field_.assign(1, source_[cursor_++]);
+            return true;
+        }
+        const size_t pos = source_.find(delimiter_, cursor_);
+        if (pos == std::string_view::npos) {
+            field_.assign(source_.data() + cursor_, source_.size() - cursor_);
+            done_ = true;
+        } else {
+            field_.assign(source_.data() + cursor_, pos - cursor_);
+            cursor_ = pos + delimiter_.size();
+        }
+        return true;
+    }
+
+    std::string_view source_;
+    std::string_view delimiter_;
+    std::string field_;
+    size_t cursor_ = 0;
+    bool done_ = false;
+};
+
+inline StringSplitRange string_split_range(std::string_view s, std::string_view delimiter) {
+    return StringSplitRange(s, delimiter);
+}
+
+inline char32_t string_at(std::string_view s, int32_t index, const char* file, int32_t line) {
+    if (index < 0 || index >= static_cast<int32_t>(s.size())) {
+        panic_at(file, line, "Index out of bounds: " + to_string(index));
+    }
+    return static_cast<char32_t>(static_cast<unsigned char>(s[static_cast<size_t>(index)]));
+}
+
+inline std::string string_repeat(const std::string& s, int32_t count) {
+    if (count <= 0) return "";
+    std::string result;
+    result.reserve(s.size() * static_cast<size_t>(count));
+    for (int32_t i = 0; i < count; ++i) result += s;
+    return result;
+}
+
+// Representation-dependent helpers used by both emitters. Operations whose
+// receiver representation is statically known are lowered directly instead.
+template <typename T>
+bool is_null(const std::shared_ptr<T>& value) {
+    return value == nullptr;
+}
+
+template <typename T>
+bool is_null(const std::optional<T>& value) {
+    return !value.has_value();
+}
+
+template <typename... T>
+bool is_null(const std::variant<std::monostate, T...>& value) {
+    return std::holds_alternative<std::monostate>(value);
+}
+
+template <typename... T>
+std::string kind(const std::variant<std::shared_ptr<T>...>& value) {
+    return std::visit([](const auto& item) { return item->kind; }, value);
+}
+
+template <typename... T>
+std::string kind(const std::variant<std::monostate, std::shared_ptr<T>...>& value) {
+    return std::visit([](const auto& item) {
+        using Item = std::decay_t<decltype(item)>;
+        if constexpr (std::is_same_v<Item, std::monostate>) {
+            return std::string("null");
+        } else {
+            return item->kind;
+        }
+    }, value);
+}
+
+template <typename T>
+auto kind(const std::shared_ptr<T>& value) -> decltype(value->kind) {
+    return value->kind;
+}
+
+template <typename... T>
+auto span(const std::variant<std::shared_ptr<T>...>& value) {
+    return std::visit([](const auto& item) { return item->span; }, value);
+}
+
+template <typename T>
+auto span(const std::shared_ptr<T>& value) {
+    return value->span;
+}
+
+template <typename Candidate, typename Variant>
+struct is_variant_alternative : std::is_same<Candidate, Variant> {};
+
+template <typename Candidate, typename... Alternatives>
+struct is_variant_alternative<Candidate, std::variant<Alternatives...>>
+    : std::bool_constant<(std::is_same_v<Candidate, Alternatives> || ...)> {};
+
+template <typename Target, typename... Source>
+bool variant_is(const std::variant<Source...>& value) {
+    return std::visit([](const auto& item) {
+        using Item = std::decay_t<decltype(item)>;
+        return is_variant_alternative<Item, Target>::value;
+    }, value);
+}
+
+template <typename Target, typename... Source>
+Target variant_narrow(const std::variant<Source...>& value) {
+    return std::visit([](const auto& item) -> Target {
+        using Item = std::decay_t<decltype(item)>;
+        if constexpr (is_variant_alternative<Item, Target>::value) {
+            return item;
+        } else {
+            throw std::runtime_error("variant does not hold a requested alternative");
+        }
+    }, value);
+}
+
+template <typename Target, typename... Source>
+Target variant_promote(const std::variant<Source...>& value) {
+    return std::visit([](const auto& item) -> Target { return item; }, value);
+}
+
+template <typename Target, typename Source>
+Target variant_promote(const Source& value) {
+    return Target{value};
+}
+
+// Single-variant dispatch through one flat table of function pointers indexed
+// by the variant's tag.  Interfaces with many implementers use this instead of
+// std::visit, whose multi-variant machinery dominates their compile time.
+namespace detail {
+
+template <typename R, typename F, typename V, std::size_t I>
+R visit_table_entry(F& visitor, V& value) {
+    return visitor(*std::get_if<I>(&value));
+}
+
+template <typename R, typename F, typename V, std::size_t... I>
+R visit_table(F& visitor, V& value, std::index_sequence<I...>) {
+    static constexpr R (*table[])(F&, V&) = { &visit_table_entry<R, F, V, I>... };
+    if (value.valueless_by_exception()) throw std::bad_variant_access{};
+    return table[value.index()](visitor, value);
+}
+
+} // namespace detail
+
+template <typename F, typename V>
+decltype(auto) visit_table(F&& visitor, V&& value) {
+    using Variant = std::remove_reference_t<V>;
+    using R = std::invoke_result_t<F&, decltype(*std::get_if<0>(&value))>;
+    return detail::visit_table<R>(visitor, value, std::make_index_sequence<std::variant_size_v<std::remove_cv_t<Variant>>>{});
+}
+
+template <typename T>
+decltype(auto) resolved_type(const std::shared_ptr<T>& value) {
+    return (value->resolvedType);
+}
+
+template <typename... T>
+decltype(auto) resolved_type(const std::variant<T...>& value) {
+    return std::visit([](const auto& item) -> decltype(auto) { return (item->resolvedType); }, value);
+}
+
+template <typename... T>
+const std::variant<std::monostate, T...>& optional_value(const std::variant<std::monostate, T...>& value) {
+    return value;
+}
+
+template <typename... T>
+std::variant<std::monostate, T...> optional_value(const std::variant<T...>& value) {
+    return std::visit([](const auto& item) -> std::variant<std::monostate, T...> { return item; }, value);
+}
+
+template <typename... T>
+std::variant<T...> unwrap_optional(const std::variant<std::monostate, T...>& value) {
+    return std::visit([](const auto& item) -> std::variant<T...> {
+        using Item = std::decay_t<decltype(item)>;
+        if constexpr (std::is_same_v<Item, std::monostate>) {
+            throw std::runtime_error("unexpected null optional");
+        } else {
+            return item;
+        }
+    }, value);
+}
+
+template <typename T>
+std::shared_ptr<T> unwrap_optional(const std::shared_ptr<T>& value) {
+    return value;
+}
+
+template <typename T>
+T unwrap_optional(const std::optional<T>& value) {
+    return value.value();
+}
+
+// ============================================================================
+// Collection helpers
+// ============================================================================
+
+// Wrap a value in a shared_ptr (used for collection literals with CTAD)
+template <typename T>
+std::shared_ptr<std::decay_t<T>> share(T&& val) {
+    return std::make_shared<std::decay_t<T>>(std::forward<T>(val));
+}
+
+template <typename T>
+T& array_at(const std::shared_ptr<std::vector<T>>& arr, int32_t index, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to index null array");
+    }
+    if (index < 0 || index >= static_cast<int32_t>(arr->size())) {
+        panic_at(file, line, "Index out of bounds: " + to_string(index));
+    }
+    return (*arr)[static_cast<size_t>(index)];
+}
+
+template <typename T>
+void array_require_min_size(const std::shared_ptr<std::vector<T>>& arr, int32_t count, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to destructure null array");
+    }
+    const auto size = static_cast<int32_t>(arr->size());
+    if (size < count) {
+        panic_at(file, line, "Array destructuring expected at least " + to_string(count) + " elements, got " + to_string(size));
+    }
+}
+
+template <typename T>
+void array_reserve(const std::shared_ptr<std::vector<T>>& arr, int32_t capacity) {
+    if (!arr) {
+        panic("Attempted to reserve capacity on a null array");
+    }
+    if (capacity > 0) {
+        arr->reserve(static_cast<size_t>(capacity));
+    }
+}
+
+template <typename T>
+Result<T, string> array_pop(const std::shared_ptr<std::vector<T>>& arr) {
+    if (!arr) {
+        return Failure<string>{"Attempted to pop from null array"};
+    }
+    if (arr->empty()) {
+        return Failure<string>{"Attempted to pop from empty array"};
+    }
+    T value = arr->back();
+    arr->pop_back();
+    return Success<T>{std::move(value)};
+}
+
+template <typename T>
+bool array_contains(const std::shared_ptr<std::vector<T>>& arr, const T& element, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to search null array");
+    }
+    return std::find(arr->begin(), arr->end(), element) != arr->end();
+}
+
+template <typename T>
+int32_t array_indexOf(const std::shared_ptr<std::vector<T>>& arr, const T& element, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to search null array");
+    }
+    const auto size = static_cast<int32_t>(arr->size());
+    for (int32_t i = 0; i < size; i++) {
+        if ((*arr)[static_cast<size_t>(i)] == element) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+template <typename T, typename Predicate>
+bool array_some(const std::shared_ptr<std::vector<T>>& arr, const Predicate& predicate, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to iterate null array in some()");
+    }
+    for (const auto& item : *arr) {
+        if (detail::invoke_callable(predicate, item)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T, typename Predicate>
+bool array_every(const std::shared_ptr<std::vector<T>>& arr, const Predicate& predicate, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to iterate null array in every()");
+    }
+    for (const auto& item : *arr) {
+        if (!detail::invoke_callable(predicate, item)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T, typename Predicate>
+std::shared_ptr<std::vector<T>> array_filter(const std::shared_ptr<std::vector<T>>& arr, const Predicate& predicate, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to iterate null array in filter()");
+    }
+    auto result = std::make_shared<std::vector<T>>();
+    result->reserve(arr->size());
+    for (const auto& item : *arr) {
+        if (detail::invoke_callable(predicate, item)) {
+            result->push_back(item);
+        }
+    }
+    return result;
+}
+
+template <typename T, typename Mapper>
+auto array_map(const std::shared_ptr<std::vector<T>>& arr, const Mapper& mapper, const char* file, int32_t line)
+    -> std::shared_ptr<std::vector<std::decay_t<decltype(detail::invoke_callable(std::declval<const Mapper&>(), std::declval<const T&>()))>>> {
+    if (!arr) {
+        panic_at(file, line, "Attempted to iterate null array in map()");
+    }
+    using U = std::decay_t<decltype(detail::invoke_callable(std::declval<const Mapper&>(), std::declval<const T&>()))>;
+    auto result = std::make_shared<std::vector<U>>();
+    result->reserve(arr->size());
+    for (const auto& item : *arr) {
+        result->push_back(detail::invoke_callable(mapper, item));
+    }
+    return result;
+}
+
+/**
+ * Fused filter/map/some/every chain over one array. The emitter lowers
+ * `arr.filter(p).map(f).some(q)` with inline lambdas to
+ * `array_pipeline(arr, ...).filter(p).map(f).some(q)`: each stage wraps the
+ * previous source in a push loop, so the whole chain runs as a single pass
+ * with no intermediate vectors and no type-erased calls. Stages must be
+ * consumed within the full-expression that built them.
+ */
+template <typename T, typename Source>
+class ArrayPipeline {
+public:
+    ArrayPipeline(Source source, size_t size_hint)
+        : source_(std::move(source)), size_hint_(size_hint) {}
+
+    template <typename Predicate>
+    auto filter(Predicate predicate) && {
+        auto source = [inner = std::move(source_), predicate = std::move(predicate)](auto&& sink) {
+            return inner([&](const T& item) { return predicate(item) ? sink(item) : true; });
+        };
+        return ArrayPipeline<T, decltype(source)>(std::move(source), size_hint_);
+    }
+
+    template <typename Mapper>
+    auto map(Mapper mapper) && {
+        using U = std::decay_t<std::invoke_result_t<const Mapper&, const T&>>;
+        auto source = [inner = std::move(source_), mapper = std::move(mapper)](auto&& sink) {
+            return inner([&](const T& item) { return sink(static_cast<const U&>(mapper(item))); });
+        };
+        return ArrayPipeline<U, decltype(source)>(std::move(source), size_hint_);
+    }
+
+    template <typename Predicate>
+    bool some(Predicate predicate) && {
+        return !source_([&](const T& item) { return !predicate(item); });
+    }
+
+    template <typename Predicate>
+    bool every(Predicate predicate) && {
+        return source_([&](const T& item) { return static_cast<bool>(predicate(item)); });
+    }
+
+    std::shared_ptr<std::vector<T>> collect() && {
+        auto result = std::make_shared<std::vector<T>>();
+        result->reserve(size_hint_);
+        source_([&](const T& item) {
+            result->push_back(item);
+            return true;
+        });
+        return result;
+    }
+
+private:
+    Source source_;
+    size_t size_hint_;
+};
+
+template <typename T>
+auto array_pipeline(const std::shared_ptr<std::vector<T>>& arr, const char* operation, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, std::string("Attempted to iterate null array in ") + operation + "()");
+    }
+    // Sinks return false to stop early; the source reports whether it ran to the end.
+    auto source = [items = arr](auto&& sink) {
+        for (const auto& item : *items) {
+            if (!sink(item)) return false;
+        }
+        return true;
+    };
+    const size_t size = arr->size();
+    return ArrayPipeline<T, decltype(source)>(std::move(source), size);
+}
+
+template <typename T>
+std::shared_ptr<std::vector<T>> array_slice(const std::shared_ptr<std::vector<T>>& arr, int32_t start, int32_t end, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to slice null array");
+    }
+
+    const int32_t size = static_cast<int32_t>(arr->size());
+    if (start < 0) start = 0;
+    if (end < 0) end = 0;
+    if (start > size) start = size;
+    if (end > size) end = size;
+    if (start >= end) {
+        return std::make_shared<std::vector<T>>();
+    }
+
+    using Diff = typename std::vector<T>::difference_type;
+    return std::make_shared<std::vector<T>>(
+        arr->begin() + static_cast<Diff>(start),
+        arr->begin() + static_cast<Diff>(end)
+    );
+}
+
+template <typename T>
+std::shared_ptr<std::vector<T>> array_buildReadonly(const std::shared_ptr<std::vector<T>>& arr, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to buildReadonly from null array");
+    }
+    // Move-drain: transfer contents to a new allocation; original vector is left empty.
+    auto result = std::make_shared<std::vector<T>>(std::move(*arr));
+    arr->clear();
+    return result;
+}
+
+template <typename T>
+std::shared_ptr<std::vector<T>> array_cloneMutable(const std::shared_ptr<std::vector<T>>& arr, const char* file, int32_t line) {
+    if (!arr) {
+        panic_at(file, line, "Attempted to cloneMutable from null array");
+    }
+    return std::make_shared<std::vector<T>>(*arr);
+}
+
+// Map helpers — bridge Doof's Map methods to ordered_map
+template <typename K, typename V>
+doof::Result<V, string> map_get(const std::shared_ptr<ordered_map<K, V>>& m, const K& key, const char* file, int32_t line) {
+    if (!m) {
+        panic_at(file, line, "Attempted to access null map");
+    }
+    m->validate_invariants("map_get");
+    auto it = m->find(key);
+    if (it != m->end()) return doof::Success<V>{it->second};
+    return doof::Failure<string>{"Map key not found"};
+}
+
+template <typename K, typename V>
+V& map_at(const std::shared_ptr<ordered_map<K, V>>& m, const K& key, const char* file, int32_t line) {
+    if (!m) {
+        panic_at(file, line, "Attempted to index null map");
+    }
+    m->validate_invariants("map_at");
+    auto it = m->find(key);
+    if (it == m->end()) {
+        panic_at(file, line, "Map key not found");
+    }
+    return it->second;
+}
+
+template <typename K, typename V>
+V& map_index(const std::shared_ptr<ordered_map<K, V>>& m, const K& key, const char* file, int32_t line) {
+    if (!m) {
+        panic_at(file, line, "Attempted to index null map");
+    }
+    m->validate_invariants("map_index");
+    return (*m)[key];
+}
+
+template <typename K, typename V>
+void map_set(const std::shared_ptr<ordered_map<K, V>>& m, const K& key, const V& value, const char* file, int32_t line) {
+    if (!m) {
+        panic_at(file, line, "Attempted to mutate null map");
+    }
+    m->insert_or_assign(key, value);
+}
+
+template <typename K, typename V>
+std::shared_ptr<std::vector<K>> map_keys(const std::shared_ptr<ordered_map<K, V>>& m, const char* file, int32_t line) {
+    if (!m) {
+        panic_at(file, line, "Attempted to read keys from null map");
+    }
+    m->validate_invariants("map_keys");
+    auto result = std::make_shared<std::vector<K>>();
+    result->reserve(m->size());
+    for (const auto& [k, v] : *m) result->push_back(k);
+    return result;
+}
+
+template <typename K, typename V>
+std::shared_ptr<std::vector<V>> map_values(const std::shared_ptr<ordered_map<K, V>>& m, const char* file, int32_t line) {
+    if (!m) {
+        panic_at(file, line, "Attempted to read values from null map");
+    }
+    m->validate_invariants("map_values");
+    auto result = std::make_shared<std::vector<V>>();
+    result->reserve(m->size());
+    for (const auto& [k, v] : *m) result->push_back(v);
+    return result;
+}
+
+template <typename K, typename V>
+std::shared_ptr<ordered_map<K, V>> map_buildReadonly(const std::shared_ptr<ordered_map<K, V>>& m, const char* file, int32_t line) {
+    if (!m) {
+        panic_at(file, line, "Attempted to buildReadonly from null map");
+    }
+    m->validate_invariants("map_buildReadonly source");
+    auto result = std::make_shared<ordered_map<K, V>>(std::move(*m));
+    m->clear();
+    result->validate_invariants("map_buildReadonly result");
+    return result;
+}
+
+template <typename K, typename V>
+std::shared_ptr<ordered_map<K, V>> map_cloneMutable(const std::shared_ptr<ordered_map<K, V>>& m, const char* file, int32_t line) {
+    if (!m) {
+        panic_at(file, line, "Attempted to cloneMutable from null map");
+    }
+    m->validate_invariants("map_cloneMutable");
+    return std::make_shared<ordered_map<K, V>>(*m);
+}
+
+template <typename T>
+std::shared_ptr<std::vector<T>> set_values(const std::shared_ptr<ordered_set<T>>& s, const char* file, int32_t line) {
+    if (!s) {
+        panic_at(file, line, "Attempted to read values from null set");
+    }
+    s->validate_invariants("set_values");
+    auto result = std::make_shared<std::vector<T>>();
+    result->reserve(s->size());
+    for (const auto& value : *s) result->push_back(value);
+    return result;
+}
+
+template <typename T>
+std::shared_ptr<ordered_set<T>> set_buildReadonly(const std::shared_ptr<ordered_set<T>>& s, const char* file, int32_t line) {
+    if (!s) {
+        panic_at(file, line, "Attempted to buildReadonly from null set");
+    }
+    s->validate_invariants("set_buildReadonly source");
+    auto result = std::make_shared<ordered_set<T>>(std::move(*s));
+    s->clear();
+    result->validate_invariants("set_buildReadonly result");
+    return result;
+}
+
+template <typename T>
+std::shared_ptr<ordered_set<T>> set_cloneMutable(const std::shared_ptr<ordered_set<T>>& s, const char* file, int32_t line) {
+    if (!s) {
+        panic_at(file, line, "Attempted to cloneMutable from null set");
+    }
+    s->validate_invariants("set_cloneMutable");
+    return std::make_shared<ordered_set<T>>(*s);
+}
+
+// ============================================================================
+// Print utilities
+// ============================================================================
+
+template <typename T>
+inline void println(const T& val) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        std::cout << val << std::endl;
+    } else if constexpr (std::is_same_v<T, const char*>) {
+        std::cout << val << std::endl;
+    } else {
+        std::cout << to_string(val) << std::endl;
+    }
+}
+
+inline void println() {
+    std::cout << std::endl;
+}
+
+template <typename T>
+inline void print(const T& val) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        std::cout << val;
+    } else if constexpr (std::is_same_v<T, const char*>) {
+        std::cout << val;
+    } else {
+        std::cout << to_string(val);
+    }
+}
+
+// ============================================================================
+// Range utilities
+// ============================================================================
+
+struct Range {
+    int32_t lowerBound;
+    int32_t upperBound;
+
+    struct Iterator {
+        int32_t current;
+
+        int32_t operator*() const { return current; }
+        Iterator& operator++() {
+            ++current;
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const {
+            return current != other.current;
+        }
+    };
+
+    Iterator begin() const {
+        bool rev = lowerBound > upperBound;
+        if (rev) return Iterator{lowerBound};
+        return Iterator{lowerBound};
+    }
+    Iterator end() const {
+        bool rev = lowerBound > upperBound;
+        if (rev) return Iterator{lowerBound};
+        return Iterator{upperBound};
+    }
+};
+
+inline Range range(int32_t start, int32_t end) {
+    return Range{start, end + 1};
+}
+
+inline Range range_exclusive(int32_t start, int32_t end) {
+    return Range{start, end};
+}
+
+// The emitter moves the region between these markers (actors, promises and
+// parallel algorithms) into doof_runtime_actors.hpp, which only modules that
+// use them include. It also owns the <future> and <thread> includes.
+/* __DOOF_RUNTIME_ACTORS_BEGIN__ */
+// ============================================================================
+// Actor scheduler — carrier threads that run ready actor mailboxes
+// ============================================================================
+//
+// Actors share a fixed pool of carrier threads sized to the core count. An
+// actor with queued work is scheduled onto exactly one carrier at a time, so
+// its messages still run serially. Idle carriers steal ready actors from busy
+// ones. `DOOF_ACTOR_CARRIERS` overrides the pool width at startup; defining
+// `DOOF_ACTOR_THREAD_PER_ACTOR` restores one dedicated thread per actor.
+
+namespace detail {
+
+#if defined(DOOF_ACTOR_THREAD_PER_ACTOR)
+
+class BlockingScope {
+public:
+    BlockingScope() {}
+    ~BlockingScope() {}
+    BlockingScope(const BlockingScope&) = delete;
+    BlockingScope& operator=(const BlockingScope&) = delete;
+};
+
+#else
+
+class ScheduledMailbox {
+public:
+    virtual ~ScheduledMailbox() = default;
+    // Run a bounded slice of queued work. Returns true when work remains and
+    // the mailbox must be scheduled again.
+    virtual bool run_slice() = 0;
+};
+
+class ActorScheduler final {
+public:
+    static constexpr int slice_budget = 64;
+
+    static ActorScheduler& shared() {
+        // Leaked on purpose: carriers stay parked until process exit so actors
+        // destroyed during static teardown can still drain their mailboxes.
+        static ActorScheduler* scheduler = new ActorScheduler();
+        return *scheduler;
+    }
+
+    void schedule(ScheduledMailbox* mailbox) {
+        Carrier* local = current_carrier();
+        if (local != nullptr && local->bound) {
+            std::lock_guard<std::mutex> lock(local->mutex);
+            local->ready.push_back(mailbox);
+        } else {
+            std::lock_guard<std::mutex> lock(injection_mutex_);
+            injection_.push_back(mailbox);
+        }
+        pending_.fetch_add(1);
+        if (sleeping_.load() > 0) {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_.notify_one();
+        }
+    }
+
+    // A carrier that parks in a blocking wait hands its slot to a compensation
+    // carrier so nested synchronous calls cannot starve the pool.
+    static bool enter_blocking() {
+        Carrier* local = current_carrier();
+        if (local == nullptr || local->blocking++ > 0) {
+            return false;
+        }
+        auto& scheduler = shared();
+        if (scheduler.active_.fetch_sub(1) - 1 < scheduler.target_) {
+            scheduler.spawn_compensation();
+        }
+        return true;
+    }
+
+    // Carrier pool width, excluding compensation carriers.
+    static int width() {
+        return shared().target_;
+    }
+
+    static void leave_blocking() {
+        --current_carrier()->blocking;
+        auto& scheduler = shared();
+        if (scheduler.active_.fetch_add(1) + 1 > scheduler.target_ && scheduler.sleeping_.load() > 0) {
+            // Let a parked compensation carrier notice the pool is over width.
+            std::lock_guard<std::mutex> lock(scheduler.idle_mutex_);
+            scheduler.idle_.notify_all();
+        }
+    }
+
+private:
+    struct Carrier {
+        std::mutex mutex;
+        std::deque<ScheduledMailbox*> ready;
+        size_t index = 0;
+        bool bound = false;
+        int blocking = 0;
+    };
+
+    static Carrier*& current_carrier() {
+        static thread_local Carrier* carrier = nullptr;
+        return carrier;
+    }
+
+    ActorScheduler() {
+        int width = static_cast<int>(std::thread::hardware_concurrency());
+        if (const char* configured = std::getenv("DOOF_ACTOR_CARRIERS")) {
+            const int parsed = std::atoi(configured);
+            if (parsed > 0) width = parsed;
+        }
+        target_ = width > 0 ? width : 1;
+        for (int index = 0; index < target_; ++index) {
+            auto carrier = std::make_unique<Carrier>();
+            carrier->index = static_cast<size_t>(index);
+            carrier->bound = true;
+            bound_.push_back(std::move(carrier));
+        }
+        for (auto& carrier : bound_) {
+            active_.fetch_add(1);
+            std::thread(&ActorScheduler::run_carrier, this, carrier.get()).detach();
+        }
+    }
+
+    void spawn_compensation() {
+        active_.fetch_add(1);
+        std::thread(&ActorScheduler::run_carrier, this, nullptr).detach();
+    }
+
+    void run_carrier(Carrier* carrier) {
+        std::unique_ptr<Carrier> compensation;
+        if (carrier == nullptr) {
+            compensation = std::make_unique<Carrier>();
+            carrier = compensation.get();
+        }
+        current_carrier() = carrier;
+        while (true) {
+            if (ScheduledMailbox* mailbox = next_ready(*carrier)) {
+                if (mailbox->run_slice()) {
+                    schedule(mailbox);
+                }
+            } else if (carrier->bound || !over_target()) {
+                park(!carrier->bound);
+                continue;
+            }
+            if (!carrier->bound && retire_compensation()) {
+                return;
+            }
+        }
+    }
+
+    ScheduledMailbox* next_ready(Carrier& self) {
+        if (self.bound) {
+            if (ScheduledMailbox* mailbox = pop_front(self.mutex, self.ready)) return mailbox;
+        }
+        if (ScheduledMailbox* mailbox = pop_front(injection_mutex_, injection_)) return mailbox;
+        const size_t count = bound_.size();
+        for (size_t offset = 1; offset <= count; ++offset) {
+            Carrier& victim = *bound_[(self.index + offset) % count];
+            if (&victim == &self) continue;
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.ready.empty()) {
+                ScheduledMailbox* mailbox = victim.ready.back();
+                victim.ready.pop_back();
+                pending_.fetch_sub(1);
+                return mailbox;
+            }
+        }
+        return nullptr;
+    }
+
+    ScheduledMailbox* pop_front(std::mutex& mutex, std::deque<ScheduledMailbox*>& queue) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) return nullptr;
+        ScheduledMailbox* mailbox = queue.front();
+        queue.pop_front();
+        pending_.fetch_sub(1);
+        return mailbox;
+    }
+
+    void park(bool compensating) {
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        sleeping_.fetch_add(1);
+        idle_.wait(lock, [this, compensating] {
+            return pending_.load() > 0 || (compensating && over_target());
+        });
+        sleeping_.fetch_sub(1);
+    }
+
+    bool over_target() const {
+        return active_.load() > target_;
+    }
+
+    bool retire_compensation() {
+        int active = active_.load();
+        while (active > target_) {
+            if (active_.compare_exchange_weak(active, active - 1)) return true;
+        }
+        return false;
+    }
+
+    int target_ = 1;
+    std::vector<std::unique_ptr<Carrier>> bound_;
+    std::mutex injection_mutex_;
+    std::deque<ScheduledMailbox*> injection_;
+    std::atomic<int64_t> pending_{0};
+    std::atomic<int> active_{0};
+    std::atomic<int> sleeping_{0};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+};
+
+// RAII marker for waits that may park the current thread. On carriers it keeps
+// the pool at full width for the duration of the wait; elsewhere it is free.
+class BlockingScope {
+    bool entered_;
+public:
+    BlockingScope() : entered_(ActorScheduler::enter_blocking()) {}
+    ~BlockingScope() {
+        if (entered_) ActorScheduler::leave_blocking();
+    }
+    BlockingScope(const BlockingScope&) = delete;
+    BlockingScope& operator=(const BlockingScope&) = delete;
+};
+
+#endif
+} // namespace detail
+
+// ============================================================================
+// Parallel array algorithms — chunked work across the carrier pool
+// ============================================================================
+//
+// parallelMap / parallelFilter / parallelReduce / parallelSort split a
+// readonly array into contiguous chunks and run them on the actor carriers,
+// with the calling thread claiming chunks too so the call always makes
+// progress. The checker only admits callbacks it can prove isolated, and the
+// emitter passes them as bare functors, so chunks never touch actor-affine
+// state. Results keep the input order.
+
+namespace detail {
+
+class ParallelJob {
+public:
+    ParallelJob(size_t chunks, std::function<void(size_t)> body)
+        : chunks_(chunks), body_(std::move(body)) {}
+
+    void run_chunks() {
+        size_t chunk;
+        while ((chunk = next_.fetch_add(1, std::memory_order_relaxed)) < chunks_) {
+            body_(chunk);
+            if (done_.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks_) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                finished_ = true;
+                finished_cv_.notify_all();
+            }
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (finished_) return;
+        BlockingScope blocking;
+        finished_cv_.wait(lock, [this] { return finished_; });
+    }
+
+private:
+    const size_t chunks_;
+    std::function<void(size_t)> body_;
+    std::atomic<size_t> next_{0};
+    std::atomic<size_t> done_{0};
+    std::mutex mutex_;
+    std::condition_variable finished_cv_;
+    bool finished_ = false;
+};
+
+#if !defined(DOOF_ACTOR_THREAD_PER_ACTOR)
+class ParallelHelper final : public ScheduledMailbox {
+public:
+    explicit ParallelHelper(std::shared_ptr<ParallelJob> job) : job_(std::move(job)) {}
+
+    bool run_slice() override {
+        job_->run_chunks();
+        delete this;
+        return false;
+    }
+
+private:
+    std::shared_ptr<ParallelJob> job_;
+};
+#endif
+
+inline size_t parallel_width() {
+#if defined(DOOF_ACTOR_THREAD_PER_ACTOR)
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+#else
+    return static_cast<size_t>(ActorScheduler::width());
+#endif
+}
+
+// Below this many elements per chunk the hand-off costs more than it saves.
+constexpr size_t parallel_min_chunk = 256;
+
+inline size_t parallel_chunk_count(size_t size) {
+    const size_t width = parallel_width();
+    if (width <= 1) return 1;
+    const size_t by_size = (size + parallel_min_chunk - 1) / parallel_min_chunk;
+    return std::max<size_t>(1, std::min(by_size, width * 4));
+}
+
+// Runs body(chunk) for every chunk in [0, chunks) and returns once all have
+// finished. body must be safe to call concurrently for distinct chunks.
+template <typename Body>
+void parallel_for_chunks(size_t chunks, const Body& body) {
+    if (chunks <= 1) {
+        if (chunks == 1) body(size_t{0});
+        return;
+    }
+    auto job = std::make_shared<ParallelJob>(chunks, [&body](size_t chunk) { body(chunk); });
+    const size_t helpers = std::min(chunks, parallel_width()) - 1;
+    for (size_t i = 0; i < helpers; ++i) {
+#if defined(DOOF_ACTOR_THREAD_PER_ACTOR)
+        std::thread([job] { job->run_chunks(); }).detach();
+#else
+        ActorScheduler::shared().schedule(new ParallelHelper(job));
+#endif
+    }
+    job->run_chunks();
+    job->wait();
+}
+
+struct ParallelRange {
+    size_t begin;
+    size_t end;
+};
+
+inline ParallelRange parallel_chunk_range(size_t size, size_t chunks, size_t chunk) {
+    return ParallelRange{size * chunk / chunks, size * (chunk + 1) / chunks};
+}
+
+template <typename U>
+std::shared_ptr<std::vector<U>> parallel_concat(std::vector<std::vector<U>>& parts) {
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    auto result = std::make_shared<std::vector<U>>();
+    result->reserve(total);
+    for (auto& part : parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(*result));
+    }
+    return result;
+}
+
+} // namespace detail
+
+template <typename T, typename Mapper>
+auto array_parallelMap(const std::shared_ptr<std::vector<T>>& arr, const Mapper& mapper, const char* file, int32_t line)
+    -> std::shared_ptr<std::vector<std::decay_t<std::invoke_result_t<const Mapper&, const T&>>>> {
+    if (!arr) {
+        panic_at(file, line, "Attempted to iterate null array in parallelMap()");
+    }
+    using U = std::decay_t<std::invoke_result_t<const Mapper&, const T&>>;
+    const std::vector<T>& items = *arr;
+    const size_t chunks = detail::parallel_chunk_count(items.size());
+    std::vector<std::vector<U>> parts(chunks);
+    detail::parallel_for_chunks(chunks, [&](size_t chunk) {
+        const auto range = detail::parallel_chunk_range(items.size(), chunks, chunk);
+        auto& out = parts[chunk];
+        out.reserve(range.end - range.begin);
+        for (size_t i = range.begin; i < range.end; ++i) out.push_back(mapper(items[i]));
+    });
+    return detail::parallel_concat(parts);
 }
 
 template <typename T, typename Predicate>
-bool array_some(const std::shared_ptr<std::vector<T>>& arr, const Predicate& predicate, const char* file, int32_t line) {
+std::shared_ptr<std::vector<T>> array_parallelFilter(const std::shared_ptr<std::vector<T>>& arr, const Predicate& predicate, const char* file, int32_t line) {
     if (!arr) {
-        panic_at(file, line, "Attempted to iterate null array in some()");
-    }
-    for (const auto& item : *arr) {
-        if (predicate.call(item)) {
-            return true;
+        panic_at(file, line, "Attempted to iterate null array in parallelFilter()");
+    }
+    const std::vector<T>& items = *arr;
+    const size_t chunks = detail::parallel_chunk_count(items.size());
+    std::vector<std::vector<T>> parts(chunks);
+    detail::parallel_for_chunks(chunks, [&](size_t chunk) {
+        const auto range = detail::parallel_chunk_range(items.size(), chunks, chunk);
+        for (size_t i = range.begin; i < range.end; ++i) {
+            if (predicate(items[i])) parts[chunk].push_back(items[i]);
         }
-    }
-    return false;
+    });
+    return detail::parallel_concat(parts);
 }
 
-template <typename T, typename Predicate>
-bool array_every(const std::shared_ptr<std::vector<T>>& arr, const Predicate& predicate, const char* file, int32_t line) {
+// combine must be associative: each chunk folds its own elements, then the
+// chunk results fold left-to-right onto initial.
+template <typename T, typename Combine>
+T array_parallelReduce(const std::shared_ptr<std::vector<T>>& arr, typename std::vector<T>::value_type initial, const Combine& combine, const char* file, int32_t line) {
     if (!arr) {
-        panic_at(file, line, "Attempted to iterate null array in every()");
-    }
-    for (const auto& item : *arr) {
-        if (!predicate.call(item)) {
-            return false;
-        }
+        panic_at(file, line, "Attempted to iterate null array in parallelReduce()");
+    }
+    const std::vector<T>& items = *arr;
+    const size_t chunks = detail::parallel_chunk_count(items.size());
+    std::vector<std::optional<T>> parts(chunks);
+    detail::parallel_for_chunks(chunks, [&](size_t chunk) {
+        const auto range = detail::parallel_chunk_range(items.size(), chunks, chunk);
+        if (range.begin == range.end) return;
+        T acc = items[range.begin];
+        for (size_t i = range.begin + 1; i < range.end; ++i) acc = combine(acc, items[i]);
+        parts[chunk].emplace(std::move(acc));
+    });
+    for (auto& part : parts) {
+        if (part) initial = combine(initial, *part);
     }
-    return true;
+    return initial;
 }
 
-template <typename T, typename Predicate>
-std::shared_ptr<std::vector<T>> array_filter(const std::shared_ptr<std::vector<T>>& arr, const Predicate& predicate, const char* file, int32_t line) {
+// Stable: chunks are stable-sorted in parallel, then merged pairwise, with
+// each round of merges also spread across the pool.
+template <typename T, typename Compare>
+std::shared_ptr<std::vector<T>> array_parallelSort(const std::shared_ptr<std::vector<T>>& arr, const Compare& compare, const char* file, int32_t line) {
     if (!arr) {
-        panic_at(file, line, "Attempted to iterate null array in filter()");
-    }
-    auto result = std::make_shared<std::vector<T>>();
-    result->reserve(arr->size());
-    for (const auto& item : *arr) {
-        if (predicate.call(item)) {
-            result->push_back(item);
-        }
+        panic_at(file, line, "Attempted to sort null array in parallelSort()");
+    }
+    auto result = std::make_shared<std::vector<T>>(*arr);
+    std::vector<T>& items = *result;
+    const auto less = [&compare](const T& a, const T& b) { return compare(a, b) < 0; };
+    const size_t chunks = detail::parallel_chunk_count(items.size());
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t chunk = 0; chunk <= chunks; ++chunk) {
+        bounds[chunk] = detail::parallel_chunk_range(items.size(), chunks, chunk).begin;
+    }
+    detail::parallel_for_chunks(chunks, [&](size_t chunk) {
+        std::stable_sort(items.begin() + bounds[chunk], items.begin() + bounds[chunk + 1], less);
+    });
+    for (size_t width = 1; width < chunks; width *= 2) {
+        const size_t merges = (chunks + 2 * width - 1) / (2 * width);
+        detail::parallel_for_chunks(merges, [&](size_t merge) {
+            const size_t first = merge * 2 * width;
+            const size_t middle = std::min(first + width, chunks);
+            const size_t last = std::min(first + 2 * width, chunks);
+            if (middle == last) return;
+            std::inplace_merge(items.begin() + bounds[first], items.begin() + bounds[middle], items.begin() + bounds[last], less);
+        });
     }
     return result;
 }
 
-template <typename T, typename Mapper>
-auto array_map(const std::shared_ptr<std::vector<T>>& arr, const Mapper& mapper, const char* file, int32_t line)
-    -> std::shared_ptr<std::vector<std::decay_t<decltype(std::declval<const Mapper&>().call(std::declval<const T&>()))>>> {
-    if (!arr) {
-        panic_at(file, line, "Attempted to iterate null array in map()");
+// ============================================================================
+// Promise<T> — async result wrapper
+// ============================================================================
+
+namespace detail {
+
+// Per-thread wake-up permit. Parkers are recycled rather than freed when their
+// thread exits, so a late `unpark` can only ever reach a live parker; a stray
+// permit just causes one extra wake-up for whichever thread owns it next.
+class ThreadParker {
+public:
+    void park() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        permitted_.wait(lock, [this] { return permit_; });
+        permit_ = false;
     }
-    using U = std::decay_t<decltype(std::declval<const Mapper&>().call(std::declval<const T&>()))>;
-    auto result = std::make_shared<std::vector<U>>();
-    result->reserve(arr->size());
-    for (const auto& item : *arr) {
-        result->push_back(mapper.call(item));
+
+    void unpark() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            permit_ = true;
+        }
+        permitted_.notify_one();
     }
-    return result;
-}
 
-template <typename T>
-std::shared_ptr<std::vector<T>> array_slice(const std::shared_ptr<std::vector<T>>& arr, int32_t start, int32_t end, const char* file, int32_t line) {
-    if (!arr) {
-        panic_at(file, line, "Attempted to slice null array");
+    static ThreadParker& current() {
+        thread_local Lease lease;
+        return *lease.parker;
     }
 
-    const int32_t size = static_cast<int32_t>(arr->size());
-    if (start < 0) start = 0;
-    if (end < 0) end = 0;
-    if (start > size) start = size;
-    if (end > size) end = size;
-    if (start >= end) {
-        return std::make_shared<std::vector<T>>();
+private:
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadParker*> idle;
+    };
+
+    struct Lease {
+        ThreadParker* parker;
+
+        Lease() {
+            Registry& pool = registry();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            if (pool.idle.empty()) {
+                parker = new ThreadParker();
+            } else {
+                parker = pool.idle.back();
+                pool.idle.pop_back();
+            }
+        }
+
+        ~Lease() {
+            Registry& pool = registry();
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.idle.push_back(parker);
+        }
+    };
+
+    static Registry& registry() {
+        static Registry* pool = new Registry();
+        return *pool;
     }
 
-    using Diff = typename std::vector<T>::difference_type;
-    return std::make_shared<std::vector<T>>(
-        arr->begin() + static_cast<Diff>(start),
-        arr->begin() + static_cast<Diff>(end)
-    );
-}
+    std::mutex mutex_;
+    std::condition_variable permitted_;
+    bool permit_ = false;
+};
+
+// Notified once when a reply slot settles. Listeners are intrusive: the slot
+// reads `next` before calling `settled()`, so a listener may be released from
+// inside its own notification.
+struct ReplyListener {
+    ReplyListener* next = nullptr;
+    virtual void settled() noexcept = 0;
 
+protected:
+    ~ReplyListener() = default;
+};
+
+// One-shot value-or-exception slot. Listeners link themselves onto an
+// intrusive stack; settling swaps in the ready marker and notifies each
+// linked listener. Blocking waiters are listeners on their own stack that
+// park until notified. The slot is settled at most once.
 template <typename T>
-std::shared_ptr<std::vector<T>> array_buildReadonly(const std::shared_ptr<std::vector<T>>& arr, const char* file, int32_t line) {
-    if (!arr) {
-        panic_at(file, line, "Attempted to buildReadonly from null array");
+class ReplySlot {
+public:
+    using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    ReplySlot() = default;
+    ReplySlot(const ReplySlot&) = delete;
+    ReplySlot& operator=(const ReplySlot&) = delete;
+
+    template <typename F>
+    void settle_with(F& produce) noexcept {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                produce();
+                value_.emplace();
+            } else {
+                value_.emplace(produce());
+            }
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+        announce();
     }
-    // Move-drain: transfer contents to a new allocation; original vector is left empty.
-    auto result = std::make_shared<std::vector<T>>(std::move(*arr));
-    arr->clear();
-    return result;
-}
 
-template <typename T>
-std::shared_ptr<std::vector<T>> array_cloneMutable(const std::shared_ptr<std::vector<T>>& arr, const char* file, int32_t line) {
-    if (!arr) {
-        panic_at(file, line, "Attempted to cloneMutable from null array");
+    void fail(std::exception_ptr error) noexcept {
+        error_ = std::move(error);
+        announce();
     }
-    return std::make_shared<std::vector<T>>(*arr);
-}
 
-// Map helpers — bridge Doof's Map methods to ordered_map
-template <typename K, typename V>
-doof::Result<V, std::string> map_get(const std::shared_ptr<ordered_map<K, V>>& m, const K& key, const char* file, int32_t line) {
-    if (!m) {
-        panic_at(file, line, "Attempted to access null map");
+    bool ready() const {
+        return listeners_.load(std::memory_order_acquire) == ready_marker();
     }
-    m->validate_invariants("map_get");
-    auto it = m->find(key);
-    if (it != m->end()) return doof::Success<V>{it->second};
-    return doof::Failure<std::string>{"Map key not found"};
-}
 
-template <typename K, typename V>
-V& map_at(const std::shared_ptr<ordered_map<K, V>>& m, const K& key, const char* file, int32_t line) {
-    if (!m) {
-        panic_at(file, line, "Attempted to index null map");
+    // Links `listener` for notification; returns false, leaving it unlinked,
+    // when the slot has already settled.
+    bool listen(ReplyListener* listener) const {
+        ReplyListener* top = listeners_.load(std::memory_order_acquire);
+        do {
+            if (top == ready_marker()) return false;
+            listener->next = top;
+        } while (!listeners_.compare_exchange_weak(
+            top, listener, std::memory_order_acq_rel, std::memory_order_acquire));
+        return true;
     }
-    m->validate_invariants("map_at");
-    auto it = m->find(key);
-    if (it == m->end()) {
-        panic_at(file, line, "Map key not found");
+
+    void wait() const {
+        // Replies to actor calls usually arrive within a scheduler quantum, so
+        // yield briefly before parking.
+        for (int spin = 0; spin < spin_limit && !ready(); ++spin) {
+            std::this_thread::yield();
+        }
+        ParkedWaiter self;
+        if (!listen(&self)) return;
+        BlockingScope blocking;
+        self.parker->park();
     }
-    return it->second;
-}
 
-template <typename K, typename V>
-V& map_index(const std::shared_ptr<ordered_map<K, V>>& m, const K& key, const char* file, int32_t line) {
-    if (!m) {
-        panic_at(file, line, "Attempted to index null map");
+    // Waits from the application domain's own thread, dispatching its
+    // callbacks meanwhile so continuations posted back to it still run.
+    void wait_dispatching(ApplicationDomain& domain) const {
+        if (ready()) return;
+        DispatchingWaiter self(domain);
+        if (!listen(&self)) return;
+        domain.dispatch_until(self.done);
     }
-    m->validate_invariants("map_index");
-    return (*m)[key];
-}
 
-template <typename K, typename V>
-void map_set(const std::shared_ptr<ordered_map<K, V>>& m, const K& key, const V& value, const char* file, int32_t line) {
-    if (!m) {
-        panic_at(file, line, "Attempted to mutate null map");
+    // Blocks until settled, then returns the value or rethrows the failure.
+    const Stored& value() const {
+        wait();
+        if (error_) std::rethrow_exception(error_);
+        return *value_;
     }
-    m->insert_or_assign(key, value);
-}
 
-template <typename K, typename V>
-std::shared_ptr<std::vector<K>> map_keys(const std::shared_ptr<ordered_map<K, V>>& m, const char* file, int32_t line) {
-    if (!m) {
-        panic_at(file, line, "Attempted to read keys from null map");
+    Stored take() {
+        wait();
+        if (error_) std::rethrow_exception(error_);
+        return std::move(*value_);
     }
-    m->validate_invariants("map_keys");
-    auto result = std::make_shared<std::vector<K>>();
-    result->reserve(m->size());
-    for (const auto& [k, v] : *m) result->push_back(k);
-    return result;
-}
 
-template <typename K, typename V>
-std::shared_ptr<std::vector<V>> map_values(const std::shared_ptr<ordered_map<K, V>>& m, const char* file, int32_t line) {
-    if (!m) {
-        panic_at(file, line, "Attempted to read values from null map");
+    // Settled slots only: the failure, or null after a successful settle.
+    const std::exception_ptr& error() const { return error_; }
+
+    // Settled, successful slots only.
+    const Stored& settled_value() const { return *value_; }
+
+private:
+    struct ParkedWaiter final : ReplyListener {
+        ThreadParker* parker = &ThreadParker::current();
+        void settled() noexcept override { parker->unpark(); }
+    };
+
+    struct DispatchingWaiter final : ReplyListener {
+        ApplicationDomain* domain;
+        bool done = false;
+        explicit DispatchingWaiter(ApplicationDomain& owner) : domain(&owner) {}
+        void settled() noexcept override { domain->settle_waiter(done); }
+    };
+
+    static constexpr int spin_limit = 8;
+
+    // Sentinel address only; never dereferenced.
+    static inline char ready_tag_ = 0;
+    static ReplyListener* ready_marker() { return reinterpret_cast<ReplyListener*>(&ready_tag_); }
+
+    void announce() noexcept {
+        ReplyListener* listener = listeners_.exchange(ready_marker(), std::memory_order_acq_rel);
+        while (listener != nullptr) {
+            ReplyListener* next = listener->next;
+            listener->settled();
+            listener = next;
+        }
     }
-    m->validate_invariants("map_values");
-    auto result = std::make_shared<std::vector<V>>();
-    result->reserve(m->size());
-    for (const auto& [k, v] : *m) result->push_back(v);
-    return result;
-}
 
-template <typename K, typename V>
-std::shared_ptr<ordered_map<K, V>> map_buildReadonly(const std::shared_ptr<ordered_map<K, V>>& m, const char* file, int32_t line) {
-    if (!m) {
-        panic_at(file, line, "Attempted to buildReadonly from null map");
+    mutable std::atomic<ReplyListener*> listeners_{nullptr};
+    std::optional<Stored> value_;
+    std::exception_ptr error_;
+};
+
+// Classifies a failed reply for Promise::get(). Panics keep unwinding and
+// other exceptions become the Failure arm; only this path pays the rethrow.
+DOOF_COLD inline doof::Failure<string> promise_failure(const std::exception_ptr& error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const doof::Panic&) {
+        throw;
+    } catch (const std::exception& e) {
+        return doof::Failure<string>{std::string(e.what())};
+    } catch (...) {
+        return doof::Failure<string>{std::string("unknown error")};
     }
-    m->validate_invariants("map_buildReadonly source");
-    auto result = std::make_shared<ordered_map<K, V>>(std::move(*m));
-    m->clear();
-    result->validate_invariants("map_buildReadonly result");
-    return result;
 }
 
-template <typename K, typename V>
-std::shared_ptr<ordered_map<K, V>> map_cloneMutable(const std::shared_ptr<ordered_map<K, V>>& m, const char* file, int32_t line) {
-    if (!m) {
-        panic_at(file, line, "Attempted to cloneMutable from null map");
-    }
-    m->validate_invariants("map_cloneMutable");
-    return std::make_shared<ordered_map<K, V>>(*m);
+inline std::exception_ptr broken_reply() {
+    return std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
 }
 
+// Reference-counted reply shared by a Promise and the message producing it.
 template <typename T>
-std::shared_ptr<std::vector<T>> set_values(const std::shared_ptr<ordered_set<T>>& s, const char* file, int32_t line) {
-    if (!s) {
-        panic_at(file, line, "Attempted to read values from null set");
+class PromiseState : public ReplySlot<T> {
+public:
+    PromiseState() = default;
+    PromiseState(const PromiseState&) = delete;
+    PromiseState& operator=(const PromiseState&) = delete;
+
+    void retain() noexcept { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+    void release() noexcept {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
     }
-    s->validate_invariants("set_values");
-    auto result = std::make_shared<std::vector<T>>();
-    result->reserve(s->size());
-    for (const auto& value : *s) result->push_back(value);
-    return result;
-}
 
-template <typename T>
-std::shared_ptr<ordered_set<T>> set_buildReadonly(const std::shared_ptr<ordered_set<T>>& s, const char* file, int32_t line) {
-    if (!s) {
-        panic_at(file, line, "Attempted to buildReadonly from null set");
+    // Waits for the reply. A wait from the application domain keeps
+    // dispatching its callbacks, since continuations may be queued there.
+    const typename ReplySlot<T>::Stored& result() {
+        await();
+        return this->value();
     }
-    s->validate_invariants("set_buildReadonly source");
-    auto result = std::make_shared<ordered_set<T>>(std::move(*s));
-    s->clear();
-    result->validate_invariants("set_buildReadonly result");
-    return result;
-}
 
-template <typename T>
-std::shared_ptr<ordered_set<T>> set_cloneMutable(const std::shared_ptr<ordered_set<T>>& s, const char* file, int32_t line) {
-    if (!s) {
-        panic_at(file, line, "Attempted to cloneMutable from null set");
+    // Waits like result() but leaves a failure in error() instead of
+    // rethrowing it.
+    void await() {
+        if (!this->ready() && ApplicationDomain::is_application_domain(active_actor_domain)) {
+            this->wait_dispatching(ApplicationDomain::shared());
+        }
+        this->wait();
     }
-    s->validate_invariants("set_cloneMutable");
-    return std::make_shared<ordered_set<T>>(*s);
-}
 
-// ============================================================================
-// Print utilities
-// ============================================================================
+protected:
+    virtual ~PromiseState() = default;
 
-template <typename T>
-inline void println(const T& val) {
-    if constexpr (std::is_same_v<T, std::string>) {
-        std::cout << val << std::endl;
-    } else if constexpr (std::is_same_v<T, const char*>) {
-        std::cout << val << std::endl;
-    } else {
-        std::cout << to_string(val) << std::endl;
+private:
+    std::atomic<uint32_t> refs_{1};
+};
+
+// Message carrying its closure and its reply in one recycled allocation. The
+// mailbox and the returned Promise each hold one reference.
+template <typename R, typename F>
+class CallEnvelope final : public MailboxNode, public PromiseState<R> {
+    F produce_;
+public:
+    explicit CallEnvelope(F produce) : produce_(std::move(produce)) {
+        this->retain();
     }
-}
 
-inline void println() {
-    std::cout << std::endl;
-}
+    void invoke() override {
+        this->settle_with(produce_);
+        this->release();
+    }
 
-template <typename T>
-inline void print(const T& val) {
-    if constexpr (std::is_same_v<T, std::string>) {
-        std::cout << val;
-    } else if constexpr (std::is_same_v<T, const char*>) {
-        std::cout << val;
-    } else {
-        std::cout << to_string(val);
+    void discard() noexcept override {
+        this->fail(broken_reply());
+        this->release();
     }
-}
+};
 
-// ============================================================================
-// Range utilities
-// ============================================================================
+// Stack-resident message for synchronous calls; the caller owns it and waits
+// for the reply before the frame unwinds.
+template <typename R, typename F>
+class SyncEnvelope final : public MailboxNode {
+    F& produce_;
+    ReplySlot<R> reply_;
+public:
+    explicit SyncEnvelope(F& produce) : produce_(produce) {}
+
+    void invoke() override { reply_.settle_with(produce_); }
+    void discard() noexcept override { reply_.fail(broken_reply()); }
 
-struct Range {
-    int32_t lowerBound;
-    int32_t upperBound;
+    R take() {
+        if constexpr (std::is_void_v<R>) {
+            reply_.take();
+        } else {
+            return reply_.take();
+        }
+    }
+};
 
-    struct Iterator {
-        int32_t current;
+// Continuation waiting on another promise. When the source settles the
+// envelope queues itself on the continuation's domain, or runs inline when
+// the continuation has no domain. A domain with a shared owner is held only
+// weakly; if it is gone by then, the continuation is discarded.
+template <typename R, typename F>
+class ContinuationEnvelope final : public MailboxNode, public ReplyListener, public PromiseState<R> {
+    F produce_;
+    CallbackDomain* domain_;
+    std::weak_ptr<void> anchor_;
+    bool anchored_ = false;
+public:
+    ContinuationEnvelope(F produce, CallbackDomain* domain)
+        : produce_(std::move(produce)), domain_(domain) {
+        if (domain_ != nullptr) {
+            std::shared_ptr<void> anchor = domain_->lifetime_anchor();
+            anchored_ = anchor != nullptr;
+            anchor_ = anchor;
+        }
+        this->retain();
+    }
 
-        int32_t operator*() const { return current; }
-        Iterator& operator++() {
-            ++current;
-            return *this;
+    void settled() noexcept override {
+        if (domain_ == nullptr) {
+            invoke();
+            return;
         }
-        bool operator!=(const Iterator& other) const {
-            return current != other.current;
+        std::shared_ptr<void> hold;
+        if (anchored_) {
+            hold = anchor_.lock();
+            if (!hold) {
+                discard();
+                return;
+            }
         }
-    };
+        CallbackDomain* domain = domain_;
+        try {
+            // A domain that refuses the message has already discarded it.
+            domain->enqueue_message(this);
+        } catch (...) {
+        }
+    }
 
-    Iterator begin() const {
-        bool rev = lowerBound > upperBound;
-        if (rev) return Iterator{lowerBound};
-        return Iterator{lowerBound};
+    void invoke() override {
+        this->settle_with(produce_);
+        this->release();
     }
-    Iterator end() const {
-        bool rev = lowerBound > upperBound;
-        if (rev) return Iterator{lowerBound};
-        return Iterator{upperBound};
+
+    void discard() noexcept override {
+        this->fail(broken_reply());
+        this->release();
     }
 };
 
-inline Range range(int32_t start, int32_t end) {
-    return Range{start, end + 1};
-}
-
-inline Range range_exclusive(int32_t start, int32_t end) {
-    return Range{start, end};
-}
-
-// ============================================================================
-// Promise<T> — async result wrapper
-// ============================================================================
+} // namespace detail
 
 template <typename T>
 class Promise {
-    std::shared_future<T> future_;
+    detail::PromiseState<T>* state_;
 public:
-    explicit Promise(std::future<T>&& f) : future_(f.share()) {}
-    explicit Promise(std::shared_future<T> f) : future_(std::move(f)) {}
+    // Adopts one reference to `state`.
+    explicit Promise(detail::PromiseState<T>* state) : state_(state) {}
+
+    Promise(const Promise& other) : state_(other.state_) { state_->retain(); }
+    Promise& operator=(const Promise& other) {
+        other.state_->retain();
+        state_->release();
+        state_ = other.state_;
+        return *this;
+    }
+    ~Promise() { state_->release(); }
 
-    doof::Result<T, std::string> get() const {
-        try {
-            return doof::Success<T>{future_.get()};
-        } catch (const doof::Panic&) {
-            throw;
-        } catch (const std::exception& e) {
-            return doof::Failure<std::string>{std::string(e.what())};
-        } catch (...) {
-            return doof::Failure<std::string>{std::string("unknown error")};
-        }
+    doof::Result<T, string> get() const {
+        state_->await();
+        if (DOOF_UNLIKELY(state_->error() != nullptr)) return detail::promise_failure(state_->error());
+        return doof::Success<T>{state_->settled_value()};
     }
+
+    // Runs `next` with the settled result on the domain `next` was created
+    // in, without blocking the caller, and returns a promise of its result.
+    template <typename U>
+    Promise<U> then(const doof::callback<U(doof::Result<T, string>)>& next) const;
+
+    // Runtime combinators listen on the shared state directly.
+    detail::PromiseState<T>& shared_state() const { return *state_; }
 };
 
 // Specialization for void
 template <>
 class Promise<void> {
-    std::shared_future<void> future_;
+    detail::PromiseState<void>* state_;
 public:
-    explicit Promise(std::future<void>&& f) : future_(f.share()) {}
-    explicit Promise(std::shared_future<void> f) : future_(std::move(f)) {}
+    // Adopts one reference to `state`.
+    explicit Promise(detail::PromiseState<void>* state) : state_(state) {}
+
+    Promise(const Promise& other) : state_(other.state_) { state_->retain(); }
+    Promise& operator=(const Promise& other) {
+        other.state_->retain();
+        state_->release();
+        state_ = other.state_;
+        return *this;
+    }
+    ~Promise() { state_->release(); }
 
-    doof::Result<void, std::string> get() const {
-        try {
-            future_.get();
-            return doof::Success<void>{};
-        } catch (const doof::Panic&) {
-            throw;
-        } catch (const std::exception& e) {
-            return doof::Failure<std::string>{std::string(e.what())};
-        } catch (...) {
-            return doof::Failure<std::string>{std::string("unknown error")};
-        }
+    doof::Result<void, string> get() const {
+        state_->await();
+        if (DOOF_UNLIKELY(state_->error() != nullptr)) return detail::promise_failure(state_->error());
+        return doof::Success<void>{};
     }
+
+    // Runs `next` with the settled result on the domain `next` was created
+    // in, without blocking the caller, and returns a promise of its result.
+    template <typename U>
+    Promise<U> then(const doof::callback<U(doof::Result<void, string>)>& next) const;
+
+    // Runtime combinators listen on the shared state directly.
+    detail::PromiseState<void>& shared_state() const { return *state_; }
 };
 
 template <typename R, typename... Args>
@@ -1986,185 +6313,401 @@ doof::Promise<R> callback<R(Args...)>::post(Args... args) const {
     }
     auto owner = owner_ ? owner_ : &doof::detail::ApplicationDomain::shared();
 
-    auto prom = std::make_shared<std::promise<R>>();
-    auto fut = prom->get_future();
     auto self = *this;
     auto packedArgs = std::make_tuple(std::forward<Args>(args)...);
-    owner->enqueue_callback([self, prom, packedArgs = std::move(packedArgs)]() mutable {
-        try {
-            if constexpr (std::is_void_v<R>) {
-                std::apply([&](auto&&... unpacked) {
-                    doof::detail::call_callback_unchecked(self, std::forward<decltype(unpacked)>(unpacked)...);
-                }, std::move(packedArgs));
-                prom->set_value();
-            } else {
-                prom->set_value(std::apply([&](auto&&... unpacked) -> R {
-                    return doof::detail::call_callback_unchecked(self, std::forward<decltype(unpacked)>(unpacked)...);
-                }, std::move(packedArgs)));
+    auto produce = [self, packedArgs = std::move(packedArgs)]() mutable -> R {
+        return std::apply([&](auto&&... unpacked) -> R {
+            return doof::detail::call_callback_unchecked(self, std::forward<decltype(unpacked)>(unpacked)...);
+        }, std::move(packedArgs));
+    };
+    auto* message = new detail::CallEnvelope<R, decltype(produce)>(std::move(produce));
+    doof::Promise<R> reply(message);
+    owner->enqueue_message(message);
+    return reply;
+}
+
+namespace detail {
+
+template <typename T, typename U>
+doof::Promise<U> chain_promise(
+    const doof::Promise<T>& source,
+    const doof::callback<U(doof::Result<T, string>)>& next
+) {
+    if (!next) {
+        doof::panic("promise continuation is not initialized");
+    }
+    auto produce = [source, next]() -> U {
+        return call_callback_unchecked(next, source.get());
+    };
+    auto* continuation = new ContinuationEnvelope<U, decltype(produce)>(std::move(produce), next.owner_domain());
+    doof::Promise<U> chained(continuation);
+    if (!source.shared_state().listen(continuation)) continuation->settled();
+    return chained;
+}
+
+// Promise settled from a fixed set of inputs. Each input carries one listener
+// leg; the state keeps an extra reference until every leg has fired, so the
+// combined promise can be dropped before its inputs settle.
+template <typename T, typename R>
+class GatherState : public PromiseState<R> {
+public:
+    using result_type = R;
+
+    explicit GatherState(const std::vector<doof::Promise<T>>& inputs)
+        : inputs_(inputs), legs_(new Leg[inputs.size()]), pending_(inputs.size()) {}
+
+    void start() {
+        if (inputs_.empty()) {
+            settle_empty();
+            return;
+        }
+        this->retain();
+        for (size_t index = 0; index < inputs_.size(); ++index) {
+            Leg& leg = legs_[index];
+            leg.owner = this;
+            leg.index = index;
+            if (!inputs_[index].shared_state().listen(&leg)) leg.settled();
+        }
+    }
+
+protected:
+    virtual void settle_empty() noexcept = 0;
+    virtual void leg_settled(PromiseState<T>& input) noexcept = 0;
+    virtual void legs_settled() noexcept {}
+
+    // True for the first caller only; that caller settles the combined state.
+    bool claim() noexcept {
+        return !claimed_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    std::vector<doof::Promise<T>> inputs_;
+
+private:
+    struct Leg final : ReplyListener {
+        GatherState* owner = nullptr;
+        size_t index = 0;
+        void settled() noexcept override { owner->fire(index); }
+    };
+
+    // A leg must not touch the state after its decrement unless it was the
+    // last one, since the last leg may release the state.
+    void fire(size_t index) noexcept {
+        leg_settled(inputs_[index].shared_state());
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            legs_settled();
+            this->release();
+        }
+    }
+
+    std::unique_ptr<Leg[]> legs_;
+    std::atomic<size_t> pending_;
+    std::atomic<bool> claimed_{false};
+};
+
+template <typename T>
+using all_of_t = std::conditional_t<std::is_void_v<T>, void, std::shared_ptr<std::vector<T>>>;
+
+template <typename T>
+class AllOfState final : public GatherState<T, all_of_t<T>> {
+public:
+    using GatherState<T, all_of_t<T>>::GatherState;
+
+private:
+    void settle_empty() noexcept override { collect(); }
+
+    void leg_settled(PromiseState<T>& input) noexcept override {
+        if (input.error() && this->claim()) this->fail(input.error());
+    }
+
+    void legs_settled() noexcept override {
+        if (this->claim()) collect();
+    }
+
+    void collect() noexcept {
+        auto produce = [this]() -> all_of_t<T> {
+            if constexpr (!std::is_void_v<T>) {
+                auto values = std::make_shared<std::vector<T>>();
+                values->reserve(this->inputs_.size());
+                for (const auto& input : this->inputs_) {
+                    values->push_back(input.shared_state().value());
+                }
+                return values;
             }
-        } catch (...) {
-            prom->set_exception(std::current_exception());
+        };
+        this->settle_with(produce);
+    }
+};
+
+template <typename T>
+class AnyOfState final : public GatherState<T, T> {
+public:
+    using GatherState<T, T>::GatherState;
+
+private:
+    void settle_empty() noexcept override {
+        this->fail(std::make_exception_ptr(std::runtime_error("whenAny requires at least one promise")));
+    }
+
+    void leg_settled(PromiseState<T>& input) noexcept override {
+        if (!this->claim()) return;
+        if (input.error()) {
+            this->fail(input.error());
+            return;
         }
-    });
-    return doof::Promise<R>(std::move(fut));
+        auto produce = [&input]() -> T {
+            if constexpr (!std::is_void_v<T>) {
+                return input.value();
+            }
+        };
+        this->settle_with(produce);
+    }
+};
+
+template <typename State, typename T>
+auto gather_promises(const std::shared_ptr<std::vector<doof::Promise<T>>>& promises) {
+    if (!promises) {
+        doof::panic("promise combinator received a null array");
+    }
+    auto* state = new State(*promises);
+    doof::Promise<typename State::result_type> combined(state);
+    state->start();
+    return combined;
+}
+
+} // namespace detail
+
+template <typename T>
+template <typename U>
+Promise<U> Promise<T>::then(const doof::callback<U(doof::Result<T, string>)>& next) const {
+    return detail::chain_promise(*this, next);
+}
+
+template <typename U>
+Promise<U> Promise<void>::then(const doof::callback<U(doof::Result<void, string>)>& next) const {
+    return detail::chain_promise(*this, next);
+}
+
+// Settles with every value in input order, or with the first failure.
+template <typename T>
+Promise<detail::all_of_t<T>> when_all(const std::shared_ptr<std::vector<Promise<T>>>& promises) {
+    return detail::gather_promises<detail::AllOfState<T>>(promises);
+}
+
+// Settles with whichever input settles first, success or failure.
+template <typename T>
+Promise<T> when_any(const std::shared_ptr<std::vector<Promise<T>>>& promises) {
+    return detail::gather_promises<detail::AnyOfState<T>>(promises);
 }
 
 // ============================================================================
-// Actor<T> — single-threaded message queue actor
+// Actor<T> — serial message queue actor
 // ============================================================================
 
 template <typename T>
-class Actor : public std::enable_shared_from_this<Actor<T>>, public detail::CallbackDomain {
+class Actor
+    : public std::enable_shared_from_this<Actor<T>>,
+      public detail::CallbackDomain
+#if !defined(DOOF_ACTOR_THREAD_PER_ACTOR)
+    , private detail::ScheduledMailbox
+#endif
+{
     // Actor state remains reachable only through this actor until retirement,
     // but class methods require shared ownership for Doof's `this` lowering.
     std::shared_ptr<T> instance_;
+    detail::MpscMailbox mailbox_;
+    // High bit: closed to new calls. Low bits: producers mid-push, so
+    // retirement can wait for admitted calls before queueing itself last.
+    std::atomic<uint32_t> admission_{0};
+    static constexpr uint32_t closed_bit = 1u << 31;
+    // Wakes threads blocked in close_admission() or finish().
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+#if defined(DOOF_PROFILE)
+    // Messages pushed but not yet serviced, sampled as the mailbox depth.
+    std::atomic<int64_t> queued_{0};
+#endif
+
+    void service(detail::MailboxNode* node) {
+        doof::detail::ActiveActorScope active(this);
+#if defined(DOOF_PROFILE)
+        profile::ServiceScope traced(profile::actor_labels<T>(), this, queued_.fetch_sub(1) - 1);
+#endif
+        detail::run_mailbox_node(node);
+    }
+
+    bool push_message(detail::MailboxNode* node) {
+#if defined(DOOF_PROFILE)
+        queued_.fetch_add(1);
+#endif
+        return mailbox_.push(node);
+    }
+
+#if defined(DOOF_ACTOR_THREAD_PER_ACTOR)
     std::thread thread_;
-    std::queue<std::function<void()>> mailbox_;
     std::mutex mutex_;
     std::condition_variable cv_;
-    bool accepting_ = true;
     bool stopped_ = false;
 
     void run() {
         while (true) {
-            std::function<void()> task;
-            {
-                std::unique_lock<std::mutex> lock(mutex_);
-                cv_.wait(lock, [this] { return !mailbox_.empty() || stopped_; });
-                if (stopped_ && mailbox_.empty()) return;
-                task = std::move(mailbox_.front());
-                mailbox_.pop();
+            if (detail::MailboxNode* node = mailbox_.pop()) {
+                service(node);
+                continue;
+            }
+            if (!mailbox_.try_park()) continue;
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !mailbox_.parked() || stopped_; });
+            if (stopped_ && mailbox_.parked()) return;
+        }
+    }
+
+    void wake() {
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cv_.notify_one();
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) thread_.join();
+    }
+#else
+    // Holds the actor alive while it is queued on or running on a carrier.
+    std::shared_ptr<Actor> scheduled_self_;
+    // Threads in finish(); the carrier only notifies on parking when nonzero.
+    std::atomic<uint32_t> park_waiters_{0};
+
+    bool run_slice() override {
+        for (int budget = 0; budget < detail::ActorScheduler::slice_budget; ++budget) {
+            detail::MailboxNode* node = mailbox_.pop();
+            if (node == nullptr) {
+                auto self = std::move(scheduled_self_);
+                if (mailbox_.try_park()) {
+                    if (park_waiters_.load() != 0) notify_idle();
+                    // Dropping the carrier's reference may destroy the actor.
+                    return false;
+                }
+                scheduled_self_ = std::move(self);
+                continue;
             }
-            doof::detail::ActiveActorScope active(this);
-            task();
+            service(node);
+        }
+        return true;
+    }
+
+    void wake() {
+        scheduled_self_ = this->weak_from_this().lock();
+        detail::ActorScheduler::shared().schedule(this);
+    }
+
+    void finish() {
+        // Wait until the carrier has run every admitted message and parked the
+        // mailbox. A message that stops its own actor is that carrier, so it
+        // returns and lets the rest of the slice drain the queue.
+        if (mailbox_.parked() || detail::active_actor_domain == this) return;
+        detail::BlockingScope blocking;
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        park_waiters_.fetch_add(1);
+        idle_cv_.wait(lock, [this] { return mailbox_.parked(); });
+        park_waiters_.fetch_sub(1);
+    }
+#endif
+
+    void notify_idle() {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_cv_.notify_all();
+    }
+
+    // The last producer out after closing wakes the retiring thread.
+    void leave_admission() {
+        if (admission_.fetch_sub(1) == (closed_bit | 1)) notify_idle();
+    }
+
+    void post_task(detail::MailboxNode* node) {
+        if (admission_.fetch_add(1) & closed_bit) {
+            leave_admission();
+            node->discard();
+            doof::panic("actor is retiring or retired");
         }
+        const bool woke = push_message(node);
+        leave_admission();
+        if (woke) wake();
+    }
+
+    // Close the actor to new calls and wait out producers already admitted.
+    bool close_admission() {
+        const uint32_t previous = admission_.fetch_or(closed_bit);
+        if ((previous & ~closed_bit) != 0) {
+            std::unique_lock<std::mutex> lock(idle_mutex_);
+            idle_cv_.wait(lock, [this] { return (admission_.load() & ~closed_bit) == 0; });
+        }
+        return (previous & closed_bit) == 0;
     }
 
 public:
     template <typename... Args>
     explicit Actor(Args&&... args)
         : instance_(std::make_shared<T>(std::forward<Args>(args)...)) {
+#if defined(DOOF_ACTOR_THREAD_PER_ACTOR)
         thread_ = std::thread(&Actor::run, this);
+#endif
     }
 
     // Synchronous call — enqueue and block until complete
     template <typename R, typename F>
     R call_sync(F&& f) {
-        if constexpr (std::is_void_v<R>) {
-            std::promise<void> prom;
-            auto fut = prom.get_future();
-            {
-                std::lock_guard<std::mutex> lock(mutex_);
-                if (!accepting_) doof::panic("actor is retiring or retired");
-                mailbox_.push([this, f = std::forward<F>(f), &prom]() {
-                    try {
-                        f(*instance_);
-                        prom.set_value();
-                    } catch (...) {
-                        prom.set_exception(std::current_exception());
-                    }
-                });
-            }
-            cv_.notify_one();
-            return fut.get();
-        } else {
-            std::promise<R> prom;
-            auto fut = prom.get_future();
-            {
-                std::lock_guard<std::mutex> lock(mutex_);
-                if (!accepting_) doof::panic("actor is retiring or retired");
-                mailbox_.push([this, f = std::forward<F>(f), &prom]() {
-                    try {
-                        prom.set_value(f(*instance_));
-                    } catch (...) {
-                        prom.set_exception(std::current_exception());
-                    }
-                });
-            }
-            cv_.notify_one();
-            return fut.get();
-        }
+        auto produce = [this, &f]() -> R { return f(*instance_); };
+        detail::SyncEnvelope<R, decltype(produce)> message(produce);
+        post_task(&message);
+        return message.take();
     }
 
     // Asynchronous call — enqueue and return a Promise
     template <typename R, typename F>
     doof::Promise<R> call_async(F&& f) {
-        auto prom = std::make_shared<std::promise<R>>();
-        auto fut = prom->get_future();
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (!accepting_) doof::panic("actor is retiring or retired");
-            if constexpr (std::is_void_v<R>) {
-                mailbox_.push([this, f = std::forward<F>(f), prom]() {
-                    try {
-                        f(*instance_);
-                        prom->set_value();
-                    } catch (...) {
-                        prom->set_exception(std::current_exception());
-                    }
-                });
-            } else {
-                mailbox_.push([this, f = std::forward<F>(f), prom]() {
-                    try {
-                        prom->set_value(f(*instance_));
-                    } catch (...) {
-                        prom->set_exception(std::current_exception());
-                    }
-                });
-            }
-        }
-        cv_.notify_one();
-        return doof::Promise<R>(std::move(fut));
+        auto produce = [this, f = std::forward<F>(f)]() mutable -> R { return f(*instance_); };
+        auto* message = new detail::CallEnvelope<R, decltype(produce)>(std::move(produce));
+        doof::Promise<R> reply(message);
+        post_task(message);
+        return reply;
     }
 
-    void enqueue_callback(std::function<void()> task) override {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (!accepting_) doof::panic("actor is retiring or retired");
-            mailbox_.push(std::move(task));
-        }
-        cv_.notify_one();
+    void enqueue_message(detail::MailboxNode* message) override {
+        post_task(message);
+    }
+
+    std::shared_ptr<void> lifetime_anchor() override {
+        return this->weak_from_this().lock();
     }
 
     // Retire the actor — drain accepted work, stop, and return owned state.
     std::shared_ptr<T> retire() {
-        std::promise<std::shared_ptr<T>> prom;
-        auto fut = prom.get_future();
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (!accepting_) doof::panic("actor is already retiring or retired");
-            accepting_ = false;
-            mailbox_.push([this, &prom]() {
-                try {
-                    if (!instance_) doof::panic("actor is already retired");
-                    prom.set_value(std::move(instance_));
-                    stopped_ = true;
-                } catch (...) {
-                    prom.set_exception(std::current_exception());
-                }
-            });
-        }
-        cv_.notify_one();
-        std::shared_ptr<T> value = fut.get();
-        if (thread_.joinable()) thread_.join();
+        if (!close_admission()) doof::panic("actor is already retiring or retired");
+        auto produce = [this]() -> std::shared_ptr<T> {
+            if (!instance_) doof::panic("actor is already retired");
+            return std::move(instance_);
+        };
+        detail::SyncEnvelope<std::shared_ptr<T>, decltype(produce)> message(produce);
+        if (push_message(&message)) wake();
+        std::shared_ptr<T> value = message.take();
+        finish();
         return value;
     }
 
-    // Stop the actor — drain the queue and join the thread
+    // Stop the actor — drain the queue and wait for the actor to go idle
     void stop() {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            accepting_ = false;
-            stopped_ = true;
-        }
-        cv_.notify_one();
-        if (thread_.joinable()) thread_.join();
+        close_admission();
+        finish();
     }
 
     ~Actor() {
         stop();
     }
 };
+/* __DOOF_RUNTIME_ACTORS_END__ */
 
 template <typename T>
 struct metadata_inner { using type = T; };
@@ -2269,29 +6812,21 @@ const doof::ClassMetadata<metadata_inner_t<T>>& metadata_for_type() {
 // ============================================================================
 
 #ifdef DOOF_COVERAGE
-#include <unordered_set>
 
 namespace doof {
 namespace coverage {
 
-struct LineHit {
+// Each instrumented module owns a static bitmap with one bit per source line.
+// A line costs a relaxed load once it has been seen, so hot loops do not
+// contend on a shared lock or cache line; the bitmaps are dumped at exit.
+struct ModuleLines {
     int module_id;
-    int line;
-    bool operator==(const LineHit& o) const noexcept {
-        return module_id == o.module_id && line == o.line;
-    }
-};
-
-struct LineHitHash {
-    std::size_t operator()(const LineHit& h) const noexcept {
-        return std::hash<long long>{}(
-            (static_cast<long long>(h.module_id) << 32) |
-            static_cast<unsigned int>(static_cast<unsigned>(h.line)));
-    }
+    int line_count;
+    std::atomic<uint64_t>* words;
+    ModuleLines* next;
 };
 
-inline std::unordered_set<LineHit, LineHitHash> _coverage_hits;
-inline std::mutex _coverage_hits_mutex;
+inline std::atomic<ModuleLines*> _registered_modules{nullptr};
 inline std::once_flag _coverage_registration_once;
 
 inline void _cov_dump();
@@ -2302,16 +6837,108 @@ inline void _cov_ensure_registered() {
     });
 }
 
-inline void cov_mark(int module_id, int line) {
+inline void _cov_register(ModuleLines* module) {
     _cov_ensure_registered();
-    std::lock_guard<std::mutex> lock(_coverage_hits_mutex);
-    _coverage_hits.insert(LineHit{module_id, line});
+    module->next = _registered_modules.load(std::memory_order_relaxed);
+    while (!_registered_modules.compare_exchange_weak(module->next, module, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+/// Emitted once per instrumented .cpp file, sized to its highest instrumented line.
+template <int LineCount>
+class ModuleBitmap {
+public:
+    // constexpr, so the static bitmap is constant-initialized and no dynamic
+    // initializer ever rewrites it: a line marked by another file's static
+    // initializers survives.  The module joins the exit dump on its first mark.
+    constexpr explicit ModuleBitmap(int module_id) noexcept
+        : words_{}, registered_(false), lines_{module_id, LineCount, words_, nullptr} {}
+
+    ModuleBitmap(const ModuleBitmap&) = delete;
+    ModuleBitmap& operator=(const ModuleBitmap&) = delete;
+
+    void mark(int line) noexcept {
+        std::atomic<uint64_t>& word = words_[line >> 6];
+        const uint64_t bit = uint64_t{1} << (line & 63);
+        if ((word.load(std::memory_order_relaxed) & bit) == 0) {
+            word.fetch_or(bit, std::memory_order_relaxed);
+            if (!registered_.load(std::memory_order_relaxed) && !registered_.exchange(true, std::memory_order_acq_rel)) {
+                _cov_register(&lines_);
+            }
+        }
+    }
+
+private:
+    std::atomic<uint64_t> words_[LineCount / 64 + 1];
+    std::atomic<bool> registered_;
+    ModuleLines lines_;
+};
+
+// Emitters that do not declare a module bitmap call cov_mark(module, line).
+// Module ids index a fixed directory of lazily allocated line pages, so this
+// path is lock-free too, just one indirection slower.
+inline constexpr int _dynamic_module_limit = 4096;
+inline constexpr int _page_lines = 4096;
+inline constexpr int _pages_per_module = 256;
+
+struct _DynamicModule {
+    std::atomic<std::atomic<uint64_t>*> pages[_pages_per_module];
+};
+
+inline std::atomic<_DynamicModule*> _dynamic_modules[_dynamic_module_limit];
+
+inline void cov_mark(int module_id, int line) {
+    if (module_id < 0 || module_id >= _dynamic_module_limit || line < 0 || line >= _page_lines * _pages_per_module) return;
+    _DynamicModule* module = _dynamic_modules[module_id].load(std::memory_order_acquire);
+    if (module == nullptr) {
+        _cov_ensure_registered();
+        auto* fresh = new _DynamicModule();
+        for (auto& page : fresh->pages) page.store(nullptr, std::memory_order_relaxed);
+        if (_dynamic_modules[module_id].compare_exchange_strong(module, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            module = fresh;
+        } else {
+            delete fresh;
+        }
+    }
+    std::atomic<std::atomic<uint64_t>*>& slot = module->pages[line / _page_lines];
+    std::atomic<uint64_t>* page = slot.load(std::memory_order_acquire);
+    if (page == nullptr) {
+        auto* fresh = new std::atomic<uint64_t>[_page_lines / 64];
+        for (int index = 0; index < _page_lines / 64; ++index) fresh[index].store(0, std::memory_order_relaxed);
+        if (slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            page = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    const int offset = line % _page_lines;
+    std::atomic<uint64_t>& word = page[offset >> 6];
+    const uint64_t bit = uint64_t{1} << (offset & 63);
+    if ((word.load(std::memory_order_relaxed) & bit) == 0) {
+        word.fetch_or(bit, std::memory_order_relaxed);
+    }
 }
 
 inline void _cov_dump() {
-    std::lock_guard<std::mutex> lock(_coverage_hits_mutex);
-    for (const auto& h : _coverage_hits) {
-        std::cout << "__COV__ " << h.module_id << " " << h.line << "\n";
+    for (ModuleLines* module = _registered_modules.load(std::memory_order_acquire); module != nullptr; module = module->next) {
+        for (int line = 0; line <= module->line_count; ++line) {
+            if (module->words[line >> 6].load(std::memory_order_relaxed) & (uint64_t{1} << (line & 63))) {
+                std::cout << "__COV__ " << module->module_id << " " << line << "\n";
+            }
+        }
+    }
+    for (int module_id = 0; module_id < _dynamic_module_limit; ++module_id) {
+        const _DynamicModule* module = _dynamic_modules[module_id].load(std::memory_order_acquire);
+        if (module == nullptr) continue;
+        for (int page_index = 0; page_index < _pages_per_module; ++page_index) {
+            const std::atomic<uint64_t>* page = module->pages[page_index].load(std::memory_order_acquire);
+            if (page == nullptr) continue;
+            for (int offset = 0; offset < _page_lines; ++offset) {
+                if (page[offset >> 6].load(std::memory_order_relaxed) & (uint64_t{1} << (offset & 63))) {
+                    std::cout << "__COV__ " << module_id << " " << page_index * _page_lines + offset << "\n";
+                }
+            }
+        }
     }
     std::cout.flush();
 }
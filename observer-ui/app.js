@@ -5,6 +5,10 @@ const updatedAt = document.getElementById("updatedAt");
 const refreshButton = document.getElementById("refreshButton");
 const status = document.querySelector(".status");
 const statusText = document.getElementById("statusText");
+const flameGraph = document.getElementById("flameGraph");
+const mailboxBody = document.getElementById("mailboxBody");
+const traceEmpty = document.getElementById("traceEmpty");
+const traceButton = document.getElementById("traceButton");
 
 let latestMetrics = [];
 let latestDisplayMetrics = [];
@@ -85,7 +89,9 @@ function renderMetrics() {
     value.className = "number";
     delta.className = "number delta";
     name.textContent = metric.name;
-    value.textContent = String(metric.value);
+    value.textContent = metric.type === "histogram"
+      ? `${metric.count} · p50 ${metric.p50} · p99 ${metric.p99}`
+      : String(metric.value);
     if (metric.consolidated && metric.delta !== null) {
       delta.textContent = formatDelta(metric.delta);
       delta.classList.toggle("positive", metric.delta > 0);
@@ -107,17 +113,151 @@ async function refresh() {
     if (!jsonResponse.ok) {
       throw new Error("observer request failed");
     }
-    latestMetrics = await jsonResponse.json();
-    latestDisplayMetrics = displayedMetrics(latestMetrics);
-    updatedAt.textContent = new Date().toLocaleTimeString();
-    setStatus("ok", "Live");
-    renderMetrics();
+    applyMetrics(await jsonResponse.json());
+  } catch {
+    setStatus("error", "Disconnected");
+  }
+}
+
+function applyMetrics(metrics) {
+  latestMetrics = metrics;
+  latestDisplayMetrics = displayedMetrics(latestMetrics);
+  updatedAt.textContent = new Date().toLocaleTimeString();
+  setStatus("ok", "Live");
+  renderMetrics();
+}
+
+// The event stream sends one full snapshot, then only the metrics that
+// changed; EventSource reconnects on its own and each reconnect re-snapshots.
+function connectMetricStream() {
+  if (typeof EventSource === "undefined") return false;
+  const stream = new EventSource("/api/metrics/stream");
+  stream.addEventListener("snapshot", (event) => applyMetrics(JSON.parse(event.data)));
+  stream.addEventListener("delta", (event) => {
+    const byName = new Map(latestMetrics.map((metric) => [metric.name, metric]));
+    for (const metric of JSON.parse(event.data)) {
+      byName.set(metric.name, metric);
+    }
+    applyMetrics([...byName.values()]);
+  });
+  stream.addEventListener("error", () => setStatus("error", "Reconnecting"));
+  return true;
+}
+
+const FLAME_ROW_HEIGHT = 22;
+
+// Nest each thread's complete events by time containment and merge identical
+// stacks, so the graph shows inclusive time per call path across all threads.
+function buildFlameTree(events) {
+  const root = { name: "all", total: 0, children: new Map() };
+  const byThread = new Map();
+  for (const event of events) {
+    if (event.ph !== "X") continue;
+    const list = byThread.get(event.tid) ?? [];
+    list.push(event);
+    byThread.set(event.tid, list);
+  }
+  for (const list of byThread.values()) {
+    list.sort((left, right) => left.ts - right.ts || right.dur - left.dur);
+    const stack = [];
+    for (const event of list) {
+      const end = event.ts + event.dur;
+      while (stack.length > 0 && stack[stack.length - 1].end <= event.ts) stack.pop();
+      const parent = stack.length > 0 ? stack[stack.length - 1].node : root;
+      let node = parent.children.get(event.name);
+      if (!node) {
+        node = { name: event.name, total: 0, children: new Map() };
+        parent.children.set(event.name, node);
+      }
+      node.total += event.dur;
+      if (parent === root) root.total += event.dur;
+      stack.push({ end, node });
+    }
+  }
+  return root;
+}
+
+function renderFlameGraph(root) {
+  const frames = [];
+  let depth = 0;
+  const place = (node, left, width, level) => {
+    depth = Math.max(depth, level + 1);
+    const frame = document.createElement("div");
+    frame.className = node.name.startsWith("actor ") ? "flame-frame actor" : "flame-frame";
+    frame.style.left = `${left}%`;
+    frame.style.width = `${width}%`;
+    frame.style.top = `${level * FLAME_ROW_HEIGHT}px`;
+    const share = root.total > 0 ? (node.total / root.total) * 100 : 0;
+    frame.textContent = node.name;
+    frame.title = `${node.name}\n${(node.total / 1000).toFixed(3)} ms (${share.toFixed(1)}%)`;
+    frames.push(frame);
+    let offset = left;
+    const children = [...node.children.values()].sort((a, b) => b.total - a.total);
+    for (const child of children) {
+      const childWidth = node.total > 0 ? (child.total / node.total) * width : 0;
+      if (childWidth >= 0.1) place(child, offset, childWidth, level + 1);
+      offset += childWidth;
+    }
+  };
+  if (root.total > 0) place(root, 0, 100, 0);
+  flameGraph.style.height = `${depth * FLAME_ROW_HEIGHT}px`;
+  flameGraph.replaceChildren(...frames);
+}
+
+function renderMailboxes(events) {
+  const series = new Map();
+  for (const event of events) {
+    if (event.ph !== "C") continue;
+    const key = `${event.name} ${event.id}`;
+    const existing = series.get(key) ?? { name: event.name, ts: -1, last: 0, max: 0 };
+    const depth = event.args?.depth ?? 0;
+    existing.max = Math.max(existing.max, depth);
+    if (event.ts >= existing.ts) {
+      existing.ts = event.ts;
+      existing.last = depth;
+    }
+    series.set(key, existing);
+  }
+  const rows = [...series.values()].sort((left, right) => right.max - left.max);
+  mailboxBody.replaceChildren(...rows.map((row) => {
+    const tr = document.createElement("tr");
+    const name = document.createElement("td");
+    const last = document.createElement("td");
+    const max = document.createElement("td");
+    name.className = "name";
+    last.className = "number";
+    max.className = "number";
+    name.textContent = row.name;
+    last.textContent = String(row.last);
+    max.textContent = String(row.max);
+    tr.append(name, last, max);
+    return tr;
+  }));
+  return rows.length;
+}
+
+async function captureTrace() {
+  try {
+    const response = await fetch("/api/trace", { cache: "no-store" });
+    if (!response.ok) {
+      throw new Error("trace request failed");
+    }
+    const trace = await response.json();
+    const events = trace.traceEvents ?? [];
+    const root = buildFlameTree(events);
+    renderFlameGraph(root);
+    const mailboxes = renderMailboxes(events);
+    traceEmpty.classList.toggle("hidden", root.total > 0 || mailboxes > 0);
+    traceEmpty.textContent = "No spans recorded. Run with doof run --profile to trace.";
   } catch {
     setStatus("error", "Disconnected");
   }
 }
 
 filterInput.addEventListener("input", renderMetrics);
+traceButton.addEventListener("click", captureTrace);
 refreshButton.addEventListener("click", refresh);
-refresh();
-setInterval(refresh, 1000);
+if (!connectMetricStream()) {
+  refresh();
+  setInterval(refresh, 1000);
+}
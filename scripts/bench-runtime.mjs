@@ -0,0 +1,48 @@
+import { spawnSync } from "node:child_process";
+import * as fs from "node:fs";
+import * as path from "node:path";
+import { fileURLToPath } from "node:url";
+
+const scriptDirectory = path.dirname(fileURLToPath(import.meta.url));
+const repositoryRoot = path.resolve(scriptDirectory, "..");
+const benchRoot = path.join(repositoryRoot, "bench", "runtime");
+const outputRoot = path.join(repositoryRoot, "build", "bench", "runtime");
+const executableSuffix = process.platform === "win32" ? ".exe" : "";
+const compiler = process.env.CXX || "c++";
+const selected = process.argv.slice(2);
+
+function run(command, args) {
+  const result = spawnSync(command, args, { cwd: repositoryRoot, stdio: "inherit" });
+  if (result.error) throw result.error;
+  if (result.status !== 0) {
+    throw new Error(`${command} exited with status ${result.status}`);
+  }
+}
+
+const benchmarks = fs.readdirSync(benchRoot)
+  .filter((name) => name.endsWith(".cpp"))
+  .map((name) => path.basename(name, ".cpp"))
+  .filter((name) => selected.length === 0 || selected.includes(name))
+  .sort();
+
+if (benchmarks.length === 0) {
+  throw new Error(`No runtime benchmarks matched ${selected.join(", ")}`);
+}
+
+fs.mkdirSync(outputRoot, { recursive: true });
+for (const name of benchmarks) {
+  const executable = path.join(outputRoot, `${name}${executableSuffix}`);
+  console.log(`\n== ${name} ==`);
+  run(compiler, [
+    "-std=c++17",
+    "-Wall",
+    "-Wextra",
+    "-O2",
+    "-pthread",
+    `-I${repositoryRoot}`,
+    path.join(benchRoot, `${name}.cpp`),
+    "-o",
+    executable,
+  ]);
+  run(executable, []);
+}
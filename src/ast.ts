@@ -674,6 +674,8 @@ export interface ClassDeclaration {
   private_: boolean;
   /** Set by the checker when user code accesses .toJsonObject() or .fromJsonValue() */
   needsJson?: boolean;
+  /** Set when a JsonDocument decode (interface or alias fromJsonText) can reach this class */
+  needsJsonDocument?: boolean;
   /** Set by the checker when user code accesses .metadata or .invoke() */
   needsMetadata?: boolean;
   span: SourceSpan;
@@ -703,8 +705,10 @@ export interface InterfaceDeclaration {
   fields: InterfaceField[];
   methods: InterfaceMethod[];
   exported: boolean;
-  /** Set by the checker when user code accesses .fromJsonValue() */
+  /** Set by the checker when user code accesses .fromJsonValue() or .fromJsonText() */
   needsJson?: boolean;
+  /** Set by the checker when user code accesses .fromJsonText() */
+  needsJsonDocument?: boolean;
   span: SourceSpan;
 }
 
@@ -755,8 +759,10 @@ export interface TypeAliasDeclaration {
   typeParamConstraints?: (TypeAnnotation | null)[];
   type: TypeAnnotation;
   exported: boolean;
-  /** Set by the checker when user code accesses .fromJsonValue() */
+  /** Set by the checker when user code accesses .fromJsonValue() or .fromJsonText() */
   needsJson?: boolean;
+  /** Set by the checker when user code accesses .fromJsonText() */
+  needsJsonDocument?: boolean;
   span: SourceSpan;
 }
 
@@ -0,0 +1,227 @@
+import * as fs from "node:fs";
+import * as os from "node:os";
+import * as path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { resolveCompilerToolchain } from "./cli-core.js";
+import {
+  compareBenchReports,
+  discoverBenchmarks,
+  findBenchFiles,
+  generateBenchHarnessSource,
+  parseBenchOutput,
+  runBenchCommand,
+  summarizeBenchMeasurement,
+  type BenchReport,
+} from "./bench-runner.js";
+import type { TestReporter } from "./test-runner.js";
+
+const tmpDirs: string[] = [];
+
+afterEach(() => {
+  while (tmpDirs.length > 0) {
+    const dir = tmpDirs.pop();
+    if (dir) fs.rmSync(dir, { recursive: true, force: true });
+  }
+});
+
+describe("bench runner discovery", () => {
+  it("finds .bench.do files and exported bench functions", () => {
+    const dir = createTempDir();
+    writeFile(dir, "doof.json", JSON.stringify({ name: "benches" }));
+    writeFile(dir, "alpha.bench.do", [
+      "export function benchAlpha(): void {}",
+      "export function helper(): void {}",
+      "",
+    ].join("\n"));
+    writeFile(dir, "alpha.test.do", "export function testAlpha(): void {}\n");
+
+    const files = findBenchFiles(dir);
+    const benches = discoverBenchmarks(dir, files);
+
+    expect(files.map((file) => path.relative(dir, file))).toEqual(["alpha.bench.do"]);
+    expect(benches.map((bench) => bench.id)).toEqual(["alpha.bench.do::benchAlpha"]);
+  });
+
+  it("rejects benchmarks with parameters", () => {
+    const dir = createTempDir();
+    writeFile(dir, "doof.json", JSON.stringify({ name: "benches" }));
+    writeFile(dir, "broken.bench.do", "export function benchBroken(n: int): void {}\n");
+
+    expect(() => discoverBenchmarks(dir, findBenchFiles(dir))).toThrow('benchmark "benchBroken" must not declare parameters');
+  });
+
+  it("generates a harness that measures the selected benchmark", () => {
+    const source = generateBenchHarnessSource("/project/.doof-bench/__doof_bench___maps.bench.do.do", [
+      { id: "maps.bench.do::benchInsert", name: "benchInsert", modulePath: "/project/maps.bench.do", moduleDisplayPath: "maps.bench.do" },
+    ]);
+
+    expect(source).toContain('import { benchInsert } from "../maps.bench"');
+    expect(source).toContain('import function benchRun(id: string, body: (): void): void from "doof_bench.hpp" as doof_bench::run');
+    expect(source).toContain('benchRun("maps.bench.do::benchInsert", (): void => benchInsert())');
+  });
+});
+
+describe("bench runner statistics", () => {
+  it("summarises samples with median, p99, and MAD", () => {
+    const output = [
+      "unrelated output",
+      '__BENCH__ {"id":"a.bench.do::benchA","iterations":400,"allocations":800,"samples":[12,10,11,10,50],"metrics":{"ops":400}}',
+    ].join("\n");
+    const measurement = parseBenchOutput(output);
+
+    expect(measurement).not.toBeNull();
+    expect(summarizeBenchMeasurement(measurement!)).toEqual({
+      id: "a.bench.do::benchA",
+      iterations: 400,
+      samples: 5,
+      medianNs: 11,
+      p99Ns: 50,
+      madNs: 1,
+      allocationsPerOp: 2,
+      metricsPerOp: { ops: 1 },
+    });
+  });
+
+  it("flags medians slower than the baseline threshold", () => {
+    const result = (id: string, medianNs: number) => ({
+      id,
+      iterations: 1,
+      samples: 1,
+      medianNs,
+      p99Ns: medianNs,
+      madNs: 0,
+      allocationsPerOp: 0,
+      metricsPerOp: {},
+    });
+    const baseline: BenchReport = { timestamp: "", benchmarks: [result("fast", 100), result("steady", 100)] };
+    const current: BenchReport = { timestamp: "", benchmarks: [result("fast", 120), result("steady", 105), result("new", 1)] };
+
+    expect(compareBenchReports(current, baseline, 10)).toEqual([
+      { id: "fast", baselineMedianNs: 100, medianNs: 120, changePercent: 20, regressed: true },
+      { id: "steady", baselineMedianNs: 100, medianNs: 105, changePercent: 5, regressed: false },
+    ]);
+  });
+});
+
+describe("bench runner execution", () => {
+  it("lists benchmarks without compiling", async () => {
+    const dir = createTempDir();
+    writeFile(dir, "doof.json", JSON.stringify({ name: "benches" }));
+    writeFile(dir, "calc.bench.do", [
+      "export function benchAdd(): void {}",
+      "export function benchSub(): void {}",
+      "",
+    ].join("\n"));
+
+    const reporter = createReporter();
+    const result = await runBenchCommand({
+      targetPath: dir,
+      compiler: { kind: "gcc-like", command: "clang++" },
+      nativeBuild: emptyNativeBuildOptions(),
+      filter: "Sub",
+      listOnly: true,
+      verbose: false,
+      reporter,
+    });
+
+    expect(result).toEqual({ discovered: 1, executed: 0, failed: 0, regressions: 0 });
+    expect(reporter.logs).toContain("calc.bench.do::benchSub");
+  });
+
+  it("builds in release mode and writes JSON results", async () => {
+    let compiler;
+    try {
+      compiler = resolveCompilerToolchain(null);
+    } catch {
+      return;
+    }
+    const dir = createTempDir();
+    writeFile(dir, "doof.json", JSON.stringify({ name: "benches" }));
+    writeFile(dir, "strings.bench.do", [
+      "export function benchConcat(): void {",
+      '    value := "bench-" + "mark"',
+      '    metricsIncrement("concat_ops", 1L)',
+      "    if value.length != 10 {",
+      '        panic("unexpected length")',
+      "    }",
+      "}",
+      "",
+    ].join("\n"));
+
+    const reporter = createReporter();
+    const output = path.join(dir, "results.json");
+    const originalEnv = { ...process.env };
+    process.env.DOOF_BENCH_SAMPLES = "3";
+    process.env.DOOF_BENCH_SAMPLE_NS = "100000";
+    process.env.DOOF_BENCH_WARMUP_NS = "100000";
+    try {
+      const result = await runBenchCommand({
+        targetPath: dir,
+        compiler,
+        nativeBuild: emptyNativeBuildOptions(),
+        filter: null,
+        listOnly: false,
+        verbose: false,
+        reporter,
+        output,
+      });
+
+      expect(result).toEqual({ discovered: 1, executed: 1, failed: 0, regressions: 0 });
+    } finally {
+      process.env = originalEnv;
+    }
+
+    const report = JSON.parse(fs.readFileSync(output, "utf8")) as BenchReport;
+    expect(report.benchmarks).toHaveLength(1);
+    expect(report.benchmarks[0]).toMatchObject({ id: "strings.bench.do::benchConcat", samples: 3 });
+    expect(report.benchmarks[0].metricsPerOp).toEqual({ concat_ops: 1 });
+    const manifest = JSON.parse(fs.readFileSync(
+      path.join(dir, "build", ".doof-bench", "strings.bench.do", "doof-build.json"),
+      "utf8",
+    ));
+    expect(manifest.defines).toContain("NDEBUG");
+  });
+});
+
+function createTempDir(): string {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), "doof-bench-runner-"));
+  tmpDirs.push(dir);
+  return dir;
+}
+
+function writeFile(rootDir: string, relativePath: string, content: string): void {
+  const filePath = path.join(rootDir, relativePath);
+  fs.mkdirSync(path.dirname(filePath), { recursive: true });
+  fs.writeFileSync(filePath, content);
+}
+
+function createReporter(): TestReporter & { logs: string[]; errors: string[] } {
+  const logs: string[] = [];
+  const errors: string[] = [];
+  return {
+    logs,
+    errors,
+    log(message: string) {
+      logs.push(message);
+    },
+    error(message: string) {
+      errors.push(message);
+    },
+  };
+}
+
+function emptyNativeBuildOptions() {
+  return {
+    cppStd: "c++17",
+    includePaths: [],
+    libraryPaths: [],
+    linkLibraries: [],
+    frameworks: [],
+    pkgConfigPackages: [],
+    sourceFiles: [],
+    objectFiles: [],
+    compilerFlags: [],
+    linkerFlags: [],
+    defines: [],
+  };
+}
@@ -0,0 +1,356 @@
+import * as fs from "node:fs";
+import * as path from "node:path";
+import { execFileSync } from "node:child_process";
+import {
+  type CompilerToolchain,
+  formatDiagnostic,
+  runNativeBuildGraph,
+  runPipelineWithFs,
+} from "./cli-core.js";
+import type { NativeBuildOptions } from "./emitter-module.js";
+import { withReleaseBuildDefaults } from "./package-artifacts.js";
+import { loadBenchSupport } from "./runtime-assets.js";
+import {
+  type DiscoveredTest,
+  type DiscoveryConvention,
+  type TestReporter,
+  determineExecutionRoot,
+  determineRootDir,
+  discoverTests,
+  escapeDoofString,
+  filterTests,
+  findTestFiles,
+  groupTestsByModule,
+  indentBlock,
+  OverlayFS,
+  toImportSpecifier,
+} from "./test-runner.js";
+
+const HARNESS_FILENAME = "__doof_bench__.do";
+const BENCH_SUPPORT_HEADER = "doof_bench.hpp";
+const BENCH_LINE_PREFIX = "__BENCH__ ";
+const DEFAULT_REGRESSION_THRESHOLD_PERCENT = 10;
+
+export const BENCH_CONVENTION: DiscoveryConvention = {
+  fileSuffix: ".bench.do",
+  functionPrefix: "bench",
+  label: "benchmark",
+};
+
+export interface RunBenchCommandOptions {
+  targetPath: string;
+  compiler: CompilerToolchain;
+  nativeBuild: NativeBuildOptions;
+  filter: string | null;
+  listOnly: boolean;
+  verbose: boolean;
+  reporter: TestReporter;
+  /** Output path for the JSON results. Defaults to build/bench/doof-bench.json under the bench root. */
+  output?: string;
+  /** Saved results to compare against; medians slower by more than the threshold are regressions. */
+  baseline?: string;
+  /** Allowed median slowdown against the baseline, in percent. Defaults to 10. */
+  regressionThresholdPercent?: number;
+}
+
+export interface RunBenchCommandResult {
+  discovered: number;
+  executed: number;
+  failed: number;
+  regressions: number;
+}
+
+/** Raw measurement printed by the harness as one `__BENCH__ {json}` line. */
+export interface BenchMeasurement {
+  id: string;
+  iterations: number;
+  allocations: number;
+  /** Nanoseconds per iteration for each timed batch. */
+  samples: number[];
+  /** Counter deltas across the timed batches, keyed by metric name. */
+  metrics: Record<string, number>;
+}
+
+export interface BenchResult {
+  id: string;
+  iterations: number;
+  samples: number;
+  medianNs: number;
+  p99Ns: number;
+  madNs: number;
+  allocationsPerOp: number;
+  metricsPerOp: Record<string, number>;
+}
+
+export interface BenchReport {
+  timestamp: string;
+  benchmarks: BenchResult[];
+}
+
+export interface BenchComparison {
+  id: string;
+  baselineMedianNs: number;
+  medianNs: number;
+  changePercent: number;
+  regressed: boolean;
+}
+
+export function findBenchFiles(targetPath: string): string[] {
+  return findTestFiles(targetPath, BENCH_CONVENTION);
+}
+
+export function discoverBenchmarks(rootDir: string, benchFiles: readonly string[]): DiscoveredTest[] {
+  return discoverTests(rootDir, benchFiles, undefined, BENCH_CONVENTION);
+}
+
+export function generateBenchHarnessSource(
+  harnessPath: string,
+  benchmarks: readonly DiscoveredTest[],
+): string {
+  const imports = benchmarks.map((bench) => {
+    const specifier = toImportSpecifier(harnessPath, bench.modulePath);
+    return `import { ${bench.name} } from "${specifier}"`;
+  });
+
+  const branches: string[] = [];
+  benchmarks.forEach((bench, index) => {
+    const keyword = index === 0 ? "if" : "} else if";
+    const id = escapeDoofString(bench.id);
+    branches.push(`    ${keyword} benchId == "${id}" {`);
+    branches.push(`        benchRun("${id}", (): void => ${bench.name}())`);
+    branches.push("        return 0");
+  });
+
+  return [
+    ...imports,
+    `import function benchRun(id: string, body: (): void): void from "${BENCH_SUPPORT_HEADER}" as doof_bench::run`,
+    "",
+    "function main(args: string[]): int {",
+    "    if args.length < 1 {",
+    "        println(\"missing benchmark id\")",
+    "        return 2",
+    "    }",
+    "",
+    "    benchId := args[0]",
+    ...branches,
+    "    } else {",
+    "        println(\"unknown benchmark id: ${benchId}\")",
+    "        return 2",
+    "    }",
+    "}",
+  ].join("\n");
+}
+
+/** Extract the measurement line from a harness run's stdout. */
+export function parseBenchOutput(stdout: string): BenchMeasurement | null {
+  for (const line of stdout.split("\n")) {
+    const trimmed = line.trimEnd();
+    if (!trimmed.startsWith(BENCH_LINE_PREFIX)) continue;
+    return JSON.parse(trimmed.slice(BENCH_LINE_PREFIX.length)) as BenchMeasurement;
+  }
+  return null;
+}
+
+/**
+ * Summarise a measurement: median and p99 of the per-iteration sample times,
+ * the median absolute deviation as a noise estimate, and allocations and
+ * counter deltas divided by the timed iteration count.
+ */
+export function summarizeBenchMeasurement(measurement: BenchMeasurement): BenchResult {
+  const sorted = [...measurement.samples].sort((left, right) => left - right);
+  const medianNs = median(sorted);
+  const deviations = sorted.map((sample) => Math.abs(sample - medianNs)).sort((left, right) => left - right);
+  const iterations = Math.max(1, measurement.iterations);
+  const metricsPerOp: Record<string, number> = {};
+  for (const [name, delta] of Object.entries(measurement.metrics)) {
+    metricsPerOp[name] = round(delta / iterations);
+  }
+
+  return {
+    id: measurement.id,
+    iterations: measurement.iterations,
+    samples: sorted.length,
+    medianNs: round(medianNs),
+    p99Ns: round(percentile(sorted, 0.99)),
+    madNs: round(median(deviations)),
+    allocationsPerOp: round(measurement.allocations / iterations),
+    metricsPerOp,
+  };
+}
+
+/** Compare each benchmark present in both reports by median time. */
+export function compareBenchReports(
+  current: BenchReport,
+  baseline: BenchReport,
+  thresholdPercent = DEFAULT_REGRESSION_THRESHOLD_PERCENT,
+): BenchComparison[] {
+  const baselineById = new Map(baseline.benchmarks.map((bench) => [bench.id, bench]));
+  const comparisons: BenchComparison[] = [];
+  for (const bench of current.benchmarks) {
+    const previous = baselineById.get(bench.id);
+    if (!previous || previous.medianNs <= 0) continue;
+    const changePercent = round(((bench.medianNs - previous.medianNs) / previous.medianNs) * 100);
+    comparisons.push({
+      id: bench.id,
+      baselineMedianNs: previous.medianNs,
+      medianNs: bench.medianNs,
+      changePercent,
+      regressed: changePercent > thresholdPercent,
+    });
+  }
+  return comparisons;
+}
+
+export async function runBenchCommand(options: RunBenchCommandOptions): Promise<RunBenchCommandResult> {
+  const absoluteTargetPath = path.resolve(options.targetPath);
+  const rootDir = determineRootDir(absoluteTargetPath);
+  const discovered = discoverBenchmarks(rootDir, findBenchFiles(absoluteTargetPath));
+  const selected = filterTests(discovered, options.filter);
+
+  if (selected.length === 0) {
+    const suffix = options.filter ? ` matching \"${options.filter}\"` : "";
+    throw new Error(`No benchmarks found under ${absoluteTargetPath}${suffix}`);
+  }
+
+  if (options.listOnly) {
+    for (const bench of selected) {
+      options.reporter.log(bench.id);
+    }
+
+    return { discovered: selected.length, executed: 0, failed: 0, regressions: 0 };
+  }
+
+  const results: BenchResult[] = [];
+  let failed = 0;
+
+  for (const group of groupTestsByModule(selected)) {
+    const harnessPath = buildHarnessPath(rootDir, group.moduleDisplayPath);
+    const overlay = new Map<string, string>([[harnessPath, generateBenchHarnessSource(harnessPath, group.tests)]]);
+    const fileSystem = new OverlayFS(overlay);
+    const executionRoot = determineExecutionRoot(group.modulePath, fileSystem);
+    const outDir = buildBenchOutputDir(executionRoot, group.moduleDisplayPath);
+
+    const { project, nativeBuild, outputBinaryName, provenance, buildManifest } = runPipelineWithFs(
+      fileSystem,
+      harnessPath,
+      options.verbose,
+      options.nativeBuild,
+      options.reporter.log,
+      (diagnostic) => options.reporter.error(formatDiagnostic(diagnostic)),
+    );
+
+    const releaseNativeBuild = withReleaseBuildDefaults(nativeBuild, options.compiler.kind);
+    buildManifest.compilerFlags = [...releaseNativeBuild.compilerFlags];
+    buildManifest.defines = [...releaseNativeBuild.defines];
+
+    // Harness builds include the header from their output directory, which
+    // is always on the include path.
+    const benchProject = {
+      ...project,
+      supportFiles: [...project.supportFiles, { relativePath: BENCH_SUPPORT_HEADER, content: loadBenchSupport() }],
+    };
+    const { outBinary: binary } = await runNativeBuildGraph(
+      outDir,
+      benchProject,
+      options.compiler,
+      releaseNativeBuild,
+      options.verbose,
+      outputBinaryName,
+      provenance,
+      buildManifest,
+    );
+
+    for (const bench of group.tests) {
+      if (options.verbose) options.reporter.log(`Running ${bench.id}`);
+
+      try {
+        const stdout = execFileSync(binary, [bench.id], {
+          stdio: "pipe",
+          cwd: executionRoot,
+          env: options.compiler.env ?? process.env,
+        }).toString();
+        const measurement = parseBenchOutput(stdout);
+        if (!measurement) {
+          throw new Error("benchmark produced no measurement");
+        }
+        const result = summarizeBenchMeasurement(measurement);
+        results.push(result);
+        options.reporter.log(formatBenchResult(result));
+      } catch (e: any) {
+        failed++;
+        options.reporter.error(`FAIL ${bench.id}`);
+        const stdout = e.stdout?.toString()?.trimEnd() ?? "";
+        const stderr = e.stderr?.toString()?.trimEnd() ?? (e instanceof Error ? e.message : "");
+        if (stdout) options.reporter.error(`stdout:\n${indentBlock(stdout)}`);
+        if (stderr) options.reporter.error(`stderr:\n${indentBlock(stderr)}`);
+      }
+    }
+  }
+
+  const report: BenchReport = { timestamp: new Date().toISOString(), benchmarks: results };
+  const outputPath = options.output || path.join(rootDir, "build", "bench", "doof-bench.json");
+  fs.mkdirSync(path.dirname(outputPath), { recursive: true });
+  fs.writeFileSync(outputPath, JSON.stringify(report, null, 2) + "\n");
+  options.reporter.log(`Benchmark results written to ${outputPath}`);
+
+  let regressions = 0;
+  if (options.baseline) {
+    const baseline = JSON.parse(fs.readFileSync(options.baseline, "utf-8")) as BenchReport;
+    const threshold = options.regressionThresholdPercent ?? DEFAULT_REGRESSION_THRESHOLD_PERCENT;
+    for (const comparison of compareBenchReports(report, baseline, threshold)) {
+      const sign = comparison.changePercent > 0 ? "+" : "";
+      const message = `${comparison.id}: ${formatNs(comparison.baselineMedianNs)} -> ${formatNs(comparison.medianNs)} (${sign}${comparison.changePercent.toFixed(1)}%)`;
+      if (comparison.regressed) {
+        regressions++;
+        options.reporter.error(`REGRESSION ${message}`);
+      } else {
+        options.reporter.log(`OK ${message}`);
+      }
+    }
+  }
+
+  options.reporter.log(`Benchmarks finished: ${results.length} measured, ${failed} failed, ${regressions} regressed`);
+
+  return {
+    discovered: selected.length,
+    executed: selected.length,
+    failed,
+    regressions,
+  };
+}
+
+function formatBenchResult(result: BenchResult): string {
+  const metrics = Object.entries(result.metricsPerOp).map(([name, perOp]) => ` ${name}/op ${perOp}`).join("");
+  return `BENCH ${result.id}: median ${formatNs(result.medianNs)}, p99 ${formatNs(result.p99Ns)}, mad ${formatNs(result.madNs)}, allocs/op ${result.allocationsPerOp}${metrics}`;
+}
+
+function formatNs(value: number): string {
+  return `${value.toFixed(1)} ns`;
+}
+
+function median(sorted: readonly number[]): number {
+  if (sorted.length === 0) return 0;
+  const middle = Math.floor(sorted.length / 2);
+  return sorted.length % 2 === 0 ? (sorted[middle - 1] + sorted[middle]) / 2 : sorted[middle];
+}
+
+/** Nearest-rank percentile of an ascending list. */
+function percentile(sorted: readonly number[], q: number): number {
+  if (sorted.length === 0) return 0;
+  const rank = Math.max(1, Math.ceil(q * sorted.length));
+  return sorted[Math.min(sorted.length, rank) - 1];
+}
+
+function round(value: number): number {
+  return Math.round(value * 1000) / 1000;
+}
+
+function buildHarnessPath(rootDir: string, moduleDisplayPath: string): string {
+  const safeModulePath = moduleDisplayPath.replace(/[^A-Za-z0-9._-]+/g, "_");
+  return path.join(rootDir, ".doof-bench", `${HARNESS_FILENAME.replace(/\.do$/, "")}_${safeModulePath}.do`);
+}
+
+function buildBenchOutputDir(executionRoot: string, moduleDisplayPath: string): string {
+  const safeModulePath = moduleDisplayPath.replace(/[^A-Za-z0-9._-]+/g, "_");
+  return path.join(executionRoot, "build", ".doof-bench", safeModulePath);
+}
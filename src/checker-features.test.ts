@@ -1149,6 +1149,70 @@ describe("Concurrency", () => {
     expect(cr.diagnostics.some((d) => d.message.includes('Actor<Worker> construction is not isolated'))).toBe(true);
     expect(cr.diagnostics.some((d) => d.message.includes('non-isolated function "constructor"'))).toBe(true);
   });
+
+  it("allows parallel array methods with isolated callbacks", () => {
+    const cr = check(
+      {
+        "/main.do": `
+          isolated function score(x: int): int => x * 3
+
+          function total(values: readonly int[]): int {
+            scale := 2
+            scaled := values.parallelMap((it: int): int => it * scale)
+            kept := scaled.parallelFilter((it: int): bool => it > 4)
+            sorted := kept.parallelSort((a: int, b: int): int => b - a)
+            scored := sorted.parallelMap(score)
+            return scored.parallelReduce(0, (acc: int, it: int): int => acc + it)
+          }
+        `,
+      },
+      "/main.do",
+    );
+    expect(cr.diagnostics).toHaveLength(0);
+  });
+
+  it("rejects parallel array methods on mutable arrays", () => {
+    const cr = check(
+      {
+        "/main.do": `
+          function main(values: int[]): int[] => values.parallelMap((it: int): int => it + 1)
+        `,
+      },
+      "/main.do",
+    );
+    expect(cr.diagnostics.some((d) => d.message.includes('Method "parallelMap" is only available on readonly arrays'))).toBe(true);
+  });
+
+  it("rejects parallel callbacks that are not provably isolated", () => {
+    const cr = check(
+      {
+        "/main.do": `
+          shared := [0]
+          function record(x: int): int {
+            shared.push(x)
+            return x
+          }
+
+          function run(values: readonly int[], pick: (it: int): bool): void {
+            let total = 0
+            buffer: int[] := []
+            a := values.parallelMap((it: int): int => it + total)
+            b := values.parallelMap((it: int): int => buffer.length + it)
+            c := values.parallelMap(record)
+            d := values.parallelFilter(pick)
+            e := values.parallelMap((it: int): int => record(it))
+          }
+        `,
+      },
+      "/main.do",
+    );
+    const messages = cr.diagnostics.map((d) => d.message);
+    expect(messages).toContain('Callback passed to parallelMap is not isolated: captures mutable binding "total"');
+    expect(messages.some((m) => m.startsWith('Callback passed to parallelMap is not isolated: captures "buffer" whose'))).toBe(true);
+    expect(messages).toContain('Callback passed to parallelMap is not isolated: accesses mutable module binding "shared"');
+    expect(messages).toContain('Callback passed to parallelFilter is not isolated: "pick" is not an inline lambda or named function');
+    expect(messages).toContain('Callback passed to parallelMap is not isolated: calls non-isolated function "record"');
+  });
 });
 
 describe("checker — for-of ranges", () => {
@@ -3647,6 +3711,19 @@ describe("JSON serialization — fromJsonValue", () => {
     expect(result?.errorType).toEqual(STRING_TYPE);
   });
 
+  it("resolves fromJsonText() to (string, bool = false) → Result<T, string> on class name", () => {
+    const info = check({ "/main.do": `
+      class Point { x, y: float }
+      const result = Point.fromJsonText("{}")
+      const lenient = Point.fromJsonText("{}", true)
+    ` }, "/main.do");
+    expect(info.diagnostics).toHaveLength(0);
+    const resultDecl = info.program.statements[1] as ConstDeclaration;
+    const result = resultDecl.resolvedType ? getResultShape(resultDecl.resolvedType) : null;
+    expect(result?.successType.kind).toBe("class");
+    expect(result?.errorType).toEqual(STRING_TYPE);
+  });
+
   it("errors for non-serializable field on fromJsonValue", () => {
     const info = check({ "/main.do": `
       class Bad {
@@ -3827,6 +3904,17 @@ describe("JSON serialization — reserved method names", () => {
     expect(info.diagnostics.some((d) => d.message.includes("fromJsonValue"))).toBe(true);
   });
 
+  it("errors when user defines fromJsonReader method on a class", () => {
+    const info = check({ "/main.do": `
+      class Foo {
+        x: int
+        function fromJsonReader(text: string): string => text
+      }
+    ` }, "/main.do");
+    expect(info.diagnostics.some((d) => d.message.includes("reserved intrinsic method"))).toBe(true);
+    expect(info.diagnostics.some((d) => d.message.includes("fromJsonReader"))).toBe(true);
+  });
+
   it("errors when user defines metadata method on a class", () => {
     const info = check({ "/main.do": `
       class Foo {
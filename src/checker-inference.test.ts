@@ -110,6 +110,8 @@ describe("Identifier resolution", () => {
         "/main.do": `
           function test(): void {
             metricsIncrement("requests_total", 1L)
+            metricsObserve("request_latency_us", 120L)
+            metricsGaugeSet("queue_depth", 2.5)
             snapshot := metricsSnapshotPrometheus()
           }
         `,
@@ -2,6 +2,7 @@
 
 import type {
   ActorCreationExpression,
+  CallExpression,
   ClassDeclaration,
   Expression,
   FunctionDeclaration,
@@ -11,7 +12,7 @@ import type {
 import { findActorBoundaryViolation } from "./checker-actor-boundary.js";
 import type { CheckerHost } from "./checker-internal.js";
 import { walkExpression, walkStatementListExpressions } from "./checker-stmt.js";
-import { isAssignableTo, type ModuleTypeInfo, type ResolvedType } from "./checker-types.js";
+import { isAssignableTo, PARALLEL_ARRAY_METHODS, type ModuleTypeInfo, type ResolvedType } from "./checker-types.js";
 import type { AnalysisResult } from "./analyzer.js";
 import type { ModuleSymbol, ModuleSymbolTable } from "./types.js";
 
@@ -360,6 +361,106 @@ function actorConstructionReason(
   return null;
 }
 
+const NON_VALUE_BINDING_KINDS = new Set([
+  "class",
+  "struct",
+  "function",
+  "interface",
+  "enum",
+  "type-alias",
+  "type-parameter",
+  "import",
+  "builtin",
+  "namespace-import",
+]);
+
+/**
+ * Why a parallel-array callback may not run on several carriers at once, or
+ * null when it is provably isolated. Named functions use the inferred
+ * isolation of their declaration; inline lambdas must also capture only
+ * immutable bindings whose values may cross actor boundaries.
+ */
+function parallelCallbackReason(
+  host: CheckerHost,
+  graph: IsolationGraph,
+  table: ModuleSymbolTable,
+  callback: Expression,
+): string | null {
+  if (callback.kind === "identifier") {
+    const target = targetForCall(graph, callback);
+    if (!target) return `"${callback.name}" is not an inline lambda or named function`;
+    return target.reason ? reasonText(target.reason) : null;
+  }
+  if (callback.kind !== "lambda-expression") {
+    return "only inline lambdas and named functions can be proven isolated";
+  }
+
+  const declaredInside = (span: SourceSpan, module: string): boolean =>
+    module === table.path
+    && span.start.offset >= callback.span.start.offset
+    && span.end.offset <= callback.span.end.offset;
+
+  let reason: string | null = null;
+  walkExpression(callback, (nested) => {
+    if (reason) return;
+    if (nested.kind === "this-expression") {
+      reason = 'captures "this"';
+      return;
+    }
+    if (nested.kind !== "identifier" || !nested.resolvedBinding) return;
+    const binding = nested.resolvedBinding;
+    if (NON_VALUE_BINDING_KINDS.has(binding.kind) || declaredInside(binding.span, binding.module)) return;
+    if (binding.kind === "field") {
+      reason = 'captures "this"';
+    } else if (binding.mutable) {
+      reason = `captures mutable binding "${nested.name}"`;
+    } else if (binding.type.kind === "function") {
+      reason = `captures callback "${nested.name}"`;
+    } else {
+      const violation = findActorBoundaryViolation(host, binding.type, table);
+      if (violation) reason = `captures "${nested.name}" whose ${violation.reason}`;
+    }
+  });
+  if (reason) return reason;
+
+  const effect = firstExpressionReason(host, graph, callback);
+  return effect ? reasonText(effect) : null;
+}
+
+function validateParallelArrayCall(
+  host: CheckerHost,
+  graph: IsolationGraph,
+  table: ModuleSymbolTable,
+  info: ModuleTypeInfo,
+  expression: CallExpression,
+): void {
+  if (expression.callee.kind !== "member-expression") return;
+  const method = expression.callee.property;
+  const arrayType = expression.callee.object.resolvedType;
+  if (!PARALLEL_ARRAY_METHODS.has(method) || arrayType?.kind !== "array" || !arrayType.readonly_) return;
+
+  const elementViolation = findActorBoundaryViolation(host, arrayType, table);
+  if (elementViolation) {
+    info.diagnostics.push({
+      severity: "error",
+      message: `Array passed to ${method} must be shareable across threads: ${elementViolation.reason}`,
+      span: expression.callee.object.span,
+      module: table.path,
+    });
+  }
+
+  const callback = expression.args[expression.args.length - 1]?.value;
+  const reason = callback ? parallelCallbackReason(host, graph, table, callback) : null;
+  if (callback && reason) {
+    info.diagnostics.push({
+      severity: "error",
+      message: `Callback passed to ${method} is not isolated: ${reason}`,
+      span: callback.span,
+      module: table.path,
+    });
+  }
+}
+
 /** Validate explicit isolation contracts and actor-dispatched execution paths. */
 export function validateIsolationEffects(
   host: CheckerHost,
@@ -398,6 +499,10 @@ export function validateIsolationEffects(
       }
     }
 
+    if (expression.kind === "call-expression") {
+      validateParallelArrayCall(host, graph, table, info, expression);
+    }
+
     if (expression.kind === "actor-creation-expression") {
       const reason = actorConstructionReason(host, graph, expression, table);
       if (reason) {
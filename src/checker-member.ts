@@ -16,6 +16,7 @@ import {
   JSON_VALUE_TYPE,
   REFLECTABLE_CONSTRAINT_TYPE,
   JSON_OBJECT_TYPE,
+  PARALLEL_ARRAY_METHODS,
   STRING_TYPE,
   BOOL_TYPE,
   CHAR_TYPE,
@@ -277,7 +278,7 @@ function inferClassInstanceMemberType(
       return { kind: "function", params: [], returnType: JSON_OBJECT_TYPE };
     }
 
-    if (property === "fromJsonValue" || property === "metadata") {
+    if (property === "fromJsonValue" || property === "fromJsonText" || property === "metadata") {
       reportMemberDiagnostic(
         info,
         table,
@@ -346,7 +347,7 @@ function inferClassStaticMemberType(
   return withClassTypeParams(host, classDecl, () => {
     const classSubMap = buildClassTypeSubstitution(objectType);
 
-    if (property === "fromJsonValue") {
+    if (property === "fromJsonValue" || property === "fromJsonText") {
       classDecl.needsJson = true;
       validateNoDedicatedConstructorForJson(objectType, table, info, span);
       const nonSerializable = collectNonSerializableFields(objectType);
@@ -363,7 +364,9 @@ function inferClassStaticMemberType(
       return {
         kind: "function",
         params: [
-          { name: "json", type: JSON_VALUE_TYPE },
+          property === "fromJsonText"
+            ? { name: "text", type: STRING_TYPE }
+            : { name: "json", type: JSON_VALUE_TYPE },
           { name: "lenient", type: BOOL_TYPE, hasDefault: true, defaultValue: null },
         ],
         returnType: makeResultType(objectType, STRING_TYPE),
@@ -525,7 +528,7 @@ function inferInterfaceStaticMemberType(
   const ifaceTable = host.analysisResult.modules.get(objectType.symbol.module);
   if (!ifaceTable) return UNKNOWN_TYPE;
 
-  if (property === "fromJsonValue") {
+  if (property === "fromJsonValue" || property === "fromJsonText") {
     if (mode === "qualified-static") {
       reportMemberDiagnostic(
         info,
@@ -541,6 +544,12 @@ function inferInterfaceStaticMemberType(
     for (const cls of implClasses) {
       cls.declaration.needsJson = true;
     }
+    if (property === "fromJsonText") {
+      ifaceDecl.needsJsonDocument = true;
+      for (const cls of implClasses) {
+        cls.declaration.needsJsonDocument = true;
+      }
+    }
     if (implClasses.length === 0 && info && span) {
       info.diagnostics.push({
         severity: "error",
@@ -577,7 +586,9 @@ function inferInterfaceStaticMemberType(
     return {
       kind: "function",
       params: [
-        { name: "json", type: JSON_VALUE_TYPE },
+        property === "fromJsonText"
+          ? { name: "text", type: STRING_TYPE }
+          : { name: "json", type: JSON_VALUE_TYPE },
         { name: "lenient", type: BOOL_TYPE, hasDefault: true, defaultValue: null },
       ],
       returnType: makeResultType(objectType, STRING_TYPE),
@@ -677,7 +688,7 @@ function inferTypeAliasStaticMemberType(
 ): ResolvedType {
   const aliasDecl = aliasSymbol.declaration;
 
-  if (property !== "fromJsonValue") {
+  if (property !== "fromJsonValue" && property !== "fromJsonText") {
     reportMemberDiagnostic(
       info,
       table,
@@ -692,7 +703,7 @@ function inferTypeAliasStaticMemberType(
       info,
       table,
       span,
-      `"fromJsonValue" is not available on generic type alias "${aliasSymbol.name}"`,
+      `"${property}" is not available on generic type alias "${aliasSymbol.name}"`,
     );
     return UNKNOWN_TYPE;
   }
@@ -702,7 +713,7 @@ function inferTypeAliasStaticMemberType(
       info,
       table,
       span,
-      `Cannot deserialize type alias "${aliasSymbol.name}": fromJsonValue requires a union of classes`,
+      `Cannot deserialize type alias "${aliasSymbol.name}": ${property} requires a union of classes`,
     );
     return UNKNOWN_TYPE;
   }
@@ -715,16 +726,18 @@ function inferTypeAliasStaticMemberType(
       info,
       table,
       span,
-      `Cannot deserialize type alias "${aliasSymbol.name}": fromJsonValue requires a union of classes`,
+      `Cannot deserialize type alias "${aliasSymbol.name}": ${property} requires a union of classes`,
     );
     return UNKNOWN_TYPE;
   }
 
   aliasDecl.needsJson = true;
+  if (property === "fromJsonText") aliasDecl.needsJsonDocument = true;
 
   const classSymbols = classMembers.map((member) => member.symbol);
   for (const cls of classSymbols) {
     cls.declaration.needsJson = true;
+    if (property === "fromJsonText") cls.declaration.needsJsonDocument = true;
     validateNoDedicatedConstructorForJson({ kind: "class", symbol: cls }, table, info, span);
     const nonSerializable = collectNonSerializableFields({ kind: "class", symbol: cls });
     if (nonSerializable.length > 0 && info && span) {
@@ -752,7 +765,9 @@ function inferTypeAliasStaticMemberType(
   return {
     kind: "function",
     params: [
-      { name: "json", type: JSON_VALUE_TYPE },
+      property === "fromJsonText"
+        ? { name: "text", type: STRING_TYPE }
+        : { name: "json", type: JSON_VALUE_TYPE },
       { name: "lenient", type: BOOL_TYPE, hasDefault: true, defaultValue: null },
     ],
     returnType: makeResultType(objectType, STRING_TYPE),
@@ -1082,6 +1097,71 @@ export function inferMemberType(
         returnType: { kind: "array", elementType: mappedType, readonly_: objectType.readonly_ },
       };
     }
+    if (PARALLEL_ARRAY_METHODS.has(property) && !objectType.readonly_) {
+      reportMemberDiagnostic(info, table, span, `Method "${property}" is only available on readonly arrays`);
+      return UNKNOWN_TYPE;
+    }
+    if (property === "parallelMap") {
+      const mappedType: ResolvedType = { kind: "typevar", name: "U" };
+      return {
+        kind: "function",
+        typeParams: ["U"],
+        params: [{
+          name: "mapper",
+          type: {
+            kind: "function",
+            params: [{ name: "it", type: elem }],
+            returnType: mappedType,
+          },
+        }],
+        returnType: { kind: "array", elementType: mappedType, readonly_: true },
+      };
+    }
+    if (property === "parallelFilter") {
+      return {
+        kind: "function",
+        params: [{
+          name: "predicate",
+          type: {
+            kind: "function",
+            params: [{ name: "it", type: elem }],
+            returnType: BOOL_TYPE,
+          },
+        }],
+        returnType: { kind: "array", elementType: elem, readonly_: true },
+      };
+    }
+    if (property === "parallelReduce") {
+      return {
+        kind: "function",
+        params: [
+          { name: "initial", type: elem },
+          {
+            name: "combine",
+            type: {
+              kind: "function",
+              params: [{ name: "acc", type: elem }, { name: "it", type: elem }],
+              returnType: elem,
+            },
+          },
+        ],
+        returnType: elem,
+      };
+    }
+    if (property === "parallelSort") {
+      return {
+        kind: "function",
+        params: [{
+          name: "compare",
+          type: {
+            kind: "function",
+            params: [{ name: "a", type: elem }, { name: "b", type: elem }],
+            returnType: INT_TYPE,
+          },
+        }],
+        returnType: { kind: "array", elementType: elem, readonly_: true },
+      };
+    }
     if (property === "slice") {
       return {
         kind: "function",
@@ -1230,6 +1310,22 @@ export function inferMemberType(
         returnType: makeResultType(objectType.valueType, STRING_TYPE),
       };
     }
+    if (property === "continueWith") {
+      const continuedType: ResolvedType = { kind: "typevar", name: "U" };
+      return {
+        kind: "function",
+        typeParams: ["U"],
+        params: [{
+          name: "next",
+          type: {
+            kind: "function",
+            params: [{ name: "result", type: makeResultType(objectType.valueType, STRING_TYPE) }],
+            returnType: continuedType,
+          },
+        }],
+        returnType: { kind: "promise", valueType: continuedType },
+      };
+    }
   }
 
   const objectResult = getResultShape(objectType);
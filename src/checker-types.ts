@@ -279,6 +279,14 @@ export const RANGE_TYPE: RangeResolvedType = { kind: "range" };
 export const JSON_SERIALIZABLE_CONSTRAINT_TYPE: JsonSerializableConstraintType = { kind: "json-serializable-constraint" };
 export const REFLECTABLE_CONSTRAINT_TYPE: ReflectableConstraintType = { kind: "reflectable-constraint" };
 
+/** Readonly-array methods that run their callback across carrier threads. */
+export const PARALLEL_ARRAY_METHODS: ReadonlySet<string> = new Set([
+  "parallelMap",
+  "parallelFilter",
+  "parallelReduce",
+  "parallelSort",
+]);
+
 /** Build the canonical semantic representation of Result<T, E>. */
 export function makeResultType(successType: ResolvedType, errorType: ResolvedType): UnionResolvedType {
   return {
@@ -54,6 +54,7 @@ import {
   JSON_SERIALIZABLE_CONSTRAINT_TYPE,
   REFLECTABLE_CONSTRAINT_TYPE,
   LONG_TYPE,
+  DOUBLE_TYPE,
   VOID_TYPE,
   NULL_TYPE,
   RANGE_TYPE,
@@ -1125,6 +1126,12 @@ export class TypeChecker {
    */
   private addBuiltinFunctions(scope: Scope): void {
     const catchPanicSuccessType: ResolvedType = { kind: "typevar", name: "T" };
+    const promiseValueType: ResolvedType = { kind: "typevar", name: "T" };
+    const promiseArrayType: ResolvedType = {
+      kind: "array",
+      elementType: { kind: "promise", valueType: promiseValueType },
+      readonly_: false,
+    };
     const builtins: { name: string; params: FunctionResolvedParam[]; returnType: ResolvedType; typeParams?: string[] }[] = [
       // println(value: T): void — print a value followed by a newline
       { name: "println", params: [{ name: "value", type: UNKNOWN_TYPE }], returnType: VOID_TYPE },
@@ -1142,13 +1149,31 @@ export class TypeChecker {
         returnType: makeResultType(catchPanicSuccessType, STRING_TYPE),
         typeParams: ["T"],
       },
+      // whenAll<T>(promises: Promise<T>[]): Promise<T[]> — settle with every value, or the first failure
+      {
+        name: "whenAll",
+        params: [{ name: "promises", type: promiseArrayType }],
+        returnType: { kind: "promise", valueType: { kind: "array", elementType: promiseValueType, readonly_: false } },
+        typeParams: ["T"],
+      },
+      // whenAny<T>(promises: Promise<T>[]): Promise<T> — settle with whichever promise settles first
+      {
+        name: "whenAny",
+        params: [{ name: "promises", type: promiseArrayType }],
+        returnType: { kind: "promise", valueType: promiseValueType },
+        typeParams: ["T"],
+      },
       // to_string(value: T): string — convert any value to a string
       { name: "to_string", params: [{ name: "value", type: UNKNOWN_TYPE }], returnType: STRING_TYPE },
       // concat(...args): string — concatenate values into a string
       { name: "concat", params: [{ name: "value", type: UNKNOWN_TYPE }], returnType: STRING_TYPE },
       // metricsIncrement(name: string, value: long): void — increment a process-local counter
       { name: "metricsIncrement", params: [{ name: "name", type: STRING_TYPE }, { name: "value", type: LONG_TYPE }], returnType: VOID_TYPE },
-      // metricsSnapshotPrometheus(): string — render current counters in Prometheus text format
+      // metricsObserve(name: string, value: long): void — record a sample in a latency histogram
+      { name: "metricsObserve", params: [{ name: "name", type: STRING_TYPE }, { name: "value", type: LONG_TYPE }], returnType: VOID_TYPE },
+      // metricsGaugeSet(name: string, value: double): void — set a process-local gauge
+      { name: "metricsGaugeSet", params: [{ name: "name", type: STRING_TYPE }, { name: "value", type: DOUBLE_TYPE }], returnType: VOID_TYPE },
+      // metricsSnapshotPrometheus(): string — render current metrics in Prometheus text format
       { name: "metricsSnapshotPrometheus", params: [], returnType: STRING_TYPE },
     ];
 
@@ -1383,6 +1408,10 @@ export class TypeChecker {
       this.unifyType(paramType.elementType, argType.elementType, typeParams, result);
       return;
     }
+    if (paramType.kind === "promise" && argType.kind === "promise") {
+      this.unifyType(paramType.valueType, argType.valueType, typeParams, result);
+      return;
+    }
     if (paramType.kind === "tuple" && argType.kind === "tuple") {
       const len = Math.min(paramType.elements.length, argType.elements.length);
       for (let i = 0; i < len; i++) {
@@ -388,6 +388,7 @@ function createProjectEmitResult(): ProjectEmitResult {
       },
     ],
     runtime: "",
+    runtimeActors: "",
     supportFiles: [],
     outputNativeCopies: [],
     outputNativeIncludePaths: [],
@@ -6,6 +6,7 @@ import { reckon, type BuildSummary, type Task, type TaskContext } from "@andrew2
 import { ModuleAnalyzer } from "./analyzer.js";
 import { TypeChecker } from "./checker.js";
 import { emitProject, type NativeBuildOptions, type ProjectEmitResult } from "./emitter-module.js";
+import { RUNTIME_CORE_HEADER_FILE, runtimeHeaderFiles } from "./emitter-runtime.js";
 import type { DoofBuildTarget, IOSAppDestination, ResolvedDoofBuildTarget } from "./build-targets.js";
 import type { FileSystem } from "./resolver.js";
 import { dirnameFsPath, isWithinFsRoot, joinFsPath, relativeFsPath, resolveFsPath, toPortablePath } from "./path-utils.js";
@@ -114,8 +115,15 @@ export interface CompilerToolchain {
   kind: CompilerToolchainKind;
   command: string;
   env?: NodeJS.ProcessEnv;
+  /**
+   * Family of a gcc-like compiler, when `--version` identified it. Selects
+   * the precompiled header and profile-guided optimisation flags.
+   */
+  compilerFamily?: GccLikeCompilerFamily;
 }
 
+export type GccLikeCompilerFamily = "gcc" | "clang";
+
 const EMSCRIPTEN_DEFAULT_COMPILE_FLAGS = ["-Oz", "-flto"];
 const EMSCRIPTEN_DEFAULT_LINK_FLAGS = [
   "-Oz",
@@ -205,11 +213,21 @@ interface ManagedNativeCopyManifest {
   files: string[];
 }
 
+interface ObjectCacheVariant {
+  object: string;
+  dependencies: Array<{ path: string; hash: string }>;
+}
+
+interface ObjectCacheEntry {
+  variants: ObjectCacheVariant[];
+}
+
 const DEFAULT_GCC_TOOLCHAIN: CompilerToolchain = { kind: "gcc-like", command: "c++" };
 const VSWHERE_COMPONENT = "Microsoft.VisualStudio.Component.VC.Tools.x86.x64";
 const GCC_LIKE_COMPILERS = ["clang++", "g++", "c++"] as const;
 const VISUAL_STUDIO_VERSION_NAMES = ["18", "17", "16", "15", "Preview", "Current"];
 const VISUAL_STUDIO_EDITIONS = ["Community", "Professional", "Enterprise", "BuildTools"];
+const OBJECT_CACHE_VARIANTS_PER_SOURCE = 4;
 
 function defaultCompilerDetectionHost(): CompilerDetectionHost {
   return {
@@ -341,6 +359,7 @@ export function runPipelineWithFs(
     coverage?: boolean;
     metricsClassLifecycle?: boolean;
     observe?: boolean;
+    profile?: boolean;
     materializeExternalDependencies?: boolean;
   } = {},
 ): PipelineResult {
@@ -425,6 +444,8 @@ export function runPipelineWithFs(
     coverage: options.coverage,
     metricsClassLifecycle: options.metricsClassLifecycle,
     observe: options.observe,
+    profile: options.profile,
+    strings: packageGraph.rootPackage.manifest.build?.strings,
   });
   const project: ProjectEmitResult = nativeCopyPlan
     ? {
@@ -474,7 +495,9 @@ export function writeProject(
 ): void {
   fs.mkdirSync(outDir, { recursive: true });
 
-  writeFile(path.join(outDir, "doof_runtime.hpp"), project.runtime, verbose, log);
+  for (const runtimeFile of runtimeHeaderFiles(project)) {
+    writeFile(path.join(outDir, runtimeFile.relativePath), runtimeFile.content, verbose, log);
+  }
 
   for (const mod of project.modules) {
     writeFile(path.join(outDir, mod.hppPath), mod.hppCode, verbose, log);
@@ -518,7 +541,9 @@ export function createProjectMaterializePlan(
     taskByOutputPath.set(outputPath, task);
   };
 
-  addGeneratedFile("doof_runtime.hpp", project.runtime);
+  for (const runtimeFile of runtimeHeaderFiles(project)) {
+    addGeneratedFile(runtimeFile.relativePath, runtimeFile.content);
+  }
   for (const mod of project.modules) {
     addGeneratedFile(mod.hppPath, mod.hppCode);
     addGeneratedFile(mod.cppPath, mod.cppCode);
@@ -721,13 +746,15 @@ export function createNativeBuildGraphPlan(
   const generatedHeaderTasks = project.modules
     .map((mod) => materializePlan.taskByOutputPath.get(resolveOutputRelativePath(inputs.absOutDir, mod.hppPath, platform)))
     .filter((task): task is Task => Boolean(task));
-  const runtimeTask = materializePlan.taskByOutputPath.get(resolveOutputRelativePath(inputs.absOutDir, "doof_runtime.hpp", platform));
+  const runtimeTasks = runtimeHeaderFiles(project)
+    .map((file) => materializePlan.taskByOutputPath.get(resolveOutputRelativePath(inputs.absOutDir, file.relativePath, platform)))
+    .filter((task): task is Task => Boolean(task));
   const outputNativeCopyTasks = expandOutputNativeCopies(project.outputNativeCopies)
     .map((file) => materializePlan.taskByOutputPath.get(resolveOutputRelativePath(inputs.absOutDir, file.relativePath, platform)))
     .filter((task): task is Task => Boolean(task));
   const sharedGeneratedDependencies = uniqueTasks([
     ...generatedHeaderTasks,
-    ...(runtimeTask ? [runtimeTask] : []),
+    ...runtimeTasks,
     ...outputNativeCopyTasks,
   ]);
   const compileSources = uniqueStrings([...inputs.moduleCppFiles, ...inputs.effectiveNativeBuild.sourceFiles]);
@@ -739,12 +766,27 @@ export function createNativeBuildGraphPlan(
     assertNoSwiftSources(sourceGroups.swiftSourceFiles, toolchain);
   }
   const externalDependencyTasks = project.externalDependencySentinelPaths.map(externalDependencySentinelTask);
+  const objectCacheDirectory = buildObjectCacheDirectory(inputs.absOutDir, platform);
+  // A single module would parse the runtime once either way.
+  const precompiledRuntime = toolchain.kind === "gcc-like" && toolchain.compilerFamily && inputs.moduleCppFiles.length > 1
+    ? precompiledRuntimeHeaderTask(
+      toolchain,
+      toolchain.compilerFamily,
+      inputs.absOutDir,
+      inputs.includePaths,
+      inputs.effectiveNativeBuild,
+      uniqueTasks([...runtimeTasks, ...externalDependencyTasks]),
+      platform,
+    )
+    : null;
+  const moduleCppFiles = new Set(inputs.moduleCppFiles);
   const objectTasks = compileSources.map((sourceFile, index) => {
     const sourceTask = materializePlan.taskByOutputPath.get(sourceFile);
     const dependencies = uniqueTasks([
       ...(sourceTask ? [sourceTask] : []),
       ...sharedGeneratedDependencies,
       ...externalDependencyTasks,
+      ...(precompiledRuntime && moduleCppFiles.has(sourceFile) ? [precompiledRuntime.task] : []),
     ]);
     const objectFile = buildIncrementalObjectFilePath(inputs.absOutDir, sourceFile, index, platform);
     return isNativeSwiftSource(sourceFile)
@@ -752,8 +794,17 @@ export function createNativeBuildGraphPlan(
       : toolchain.kind === "msvc"
       ? msvcObjectTask(toolchain, sourceFile, objectFile, inputs.includePaths, inputs.effectiveNativeBuild, dependencies)
       : toolchain.kind === "emscripten"
-        ? emscriptenObjectTask(toolchain, sourceFile, objectFile, inputs.includePaths, inputs.effectiveNativeBuild, dependencies)
-      : gccLikeObjectTask(toolchain, sourceFile, objectFile, inputs.includePaths, inputs.effectiveNativeBuild, dependencies);
+        ? emscriptenObjectTask(toolchain, sourceFile, objectFile, inputs.includePaths, inputs.effectiveNativeBuild, dependencies, objectCacheDirectory)
+      : gccLikeObjectTask(
+        toolchain,
+        sourceFile,
+        objectFile,
+        inputs.includePaths,
+        inputs.effectiveNativeBuild,
+        dependencies,
+        objectCacheDirectory,
+        moduleCppFiles.has(sourceFile) ? precompiledRuntime : null,
+      );
   });
   const linkTask = toolchain.kind === "msvc"
     ? msvcLinkTask(toolchain, inputs.outBinary, objectTasks, inputs.effectiveNativeBuild, externalDependencyTasks)
@@ -779,7 +830,13 @@ export function createNativeBuildGraphPlan(
   return {
     outBinary: inputs.outBinary,
     target: linkTask,
-    tasks: [...materializePlan.tasks, ...externalDependencyTasks, ...objectTasks, linkTask],
+    tasks: [
+      ...materializePlan.tasks,
+      ...externalDependencyTasks,
+      ...(precompiledRuntime ? [precompiledRuntime.task] : []),
+      ...objectTasks,
+      linkTask,
+    ],
   };
 }
 
@@ -1244,13 +1301,19 @@ function gccLikeObjectTask(
   includePaths: string[],
   nativeBuild: NativeBuildOptions,
   dependencies: readonly Task[],
+  objectCacheDirectory: string | null = null,
+  precompiledRuntime: PrecompiledRuntimeHeader | null = null,
 ): Task {
   const isCSource = isNativeCSource(sourceFile);
   const compiler = isCSource ? deriveGccLikeCCompilerCommand(toolchain.command) : toolchain.command;
   const dependencyFile = `${objectFile}.d`;
   const args = isCSource
     ? buildGccLikeCObjectArgs(objectFile, dependencyFile, sourceFile, includePaths, nativeBuild)
-    : buildGccLikeCxxObjectArgs(objectFile, dependencyFile, sourceFile, includePaths, nativeBuild);
+    : [
+      ...(precompiledRuntime?.compileArgs ?? []),
+      ...buildGccLikeCxxObjectArgs(objectFile, dependencyFile, sourceFile, includePaths, nativeBuild),
+    ];
+  const fingerprint = stableFingerprint({ kind: "doof-gcc-like-object", compiler, args, env: toolchain.env });
 
   return {
     id: `doof:object:${objectFile}`,
@@ -1258,15 +1321,90 @@ function gccLikeObjectTask(
     outputs: [objectFile],
     fileDependencies: dependencies.length > 0 ? [] : [sourceFile],
     taskDependencies: [...dependencies],
-    fingerprint: stableFingerprint({ kind: "doof-gcc-like-object", compiler, args, env: toolchain.env }),
+    fingerprint,
     async execute(context) {
       fs.mkdirSync(path.dirname(objectFile), { recursive: true });
-      await runBuildCommand(context, compiler, args, toolchain.env);
-      return { discoveredDependencies: parseDependencyFile(dependencyFile).filter((entry) => entry !== sourceFile) };
+      const discoveredDependencies = await compileWithObjectCache(
+        objectCacheDirectory,
+        fingerprint,
+        sourceFile,
+        objectFile,
+        dependencyFile,
+        () => runBuildCommand(context, compiler, args, toolchain.env),
+        precompiledRuntime?.headerDependencies,
+      );
+      return { discoveredDependencies };
     },
   };
 }
 
+interface PrecompiledRuntimeHeader {
+  task: Task;
+  /** Arguments that make a C++ compile use the precompiled header. */
+  compileArgs: string[];
+  /** Headers baked into the PCH, which depfiles of its users no longer list. */
+  headerDependencies: string[];
+}
+
+// Compiles doof_runtime_core.hpp once per build so generated modules skip
+// re-parsing it.  The PCH goes through a wrapper header because GCC only
+// picks up `<header>.gch` for a header named on the command line.
+function precompiledRuntimeHeaderTask(
+  toolchain: CompilerToolchain,
+  format: GccLikeCompilerFamily,
+  outDir: string,
+  includePaths: string[],
+  nativeBuild: NativeBuildOptions,
+  dependencies: readonly Task[],
+  platform: NodeJS.Platform,
+): PrecompiledRuntimeHeader {
+  const objectRoot = resolveOutputRelativePath(outDir, ".doof-objects", platform);
+  const wrapperFile = resolveOutputRelativePath(objectRoot, "doof_runtime_pch.hpp", platform);
+  const pchFile = format === "gcc" ? `${wrapperFile}.gch` : `${wrapperFile}.pch`;
+  const dependencyFile = `${pchFile}.d`;
+  const wrapper = `#include "${RUNTIME_CORE_HEADER_FILE}"\n`;
+  const args = [
+    `-std=${nativeBuild.cppStd}`,
+    ...includePaths.map((includePath) => `-I${includePath}`),
+    ...nativeBuild.defines.map((define) => `-D${define}`),
+    ...nativeBuild.compilerFlags,
+    "-MMD",
+    "-MF",
+    dependencyFile,
+    "-x",
+    "c++-header",
+    wrapperFile,
+    "-o",
+    pchFile,
+  ];
+  const fingerprint = stableFingerprint({
+    kind: "doof-gcc-like-pch",
+    compiler: toolchain.command,
+    args,
+    wrapper,
+    env: toolchain.env,
+  });
+
+  return {
+    task: {
+      id: `doof:pch:${pchFile}`,
+      label: `precompile ${RUNTIME_CORE_HEADER_FILE}`,
+      outputs: [wrapperFile, pchFile],
+      fileDependencies: [],
+      taskDependencies: [...dependencies],
+      fingerprint,
+      async execute(context) {
+        fs.mkdirSync(objectRoot, { recursive: true });
+        fs.writeFileSync(wrapperFile, wrapper, "utf8");
+        await runBuildCommand(context, toolchain.command, args, toolchain.env);
+        return { discoveredDependencies: parseDependencyFile(dependencyFile).filter((entry) => entry !== wrapperFile) };
+      },
+    },
+    compileArgs: format === "gcc" ? ["-include", wrapperFile] : ["-include-pch", pchFile],
+    headerDependencies: [resolveOutputRelativePath(outDir, RUNTIME_CORE_HEADER_FILE, platform), wrapperFile],
+  };
+}
+
 function emscriptenObjectTask(
   toolchain: CompilerToolchain,
   sourceFile: string,
@@ -1274,6 +1412,7 @@ function emscriptenObjectTask(
   includePaths: string[],
   nativeBuild: NativeBuildOptions,
   dependencies: readonly Task[],
+  objectCacheDirectory: string | null = null,
 ): Task {
   const isCSource = isNativeCSource(sourceFile);
   const compiler = isCSource ? deriveEmscriptenCCompilerCommand(toolchain.command) : toolchain.command;
@@ -1282,6 +1421,7 @@ function emscriptenObjectTask(
   const args = isCSource
     ? buildGccLikeCObjectArgs(objectFile, dependencyFile, sourceFile, includePaths, effectiveNativeBuild)
     : buildGccLikeCxxObjectArgs(objectFile, dependencyFile, sourceFile, includePaths, effectiveNativeBuild);
+  const fingerprint = stableFingerprint({ kind: "doof-emscripten-object", compiler, args, env: toolchain.env });
 
   return {
     id: `doof:object:${objectFile}`,
@@ -1289,11 +1429,18 @@ function emscriptenObjectTask(
     outputs: [objectFile],
     fileDependencies: dependencies.length > 0 ? [] : [sourceFile],
     taskDependencies: [...dependencies],
-    fingerprint: stableFingerprint({ kind: "doof-emscripten-object", compiler, args, env: toolchain.env }),
+    fingerprint,
     async execute(context) {
       fs.mkdirSync(path.dirname(objectFile), { recursive: true });
-      await runBuildCommand(context, compiler, args, toolchain.env);
-      return { discoveredDependencies: parseDependencyFile(dependencyFile).filter((entry) => entry !== sourceFile) };
+      const discoveredDependencies = await compileWithObjectCache(
+        objectCacheDirectory,
+        fingerprint,
+        sourceFile,
+        objectFile,
+        dependencyFile,
+        () => runBuildCommand(context, compiler, args, toolchain.env),
+      );
+      return { discoveredDependencies };
     },
   };
 }
@@ -1464,7 +1611,7 @@ function syncOutputNativeFiles(
     ? expandOutputNativeCopies(project.outputNativeCopies)
     : [];
   const reservedPaths = new Set<string>([
-    "doof_runtime.hpp",
+    ...runtimeHeaderFiles(project).map((file) => file.relativePath),
     "doof-build.json",
     "provenance.json",
     ...project.modules.flatMap((mod) => [mod.hppPath, mod.cppPath]),
@@ -1673,13 +1820,26 @@ function tryResolveCompilerToolchain(compiler: string, host: CompilerDetectionHo
 
 function tryResolveGccLikeToolchain(compiler: string, host: CompilerDetectionHost): CompilerToolchain | null {
   try {
-    host.execFile(compiler, ["--version"], { timeout: 5000 });
-    return { kind: "gcc-like", command: compiler };
+    const version = host.execFile(compiler, ["--version"], { timeout: 5000 }).toString();
+    const compilerFamily = detectGccLikeCompilerFamily(version);
+    return compilerFamily
+      ? { kind: "gcc-like", command: compiler, compilerFamily }
+      : { kind: "gcc-like", command: compiler };
   } catch {
     return null;
   }
 }
 
+function detectGccLikeCompilerFamily(versionOutput: string): GccLikeCompilerFamily | null {
+  if (/clang/i.test(versionOutput)) {
+    return "clang";
+  }
+  if (/\b(?:g\+\+|gcc)\b|Free Software Foundation/.test(versionOutput)) {
+    return "gcc";
+  }
+  return null;
+}
+
 function tryResolveMsvcToolchain(compiler: string, host: CompilerDetectionHost): CompilerToolchain | null {
   if (canRunMsvcCompiler(compiler, host.env, host)) {
     return { kind: "msvc", command: compiler, env: host.env };
@@ -2188,6 +2348,12 @@ function buildNativeObjectFilePath(
     : joinFsPath(objectRoot, `${relativeSourcePath}${objectExtension}`);
 }
 
+function buildObjectCacheDirectory(outDir: string, platform: NodeJS.Platform): string {
+  return platform === "win32"
+    ? path.win32.join(outDir, ".doof-object-cache")
+    : joinFsPath(outDir, ".doof-object-cache");
+}
+
 function getNativeObjectRelativeSourcePath(
   outDir: string,
   sourceFile: string,
@@ -2310,6 +2476,87 @@ function parseDependencyFile(filePath: string): string[] {
   }
 }
 
+/**
+ * Compile one translation unit through a content-addressed object cache.
+ *
+ * Entries are keyed by the compile command and the source's content hash, and
+ * each variant records the hashes of the headers (including the runtime) that
+ * the compiler reported for it. A variant whose headers still hash the same is
+ * copied into place instead of recompiling, so reverting an edit or switching
+ * back to an earlier state of a module reuses its old object. Without a cache
+ * directory, or when the compiler reports no dependency file, this just compiles.
+ */
+async function compileWithObjectCache(
+  cacheDirectory: string | null,
+  commandFingerprint: string,
+  sourceFile: string,
+  objectFile: string,
+  dependencyFile: string,
+  compile: () => Promise<void>,
+  extraDependencies: readonly string[] = [],
+): Promise<string[]> {
+  const readDependencies = () => uniqueStrings([
+    ...parseDependencyFile(dependencyFile).filter((entry) => entry !== sourceFile),
+    ...extraDependencies,
+  ]);
+  const sourceHash = cacheDirectory ? hashFileContents(sourceFile) : null;
+  if (!cacheDirectory || sourceHash === null) {
+    await compile();
+    return readDependencies();
+  }
+
+  const key = stableFingerprint({ commandFingerprint, sourceHash });
+  const entryPath = path.join(cacheDirectory, `${key}.json`);
+  const entry = readObjectCacheEntry(entryPath);
+  const hit = entry.variants.find((variant) =>
+    fs.existsSync(path.join(cacheDirectory, variant.object))
+    && variant.dependencies.every((dependency) => hashFileContents(dependency.path) === dependency.hash)
+  );
+  if (hit) {
+    fs.copyFileSync(path.join(cacheDirectory, hit.object), objectFile);
+    return hit.dependencies.map((dependency) => dependency.path);
+  }
+
+  await compile();
+  const discovered = readDependencies();
+  const dependencies: ObjectCacheVariant["dependencies"] = [];
+  for (const dependencyPath of discovered) {
+    const hash = hashFileContents(dependencyPath);
+    if (hash === null) return discovered;
+    dependencies.push({ path: dependencyPath, hash });
+  }
+  const variant: ObjectCacheVariant = {
+    object: `${key}-${stableFingerprint(dependencies)}${path.extname(objectFile)}`,
+    dependencies,
+  };
+  fs.mkdirSync(cacheDirectory, { recursive: true });
+  fs.copyFileSync(objectFile, path.join(cacheDirectory, variant.object));
+  const variants = [variant, ...entry.variants.filter((existing) => existing.object !== variant.object)];
+  for (const evicted of variants.splice(OBJECT_CACHE_VARIANTS_PER_SOURCE)) {
+    fs.rmSync(path.join(cacheDirectory, evicted.object), { force: true });
+  }
+  const nextEntry: ObjectCacheEntry = { variants };
+  fs.writeFileSync(entryPath, JSON.stringify(nextEntry, null, 2) + "\n", "utf8");
+  return discovered;
+}
+
+function readObjectCacheEntry(entryPath: string): ObjectCacheEntry {
+  try {
+    const parsed = JSON.parse(fs.readFileSync(entryPath, "utf8")) as Partial<ObjectCacheEntry>;
+    return { variants: Array.isArray(parsed.variants) ? parsed.variants : [] };
+  } catch {
+    return { variants: [] };
+  }
+}
+
+function hashFileContents(filePath: string): string | null {
+  try {
+    return createHash("sha1").update(fs.readFileSync(filePath)).digest("hex");
+  } catch {
+    return null;
+  }
+}
+
 function uniqueTasks(tasks: readonly Task[]): Task[] {
   const seen = new Set<string>();
   const result: Task[] = [];
@@ -2355,6 +2602,14 @@ export function printDiagnostic(diagnostic: DiagnosticLike): void {
 
 function writeFile(filePath: string, content: string, verbose: boolean, log: (msg: string) => void): void {
   fs.mkdirSync(path.dirname(filePath), { recursive: true });
+  // Leave unchanged files alone so their mtimes keep external builds incremental.
+  let existing: string | null = null;
+  try {
+    existing = fs.readFileSync(filePath, "utf8");
+  } catch {
+    existing = null;
+  }
+  if (existing === content) return;
   fs.writeFileSync(filePath, content);
   if (verbose) log(`  wrote ${filePath}`);
 }
@@ -16,6 +16,7 @@ import {
 import {
   createNativeBuildGraphPlan,
   createProjectMaterializePlan,
+  writeProject,
 } from "./cli-core.js";
 import { VirtualFS } from "./test-helpers.js";
 
@@ -178,6 +179,24 @@ describe("CLI argument parsing", () => {
     expect(args.coverageOutput).toBe("");
   });
 
+  it("parses bench command options", () => {
+    const args = parseArgs([
+      "node", "doof", "bench",
+      "--filter", "json",
+      "--bench-output", "/tmp/bench.json",
+      "--baseline", "/tmp/baseline.json",
+      "--regression-threshold", "5",
+      "bench/doof",
+    ]);
+
+    expect(args.command).toBe("bench");
+    expect(args.entry).toBe("bench/doof");
+    expect(args.testFilter).toBe("json");
+    expect(args.benchOutput).toBe("/tmp/bench.json");
+    expect(args.benchBaseline).toBe("/tmp/baseline.json");
+    expect(args.regressionThreshold).toBe(5);
+  });
+
   it("parses --metrics-class-lifecycle for pipeline commands", () => {
     const args = parseArgs(["node", "doof", "build", "--metrics-class-lifecycle", "samples"]);
 
@@ -192,6 +211,14 @@ describe("CLI argument parsing", () => {
     expect(args.observe).toBe(true);
   });
 
+  it("parses --profile for run as an observed, profiled build", () => {
+    const args = parseArgs(["node", "doof", "run", "--profile", "samples"]);
+
+    expect(args.profile).toBe(true);
+    expect(args.observe).toBe(true);
+    expect(args.nativeBuild.defines).toContain("DOOF_PROFILE");
+  });
+
   it("rejects --observe for non-run commands", () => {
     vi.spyOn(console, "error").mockImplementation(() => {});
     vi.spyOn(process, "exit").mockImplementation(((code?: string | number | null) => {
@@ -384,8 +411,42 @@ describe("CLI package resolution", () => {
       outDir: "/workspace/demo/state/release",
       distDir: "/workspace/demo/artifacts",
       version: "2.3.4",
+      buildProfile: "release",
     });
   });
+
+  it("keeps each package build profile in its own state directory", () => {
+    const fs = new VirtualFS({
+      "/workspace/demo/doof.json": JSON.stringify({
+        name: "demo",
+        build: { package: { profile: "release-lto" } },
+      }),
+      "/workspace/demo/main.do": "function main(): void {}",
+    });
+
+    expect(resolveCliPackageInputs(fs, "/workspace", parseArgs(["node", "doof", "package", "demo"]))).toMatchObject({
+      outDir: "/workspace/demo/build/release-lto",
+      buildProfile: "release-lto",
+    });
+    expect(resolveCliPackageInputs(
+      fs,
+      "/workspace",
+      parseArgs(["node", "doof", "package", "--build-profile", "debug", "demo"]),
+    )).toMatchObject({
+      outDir: "/workspace/demo/build/debug",
+      buildProfile: "debug",
+    });
+  });
+
+  it("rejects --build-profile outside doof package", () => {
+    vi.spyOn(console, "error").mockImplementation(() => {});
+    vi.spyOn(process, "exit").mockImplementation(((code?: string | number | null) => {
+      throw new Error(`exit ${code}`);
+    }) as never);
+
+    expect(() => parseArgs(["node", "doof", "build", "--build-profile", "release", "samples"])).toThrow("exit 1");
+    expect(() => parseArgs(["node", "doof", "package", "--build-profile", "fast", "samples"])).toThrow("exit 1");
+  });
 });
 
 describe("CLI run settings", () => {
@@ -461,6 +522,90 @@ describe("CLI compile args", () => {
     expect(fs.statSync(hppPath).mtimeMs).toBe(firstHppMtime);
   });
 
+  it("emits only the project files whose content changes", async () => {
+    const outDir = createTempDir();
+    const project = createProjectEmitResult();
+    project.modules[0].cppCode = "one\n";
+    writeProject(project, outDir, false, () => {});
+
+    const cppPath = path.join(outDir, "main.cpp");
+    const hppPath = path.join(outDir, "main.hpp");
+    const firstCppMtime = fs.statSync(cppPath).mtimeMs;
+    const firstHppMtime = fs.statSync(hppPath).mtimeMs;
+
+    project.modules[0].cppCode = "two\n";
+    await new Promise((resolve) => setTimeout(resolve, 10));
+    writeProject(project, outDir, false, () => {});
+
+    expect(fs.readFileSync(cppPath, "utf8")).toBe("two\n");
+    expect(fs.statSync(cppPath).mtimeMs).toBeGreaterThan(firstCppMtime);
+    expect(fs.statSync(hppPath).mtimeMs).toBe(firstHppMtime);
+  });
+
+  it.skipIf(process.platform === "win32")("restores cached objects when a module returns to earlier content", async () => {
+    const outDir = createTempDir();
+    const compilerDir = createTempDir();
+    const logPath = path.join(compilerDir, "invocations.log");
+    const compiler = path.join(compilerDir, "fake-c++");
+    fs.writeFileSync(compiler, [
+      "#!/bin/sh",
+      `echo compile >> "${logPath}"`,
+      "while [ $# -gt 0 ]; do",
+      "  case \"$1\" in",
+      "    -MF) dep=\"$2\"; shift ;;",
+      "    -c) src=\"$2\"; shift ;;",
+      "    -o) out=\"$2\"; shift ;;",
+      "  esac",
+      "  shift",
+      "done",
+      "cp \"$src\" \"$out\"",
+      "printf '%s: %s\\n' \"$out\" \"$src\" > \"$dep\"",
+      "",
+    ].join("\n"), "utf8");
+    fs.chmodSync(compiler, 0o755);
+
+    const nativeBuild = {
+      cppStd: "c++17",
+      includePaths: [],
+      libraryPaths: [],
+      linkLibraries: [],
+      frameworks: [],
+      pkgConfigPackages: [],
+      sourceFiles: [],
+      objectFiles: [],
+      compilerFlags: [],
+      linkerFlags: [],
+      defines: [],
+    };
+    const project = createProjectEmitResult();
+    const compileObjects = async (cppCode: string) => {
+      project.modules[0].cppCode = cppCode;
+      const graph = createNativeBuildGraphPlan(
+        outDir,
+        project,
+        { kind: "gcc-like", command: compiler },
+        nativeBuild,
+        createProjectMaterializePlan(project, outDir),
+        "demo",
+        { platform: process.platform },
+      );
+      await reckon(graph.tasks.filter((task) => task !== graph.target), {
+        cwd: path.parse(outDir).root,
+        stateDirectory: path.join(outDir, ".reckon"),
+      });
+    };
+    const compileCount = () => fs.readFileSync(logPath, "utf8").trim().split("\n").length;
+    const objectPath = path.join(outDir, ".doof-objects", "main.cpp.o");
+
+    await compileObjects("one\n");
+    await compileObjects("two\n");
+    expect(compileCount()).toBe(2);
+    await compileObjects("one\n");
+
+    expect(compileCount()).toBe(2);
+    expect(fs.readFileSync(objectPath, "utf8")).toBe("one\n");
+  });
+
   it("plans gcc-like object compile tasks and a final link task", () => {
     const project = createProjectEmitResult();
     const materializePlan = createProjectMaterializePlan(project, "/tmp/doof-build");
@@ -499,6 +644,49 @@ describe("CLI compile args", () => {
     expect(graph.target.fingerprint).toEqual(expect.any(String));
   });
 
+  it("precompiles the core runtime header for generated modules when the compiler supports it", () => {
+    const base = createProjectEmitResult();
+    const project: ProjectEmitResult = {
+      ...base,
+      modules: [
+        ...base.modules,
+        { modulePath: "/util.do", hppPath: "util.hpp", cppPath: "util.cpp", hppCode: "", cppCode: "" },
+      ],
+    };
+    const materializePlan = createProjectMaterializePlan(project, "/tmp/doof-build");
+    const graph = createNativeBuildGraphPlan(
+      "/tmp/doof-build",
+      project,
+      { kind: "gcc-like", command: "g++", compilerFamily: "gcc" },
+      {
+        cppStd: "c++20",
+        includePaths: [],
+        libraryPaths: [],
+        linkLibraries: [],
+        frameworks: [],
+        pkgConfigPackages: [],
+        sourceFiles: ["/tmp/native/bridge.cpp"],
+        objectFiles: [],
+        compilerFlags: ["-O2"],
+        linkerFlags: [],
+        defines: [],
+      },
+      materializePlan,
+      "demo",
+      { platform: "linux" },
+    );
+
+    const pchTask = graph.tasks.find((task) => task.label === "precompile doof_runtime_core.hpp");
+    expect(pchTask?.outputs).toEqual([
+      "/tmp/doof-build/.doof-objects/doof_runtime_pch.hpp",
+      "/tmp/doof-build/.doof-objects/doof_runtime_pch.hpp.gch",
+    ]);
+    const compileMain = graph.tasks.find((task) => task.label === "compile /tmp/doof-build/main.cpp");
+    const compileBridge = graph.tasks.find((task) => task.label === "compile /tmp/native/bridge.cpp");
+    expect(compileMain?.taskDependencies).toContain(pchTask);
+    expect(compileBridge?.taskDependencies).not.toContain(pchTask);
+  });
+
   it("plans mixed native C, C++, Objective-C++, and Swift sources with a swiftc link", () => {
     const project = createProjectEmitResult();
     const materializePlan = createProjectMaterializePlan(project, "/tmp/doof-build");
@@ -687,6 +875,7 @@ function createProjectEmitResult(): ProjectEmitResult {
       },
     ],
     runtime: "",
+    runtimeActors: "",
     supportFiles: [],
     outputNativeCopies: [],
     outputNativeIncludePaths: [],
@@ -60,14 +60,15 @@ import {
   writeProject,
 } from "./cli-core.js";
 import { runTestCommand } from "./test-runner.js";
+import { runBenchCommand } from "./bench-runner.js";
 import { runPackageCommand } from "./package-command.js";
-import { copyExecutableResources } from "./package-artifacts.js";
+import { copyExecutableResources, isBuildProfile, type BuildProfile } from "./package-artifacts.js";
 
 // ============================================================================
 // CLI argument parsing
 // ============================================================================
 
-type Command = "emit" | "build" | "run" | "package" | "check" | "test" | "help" | "version";
+type Command = "emit" | "build" | "run" | "package" | "check" | "test" | "bench" | "help" | "version";
 type PipelineCommand = "emit" | "build" | "run" | "package" | "check";
 
 export interface CliArgs {
@@ -86,6 +87,7 @@ export interface CliArgs {
   macosSignIdentity: string | null;
   macosSandbox: boolean | null;
   macosEntitlements: string | null;
+  buildProfile: BuildProfile | null;
   compiler: string | null;
   cppStd: string;
   verbose: boolean;
@@ -93,8 +95,12 @@ export interface CliArgs {
   listTests: boolean;
   coverage: boolean;
   coverageOutput: string;
+  benchOutput: string;
+  benchBaseline: string;
+  regressionThreshold: number | null;
   metricsClassLifecycle: boolean;
   observe: boolean;
+  profile: boolean;
   programArgs: string[];
   nativeBuild: NativeBuildOptions;
 }
@@ -113,6 +119,7 @@ Commands:
   run    [path]        Emit, compile, and run the program
   check  [path]        Type-check only (no C++ output)
   test   <path>        Discover and run exported Doof tests
+  bench  <path>        Discover, build in release mode, and measure exported Doof benchmarks
 
 Options:
   -o, --outdir <dir>   Build-state root (default: package build/ or build.buildDir)
@@ -133,6 +140,8 @@ Options:
   --macos-sandbox      Enable App Sandbox for a packaged macOS app
   --macos-entitlements <path>
                        Additional macOS package entitlements plist
+  --build-profile <name>
+                       doof package build profile: debug, release, release-lto, or pgo (default: release)
   --std <standard>     C++ standard (default: c++17)
   --include-path <dir> Additional header search path (repeatable)
   --lib-path <dir>     Additional library search path (repeatable)
@@ -143,14 +152,20 @@ Options:
   --define <name>      Preprocessor definition, optionally NAME=value (repeatable)
   --cxxflag <flag>     Additional compiler flag (repeatable)
   --ldflag <flag>      Additional linker flag (repeatable)
-  --filter <text>      Run only tests whose id contains the filter text
-  --list               List discovered tests without compiling or running them
+  --filter <text>      Run only tests or benchmarks whose id contains the filter text
+  --list               List discovered tests or benchmarks without compiling or running them
   --coverage           Collect and report line coverage for Doof source files
   --coverage-output <path>
                        Path for the JSON coverage report (default: build/coverage/doof-test-coverage.json)
+  --bench-output <path>
+                       Path for the JSON benchmark results (default: build/bench/doof-bench.json)
+  --baseline <path>    Compare benchmark medians against saved doof bench results
+  --regression-threshold <percent>
+                       Median slowdown against --baseline that fails doof bench (default: 10)
   --metrics-class-lifecycle
                        Emit class create/dispose counters through the runtime metrics API
   --observe            Run with a local observer UI for runtime metrics
+  --profile            Run with function and actor spans traced to the observer UI (implies --observe)
   -v, --verbose        Print detailed progress information
   -h, --help           Show this help message
   --version            Show version
@@ -158,6 +173,9 @@ Options:
 
 Environment:
   DOOF_RUN_TIMEOUT_MS  Max runtime in ms for doof run (default: unlimited)
+  DOOF_BENCH_SAMPLES   Timed samples per benchmark (default: 30)
+  DOOF_BENCH_SAMPLE_NS Target duration of one benchmark sample in ns (default: 10000000)
+  DOOF_BENCH_WARMUP_NS Benchmark warmup duration in ns (default: 100000000)
 
 Examples:
   doof run samples/hello.do
@@ -165,6 +183,7 @@ Examples:
   doof build -o dist samples/fibonacci.do
   doof build samples/solitaire
   doof package samples/solitaire
+  doof package --build-profile release-lto samples/solitaire
   doof build --target ios-app samples/solitaire
   doof run --target ios-app --ios-destination device samples/solitaire
   doof run --target ios-app --ios-destination device --ios-device <udid> --ios-sign-identity "Apple Development: Name (TEAMID)" --ios-provisioning-profile ~/Library/MobileDevice/Provisioning\ Profiles/profile.mobileprovision samples/solitaire
@@ -172,10 +191,11 @@ Examples:
   doof emit --verbose samples/classes.do
   doof check samples/hello.do
   doof test samples
+  doof bench bench/doof --baseline bench-baseline.json
   doof build --include-path ./vendor/include --lib-path ./vendor/lib --link-lib curl samples/http.do
 `.trimStart();
 
-const COMMANDS = new Set<Command>(["emit", "build", "run", "package", "check", "test"]);
+const COMMANDS = new Set<Command>(["emit", "build", "run", "package", "check", "test", "bench"]);
 const FALLBACK_VERSION = "0.0.0";
 
 function createEmptyNativeBuildOptions(cppStd = "c++17"): NativeBuildOptions {
@@ -211,6 +231,7 @@ export function parseArgs(argv: string[]): CliArgs {
     macosSignIdentity: null,
     macosSandbox: null,
     macosEntitlements: null,
+    buildProfile: null,
     compiler: null,
     cppStd: "c++17",
     verbose: false,
@@ -218,8 +239,12 @@ export function parseArgs(argv: string[]): CliArgs {
     listTests: false,
     coverage: false,
     coverageOutput: "",
+    benchOutput: "",
+    benchBaseline: "",
+    regressionThreshold: null,
     metricsClassLifecycle: false,
     observe: false,
+    profile: false,
     programArgs: [],
     nativeBuild: createEmptyNativeBuildOptions(),
   };
@@ -301,6 +326,12 @@ export function parseArgs(argv: string[]): CliArgs {
       case "--macos-entitlements":
         args.macosEntitlements = rest[++i] ?? fatal("Missing value for --macos-entitlements");
         break;
+      case "--build-profile": {
+        const value = rest[++i] ?? fatal("Missing value for --build-profile");
+        if (!isBuildProfile(value)) fatal(`Invalid value for --build-profile: ${value}`);
+        args.buildProfile = value;
+        break;
+      }
       case "--std":
         args.cppStd = rest[++i] ?? fatal("Missing value for --std");
         args.nativeBuild.cppStd = args.cppStd;
@@ -344,12 +375,29 @@ export function parseArgs(argv: string[]): CliArgs {
       case "--coverage-output":
         args.coverageOutput = rest[++i] ?? fatal("Missing value for --coverage-output");
         break;
+      case "--bench-output":
+        args.benchOutput = rest[++i] ?? fatal("Missing value for --bench-output");
+        break;
+      case "--baseline":
+        args.benchBaseline = rest[++i] ?? fatal("Missing value for --baseline");
+        break;
+      case "--regression-threshold": {
+        const value = Number(rest[++i] ?? fatal("Missing value for --regression-threshold"));
+        if (!Number.isFinite(value) || value < 0) fatal("--regression-threshold must be a non-negative number");
+        args.regressionThreshold = value;
+        break;
+      }
       case "--metrics-class-lifecycle":
         args.metricsClassLifecycle = true;
         break;
       case "--observe":
         args.observe = true;
         break;
+      case "--profile":
+        args.profile = true;
+        args.observe = true;
+        args.nativeBuild.defines.push("DOOF_PROFILE");
+        break;
       case "-v": case "--verbose":
         args.verbose = true;
         break;
@@ -363,9 +411,15 @@ export function parseArgs(argv: string[]): CliArgs {
     i++;
   }
 
+  if (args.profile && args.command !== "run") {
+    fatal("--profile is only supported with doof run");
+  }
   if (args.observe && args.command !== "run") {
     fatal("--observe is only supported with doof run");
   }
+  if (args.buildProfile && args.command !== "package") {
+    fatal("--build-profile is only supported with doof package");
+  }
 
   return args;
 }
@@ -397,6 +451,7 @@ interface ResolvedPackageCliInputs {
   outDir: string;
   distDir: string;
   version: string;
+  buildProfile: BuildProfile;
   packageConfig: ResolvedDoofPackageConfig;
 }
 
@@ -405,19 +460,23 @@ export function resolveCliPackageInputs(fileSystem: FileSystem, cwd: string, arg
   const context = resolveRequestedPackageContext(fileSystem, requestedPath, args.entry);
   if (context) {
     const packageConfig = resolvePackageReleaseConfig(context);
+    const buildProfile = args.buildProfile ?? packageConfig.profile ?? "release";
     return {
       entry: context.entryPath,
-      outDir: joinFsPath(args.outDirExplicit ? resolveFsPathFrom(cwd, args.outDir) : context.buildDir, "release"),
+      outDir: joinFsPath(args.outDirExplicit ? resolveFsPathFrom(cwd, args.outDir) : context.buildDir, buildProfile),
       distDir: args.distDirExplicit ? resolveFsPathFrom(cwd, args.distDir) : packageConfig.distDir,
       version: context.manifest.version ?? "0.0.0",
+      buildProfile,
       packageConfig,
     };
   }
+  const buildProfile = args.buildProfile ?? "release";
   return {
     entry: requestedPath,
-    outDir: joinFsPath(resolveFsPathFrom(cwd, args.outDir), "release"),
+    outDir: joinFsPath(resolveFsPathFrom(cwd, args.outDir), buildProfile),
     distDir: resolveFsPathFrom(cwd, args.distDir),
     version: "0.0.0",
+    buildProfile,
     packageConfig: { distDir: resolveFsPathFrom(cwd, args.distDir), macos: {}, ios: {} },
   };
 }
@@ -444,12 +503,14 @@ function runPipeline(
   iosDestination: IOSAppDestination,
   metricsClassLifecycle: boolean,
   observe = false,
+  profile = false,
 ) {
   return runPipelineWithFs(new RealFS(), entryFile, verbose, nativeBuild, log, printDiagnostic, {
     buildTargetOverride: targetOverride ?? undefined,
     iosDestinationOverride: iosDestination,
     metricsClassLifecycle,
     observe,
+    profile,
   });
 }
 
@@ -489,6 +550,7 @@ async function cmdBuildOrRun(args: CliArgs, run: boolean): Promise<void> {
     args.iosDestination,
     args.metricsClassLifecycle,
     run && args.observe,
+    run && args.profile,
   );
   if (run && buildTarget?.kind === "wasm") {
     throw new Error("doof run is not supported for --target wasm; instantiate the generated .wasm from your host runtime");
@@ -623,6 +685,8 @@ async function cmdPackage(args: CliArgs & ResolvedPackageCliInputs): Promise<voi
     macosSigning: signingOverrides.macos,
     iosSigning: signingOverrides.ios,
     metricsClassLifecycle: args.metricsClassLifecycle,
+    buildProfile: args.buildProfile,
+    pgo: args.packageConfig.pgo,
   }, { log });
   log(`Package complete: ${artifactPath}`);
 }
@@ -676,6 +740,27 @@ async function cmdTest(args: CliArgs): Promise<void> {
   }
 }
 
+async function cmdBench(args: CliArgs): Promise<void> {
+  const compiler = args.compiler ? resolveCompilerToolchain(args.compiler) : findCompilerToolchain();
+  const nativeBuild = resolveNativeBuildOptions(args.nativeBuild);
+  const result = await runBenchCommand({
+    targetPath: args.entry,
+    compiler,
+    nativeBuild,
+    filter: args.testFilter,
+    listOnly: args.listTests,
+    verbose: args.verbose,
+    reporter: { log, error },
+    output: args.benchOutput ? path.resolve(args.benchOutput) : undefined,
+    baseline: args.benchBaseline ? path.resolve(args.benchBaseline) : undefined,
+    regressionThresholdPercent: args.regressionThreshold ?? undefined,
+  });
+
+  if (!args.listTests && (result.failed > 0 || result.regressions > 0)) {
+    process.exit(1);
+  }
+}
+
 // ============================================================================
 // Output helpers
 // ============================================================================
@@ -826,6 +911,10 @@ export async function main(argv = process.argv): Promise<void> {
         if (!resolvedArgs.entry) fatal("Missing test path. Usage: doof test <path>");
         await cmdTest(resolvedArgs);
         break;
+      case "bench":
+        if (!resolvedArgs.entry) fatal("Missing benchmark path. Usage: doof bench <path>");
+        await cmdBench(resolvedArgs);
+        break;
       case "emit":
         cmdEmit(
           resolvedArgs.entry,
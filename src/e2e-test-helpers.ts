@@ -20,6 +20,7 @@ import {
   tryFindCompilerToolchain,
 } from "./cli-core.js";
 import { emitProject, type NativeBuildOptions } from "./emitter-module.js";
+import { runtimeHeaderFiles } from "./emitter-runtime.js";
 import { createPackageOutputPaths, findDoofManifestPath, loadPackageGraph } from "./package-manifest.js";
 import { collectSemanticDiagnostics, throwIfErrorDiagnostics } from "./pipeline-diagnostics.js";
 import { createBundledModuleResolver, withBundledStdlib } from "./stdlib.js";
@@ -118,8 +119,9 @@ export class E2EContext {
 
   /**
    * Compile and run a Doof source program. Returns the program's output.
+   * `nativeBuild` adds compiler options such as `defines` to the build.
    */
-  compileAndRun(doofSource: string): RunResult {
+  compileAndRun(doofSource: string, nativeBuild: Partial<NativeBuildOptions> = {}): RunResult {
     if (!this.cppToolchain) {
       return {
         exitCode: -1,
@@ -147,9 +149,9 @@ export class E2EContext {
     // Compile
     let outBinary = "";
     try {
-      const nativeBuild = createNativeBuildOptions();
-      const compilePlan = buildCompilePlan(this.tmpDir, project, nativeBuild, {
-        extraIncludePaths: getExtraIncludePaths(nativeBuild, [project.runtime, ...project.modules.map((mod) => mod.hppCode), ...project.modules.map((mod) => mod.cppCode)]),
+      const nativeBuildOptions = createNativeBuildOptions(nativeBuild);
+      const compilePlan = buildCompilePlan(this.tmpDir, project, nativeBuildOptions, {
+        extraIncludePaths: getExtraIncludePaths(nativeBuildOptions, [project.runtime, ...project.modules.map((mod) => mod.hppCode), ...project.modules.map((mod) => mod.cppCode)]),
         toolchain: this.cppToolchain,
       });
       outBinary = compilePlan.outBinary;
@@ -491,11 +493,14 @@ function createBuildMetadataForEntry(vfs: VirtualFS, entry: string) {
   });
   return {
     packageOutputPaths: createPackageOutputPaths(graph, entry),
+    strings: graph.rootPackage.manifest.build?.strings,
   };
 }
 
 function writeProjectArtifacts(tmpDir: string, project: ReturnType<typeof emitProject>): void {
-  fs.writeFileSync(path.join(tmpDir, "doof_runtime.hpp"), project.runtime);
+  for (const runtimeFile of runtimeHeaderFiles(project)) {
+    fs.writeFileSync(path.join(tmpDir, runtimeFile.relativePath), runtimeFile.content);
+  }
   for (const mod of project.modules) {
     const hppFile = path.join(tmpDir, mod.hppPath);
     const cppFile = path.join(tmpDir, mod.cppPath);
@@ -87,7 +87,7 @@ describe("emitter — Result type", () => {
       }
     `);
     expect(cpp).toContain("doof::is_failure(");
-    expect(cpp).toContain("doof::Failure<std::string>{");
+    expect(cpp).toContain("doof::propagate_failure<doof::Failure<std::string>>(");
     expect(cpp).toContain("std::move(");
     expect(cpp).toContain("doof::success_value(");
   });
@@ -130,8 +130,8 @@ describe("emitter — Result type", () => {
 
   it("generates map_get as Result<V, string>", () => {
     const header = generateRuntimeHeader();
-    expect(header).toContain("Result<V, std::string> map_get");
-    expect(header).toContain('Failure<std::string>{"Map key not found"}');
+    expect(header).toContain("Result<V, string> map_get");
+    expect(header).toContain('Failure<string>{"Map key not found"}');
   });
 
   it("generates map_set through insert_or_assign", () => {
@@ -499,7 +499,7 @@ describe("emitter — case expression on Result", () => {
       }
     `);
 
-    expect(cpp).toContain("invoke(doof::callback<int32_t()>([=]() -> int32_t");
+    expect(cpp).toContain("invoke([=]() -> int32_t");
     expect(cpp).toContain("std::visit([&](auto&& _val) -> int32_t");
     expect(cpp).not.toContain("invoke([delivered, f]() -> int32_t");
     expect(cpp).not.toContain("return doof::Success<int32_t>{[&]() -> int32_t");
@@ -1035,6 +1035,29 @@ describe("emitter — JSON serialization", () => {
     expect(cpp).toContain("User::fromJsonValue(json)");
   });
 
+  it("emits fromJsonText/fromJsonReader that decode without a JsonValue tree", () => {
+    const cpp = emit(`
+      class Inner {
+        value: int
+      }
+      class Outer {
+        inner: Inner
+        tags: string[]
+        count: int = 10
+      }
+      function parse(text: string): Result<Outer, string> => Outer.fromJsonText(text, true)
+    `);
+    expect(cpp).toContain("Outer::fromJsonText(text, true)");
+    expect(cpp).toContain("static doof::Result<std::shared_ptr<Outer>, std::string> fromJsonText(std::string_view _text, bool _lenient = false) {");
+    expect(cpp).toContain("static doof::Result<std::shared_ptr<Outer>, std::string> fromJsonReader(doof::JsonReader& _reader, bool _lenient = false) {");
+    expect(cpp).toContain('return doof::Failure<std::string>{_reader.mismatch("Field \\"inner\\" expected object")};');
+    expect(cpp).toContain("auto _r0 = Inner::fromJsonReader(_reader, _lenient);");
+    expect(cpp).toContain("_vec0->push_back(((_lenient) ? doof::json_as_string_lenient(_v1) : doof::json_as_string(_v1)));");
+    expect(cpp).toContain("} else if (!_reader.skip_value()) {");
+    expect(cpp).toContain("_f_count.emplace(10);");
+    expect(cpp).toContain("std::make_shared<Outer>(std::move(*_f_inner), std::move(*_f_tags), std::move(*_f_count))");
+  });
+
   it("emits obj.toJsonObject() as instance call", () => {
     const cpp = emit(`
       class User {
@@ -1117,6 +1140,51 @@ describe("emitter — JSON serialization", () => {
     expect(cpp).toContain("return doof::Success<Shape>{Shape(doof::success_value(_r))};");
   });
 
+  it("emits JsonNode decoders and fromJsonText for Interface.fromJsonText()", () => {
+    const cpp = emit(`
+      interface Shape {
+        area(): double
+      }
+      class Point { x: double; y: double }
+      class Circle implements Shape {
+        const kind = "circle"
+        center: Point
+        radius: double
+        area(): double => 3.14159 * radius * radius
+      }
+      class Square implements Shape {
+        const kind = "square"
+        side: double
+        area(): double => side * side
+      }
+      function parse(text: string): Result<Shape, string> => Shape.fromJsonText(text)
+    `);
+    expect(cpp).toContain("Shape_fromJsonValue(const doof::JsonValue& _j, bool _lenient = false)");
+    expect(cpp).toContain("Shape_fromJsonValue(const doof::JsonNode& _j, bool _lenient = false)");
+    expect(cpp).toContain("Shape_fromJsonText(std::string_view _text, bool _lenient = false)");
+    expect(cpp).toContain("doof::JsonDocument::parse_view(_text)");
+    expect(cpp).toContain("fromJsonValue(const doof::JsonNode& _j, bool _lenient = false)");
+    expect(cpp).toContain("Point::fromJsonValue(_it_center->second, _lenient)");
+    expect(cpp).toContain("Shape_fromJsonText(text)");
+  });
+
+  it("only emits JsonNode decoders when fromJsonText is used", () => {
+    const cpp = emit(`
+      class Circle {
+        const kind = "circle"
+        radius: double
+      }
+      class Square {
+        const kind = "square"
+        side: double
+      }
+      type Shape = Circle | Square
+      function test(json: JsonValue): Result<Shape, string> => Shape.fromJsonValue(json)
+    `);
+    expect(cpp).not.toContain("doof::JsonNode");
+    expect(cpp).not.toContain("Shape_fromJsonText");
+  });
+
   it("emits union alias fromJsonValue() as free function call", () => {
     const cpp = emit(`
       class Circle {
@@ -1161,7 +1229,7 @@ describe("emitter — JSON serialization", () => {
     `);
     expect(cpp).not.toContain("toJsonObject");
     expect(cpp).not.toContain("fromJsonValue");
-    expect(cpp).toContain('#include "doof_runtime.hpp"');
+    expect(cpp).toContain('#include "doof_runtime_core.hpp"');
   });
 
   it("does NOT emit JSON methods for a class with a dedicated constructor", () => {
@@ -1183,7 +1251,7 @@ describe("emitter — JSON serialization", () => {
         y: int
       }
     `);
-    expect(cpp).toContain('#include "doof_runtime.hpp"');
+    expect(cpp).toContain('#include "doof_runtime_core.hpp"');
   });
 
   it("uses runtime JSON helpers when toJsonObject is called", () => {
@@ -1194,7 +1262,7 @@ describe("emitter — JSON serialization", () => {
       }
       function test(p: Point): JsonObject => p.toJsonObject()
     `);
-    expect(cpp).toContain('#include "doof_runtime.hpp"');
+    expect(cpp).toContain('#include "doof_runtime_core.hpp"');
     expect(cpp).toContain("toJsonObject()");
   });
 
@@ -8,7 +8,7 @@ import { beforeAll, describe, it, expect } from "vitest";
 import { emit, emitMulti, emitProjectHelper, emitSplit } from "./emitter-test-helpers.js";
 import { emitType, mangleTypeForCppName } from "./emitter-types.js";
 import { assignModuleNamespaces } from "./emitter-names.js";
-import { generateRuntimeHeader } from "./emitter-runtime.js";
+import { generateRuntimeActorsHeader, generateRuntimeHeader } from "./emitter-runtime.js";
 import { check, collectExprs } from "./checker-test-helpers.js";
 import { UNKNOWN_TYPE, type ResolvedType } from "./checker-types.js";
 
@@ -1031,18 +1031,17 @@ describe("emitter — for-of loops", () => {
       }
     `);
 
-    expect(cpp).toContain("while (true)");
-    expect(cpp).toContain("auto _stream_next_");
-    expect(cpp).toContain("__doof_stream_next___doof_stream_int(_stream_");
-    expect(cpp).toContain("if (!_stream_next_");
-    expect(cpp).toContain("__doof_stream_value___doof_stream_int(_stream_");
+    expect(cpp).toContain("std::optional<int32_t> _stream_value_");
+    expect(cpp).toMatch(/while \((?:[\w:]*::)?__doof_stream_pull___doof_stream_int\(_stream_\d+, _stream_value_\d+\)\)/);
+    expect(cpp).toMatch(/const auto& item = \*_stream_value_\d+;/);
+    expect(cpp).toContain("bool __doof_stream_pull___doof_stream_int(const __doof_stream_int& stream, std::optional<int32_t>& slot)");
   });
 });
 
 describe("emitter — includes", () => {
   it("emits standard includes", () => {
     const cpp = emit(`const X = 42`);
-    expect(cpp).toContain('#include "doof_runtime.hpp"');
+    expect(cpp).toContain('#include "doof_runtime_core.hpp"');
     expect(cpp).toContain("#include <cstdint>");
     expect(cpp).toContain("#include <memory>");
     expect(cpp).toContain("#include <string>");
@@ -1083,14 +1082,28 @@ describe("emitter — runtime header", () => {
     }
     expect(header).toContain("std::variant<T...> unwrap_optional");
     expect(header).not.toContain("T pop(const std::shared_ptr<std::vector<T>>& value)");
-    expect(header).toContain("Result<T, std::string> array_pop");
+    expect(header).toContain("Result<T, string> array_pop");
     expect(header).toContain("bool variant_is(const std::variant<Source...>& value)");
     expect(header).toContain("Target variant_narrow(const std::variant<Source...>& value)");
     expect(header).toContain("struct is_variant_alternative : std::is_same<Candidate, Variant> {};");
     expect(header).toContain("Target variant_promote(const std::variant<Source...>& value)");
+    expect(header).toContain("decltype(auto) visit_table(F&& visitor, V&& value)");
     expect(header).toContain("decltype(auto) resolved_type(const std::variant<T...>& value)");
   });
 
+  it("keeps actors and their thread includes out of the core header", () => {
+    const core = generateRuntimeHeader();
+    expect(core).not.toContain("class ActorScheduler final");
+    expect(core).not.toContain("#include <future>");
+    expect(core).not.toContain("#include <thread>");
+
+    const actors = generateRuntimeActorsHeader();
+    expect(actors).toContain("#pragma once");
+    expect(actors).toContain("#include <thread>");
+    expect(actors).toContain('#include "doof_runtime_core.hpp"');
+    expect(actors).toContain("class ActorScheduler final");
+  });
+
   it("generates std::variant stringification support", () => {
     const header = generateRuntimeHeader();
     expect(header).toContain("inline std::string to_string(const std::variant<Ts...>& val)");
@@ -1099,11 +1112,31 @@ describe("emitter — runtime header", () => {
 
   it("uses shared inline state for coverage runtime", () => {
     const header = generateRuntimeHeader();
-    expect(header).toContain("inline std::unordered_set<LineHit, LineHitHash> _coverage_hits;");
+    expect(header).toContain("inline std::atomic<ModuleLines*> _registered_modules{nullptr};");
     expect(header).toContain("inline std::once_flag _coverage_registration_once;");
     expect(header).toContain("std::call_once(_coverage_registration_once");
   });
 
+  it("marks covered lines in a per-module bitmap", () => {
+    const project = emitProjectHelper({
+      "/main.do": [
+        "function main(): void {",
+        "  x := 1",
+        "  println(x)",
+        "}",
+      ].join("\n"),
+    }, "/main.do", { coverage: true });
+    const entry = project.modules.find((mod) => mod.modulePath === "/main.do");
+
+    const lines = entry?.instrumentedLines ?? [];
+    expect(lines).toHaveLength(2);
+    expect(entry?.cppCode).toContain(`static doof::coverage::ModuleBitmap<${lines[1]}> doof_coverage_lines(${entry?.coverageModuleId});`);
+    for (const line of lines) {
+      expect(entry?.cppCode).toContain(`::doof_coverage_lines.mark(${line});`);
+    }
+    expect(entry?.cppCode).not.toContain("cov_mark");
+  });
+
   it("omits observer support by default", () => {
     const header = generateRuntimeHeader();
     expect(header).not.toContain("namespace observe");
@@ -1120,6 +1153,8 @@ describe("emitter — runtime header", () => {
     expect(header).toContain("if (should_launch_browser())");
     expect(header).toContain("Doof Observer");
     expect(header).toContain("/api/metrics/prometheus");
+    expect(header).toContain("/api/metrics/stream");
+    expect(header).toContain("/api/trace");
   });
 
   it("starts the observer from the generated entry point when requested", () => {
@@ -1137,15 +1172,38 @@ describe("emitter — runtime header", () => {
     expect(cpp).not.toContain("doof::observe::start_server();");
   });
 
+  it("opens profiler spans in emitted function bodies when requested", () => {
+    const project = emitProjectHelper({
+      "/main.do": `
+        function work(): int => 1
+        function main(): void {
+          work()
+        }
+      `,
+    }, "/main.do", { observe: true, profile: true });
+    const entry = project.modules.find((mod) => mod.modulePath === "/main.do");
+
+    expect(entry?.cppCode).toContain('DOOF_PROFILE_SCOPE("main::work");');
+    expect(entry?.cppCode).toContain('DOOF_PROFILE_SCOPE("main::main");');
+    expect(emit("function work(): int => 1")).not.toContain("DOOF_PROFILE_SCOPE");
+  });
+
   it("emits metrics builtins", () => {
     const cpp = emit(`
       function main(): string {
         metricsIncrement("requests_total", 1L)
+        metricsObserve("request_latency_us", 250L)
+        metricsGaugeSet("queue_depth", 3.0)
+        route := "/health"
+        metricsIncrement("hits_\${route}", 1L)
         return metricsSnapshotPrometheus()
       }
     `);
 
-    expect(cpp).toContain('doof::metrics::increment_counter(std::string("requests_total"), 1LL);');
+    expect(cpp).toContain('static const doof::metrics::Counter handle = doof::metrics::counter(std::string("requests_total")); return handle; }().add(1LL);');
+    expect(cpp).toContain('static const doof::metrics::Histogram handle = doof::metrics::histogram(std::string("request_latency_us")); return handle; }().record(250LL);');
+    expect(cpp).toContain('static const doof::metrics::Gauge handle = doof::metrics::gauge(std::string("queue_depth")); return handle; }().set(3.0);');
+    expect(cpp).toContain("doof::metrics::increment_counter(");
     expect(cpp).toContain("return doof::metrics::snapshot_prometheus();");
   });
 });
@@ -1563,6 +1621,60 @@ describe("emitter — string methods", () => {
     expect(cpp).toContain("doof::string_split(");
   });
 
+  it("lowers trimmed and sliced query receivers to views", () => {
+    const cpp = emit(`
+      function test(s: string): bool {
+        return s.trim().startsWith("#") || s.slice(1).trimEnd() == "x" || s.substring(0, 2).length > 1
+      }
+    `);
+    expect(cpp).toContain("doof::string_startsWith(doof::string_trim_view(s), ");
+    expect(cpp).toContain("doof::string_trimEnd_view(doof::string_slice_view(s, 1)) == ");
+    expect(cpp).toContain("doof::string_substring_view(s, 0, 2).length()");
+    expect(cpp).not.toContain("doof::string_trim(");
+  });
+
+  it("keeps materialised strings where the result is stored", () => {
+    const cpp = emit(`
+      function test(s: string): string {
+        t := s.trim()
+        return t
+      }
+    `);
+    expect(cpp).toContain("doof::string_trim(s)");
+    expect(cpp).not.toContain("_view(");
+  });
+
+  it("iterates split fields lazily in for-of", () => {
+    const cpp = emit(`
+      function test(line: string): int {
+        let total = 0
+        for field of line.split(",") {
+          total = total + field.length
+        }
+        return total
+      }
+    `);
+    expect(cpp).toContain("doof::string_split_range(_split_source_");
+    expect(cpp).toContain("const auto& _split_source_");
+    expect(cpp).not.toContain("doof::string_split(");
+  });
+
+  it("copies a split source the loop body can reassign", () => {
+    const cpp = emit(`
+      function test(): int {
+        let line = "a,b,c"
+        let total = 0
+        for field of line.split(",") {
+          line = line + field
+          total = total + 1
+        }
+        return total
+      }
+    `);
+    expect(cpp).toMatch(/const std::string _split_source_\d+ = line;/);
+    expect(cpp).not.toContain("const auto& _split_source_");
+  });
+
   it("emits charAt and repeat", () => {
     const cpp = emit(`
       function test(s: string): char {
@@ -1667,6 +1779,234 @@ describe("emitter — string methods", () => {
     expect(cpp).toContain("doof::array_map(values");
   });
 
+  it("fuses filter/map/some chains with inline lambdas into one pipeline", () => {
+    const cpp = emit(`
+      function anyLarge(values: int[]): bool {
+        return values.filter((it: int): bool => it % 2 == 0).map((it: int): int => it * 10).some((it: int): bool => it > 30)
+      }
+
+      function doubledEvens(values: int[]): int[] {
+        return values.filter((it: int): bool => it % 2 == 0).map((it: int): int => it * 2)
+      }
+    `);
+    expect(cpp).toContain('doof::array_pipeline(values, "filter", "main.do",');
+    expect(cpp).toContain(".filter([=](int32_t it) -> bool { return it % 2 == 0; })");
+    expect(cpp).toContain(".some([=](int32_t it) -> bool { return it > 30; })");
+    expect(cpp).toContain(".map([=](int32_t it) -> int32_t { return it * 2; }).collect()");
+    expect(cpp).not.toContain("doof::array_filter(");
+    expect(cpp).not.toContain("doof::array_map(");
+  });
+
+  it("emits parallel array methods with bare functors", () => {
+    const cpp = emit(`
+      function doubled(values: readonly int[]): readonly int[] {
+        return values.parallelMap((it: int): int => it * 2)
+      }
+
+      function total(values: readonly int[]): int {
+        return values.parallelReduce(0, (acc: int, it: int): int => acc + it)
+      }
+    `);
+    expect(cpp).toContain('doof::array_parallelMap(values, [=](int32_t it) -> int32_t { return it * 2; }, "main.do",');
+    expect(cpp).toContain('doof::array_parallelReduce(values, 0, [=](int32_t acc, int32_t it) -> int32_t { return acc + it; }, "main.do",');
+  });
+
+  it("keeps separate passes when a stage takes a callback value", () => {
+    const cpp = emit(`
+      function onlyEven(values: int[], keep: (it: int): bool): int[] {
+        return values.filter(keep).map((it: int): int => it + 1)
+      }
+    `);
+    expect(cpp).toContain("doof::array_map(doof::array_filter(values, keep");
+    expect(cpp).not.toContain("doof::array_pipeline(");
+  });
+
+  it("keeps separate passes when a stage lambda has side effects", () => {
+    const cpp = emit(`
+      function countedEvens(values: int[]): int {
+        let calls = 0
+        evens := values.map((it: int): int => {
+          calls += 1
+          return it
+        }).filter((it: int): bool => it % 2 == 0)
+        return calls + evens.length
+      }
+
+      function printedAny(values: int[]): bool {
+        return values.filter((it: int): bool => it > 0).some((it: int): bool => {
+          println(it)
+          return it > 3
+        })
+      }
+    `);
+    expect(cpp).toContain("doof::array_filter(doof::array_map(values");
+    expect(cpp).toContain("doof::array_some(doof::array_filter(values");
+    expect(cpp).not.toContain("doof::array_pipeline(");
+  });
+
+  it("passes inline lambdas to single array callbacks as bare functors", () => {
+    const cpp = emit(`
+      function hasEven(values: int[]): bool {
+        return values.some((it: int): bool => it % 2 == 0)
+      }
+    `);
+    expect(cpp).toContain('doof::array_some(values, [=](int32_t it) -> bool { return it % 2 == 0; }, "main.do",');
+    expect(cpp).not.toContain("doof::callback<bool(int32_t)>");
+  });
+
+  it("borrows callback parameters that are only called directly", () => {
+    const cpp = emit(`
+      function twice(f: (x: int): int, x: int): int {
+        return f(f(x))
+      }
+
+      function run(): int {
+        const base = 3
+        return twice((x: int): int => x + base, 1)
+      }
+    `);
+    expect(cpp).toContain("int32_t twice(doof::callback_ref<int32_t(int32_t)> f, int32_t x)");
+    expect(cpp).toContain("return f.call(f.call(x));");
+    expect(cpp).toContain("twice([base](int32_t x) -> int32_t { return x + base; }, 1)");
+    expect(cpp).not.toContain("doof::callback<int32_t(int32_t)>");
+  });
+
+  it("keeps owning callbacks for parameters that escape", () => {
+    const cpp = emit(`
+      class Holder {
+        f: (x: int): int
+      }
+
+      function store(f: (x: int): int): Holder {
+        return Holder { f: f }
+      }
+
+      function later(f: (x: int): int): (): int {
+        return (): int => f(1)
+      }
+
+      function storeShorthand(f: (x: int): int): Holder {
+        return Holder { f }
+      }
+    `);
+    expect(cpp).toContain("store(doof::callback<int32_t(int32_t)> f)");
+    expect(cpp).toContain("later(doof::callback<int32_t(int32_t)> f)");
+    expect(cpp).toContain("storeShorthand(doof::callback<int32_t(int32_t)> f)");
+    expect(cpp).not.toContain("doof::callback_ref");
+  });
+
+  it("moves last uses of parameters and locals into sinks", () => {
+    const cpp = emit(`
+      struct Tag {
+        label: string
+        count: int
+      }
+
+      function make(label: string, count: int): Tag {
+        return Tag { label: label, count: count }
+      }
+
+      function collect(label: string): Tag[] {
+        let tags: Tag[] = []
+        let first = make(label, 1)
+        tags.push(first)
+        tags.push(make(label, 2))
+        return tags
+      }
+    `);
+    expect(cpp).toContain("Tag(std::string label, int32_t count) : label(std::move(label)), count(count) {}");
+    expect(cpp).toContain("return Tag(std::move(label), count);");
+    expect(cpp).toContain("auto first = make(label, 1);");
+    expect(cpp).toContain("tags->push_back(std::move(first));");
+    expect(cpp).toContain("tags->push_back(make(std::move(label), 2));");
+  });
+
+  it("keeps copies for uses repeated in a loop or statement", () => {
+    const cpp = emit(`
+      function repeat(label: string, n: int): string[] {
+        let out: string[] = []
+        let i = 0
+        while i < n {
+          out.push(label)
+          i = i + 1
+        }
+        return out
+      }
+
+      function pair(label: string): string[] {
+        return [label, label]
+      }
+    `);
+    expect(cpp).toContain("out->push_back(label);");
+    expect(cpp).not.toContain("std::move(label)");
+  });
+
+  it("stack-allocates class locals that never escape", () => {
+    const cpp = emit(`
+      class Accumulator {
+        total: int
+        add(n: int): void {
+          this.total = this.total + n
+        }
+      }
+
+      function sum(values: int[]): int {
+        acc := Accumulator(0)
+        for value of values {
+          acc.add(value)
+        }
+        return acc.total
+      }
+
+      function keep(): Accumulator {
+        acc := Accumulator(1)
+        acc.add(2)
+        return acc
+      }
+    `);
+    expect(cpp).toContain("Accumulator _stack_acc(0);");
+    expect(cpp).toContain("Accumulator* const acc = &_stack_acc;");
+    expect(cpp).toContain("acc->add(value);");
+    expect(cpp).toContain("std::make_shared<Accumulator>(1)");
+  });
+
+  it("keeps class locals on the heap when their methods can hand out this", () => {
+    const cpp = emit(`
+      class Node {
+        value: int
+        me(): Node => this
+      }
+
+      function read(): int {
+        node := Node(3)
+        return node.value
+      }
+    `);
+    expect(cpp).toContain("std::make_shared<Node>(3)");
+    expect(cpp).not.toContain("_stack_node");
+  });
+
+  it("stack-allocates non-escaping class locals in main", () => {
+    const cpp = emit(`
+      class Counter {
+        count: int
+        bump(): void {
+          this.count = this.count + 1
+        }
+      }
+
+      function main(): void {
+        counter := Counter(0)
+        counter.bump()
+        println(counter.count)
+      }
+    `);
+    expect(cpp).toContain("Counter _stack_counter(0);");
+    expect(cpp).toContain("Counter* const counter = &_stack_counter;");
+    expect(cpp).toContain("this->count = this->count + 1;");
+    expect(cpp).not.toContain("shared_from_this()->count");
+  });
+
   it("emits array buildReadonly via runtime helper", () => {
     const cpp = emit(`
       function freeze(values: int[]): readonly int[] {
@@ -343,7 +343,7 @@ describe("emitter — lambda captures", () => {
       }
     `);
 
-    expect(cpp).toContain("onEvent(doof::callback<std::string()>([=]() -> std::string");
+    expect(cpp).toContain("onEvent([=]() -> std::string");
     expect(cpp).not.toContain("[BASE_PATH]");
   });
 
@@ -360,7 +360,7 @@ describe("emitter — lambda captures", () => {
       }
     `);
 
-    expect(cpp).toContain("onEvent(doof::callback<std::string()>([=]() -> std::string");
+    expect(cpp).toContain("onEvent([=]() -> std::string");
     expect(cpp).not.toContain("[prefix]");
   });
 
@@ -438,7 +438,7 @@ describe("emitter — lambda captures", () => {
       }
     `);
 
-    expect(cpp).toContain("invoke(doof::callback<void()>([count]() -> void");
+    expect(cpp).toContain("invoke([count]() -> void");
     expect(cpp).toContain("doof::callback<int32_t()>([count]() -> int32_t");
   });
 
@@ -461,7 +461,7 @@ describe("emitter — lambda captures", () => {
       }
     `);
 
-    expect(cpp).toContain("invoke(doof::callback<void()>([camera]() -> void");
+    expect(cpp).toContain("invoke([camera]() -> void");
     expect(cpp).toContain("std::make_shared<RenderPassDescriptor>(camera)");
   });
 
@@ -490,7 +490,7 @@ describe("emitter — lambda captures", () => {
       }
     `);
 
-    expect(cpp).toContain("invoke(doof::callback<void()>([secondKind]() -> void");
+    expect(cpp).toContain("invoke([secondKind]() -> void");
     expect(cpp).not.toContain("[second, secondKind, f]");
     expect(cpp).not.toContain("[Response");
   });
@@ -539,7 +539,7 @@ describe("emitter — lambda captures", () => {
     `);
 
     expect(cpp).toContain("auto attempts = std::make_shared<int32_t>(0)");
-    expect(cpp).toContain("invoke(doof::callback<void()>([sender, attempts]() -> void");
+    expect(cpp).toContain("invoke([sender, attempts]() -> void");
     expect(cpp).toMatch(/auto _else\d+ = sender->send\(\);/);
     expect(cpp).toContain("(*attempts) = (*attempts) + 1");
   });
@@ -570,9 +570,9 @@ describe("emitter — lambda captures", () => {
       }
     `);
 
-    expect(cpp).toContain("invoke(doof::callback<int32_t()>([seed, values, extra]() -> int32_t");
+    expect(cpp).toContain("invoke([seed, values, extra]() -> int32_t");
     expect(cpp).toContain("std::make_tuple(picked, extra)");
-    expect(cpp).toContain('doof::concat("seed=", doof::to_string(seed))');
+    expect(cpp).toContain('doof::concat("seed=", seed)');
     expect(cpp).toContain(
       'doof::ordered_map<std::string, int32_t>{{std::string("seed"), seed}, {std::string("extra"), extra}}',
     );
@@ -625,7 +625,7 @@ describe("emitter — lambda captures", () => {
     `);
 
     expect(cpp).toContain("auto total = std::make_shared<int32_t>(0)");
-    expect(cpp).toContain("invoke(doof::callback<int32_t()>([seed, total]() -> int32_t");
+    expect(cpp).toContain("invoke([seed, total]() -> int32_t");
     expect(cpp).toContain("(*total) = (*total) + seed");
     expect(cpp).toContain("if (seed > 0)");
     expect(cpp).toContain("while (seed < 0)");
@@ -664,6 +664,31 @@ describe("emitter — interface method dispatch", () => {
     expect(cpp).toContain("std::visit(");
     expect(cpp).toContain("_obj->area()");
   });
+
+  it("emits a dispatch table for interfaces with many implementers", () => {
+    const classes = Array.from({ length: 9 }, (_, index) => [
+      `class Shape${index} {`,
+      `  size: float`,
+      `  function area(): float => size * ${index}.0f`,
+      `}`,
+    ].join("\n"));
+    const cpp = emitMulti(
+      {
+        "/main.do": [
+          ...classes,
+          `interface Shape {`,
+          `  size: float`,
+          `  area(): float`,
+          `}`,
+          `function getArea(s: Shape): float => s.area() + s.size`,
+        ].join("\n"),
+      },
+      "/main.do",
+    );
+    expect(cpp).toContain("doof::visit_table([](auto&& _obj) { return _obj->area(); }, s)");
+    expect(cpp).toContain("doof::visit_table([](auto&& _obj) { return _obj->size; }, s)");
+    expect(cpp).not.toContain("std::visit([](auto&& _obj) { return _obj->area(); }");
+  });
 });
 
 // ============================================================================
@@ -680,7 +705,7 @@ describe("emitter — try operators", () => {
       }
     `);
     expect(cpp).toContain("doof::is_failure(");
-    expect(cpp).toContain("doof::Failure<std::string>{");
+    expect(cpp).toMatch(/if \(DOOF_UNLIKELY\(doof::is_failure\((_try_\d+)\)\)\) return doof::propagate_failure<doof::Failure<std::string>>\(doof::failure_error\(\1\)\);/);
     expect(cpp).toContain("std::move(");
     expect(cpp).toContain("doof::success_value(");
   });
@@ -734,8 +759,15 @@ describe("emitter — string interpolation", () => {
     // Use a regular string to pass Doof source with backtick template literal
     const source = "function greet(name: string): string => `Hello, ${name}!`";
     const cpp = emit(source);
-    expect(cpp).toContain("doof::concat(");
-    expect(cpp).toContain("doof::to_string(name)");
+    expect(cpp).toContain('doof::concat("Hello, ", name, "!")');
+    expect(cpp).not.toContain("doof::to_string(name)");
+  });
+
+  it("emits a lone interpolated value through doof::to_string", () => {
+    const source = "function show(count: int): string => `${count}`";
+    const cpp = emit(source);
+    expect(cpp).toContain("doof::to_string(count)");
+    expect(cpp).not.toContain("doof::concat(");
   });
 });
 
@@ -1258,7 +1290,7 @@ describe("emitter — lambda with function type param", () => {
         return apply(add, 32)
       }
     `);
-    expect(cpp).toContain("doof::callback<int32_t(int32_t)> f");
+    expect(cpp).toContain("doof::callback_ref<int32_t(int32_t)> f");
     expect(cpp).toContain("f.call(x)");
   });
 
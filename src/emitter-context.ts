@@ -6,7 +6,7 @@
  * (which need EmitContext).
  */
 
-import type { Block, SourceSpan } from "./ast.js";
+import type { Block, Expression, SourceSpan, Statement } from "./ast.js";
 import type { ModuleSymbolTable, ClassSymbol } from "./types.js";
 import type { ResolvedType } from "./checker-types.js";
 
@@ -65,6 +65,20 @@ export interface EmitContext {
    * references.  Populated by `scanCapturedMutables()` before body emission.
    */
   capturedMutables?: Set<string>;
+  /**
+   * Identifier references that are the provable last use of a movable
+   * parameter or `let` local in the current function body.  Sink positions
+   * (call and constructor arguments, `push`, initializers, assignments) emit
+   * these as `std::move(name)`.  Populated by `findLastUseMoves()`.
+   */
+  lastUseMoves?: ReadonlySet<Expression>;
+  /**
+   * `let` and `:=` declarations of class instances that never escape the
+   * current function body.  They are emitted as stack objects with a pointer
+   * alias instead of `std::make_shared`.  Populated by
+   * `findStackAllocatedLocals()`.
+   */
+  stackAllocatedLocals?: ReadonlySet<Statement>;
   /** Concrete type substitutions used when emitting a monomorphized generic clone. */
   typeSubstitution?: Map<string, ResolvedType>;
   /** Override the emitted function name when generating a concrete clone. */
@@ -85,7 +99,7 @@ export interface EmitContext {
   forceInline?: boolean;
   /** Emit the declaration or definition with cpp-local internal linkage. */
   internalLinkage?: boolean;
-  /** When true, emit doof::coverage::cov_mark() calls for executable statements. */
+  /** When true, mark executable statements in the module's coverage bitmap. */
   coverageEnabled?: boolean;
   /** Stable integer ID for the current module in coverage data (only set when coverageEnabled). */
   coverageModuleId?: number;
@@ -93,4 +107,58 @@ export interface EmitContext {
   coverageInstrumentedLines?: Set<number>;
   /** When true, emit class create/dispose metrics counters. */
   metricsClassLifecycle?: boolean;
+  /** When true, open a profiler span at the top of each emitted function body. */
+  profileSpans?: boolean;
+  /**
+   * Runtime sections the file being emitted relies on. Shared by every
+   * context of one file; lowering sets it through `requireActorRuntime()`.
+   */
+  runtimeFeatures?: RuntimeFeatureUse;
+}
+
+// ============================================================================
+// Runtime feature use
+// ============================================================================
+
+/**
+ * Runtime sections beyond the core header that one emitted file relies on.
+ * The file emitter adds the matching includes once the file is complete.
+ */
+export interface RuntimeFeatureUse {
+  /** Actors, promises, callback `post`, or parallel array helpers. */
+  actors: boolean;
+}
+
+let currentFileFeatures: RuntimeFeatureUse | null = null;
+
+/**
+ * Start recording runtime feature use for the next emitted file. Contexts
+ * created while it is emitted pick the record up as `runtimeFeatures`.
+ */
+export function beginRuntimeFeatureUse(): RuntimeFeatureUse {
+  currentFileFeatures = { actors: false };
+  return currentFileFeatures;
+}
+
+/** Stop recording once the file's includes have been decided. */
+export function endRuntimeFeatureUse(features: RuntimeFeatureUse): void {
+  if (currentFileFeatures === features) currentFileFeatures = null;
+}
+
+/** The record for the file being emitted, if one was started. */
+export function currentRuntimeFeatureUse(): RuntimeFeatureUse | undefined {
+  return currentFileFeatures ?? undefined;
+}
+
+/** Record that the lowered construct needs the actors runtime header. */
+export function requireActorRuntime(ctx: EmitContext): void {
+  if (ctx.runtimeFeatures) ctx.runtimeFeatures.actors = true;
+}
+
+/**
+ * Type emission has no context, so Actor and Promise types record their use
+ * on the file being emitted directly.
+ */
+export function noteActorRuntimeType(): void {
+  if (currentFileFeatures) currentFileFeatures.actors = true;
 }
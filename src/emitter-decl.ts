@@ -17,14 +17,19 @@ import type {
 } from "./ast.js";
 import type { ResolvedType } from "./checker-types.js";
 import { hasDedicatedConstructor, isJSONSerializable, findSharedDiscriminator } from "./checker-types.js";
-import { emitClassCppName, emitClassSharedPtrType, emitInnerType, emitType } from "./emitter-types.js";
+import { emitBorrowedCallbackType, emitClassCppName, emitClassSharedPtrType, emitInnerType, emitStringType, emitType } from "./emitter-types.js";
 import { emitQualifiedSymbolName } from "./emitter-names.js";
 import { substituteEmitType } from "./emitter-monomorphize.js";
 import { emitExpression, indent, emitIdentifierSafe, scanCapturedMutables } from "./emitter-expr.js";
+import { getBorrowedCallbackParams } from "./emitter-expr-lambda.js";
+import { findStackAllocatedLocals } from "./emitter-escape.js";
+import { findLastUseMoves, isTriviallyCopied } from "./emitter-moves.js";
 import type { EmitContext } from "./emitter-context.js";
 import { emitBlockStatements } from "./emitter-stmt.js";
-import { emitToJSON, emitFromJSON, emitInterfaceFromJSON } from "./emitter-json.js";
+import { emitToJSON, emitFromJSON, emitFromJSONText, emitInterfaceFromJSON } from "./emitter-json.js";
 import { emitMetadataDeclaration, emitMetadataDefinition } from "./emitter-metadata.js";
+import { emitStaticMetricHandle } from "./emitter-expr-calls.js";
+import { emitProfileScope } from "./emitter-panic.js";
 import { canEmitDefaultExpressionInHeader, emitDefaultExpression } from "./emitter-defaults.js";
 import type { ClassSymbol, StructSymbol } from "./types.js";
 
@@ -88,7 +93,7 @@ function emitClassLifecycleMetricLine(
 ): void {
   if (!ctx.metricsClassLifecycle || decl.storage === "value") return;
   const key = prometheusClassLifecycleKey(event, decl, ctx);
-  ctx.sourceLines.push(`${ind}doof::metrics::increment_counter(${JSON.stringify(key)}, 1);`);
+  ctx.sourceLines.push(`${ind}${emitStaticMetricHandle("metricsIncrement", JSON.stringify(key))}.add(1);`);
 }
 
 function shouldDeferStaticFieldDefinition(
@@ -136,8 +141,9 @@ export function emitFunctionDecl(decl: FunctionDeclaration, ctx: EmitContext): v
 
   // Build parameter list
   const includeDefaults = ctx.emitParameterDefaults ?? true;
+  const borrowed = getModuleFunctionBorrowedParams(decl, ctx);
   const params = decl.params
-    .map((p, index) => emitParam(p, ctx, shouldEmitParameterDefault(decl.params, index, ctx, includeDefaults)))
+    .map((p, index) => emitParam(p, ctx, shouldEmitParameterDefault(decl.params, index, ctx, includeDefaults), borrowed.has(p.name)))
     .join(", ");
 
   // Emit function signature
@@ -163,7 +169,12 @@ export function emitFunctionDecl(decl: FunctionDeclaration, ctx: EmitContext): v
     // Pre-scan for let variables captured by lambdas → heap-box them
     const paramNameSet = new Set(decl.params.map((p) => p.name));
     const capturedMutables = scanCapturedMutables(decl.body, paramNameSet);
+    const lastUseMoves = findLastUseMoves(decl, capturedMutables);
+    const stackAllocatedLocals = findStackAllocatedLocals(decl, capturedMutables);
     const currentCallableName = ctx.currentCallableName ?? decl.name;
+    if (ctx.profileSpans) {
+      ctx.sourceLines.push(`${ind}    ${emitProfileScope(currentCallableName, ctx)}`);
+    }
     emitBlockStatements(decl.body, {
       ...ctx,
       indent: ctx.indent + 1,
@@ -171,6 +182,8 @@ export function emitFunctionDecl(decl: FunctionDeclaration, ctx: EmitContext): v
       currentCallableName,
       currentFunctionReturnType: fnRetType,
       capturedMutables: capturedMutables.size > 0 ? capturedMutables : undefined,
+      lastUseMoves: lastUseMoves.size > 0 ? lastUseMoves : undefined,
+      stackAllocatedLocals: stackAllocatedLocals.size > 0 ? stackAllocatedLocals : undefined,
     });
     ctx.sourceLines.push(`${ind}}`);
   } else {
@@ -185,6 +198,9 @@ export function emitFunctionDecl(decl: FunctionDeclaration, ctx: EmitContext): v
     }, fnRetType);
     ctx.sourceLines.push(`${ind}${inlinePrefix}${linkagePrefix}${staticPrefix}${retType} ${name}(${params}) {`);
     emitMockRecordingPrelude(decl, mockCall, ctx);
+    if (ctx.profileSpans) {
+      ctx.sourceLines.push(`${ind}    ${emitProfileScope(ctx.currentCallableName ?? decl.name, ctx)}`);
+    }
     ctx.sourceLines.push(`${ind}    return ${body};`);
     ctx.sourceLines.push(`${ind}}`);
   }
@@ -211,16 +227,29 @@ export function emitFunctionPrototype(decl: FunctionDeclaration, ctx: EmitContex
     ? emitType(resolvedDeclType.returnType, ctx.module.path)
     : "auto";
   const includeDefaults = ctx.emitParameterDefaults ?? true;
+  const borrowed = getModuleFunctionBorrowedParams(decl, ctx);
   const params = decl.params
-    .map((p, index) => emitParam(p, ctx, shouldEmitParameterDefault(decl.params, index, ctx, includeDefaults)))
+    .map((p, index) => emitParam(p, ctx, shouldEmitParameterDefault(decl.params, index, ctx, includeDefaults), borrowed.has(p.name)))
     .join(", ");
   const staticPrefix = ctx.inClass && decl.static_ ? "static " : "";
   ctx.sourceLines.push(`${ind}${staticPrefix}${retType} ${name}(${params});`);
 }
 
-export function emitParam(param: Parameter, _ctx: EmitContext, includeDefault = true): string {
+const NO_BORROWED_PARAMS: ReadonlySet<string> = new Set();
+
+/** Borrowed callback parameters of a top-level function; methods have none. */
+function getModuleFunctionBorrowedParams(decl: FunctionDeclaration, ctx: EmitContext): ReadonlySet<string> {
+  const symbol = ctx.module.symbols.get(decl.name);
+  return symbol?.symbolKind === "function" && symbol.declaration === decl
+    ? getBorrowedCallbackParams(decl)
+    : NO_BORROWED_PARAMS;
+}
+
+export function emitParam(param: Parameter, _ctx: EmitContext, includeDefault = true, borrowed = false): string {
   const resolvedType = substituteEmitType(param.resolvedType, _ctx);
-  const pType = resolvedType ? emitType(resolvedType, _ctx.module.path) : "auto";
+  const pType = !resolvedType ? "auto"
+    : borrowed && resolvedType.kind === "function" ? emitBorrowedCallbackType(resolvedType, _ctx.module.path)
+      : emitType(resolvedType, _ctx.module.path);
   const name = emitIdentifierSafe(param.name);
   if (includeDefault && param.defaultValue) {
     const defaultVal = emitDefaultExpression(param.defaultValue, resolvedType ?? undefined, _ctx.module.path);
@@ -263,6 +292,12 @@ export function emitClassDecl(decl: ClassDeclaration, ctx: EmitContext): void {
   for (const field of decl.fields) {
     emitClassField(field, { ...ctx, indent: ctx.indent + 1 }, ownerSymbol);
   }
+  if (decl.storage === "value") {
+    // Tallies copies and moves of value structs in copy-counting builds.
+    ctx.sourceLines.push("#if defined(DOOF_COUNT_COPIES)");
+    ctx.sourceLines.push(`${memberInd}doof::copies::Counter doof_copy_counter_;`);
+    ctx.sourceLines.push("#endif");
+  }
 
   const mockMethods = decl.methods.filter((method) => method.mock_);
   for (const method of mockMethods) {
@@ -313,8 +348,13 @@ export function emitClassDecl(decl: ClassDeclaration, ctx: EmitContext): void {
         return `${fType} ${emitIdentifierSafe(cf.name)}`;
       })
       .join(", ");
+    // Constructor parameters are sinks: take them by value and move them in.
     const initList = constructorFields
-      .map((cf) => `${emitIdentifierSafe(cf.name)}(${emitIdentifierSafe(cf.name)})`)
+      .map((cf) => {
+        const param = emitIdentifierSafe(cf.name);
+        const moved = !cf.field.weak_ && !isTriviallyCopied(substituteEmitType(cf.field.resolvedType, ctx));
+        return `${param}(${moved ? `std::move(${param})` : param})`;
+      })
       .join(", ");
     if (ctx.metricsClassLifecycle) {
       ctx.sourceLines.push(`${memberInd}${name}(${ctorParams}) : ${initList} {`);
@@ -366,7 +406,8 @@ export function emitClassDecl(decl: ClassDeclaration, ctx: EmitContext): void {
     ctx.sourceLines.push(`${memberInd}}`);
   }
 
-  // JSON serialization methods (toJsonObject / fromJsonValue)
+  // JSON serialization methods (toJsonObject / fromJsonValue / fromJsonText),
+  // plus a JsonNode fromJsonValue overload when a JsonDocument decode reaches the class
   // Only generate if the class was marked as needing JSON (on-demand)
   // AND all fields are JSON-serializable
   // AND the class does not define a dedicated constructor
@@ -377,6 +418,8 @@ export function emitClassDecl(decl: ClassDeclaration, ctx: EmitContext): void {
     if (!hasDedicatedConstructor(decl) && allFieldsSerializable) {
       emitToJSON(decl, name, ctx);
       emitFromJSON(decl, name, ctx);
+      if (decl.needsJsonDocument) emitFromJSON(decl, name, ctx, "node");
+      emitFromJSONText(decl, name, ctx);
     }
   }
 
@@ -551,7 +594,7 @@ export function emitInterfaceDecl(decl: InterfaceDeclaration, ctx: EmitContext):
       if (allSerializable) {
         const disc = findSharedDiscriminator(impls);
         if (disc) {
-          emitInterfaceFromJSON(name, impls, disc, ctx);
+          emitInterfaceFromJSON(name, impls, disc, ctx, decl.needsJsonDocument === true);
         }
       }
     }
@@ -672,7 +715,7 @@ export function emitTypeAnnotation(
         long: "int64_t",
         float: "float",
         double: "double",
-        string: "std::string",
+        string: emitStringType(),
         char: "char32_t",
         bool: "bool",
         void: "void",
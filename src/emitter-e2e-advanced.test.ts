@@ -5,6 +5,8 @@
  * (shared_ptr ↔ variant), JSON serialization, with statement.
  */
 
+import * as fs from "node:fs";
+import * as path from "node:path";
 import { describe as vitestDescribe, it, expect, beforeAll, afterAll } from "vitest";
 import { E2EContext, hasNativeToolchain } from "./e2e-test-helpers.js";
 
@@ -282,6 +284,199 @@ describe("e2e — Concurrency", () => {
     expect(result.stdout.trim()).toBe("49");
   });
 
+  it("runs many temporary actors on the shared carrier pool", () => {
+    const result = ctx.compileAndRun(`
+      class Square {
+        value: int
+        compute(): int { return this.value * this.value }
+      }
+      function main(): int {
+        let total = 0
+        for let i = 0; i < 2000; i += 1 {
+          const worker = Actor<Square>(i % 10)
+          const p = async worker.compute()
+          const value = try! p.get()
+          total += value
+          retire worker
+        }
+        println(total)
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("57000");
+  });
+
+  it("keeps nested synchronous actor calls live beyond the carrier count", () => {
+    const result = ctx.compileAndRun(`
+      class Relay {
+        depth: int
+        run(): int {
+          if this.depth == 0 {
+            return 0
+          }
+          const inner = Actor<Relay>(this.depth - 1)
+          const result = inner.run()
+          retire inner
+          return result + 1
+        }
+      }
+      function main(): int {
+        const relay = Actor<Relay>(64)
+        const depth = relay.run()
+        retire relay
+        println(depth)
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("64");
+  });
+
+  it("drains a deep actor mailbox in order before retiring", () => {
+    const result = ctx.compileAndRun(`
+      class Ledger {
+        total: int
+        last: int
+        ordered: bool
+        record(n: int): void {
+          if n != this.last + 1 {
+            this.ordered = false
+          }
+          this.last = n
+          this.total = this.total + n
+        }
+      }
+      function main(): int {
+        const ledger = Actor<Ledger>(0, 0, true)
+        for let i = 1; i <= 5000; i += 1 {
+          const pending = async ledger.record(i)
+        }
+        const state = retire ledger
+        println(\`\${state.total} \${state.ordered}\`)
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("12502500 true");
+  });
+
+  it("runs every queued message before stop() returns on a shared actor", () => {
+    fs.writeFileSync(path.join(ctx.tmpDir, "actor_stop.hpp"), `
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "doof_runtime_actors.hpp"
+
+namespace native {
+struct Idle {};
+
+inline int32_t runThenStop(int32_t count) {
+    auto ran = std::make_shared<std::atomic<int32_t>>(0);
+    auto actor = std::make_shared<doof::Actor<Idle>>();
+    for (int32_t i = 0; i < count; ++i) {
+        actor->call_async<void>([ran](Idle&) { ran->fetch_add(1); });
+    }
+    actor->stop();
+    return ran->load();
+}
+}
+`);
+    const result = ctx.compileAndRun(`
+      import function runThenStop(count: int): int from "actor_stop.hpp" as native::runThenStop
+
+      function main(): int {
+        println(runThenStop(1000))
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("1000");
+  });
+
+  it("chains promise continuations on the application domain", () => {
+    const result = ctx.compileAndRun(`
+      class Worker {
+        base: int
+        compute(n: int): int { return this.base * n }
+      }
+      function main(): int {
+        const worker = Actor<Worker>(3)
+        const pending = async worker.compute(7)
+        const doubled = pending.continueWith((result: Result<int, string>): int => result.unwrapOr(0) * 2)
+        const label = doubled.continueWith((result: Result<int, string>): string => \`doubled \${result.unwrapOr(-1)}\`)
+        println(try! label.get())
+        retire worker
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("doubled 42");
+  });
+
+  it("combines actor replies with whenAll and whenAny", () => {
+    const result = ctx.compileAndRun(`
+      class Worker {
+        base: int
+        compute(n: int): int { return this.base * n }
+      }
+      function main(): int {
+        const a = Actor<Worker>(1)
+        const b = Actor<Worker>(2)
+        const c = Actor<Worker>(3)
+        const values = try! whenAll([async a.compute(10), async b.compute(10), async c.compute(10)]).get()
+        println(\`\${values.length} \${values[0]} \${values[1]} \${values[2]}\`)
+        const first = try! whenAny([async b.compute(5)]).get()
+        println(first)
+        retire a
+        retire b
+        retire c
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("3 10 20 30\n10");
+  });
+
+  it("runs actors on dedicated threads with DOOF_ACTOR_THREAD_PER_ACTOR", () => {
+    const result = ctx.compileAndRunProject({
+      "/main.do": `
+        class Accumulator {
+          total: int
+          add(n: int): void { this.total = this.total + n }
+        }
+        function main(): int {
+          const a = Actor<Accumulator>(0)
+          for let i = 1; i <= 10; i += 1 {
+            const pending = async a.add(i)
+          }
+          const state = retire a
+          println(state.total)
+          return 0
+        }
+      `,
+    }, "/main.do", {
+      defines: ["DOOF_ACTOR_THREAD_PER_ACTOR"],
+    });
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("55");
+  });
+
   it("compiles isolated method in class", () => {
     const { success, error, code } = ctx.compileOnly(`
       class Processor {
@@ -1698,6 +1893,176 @@ describe("E2E — JSON serialization", () => {
     expect(result.stdout.trim()).toBe("10\n20\n30");
   });
 
+  it("decodes JSON text straight into nested fields with fromJsonText", () => {
+    const result = ctx.compileAndRun(`
+      class Item { id: int; label: string | null = null }
+      class Order {
+        const kind = "order"
+        items: Item[]
+        total: double
+        paid: bool = false
+      }
+      function show(text: string, lenient: bool): void {
+        case Order.fromJsonText(text, lenient) {
+          s: Success -> {
+            println(s.value.items.length)
+            println(s.value.paid)
+          }
+          f: Failure -> println(f.error)
+        }
+      }
+      function main(): int {
+        show("{\\"kind\\": \\"order\\", \\"skip\\": [{\\"x\\": 1}], \\"items\\": [{\\"id\\": 1}, {\\"id\\": 2, \\"label\\": \\"b\\"}], \\"total\\": 2.5}", false)
+        show("{\\"items\\": [], \\"total\\": 1, \\"paid\\": \\"true\\"}", true)
+        show("{\\"items\\": [], \\"total\\": \\"1\\"}", false)
+        show("{\\"items\\": [{\\"label\\": \\"a\\"}], \\"total\\": 1}", false)
+        show("{\\"kind\\": \\"refund\\", \\"items\\": [], \\"total\\": 1}", false)
+        show("{\\"items\\": [] \\"total\\": 1}", false)
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim().split("\n")).toEqual([
+      "2",
+      "false",
+      "0",
+      "true",
+      'Field "total" expected number but got string',
+      'Missing required field "id"',
+      'Field "kind" must be "order" but got "refund"',
+      "Invalid JSON at offset 13: expected ',' or '}'",
+    ]);
+  });
+
+  it("decodes nullable array and nested-class fields with fromJsonText", () => {
+    const result = ctx.compileAndRun(`
+      class Tag { name: string }
+      class Post {
+        tags: int[] | null
+        author: Tag | null
+      }
+      function show(text: string): void {
+        case Post.fromJsonText(text) {
+          s: Success -> {
+            const tags = s.value.tags
+            const author = s.value.author
+            if tags != null {
+              println(tags!.length)
+            } else {
+              println("no tags")
+            }
+            if author != null {
+              println(author!.name)
+            } else {
+              println("no author")
+            }
+          }
+          f: Failure -> println(f.error)
+        }
+      }
+      function main(): int {
+        show("{\\"tags\\": [1, 2, 3], \\"author\\": {\\"name\\": \\"ada\\"}}")
+        show("{\\"tags\\": null, \\"author\\": null}")
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim().split("\n")).toEqual(["3", "ada", "no tags", "no author"]);
+  });
+
+  it("decodes an interface from JSON text through a JsonDocument", () => {
+    const result = ctx.compileAndRun(`
+      class Point { x: int; y: int }
+      class Circle { const kind: string = "circle"; center: Point; radius: double; label: string }
+      class Path { const kind: string = "path"; points: Point[]; extra: JsonValue; label: string = "" }
+      interface Shape { label: string }
+      function show(text: string): void {
+        case Shape.fromJsonText(text) {
+          s: Success -> {
+            case s.value {
+              c: Circle -> println(c.label + " " + string(c.center.y) + " " + string(c.radius))
+              p: Path -> println(string(p.points.length) + " " + string(p.points[1].x))
+            }
+          }
+          f: Failure -> println(f.error)
+        }
+      }
+      function main(): int {
+        show("{\\"kind\\": \\"circle\\", \\"center\\": {\\"x\\": 1, \\"y\\": 2}, \\"radius\\": 1.5, \\"label\\": \\"a\\\\\\"b\\"}")
+        show("{\\"kind\\": \\"path\\", \\"points\\": [{\\"x\\": 3, \\"y\\": 4}, {\\"x\\": 5, \\"y\\": 6}], \\"extra\\": {\\"k\\": [1]}}")
+        show("{\\"kind\\": \\"square\\"}")
+        show("{\\"kind\\": \\"circle\\", \\"center\\": [1}")
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim().split("\n")).toEqual([
+      'a"b 2 1.5',
+      "2 5",
+      'Unknown kind: "square"',
+      "Invalid JSON at offset 31: expected ',' or ']'",
+    ]);
+  });
+
+  it("decodes long escaped JSON text across structural-index blocks", () => {
+    const result = ctx.compileAndRun(`
+      class Point { x: int; y: int }
+      class Circle { const kind: string = "circle"; center: Point; radius: double; label: string }
+      interface Shape { label: string }
+      function show(text: string): void {
+        case Shape.fromJsonText(text) {
+          s: Success -> println(s.value.label)
+          f: Failure -> println(f.error)
+        }
+      }
+      function main(): int {
+        const pad = "abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz"
+        show("{\\"kind\\": \\"circle\\", \\"center\\": {\\"x\\": 1, \\"y\\": -20}, \\"radius\\": 2.5e1, \\"label\\": \\"" + pad + "\\\\\\\\\\\\\\"\\\\u00e9\\"}")
+        show("{\\"kind\\": \\"circle\\", \\"center\\": {\\"x\\": 1, \\"y\\": 2}, \\"radius\\": 1, \\"label\\": \\"" + pad + "\\"} x")
+        show("{\\"kind\\": \\"circle\\", \\"label\\": \\"" + pad + "\\\\\\"}")
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim().split("\n")).toEqual([
+      'abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz\\"é',
+      "Invalid JSON at offset 135: unexpected trailing characters",
+      "Invalid JSON at offset 94: unterminated string",
+    ]);
+  });
+
+  it("decodes a union alias from JSON text with lenient coercion", () => {
+    const result = ctx.compileAndRun(`
+      class Circle { const kind: string = "circle"; radius: double }
+      class Rect { const kind: string = "rect"; width: double; height: double }
+      type Shape = Circle | Rect
+      function main(): int {
+        case Shape.fromJsonText("{\\"kind\\": \\"rect\\", \\"width\\": true, \\"height\\": 4}", true) {
+          s: Success -> {
+            case s.value {
+              c: Circle -> println("unexpected circle")
+              r: Rect -> println(r.width * r.height)
+            }
+          }
+          f: Failure -> println("ERROR: " + f.error)
+        }
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("4");
+  });
+
   it("serializes nullable fields", () => {
     const result = ctx.compileAndRun(`
       import { formatJsonValue } from "std/json"
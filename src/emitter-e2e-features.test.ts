@@ -583,6 +583,97 @@ describe("e2e — array safety", () => {
         if labels.length != 4 { return 11 }
         if labels[2] != "#3" { return 12 }
 
+        fused := nums.map((it: int): int => it * 3).filter((it: int): bool => it > 4).map((it: int): string => string(it))
+        if fused.length != 3 || fused[0] != "6" || fused[2] != "12" { return 13 }
+        if !nums.filter((it: int): bool => it > 1).every((it: int): bool => it >= 2) { return 14 }
+        if nums.filter((it: int): bool => it > 1).some((it: int): bool => it == 1) { return 15 }
+
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.exitCode).toBe(0);
+  });
+
+  it("keeps stage-by-stage order for side-effecting array lambdas", () => {
+    const result = ctx.compileAndRun(`
+      function main(): int {
+        nums := [1, 2, 3, 4]
+        let calls = 0
+        found := nums.map((it: int): int => {
+          calls += 1
+          return it * 2
+        }).some((it: int): bool => it == 2)
+        if !found { return 1 }
+        if calls != 4 { return 2 }
+
+        let order = ""
+        kept := nums.filter((it: int): bool => {
+          order = order + "f"
+          return it > 1
+        }).map((it: int): int => {
+          order = order + "m"
+          return it
+        })
+        if kept.length != 3 { return 3 }
+        if order != "ffffmmm" { return 4 }
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.exitCode).toBe(0);
+  });
+
+  it("runs parallel array methods across carriers", () => {
+    const result = ctx.compileAndRun(`
+      function main(): int {
+        let builder: int[] = []
+        for i of 0..<2000 {
+          builder.push(i)
+        }
+        values := builder.buildReadonly()
+
+        doubled := values.parallelMap((it: int): int => it * 2)
+        if doubled.length != 2000 || doubled[1999] != 3998 { return 1 }
+        evens := values.parallelFilter((it: int): bool => it % 2 == 0)
+        if evens.length != 1000 || evens[3] != 6 { return 2 }
+        if values.parallelReduce(0, (acc: int, it: int): int => acc + it) != 1999000 { return 3 }
+        sorted := values.parallelSort((a: int, b: int): int => b - a)
+        if sorted[0] != 1999 || sorted[1999] != 0 { return 4 }
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.exitCode).toBe(0);
+  });
+
+  it("runs borrowed and owning callback parameters together", () => {
+    const result = ctx.compileAndRun(`
+      function sumBy(values: int[], f: (it: int): int): int {
+        let total = 0
+        for it of values {
+          total = total + f(it)
+        }
+        return total
+      }
+
+      function scaled(factor: int): (it: int): int {
+        return (it: int): int => it * factor
+      }
+
+      function main(): int {
+        values := [1, 2, 3, 4]
+        offset := 10
+        if sumBy(values, (it: int): int => it + offset) != 50 { return 1 }
+        triple := scaled(3)
+        if sumBy(values, triple) != 30 { return 2 }
+        if !values.some((it: int): bool => it > offset - 7) { return 3 }
         return 0
       }
     `);
@@ -592,6 +683,64 @@ describe("e2e — array safety", () => {
     expect(result.exitCode).toBe(0);
   });
 
+  it("moves struct locals into arrays without copying them", () => {
+    const result = ctx.compileAndRun(`
+      struct Tag {
+        label: string
+        count: int
+      }
+
+      function make(count: int): Tag {
+        return Tag { label: "a label long enough to allocate", count: count }
+      }
+
+      function main(): int {
+        let tags: Tag[] = []
+        let i = 0
+        while i < 8 {
+          let tag = make(i)
+          tags.push(tag)
+          i = i + 1
+        }
+        return tags.length
+      }
+    `, { defines: ["DOOF_COUNT_COPIES"] });
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.exitCode).toBe(8);
+    expect(result.stderr).toContain("doof copy-count: copies=0 moves=");
+  });
+
+  it("runs stack-allocated class locals", () => {
+    const result = ctx.compileAndRun(`
+      class Accumulator {
+        total: int
+        label: string
+        add(n: int): void {
+          this.total = this.total + n
+        }
+        describe(): string => "\${this.label}=\${this.total}"
+      }
+
+      function main(): int {
+        acc := Accumulator(0, "sum")
+        let i = 1
+        while i <= 4 {
+          acc.add(i)
+          i = i + 1
+        }
+        println(acc.describe())
+        return acc.total
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim()).toBe("sum=10");
+    expect(result.exitCode).toBe(10);
+  });
+
   it("runs array destructuring with discard", () => {
     const result = ctx.compileAndRun(`
       function main(): int {
@@ -1293,6 +1442,30 @@ describe("e2e — string operations", () => {
       expect.unreachable(`Compile error: ${result.stderr}`);
     }
   });
+
+  it("runs for-of over split with trimmed field views", () => {
+    const result = ctx.compileAndRun(`
+      function fields(): string => " a , # b ,,cd "
+      function main(): int {
+        let kept: string[] = []
+        let total = 0
+        for field of fields().split(",") {
+          if field.trim().startsWith("#") { continue }
+          if field.trim() == "" { continue }
+          kept.push(field)
+          total = total + field.trim().length
+        }
+        println(kept)
+        return total
+      }
+    `);
+    if (result.exitCode !== -1) {
+      expect(result.stdout.trim()).toBe("[ a , cd ]");
+      expect(result.exitCode).toBe(3);
+    } else {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+  });
 });
 
 // ============================================================================
@@ -1675,4 +1848,21 @@ describe("e2e — non-null assertion", () => {
     expect(result.exitCode).toBe(0);
     expect(result.stdout.trim()).toBe("Success(2)\n(1, 2)");
   });
+
+  it("reports the top histogram bucket as +Inf in Prometheus text", () => {
+    const result = ctx.compileAndRun(`
+      function main(): int {
+        metricsObserve("huge", 9000000000000000000L)
+        metricsObserve("huge", 5L)
+        print(metricsSnapshotPrometheus())
+        return 0
+      }
+    `);
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.exitCode).toBe(0);
+    expect(result.stdout).toContain('huge_bucket{le="5"} 1\nhuge_bucket{le="+Inf"} 2\n');
+    expect(result.stdout).not.toContain('le="-');
+  });
 });
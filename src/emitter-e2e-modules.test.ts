@@ -1,7 +1,8 @@
 /**
  * End-to-end C++ compilation tests (part 3).
  *
- * Covers: module splitting (.hpp/.cpp), extern class imports, namespace imports.
+ * Covers: module splitting (.hpp/.cpp), extern class imports, namespace imports,
+ * mixed native build inputs, and the shared string profile.
  */
 
 import { describe as vitestDescribe, it, expect, beforeAll, afterAll } from "vitest";
@@ -1347,3 +1348,53 @@ int32_t NativeCounter::get() const {
     expect(result.stdout).toContain("Replace first: ticket / DOOF-105");
   });
 });
+
+describe("e2e — shared string profile", () => {
+  it("runs string slicing, maps, and JSON decoding with build.strings shared", () => {
+    const result = ctx.compileAndRunProject(
+      {
+        "/doof.json": JSON.stringify({ name: "shared-strings", build: { strings: "shared" } }),
+        "/main.do": `
+          class Person {
+            name: string
+            tags: string[]
+          }
+
+          function describe(p: Person): string => p.name + " <" + p.tags[0] + "," + p.tags[1] + ">"
+
+          function main(): int {
+            const line = "  alpha, beta ,gamma-delta-epsilon-zeta-eta-theta  "
+            const trimmed = line.trim()
+            const fields = trimmed.split(",")
+            let counts: Map<string, int> = {}
+            for field of fields {
+              const key = field.trim()
+              counts.set(key, key.length)
+            }
+            println(counts["beta"])
+            println(trimmed.slice(20))
+            println(trimmed.substring(0, 5))
+            println("\${trimmed.length}:\${fields.length}")
+            case Person.fromJsonText("{\\"name\\":\\"Ada Lovelace, Countess of Lovelace\\",\\"tags\\":[\\"math\\",\\"engines\\"]}") {
+              s: Success -> println(describe(s.value))
+              f: Failure -> println(f.error)
+            }
+            return 0
+          }
+        `,
+      },
+      "/main.do",
+    );
+
+    if (result.exitCode === -1) {
+      expect.unreachable(`Compile error: ${result.stderr}`);
+    }
+    expect(result.stdout.trim().split("\n")).toEqual([
+      "4",
+      "elta-epsilon-zeta-eta-theta",
+      "alpha",
+      "47:3",
+      "Ada Lovelace, Countess of Lovelace <math,engines>",
+    ]);
+  });
+});
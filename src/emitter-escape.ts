@@ -0,0 +1,260 @@
+/**
+ * Stack allocation of non-escaping class instances.
+ *
+ * A class local that is only ever used to read or write its fields and call
+ * its methods cannot outlive the function that constructed it, so it can live
+ * in the function's frame instead of behind `std::make_shared`.  The storage
+ * is emitted as a plain object and the local as a pointer to it, which keeps
+ * every `name->member` use unchanged.
+ *
+ * Only whole-function non-escape is handled here.  Actor-confined instances
+ * still use the atomic `std::shared_ptr` refcount.
+ */
+
+import type {
+  ClassDeclaration,
+  Expression,
+  FunctionDeclaration,
+  ImmutableBinding,
+  LetDeclaration,
+  ObjectProperty,
+  Statement,
+} from "./ast.js";
+import type { ResolvedType } from "./checker-types.js";
+import { walkExpression, walkStatementListExpressions } from "./checker-stmt.js";
+import type { EmitContext } from "./emitter-context.js";
+import { emitIdentifierSafe, indent } from "./emitter-expr.js";
+
+type StackLocal = LetDeclaration | ImmutableBinding;
+
+interface Candidate {
+  stmt: StackLocal;
+  decl: ClassDeclaration;
+  used: boolean;
+  excluded: boolean;
+}
+
+const stackAllocatableClasses = new WeakMap<ClassDeclaration, boolean>();
+
+/**
+ * Find class locals that can be stack-allocated: the initializer constructs a
+ * non-generic class whose methods never let `this` escape, the local is used,
+ * and every reference to it is the object of a field access or method call
+ * outside any lambda or async call.
+ */
+export function findStackAllocatedLocals(
+  decl: FunctionDeclaration,
+  capturedMutables: ReadonlySet<string>,
+): Set<Statement> {
+  const result = new Set<Statement>();
+  if (decl.body.kind !== "block" || decl.bodyless) return result;
+
+  const candidates = new Map<number, Candidate>();
+  let supported = true;
+  forEachStatement(decl.body.statements, (stmt) => {
+    if (stmt.kind === "function-declaration" || stmt.kind === "class-declaration") {
+      supported = false;
+      return;
+    }
+    if (stmt.kind !== "let-declaration" && stmt.kind !== "immutable-binding") return;
+    if (stmt.value.kind !== "call-expression" && stmt.value.kind !== "construct-expression") return;
+    if (capturedMutables.has(stmt.name)) return;
+    const classDecl = stackAllocatableClassOf(stmt.resolvedType);
+    if (!classDecl || stackAllocatableClassOf(stmt.value.resolvedType) !== classDecl) return;
+    candidates.set(stmt.span.start.offset, { stmt, decl: classDecl, used: false, excluded: false });
+  });
+  if (!supported || candidates.size === 0) return result;
+
+  const shorthandNames = new Set<string>();
+  walkStatementListExpressions(decl.body.statements, (root) => {
+    const memberUses = new Map<Expression, { property: string; called: boolean }>();
+    const called = new Set<Expression>();
+    const captured = new Set<Expression>();
+    walkExpression(root, (expr) => {
+      switch (expr.kind) {
+        case "lambda-expression":
+        case "async-expression":
+          if (containsNestedDeclaration(expr)) supported = false;
+          walkExpression(expr, (inner) => {
+            if (inner !== expr) captured.add(inner);
+          });
+          break;
+        case "call-expression":
+          called.add(expr.callee);
+          break;
+        case "member-expression":
+          if (!expr.optional) memberUses.set(expr.object, { property: expr.property, called: called.has(expr) });
+          break;
+        case "object-literal":
+          collectShorthandNames(expr.properties, shorthandNames);
+          break;
+        case "construct-expression":
+          if (expr.named) collectShorthandNames(expr.args as ObjectProperty[], shorthandNames);
+          break;
+        case "identifier": {
+          const binding = expr.resolvedBinding;
+          if (binding?.kind !== "let" && binding?.kind !== "immutable-binding") break;
+          const candidate = candidates.get(binding.span.start.offset);
+          if (!candidate || candidate.stmt.name !== expr.name) break;
+          const use = memberUses.get(expr);
+          candidate.used = true;
+          if (captured.has(expr) || !use || !isMemberUse(candidate.decl, use.property, use.called)) {
+            candidate.excluded = true;
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    });
+  });
+  if (!supported) return result;
+
+  for (const candidate of candidates.values()) {
+    if (candidate.used && !candidate.excluded && !shorthandNames.has(candidate.stmt.name)) result.add(candidate.stmt);
+  }
+  return result;
+}
+
+/**
+ * Emit a stack-allocated local from its already-emitted initializer.  Returns
+ * false when the initializer is not a plain `std::make_shared` construction
+ * (for example a `constructor` factory), leaving the caller to emit it.
+ */
+export function emitStackAllocatedLocal(stmt: StackLocal, value: string, ctx: EmitContext): boolean {
+  if (!ctx.stackAllocatedLocals?.has(stmt)) return false;
+  const match = /^std::make_shared<([\w:]+)>\(([\s\S]*)\)$/.exec(value);
+  if (!match) return false;
+
+  const ind = indent(ctx);
+  const [, cppName, args] = match;
+  const name = emitIdentifierSafe(stmt.name);
+  const storage = `_stack_${name}`;
+  ctx.sourceLines.push(args ? `${ind}${cppName} ${storage}(${args});` : `${ind}${cppName} ${storage};`);
+  ctx.sourceLines.push(`${ind}${cppName}* const ${name} = &${storage};`);
+  return true;
+}
+
+function stackAllocatableClassOf(type: ResolvedType | undefined): ClassDeclaration | null {
+  if (type?.kind !== "class" || type.symbol.extern_) return null;
+  const decl = type.symbol.declaration;
+  let allowed = stackAllocatableClasses.get(decl);
+  if (allowed === undefined) {
+    allowed = isStackAllocatableClass(decl);
+    stackAllocatableClasses.set(decl, allowed);
+  }
+  return allowed ? decl : null;
+}
+
+/**
+ * A class can live on the stack when nothing in its methods or destructor can
+ * hand out `this`: `this` appears only as the object of a field access or
+ * method call, and no lambda or async call could capture it.
+ */
+function isStackAllocatableClass(decl: ClassDeclaration): boolean {
+  if (decl.storage === "value" || decl.typeParams.length > 0 || decl.mock_) return false;
+
+  const bodies = decl.methods.filter((method) => !method.static_).map((method) => method.body);
+  if (decl.destructor) bodies.push(decl.destructor);
+  return bodies.every((body) => body.kind === "block"
+    ? isSelfContainedBlock(decl, body.statements)
+    : isSelfContainedExpression(decl, body));
+}
+
+function isSelfContainedBlock(decl: ClassDeclaration, stmts: readonly Statement[]): boolean {
+  let selfContained = true;
+  forEachStatement(stmts, (stmt) => {
+    if (stmt.kind === "function-declaration" || stmt.kind === "class-declaration") selfContained = false;
+  });
+  walkStatementListExpressions(stmts as Statement[], (root) => {
+    if (!isSelfContainedExpression(decl, root)) selfContained = false;
+  });
+  return selfContained;
+}
+
+function isSelfContainedExpression(decl: ClassDeclaration, root: Expression): boolean {
+  const memberUses = new Map<Expression, { property: string; called: boolean }>();
+  const called = new Set<Expression>();
+  let selfContained = true;
+  walkExpression(root, (expr) => {
+    switch (expr.kind) {
+      case "lambda-expression":
+      case "async-expression":
+        selfContained = false;
+        break;
+      case "call-expression":
+        called.add(expr.callee);
+        break;
+      case "member-expression":
+        memberUses.set(expr.object, { property: expr.property, called: called.has(expr) });
+        break;
+      case "this-expression": {
+        const use = memberUses.get(expr);
+        if (!use || !isMemberUse(decl, use.property, use.called)) selfContained = false;
+        break;
+      }
+      default:
+        break;
+    }
+  });
+  return selfContained;
+}
+
+function isMemberUse(decl: ClassDeclaration, property: string, called: boolean): boolean {
+  if (decl.fields.some((field) => !field.static_ && field.names.includes(property))) return true;
+  return called && decl.methods.some((method) => !method.static_ && method.name === property);
+}
+
+function collectShorthandNames(props: readonly ObjectProperty[], names: Set<string>): void {
+  for (const prop of props) {
+    if (!prop.value) names.add(prop.name);
+  }
+}
+
+function containsNestedDeclaration(expr: Expression): boolean {
+  let found = false;
+  walkExpression(expr, (inner) => {
+    if (inner.kind !== "lambda-expression" || inner.body.kind !== "block") return;
+    forEachStatement(inner.body.statements, (stmt) => {
+      if (stmt.kind === "function-declaration" || stmt.kind === "class-declaration") found = true;
+    });
+  });
+  return found;
+}
+
+/** Visit every statement in a body, descending into nested statement blocks. */
+function forEachStatement(stmts: readonly Statement[], visit: (stmt: Statement) => void): void {
+  for (const stmt of stmts) {
+    visit(stmt);
+    switch (stmt.kind) {
+      case "if-statement":
+        forEachStatement(stmt.body.statements, visit);
+        for (const elseIf of stmt.elseIfs) forEachStatement(elseIf.body.statements, visit);
+        if (stmt.else_) forEachStatement(stmt.else_.statements, visit);
+        break;
+      case "while-statement":
+      case "for-statement":
+      case "for-of-statement":
+        forEachStatement(stmt.body.statements, visit);
+        if (stmt.then_) forEachStatement(stmt.then_.statements, visit);
+        break;
+      case "with-statement":
+        forEachStatement(stmt.body.statements, visit);
+        break;
+      case "case-statement":
+        for (const arm of stmt.arms) {
+          if (arm.body.kind === "block") forEachStatement(arm.body.statements, visit);
+        }
+        break;
+      case "else-narrow-statement":
+      case "result-else-statement":
+        forEachStatement(stmt.elseBlock.statements, visit);
+        break;
+      case "block":
+        forEachStatement(stmt.statements, visit);
+        break;
+      default:
+        break;
+    }
+  }
+}
@@ -11,15 +11,19 @@ import type {
   MemberExpression,
   QualifiedMemberExpression,
   FunctionDeclaration,
+  LambdaExpression,
 } from "./ast.js";
-import { getResultShape, substituteTypeParams, type Binding, type FunctionResolvedParam, type ResolvedType, type ResultShape } from "./checker-types.js";
+import { getResultShape, PARALLEL_ARRAY_METHODS, substituteTypeParams, type Binding, type FunctionResolvedParam, type ResolvedType, type ResultShape } from "./checker-types.js";
 import { emitClassCppName, emitEnumHelperName, emitNullForType, emitType, isPointerType, isVariantUnionType } from "./emitter-types.js";
 import { resolveConcreteGenericTypeArgs, resolveMonomorphizedFunctionName, substituteEmitType } from "./emitter-monomorphize.js";
-import type { EmitContext } from "./emitter-context.js";
+import { requireActorRuntime, type EmitContext } from "./emitter-context.js";
 import { emitExpression } from "./emitter-expr.js";
 import { emitRuntimeCoercion } from "./emitter-json-value.js";
 import { emitIdentifierSafe } from "./emitter-expr-literals.js";
 import { emitPanicLocationArgs } from "./emitter-panic.js";
+import { emitLambdaFunctor, getBorrowedCallbackParams } from "./emitter-expr-lambda.js";
+import { emitMovableOperand } from "./emitter-moves.js";
+import { walkExpression } from "./checker-stmt.js";
 import { emitTypeAnnotation } from "./emitter-decl.js";
 import { emitQualifiedHelperName, emitQualifiedSymbolName, emitSymbolReferenceName } from "./emitter-names.js";
 import {
@@ -30,6 +34,7 @@ import {
   buildFieldTypeListForClassType,
   buildFieldTypeMap,
   emitClassConstruction,
+  emitInterfaceVisit,
   emitResolvedClassName,
   emitStreamNextHelperName,
   emitStreamValueHelperName,
@@ -133,15 +138,144 @@ function buildOrderedNamedCallValues(
   });
 }
 
+const INLINE_CALLBACK_ARRAY_METHODS = new Set(["some", "every", "filter", "map"]);
+const ARRAY_PIPELINE_STAGES = new Set(["filter", "map"]);
+const ARRAY_PIPELINE_TERMINALS = new Set(["filter", "map", "some", "every"]);
+
+const PURE_ARRAY_QUERY_METHODS = new Set(["contains", "indexOf", "some", "every", "filter", "map", "slice"]);
+
+/**
+ * Lower a chain of two or more filter/map calls, optionally ending in
+ * some/every, to one fused `doof::array_pipeline` pass. Fusion only applies
+ * when every stage takes an inline lambda: those closures cannot escape the
+ * chain, so they are emitted as bare functors instead of callbacks. The fused
+ * pass runs every stage per element and stops upstream stages early, so each
+ * lambda must also be free of observable side effects.
+ */
+function emitFusedArrayPipeline(expr: CallExpression, ctx: EmitContext): string | null {
+  const stages: Array<{ method: string; call: CallExpression; lambda: LambdaExpression }> = [];
+  let source: Expression = expr;
+  while (source.kind === "call-expression" && source.callee.kind === "member-expression") {
+    const member = source.callee;
+    const allowed = stages.length === 0 ? ARRAY_PIPELINE_TERMINALS : ARRAY_PIPELINE_STAGES;
+    const arg = source.args.length === 1 && !source.args[0].name ? source.args[0].value : undefined;
+    if (
+      !allowed.has(member.property) || member.optional || member.force
+      || member.object.resolvedType?.kind !== "array" || arg?.kind !== "lambda-expression"
+      || !isSideEffectFreeLambda(arg)
+    ) {
+      break;
+    }
+    stages.unshift({ method: member.property, call: source, lambda: arg });
+    source = member.object;
+  }
+  if (stages.length < 2) return null;
+
+  const first = stages[0];
+  let text = `doof::array_pipeline(${emitExpression(source, ctx)}, "${first.method}", ${emitPanicLocationArgs(first.call.span, ctx)})`;
+  for (const stage of stages) {
+    text += `.${stage.method}(${emitLambdaFunctor(stage.lambda, ctx)})`;
+  }
+  if (ARRAY_PIPELINE_STAGES.has(stages[stages.length - 1].method)) {
+    text += ".collect()";
+  }
+  return text;
+}
+
+/**
+ * A lambda is side-effect free when it only assigns its own locals and only
+ * calls isolated functions, string methods, and non-mutating array methods.
+ * Anything else (callbacks, method calls, builtins like `println`, actors)
+ * keeps the stage-by-stage evaluation order.
+ */
+function isSideEffectFreeLambda(lambda: LambdaExpression): boolean {
+  const isOwnLocal = (binding: Binding | undefined): boolean =>
+    !!binding && binding.span.start.offset >= lambda.span.start.offset && binding.span.end.offset <= lambda.span.end.offset;
+  let pure = true;
+  walkExpression(lambda, (expr) => {
+    if (!pure) return;
+    switch (expr.kind) {
+      case "assignment-expression":
+        pure = expr.target.kind === "identifier" && isOwnLocal(expr.target.resolvedBinding);
+        return;
+      case "call-expression": {
+        const callee = expr.callee;
+        if (callee.kind === "identifier") {
+          const symbol = callee.resolvedBinding?.symbol;
+          pure = symbol?.symbolKind === "function" && symbol.declaration.resolvedIsolated === true;
+        } else if (callee.kind === "member-expression" && !callee.optional) {
+          const receiver = callee.object.resolvedType;
+          pure = (receiver?.kind === "primitive" && receiver.name === "string")
+            || (receiver?.kind === "array" && PURE_ARRAY_QUERY_METHODS.has(callee.property));
+        } else {
+          pure = false;
+        }
+        return;
+      }
+      case "async-expression":
+      case "actor-creation-expression":
+      case "retire-expression":
+      case "yield-block-expression":
+        pure = false;
+        return;
+      default:
+        return;
+    }
+  });
+  return pure;
+}
+
+const STRING_VIEW_QUERY_METHODS = new Set(["indexOf", "contains", "startsWith", "endsWith"]);
+
+const STRING_VIEW_HELPERS: Record<string, string> = {
+  trim: "doof::string_trim_view",
+  trimStart: "doof::string_trimStart_view",
+  trimEnd: "doof::string_trimEnd_view",
+  slice: "doof::string_slice_view",
+  substring: "doof::string_substring_view",
+};
+
+/**
+ * Emit a string operand that is consumed within the enclosing full-expression
+ * (a query receiver, a comparison side, a `.length` read). A trim, slice or
+ * substring call in that position lowers to its `_view` runtime variant, so
+ * the intermediate string is never materialised.
+ */
+export function emitStringViewOperand(expr: Expression, ctx: EmitContext): string {
+  if (expr.kind !== "call-expression" || expr.callee.kind !== "member-expression") {
+    return emitExpression(expr, ctx);
+  }
+  const member = expr.callee;
+  const helper = STRING_VIEW_HELPERS[member.property];
+  const objType = member.object.resolvedType;
+  if (
+    !helper || member.optional || member.force
+    || objType?.kind !== "primitive" || objType.name !== "string"
+    || (member.property === "trimEnd" && expr.args.length > 0)
+    || expr.args.some((arg) => arg.name)
+  ) {
+    return emitExpression(expr, ctx);
+  }
+  const calleeType = member.resolvedType;
+  const params = calleeType?.kind === "function" ? calleeType.params : undefined;
+  const args = buildPositionalCallValues(params, expr.args, ctx, expr.span);
+  return `${helper}(${[emitStringViewOperand(member.object, ctx), ...args].join(", ")})`;
+}
+
 function buildPositionalCallValues(
   params: FunctionResolvedParam[] | undefined,
   args: Array<{ value: Expression }>,
   ctx: EmitContext,
   callSiteSpan: CallExpression["span"],
+  borrowedArgs?: ReadonlySet<number>,
+  moveArgs = false,
 ): string[] {
   const values = args.map((arg, index) => {
+    if (borrowedArgs?.has(index) && arg.value.kind === "lambda-expression") {
+      return emitLambdaFunctor(arg.value, ctx);
+    }
     const targetType = params && index < params.length ? params[index].type : undefined;
-    return emitExpression(arg.value, ctx, targetType);
+    return moveArgs ? emitMovableOperand(arg.value, ctx, targetType) : emitExpression(arg.value, ctx, targetType);
   });
 
   if (!params || args.length >= params.length) {
@@ -302,9 +436,23 @@ function emitIdentifierCallByName(
   if (name === "metricsIncrement" && isBuiltinRuntimeFunctionBinding(binding)) {
     return `doof::metrics::increment_counter(${joinedArgs})`;
   }
+  if (name === "metricsObserve" && isBuiltinRuntimeFunctionBinding(binding)) {
+    return `doof::metrics::observe(${joinedArgs})`;
+  }
+  if (name === "metricsGaugeSet" && isBuiltinRuntimeFunctionBinding(binding)) {
+    return `doof::metrics::set_gauge(${joinedArgs})`;
+  }
   if (name === "metricsSnapshotPrometheus" && isBuiltinRuntimeFunctionBinding(binding)) {
     return "doof::metrics::snapshot_prometheus()";
   }
+  if (name === "whenAll" && isBuiltinRuntimeFunctionBinding(binding)) {
+    requireActorRuntime(ctx);
+    return `doof::when_all(${joinedArgs})`;
+  }
+  if (name === "whenAny" && isBuiltinRuntimeFunctionBinding(binding)) {
+    requireActorRuntime(ctx);
+    return `doof::when_any(${joinedArgs})`;
+  }
   if (DOOF_RUNTIME_BUILTINS.has(name) && isBuiltinRuntimeFunctionBinding(binding)) {
     return `doof::${name}(${joinedArgs})`;
   }
@@ -331,6 +479,32 @@ function emitIdentifierCallByName(
   return `${emitIdentifierSafe(name)}${genericSuffix}(${joinedArgs})`;
 }
 
+const METRIC_HANDLE_BUILTINS: Record<string, { handle: string; factory: string; method: string }> = {
+  metricsIncrement: { handle: "Counter", factory: "counter", method: "add" },
+  metricsObserve: { handle: "Histogram", factory: "histogram", method: "record" },
+  metricsGaugeSet: { handle: "Gauge", factory: "gauge", method: "set" },
+};
+
+/**
+ * Emit a function-local static metrics handle so the name is registered once
+ * per call site and every later update skips the name lookup entirely.
+ */
+export function emitStaticMetricHandle(builtin: string, nameArg: string): string {
+  const { handle, factory } = METRIC_HANDLE_BUILTINS[builtin];
+  const cppType = `doof::metrics::${handle}`;
+  return `[]() -> const ${cppType}& { static const ${cppType} handle = doof::metrics::${factory}(${nameArg}); return handle; }()`;
+}
+
+/** Metrics builtins whose name is a plain string literal use a static handle. */
+function emitLiteralMetricCall(expr: CallExpression, args: string[], binding: Binding | undefined): string | null {
+  if (expr.callee.kind !== "identifier" || !isBuiltinRuntimeFunctionBinding(binding)) return null;
+  const builtin = METRIC_HANDLE_BUILTINS[expr.callee.name];
+  const nameArg = expr.args[0]?.value;
+  if (!builtin || args.length !== 2 || nameArg?.kind !== "string-literal") return null;
+  if (nameArg.parts.some((part) => typeof part !== "string")) return null;
+  return `${emitStaticMetricHandle(expr.callee.name, args[0])}.${builtin.method}(${args[1]})`;
+}
+
 function emitExplicitGenericMethodCall(
   expr: CallExpression,
   ctx: EmitContext,
@@ -377,6 +551,42 @@ function isDirectFunctionIdentifierCall(expr: CallExpression, binding: Binding |
     || (binding?.kind === "import" && binding.symbol?.symbolKind === "function");
 }
 
+/**
+ * Argument positions of a direct top-level function call whose parameters
+ * are borrowed callbacks (`doof::callback_ref`). Inline lambdas in those
+ * positions live for the whole call, so they are passed as bare functors.
+ */
+function getBorrowedCallbackArgs(expr: CallExpression, binding: Binding | undefined): ReadonlySet<number> | undefined {
+  if (!isDirectFunctionIdentifierCall(expr, binding)) return undefined;
+  const symbol = binding?.symbol;
+  if (symbol?.symbolKind !== "function" || symbol.extern_) return undefined;
+  const borrowed = getBorrowedCallbackParams(symbol.declaration);
+  if (borrowed.size === 0) return undefined;
+  const indexes = new Set<number>();
+  symbol.declaration.params.forEach((param, index) => {
+    if (borrowed.has(param.name)) indexes.add(index);
+  });
+  return indexes;
+}
+
+/**
+ * Whether last-use arguments may be moved into this call: direct calls to
+ * Doof functions and methods on Doof classes, whose by-value parameters
+ * accept rvalues. Extern and runtime callees keep their arguments as written.
+ */
+function canMoveCallArgs(expr: CallExpression, binding: Binding | undefined): boolean {
+  if (expr.callee.kind === "identifier") {
+    const symbol = binding?.symbol;
+    return isDirectFunctionIdentifierCall(expr, binding) && symbol?.symbolKind === "function" && !symbol.extern_;
+  }
+  if (expr.callee.kind !== "member-expression" || isFunctionFieldCall(expr) || isExplicitCallbackCall(expr)) return false;
+  const objectType = expr.callee.object.resolvedType;
+  if (objectType?.kind !== "struct" && (objectType?.kind !== "class" || objectType.symbol.extern_)) return false;
+  // Synthesized members such as fromJsonValue take their inputs by reference.
+  const property = expr.callee.property;
+  return objectType.symbol.declaration.methods.some((method) => method.name === property);
+}
+
 function isFunctionFieldCall(expr: CallExpression): boolean {
   if (expr.callee.kind !== "member-expression") return false;
   const memberExpr = expr.callee;
@@ -388,6 +598,16 @@ function isFunctionFieldCall(expr: CallExpression): boolean {
   );
 }
 
+// Promise members and callback `post` are defined in the actors runtime, and
+// an `auto` receiver never spells the Promise type out.
+function callNeedsActorRuntime(expr: CallExpression): boolean {
+  if (expr.resolvedType?.kind === "promise") return true;
+  if (expr.callee.kind !== "member-expression") return false;
+  const objectType = expr.callee.object.resolvedType;
+  return objectType?.kind === "promise"
+    || (objectType?.kind === "function" && expr.callee.property === "post");
+}
+
 function isExplicitCallbackCall(expr: CallExpression): boolean {
   if (expr.callee.kind !== "member-expression") return false;
   return expr.callee.property === "call"
@@ -530,6 +750,7 @@ function emitResultHelperCall(
 }
 
 export function emitCallExpression(expr: CallExpression, ctx: EmitContext): string {
+  if (callNeedsActorRuntime(expr)) requireActorRuntime(ctx);
   const calleeType = substituteEmitType(expr.callee.resolvedType, ctx);
   const calleeBinding = expr.callee.kind === "identifier" ? expr.callee.resolvedBinding : undefined;
   const hasNamedArgs = expr.args.some((arg) => arg.name);
@@ -600,10 +821,14 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
     const cppName = emitConcreteClassName(classType, ctx);
     const defaultCtx: EmitContext = { ...ctx, sourceLocationSpanOverride: expr.span };
     const allowFactory = shouldUseConstructorFactory(classType.symbol, ctx);
+    const externClass = classType.symbol.symbolKind === "class" && classType.symbol.extern_;
     const args = buildConstructorFieldInfoListForClassType(classType, allowFactory).map((field) => {
       const prop = propMap.get(field.name);
+      if (prop?.value) {
+        return externClass ? emitExpression(prop.value, ctx, field.type) : emitMovableOperand(prop.value, ctx, field.type);
+      }
       if (prop) {
-        return prop.value ? emitExpression(prop.value, ctx, field.type) : emitIdentifierSafe(prop.name);
+        return emitIdentifierSafe(prop.name);
       }
       if (field.defaultValue) {
         return emitExpression(field.defaultValue, defaultCtx, field.type);
@@ -645,6 +870,8 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
     expr.args,
     ctx,
     expr.span,
+    getBorrowedCallbackArgs(expr, calleeBinding),
+    canMoveCallArgs(expr, calleeBinding),
   );
   const args = positionalCallValues.join(", ");
   const explicitGenericMethodCall = emitExplicitGenericMethodCall(expr, ctx, args);
@@ -657,6 +884,16 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
     return emitCallbackDispatch(emitExpression((expr.callee as MemberExpression).object, ctx), args);
   }
 
+  // `then` is a keyword in Doof, so the continuation member is spelled
+  // `continueWith` and lowers to the runtime's `Promise<T>::then`.
+  if (
+    expr.callee.kind === "member-expression"
+    && expr.callee.property === "continueWith"
+    && expr.callee.object.resolvedType?.kind === "promise"
+  ) {
+    return `${emitExpression(expr.callee.object, ctx)}.then(${args})`;
+  }
+
   // Positional intrinsic arm construction.
   if (expr.callee.kind === "identifier" && expr.callee.name === "Success" && isUnshadowedResultCtorCall(expr, "Success")) {
     const successType = expr.resolvedType;
@@ -683,7 +920,9 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
     const fieldTypes = buildFieldTypeListForClassType(classType, allowFactory);
     const classPositionalValues = expr.args.map((arg, index) => {
       const targetType = index < fieldTypes.length ? fieldTypes[index] : undefined;
-      return emitExpression(arg.value, ctx, targetType);
+      return classType.symbol.symbolKind === "class" && classType.symbol.extern_
+        ? emitExpression(arg.value, ctx, targetType)
+        : emitMovableOperand(arg.value, ctx, targetType);
     });
     const positionalArgs = buildPositionalConstructorArgList(
       classType.symbol,
@@ -728,19 +967,46 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
     // Array methods: .push() → .push_back(), .reserve() → vector::reserve(),
     // and the remaining methods → runtime helpers.
     if (objType && objType.kind === "array") {
+      const fused = emitFusedArrayPipeline(expr, ctx);
+      if (fused) return fused;
       const obj = emitExpression(memberExpr.object, ctx);
       const method = memberExpr.property;
       const locationArgs = emitPanicLocationArgs(expr.span, ctx);
-      if (method === "push") return `${obj}->push_back(${args})`;
+      if (method === "push") {
+        const pushed = expr.args.length === 1
+          ? emitMovableOperand(expr.args[0].value, ctx, objType.elementType)
+          : args;
+        return `${obj}->push_back(${pushed})`;
+      }
       if (method === "reserve") return `doof::array_reserve(${obj}, ${args})`;
       if (method === "pop") return `doof::array_pop(${obj})`;
       if (method === "contains") return `doof::array_contains(${obj}, ${args}, ${locationArgs})`;
       if (method === "includes") return `doof::array_contains(${obj}, ${args}, ${locationArgs})`;
       if (method === "indexOf") return `doof::array_indexOf(${obj}, ${args}, ${locationArgs})`;
-      if (method === "some") return `doof::array_some(${obj}, ${args}, ${locationArgs})`;
-      if (method === "every") return `doof::array_every(${obj}, ${args}, ${locationArgs})`;
-      if (method === "filter") return `doof::array_filter(${obj}, ${args}, ${locationArgs})`;
-      if (method === "map") return `doof::array_map(${obj}, ${args}, ${locationArgs})`;
+      if (INLINE_CALLBACK_ARRAY_METHODS.has(method)) {
+        // These helpers invoke the callback before returning, so an inline
+        // lambda cannot escape and is passed as a bare functor, and a callback
+        // variable is passed as-is instead of through a converting copy.
+        const callbackArg = expr.args[0].value;
+        const callback = callbackArg.kind === "lambda-expression" ? emitLambdaFunctor(callbackArg, ctx)
+          : callbackArg.kind === "identifier" && callbackArg.resolvedBinding && callbackArg.resolvedBinding.kind !== "function"
+            ? emitExpression(callbackArg, ctx)
+            : args;
+        return `doof::array_${method}(${obj}, ${callback}, ${locationArgs})`;
+      }
+      if (PARALLEL_ARRAY_METHODS.has(method)) {
+        // The checker has proven the callback isolated; pass it as a bare
+        // functor so carrier threads never go through callback::call.
+        requireActorRuntime(ctx);
+        const callbackArg = expr.args[expr.args.length - 1].value;
+        const callback = callbackArg.kind === "lambda-expression"
+          ? emitLambdaFunctor(callbackArg, ctx)
+          : emitExpression(callbackArg, ctx);
+        const initial = method === "parallelReduce"
+          ? `${emitExpression(expr.args[0].value, ctx, objType.elementType)}, `
+          : "";
+        return `doof::array_${method}(${obj}, ${initial}${callback}, ${locationArgs})`;
+      }
       if (method === "slice") return `doof::array_slice(${obj}, ${args}, ${locationArgs})`;
       if (method === "buildReadonly") return `doof::array_buildReadonly(${obj}, ${locationArgs})`;
       if (method === "cloneMutable") return `doof::array_cloneMutable(${obj}, ${locationArgs})`;
@@ -748,8 +1014,10 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
 
     // String methods
     if (objType && objType.kind === "primitive" && objType.name === "string") {
-      const obj = emitExpression(memberExpr.object, ctx);
       const method = memberExpr.property;
+      const obj = STRING_VIEW_QUERY_METHODS.has(method)
+        ? emitStringViewOperand(memberExpr.object, ctx)
+        : emitExpression(memberExpr.object, ctx);
       const locationArgs = emitPanicLocationArgs(expr.span, ctx);
       if (method === "indexOf") return `doof::string_indexOf(${obj}, ${args})`;
       if (method === "contains") return `doof::string_contains(${obj}, ${args})`;
@@ -815,23 +1083,27 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
       return `${objType.name}::element_type::fromJsonValue(${args})`;
     }
 
-    // JSON serialization: Class.fromJsonValue(value) → Class::fromJsonValue(value) (static)
-    if (objType && (objType.kind === "class" || objType.kind === "struct") && memberExpr.property === "fromJsonValue") {
+    // JSON serialization: Class.fromJsonValue(value) → Class::fromJsonValue(value) (static),
+    // and Class.fromJsonText(text) → Class::fromJsonText(text) for the tree-free decoder.
+    if (objType && (objType.kind === "class" || objType.kind === "struct")
+        && (memberExpr.property === "fromJsonValue" || memberExpr.property === "fromJsonText")) {
       const className = emitClassCppName(objType.symbol, ctx.module.path);
-      return `${className}::fromJsonValue(${args})`;
+      return `${className}::${memberExpr.property}(${args})`;
     }
 
-    // JSON serialization: Interface.fromJsonValue(value) → Interface_fromJsonValue(value) (free function)
-    if (objType && objType.kind === "interface" && memberExpr.property === "fromJsonValue") {
-      return `${emitQualifiedSymbolName(objType.symbol, `${objType.symbol.name}_fromJsonValue`)}(${args})`;
+    // JSON serialization: Interface.fromJsonValue(value) → Interface_fromJsonValue(value) (free function),
+    // and Interface.fromJsonText(text) → Interface_fromJsonText(text), which decodes via a JsonDocument.
+    if (objType && objType.kind === "interface"
+        && (memberExpr.property === "fromJsonValue" || memberExpr.property === "fromJsonText")) {
+      return `${emitQualifiedSymbolName(objType.symbol, `${objType.symbol.name}_${memberExpr.property}`)}(${args})`;
     }
 
-    // JSON serialization: UnionAlias.fromJsonValue(value) → UnionAlias_fromJsonValue(value)
+    // JSON serialization: UnionAlias.fromJsonValue(value) → UnionAlias_fromJsonValue(value), likewise fromJsonText
     if (memberExpr.object.kind === "identifier"
         && memberExpr.object.resolvedBinding?.symbol?.symbolKind === "type-alias"
-        && memberExpr.property === "fromJsonValue") {
+        && (memberExpr.property === "fromJsonValue" || memberExpr.property === "fromJsonText")) {
       const symbol = memberExpr.object.resolvedBinding.symbol;
-      return `${emitQualifiedSymbolName(symbol, `${symbol.name}_fromJsonValue`)}(${args})`;
+      return `${emitQualifiedSymbolName(symbol, `${symbol.name}_${memberExpr.property}`)}(${args})`;
     }
 
     // Enum static methods: .fromName() → EnumName_fromName(), .fromValue() → EnumName_fromValue()
@@ -849,9 +1121,9 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
       const obj = emitExpression(memberExpr.object, ctx);
       const method = emitIdentifierSafe(memberExpr.property);
       if (args) {
-        return `std::visit([&](auto&& _obj) { return _obj->${method}(${args}); }, ${obj})`;
+        return emitInterfaceVisit(objType, `[&](auto&& _obj) { return _obj->${method}(${args}); }`, obj, ctx);
       }
-      return `std::visit([](auto&& _obj) { return _obj->${method}(); }, ${obj})`;
+      return emitInterfaceVisit(objType, `[](auto&& _obj) { return _obj->${method}(); }`, obj, ctx);
     }
 
     if (objType && isVariantUnionType(objType)) {
@@ -887,6 +1159,7 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
 
     // Actor method call (sync) → actor->call_sync(...)
     if (objType && objType.kind === "actor") {
+      requireActorRuntime(ctx);
       return emitActorSyncCall(expr, memberExpr, objType, args, ctx);
     }
   }
@@ -933,6 +1206,8 @@ export function emitCallExpression(expr: CallExpression, ctx: EmitContext): stri
     if (calleeType?.kind === "function" && !isDirectFunctionIdentifierCall(expr, calleeBinding)) {
       return emitCallbackCall(emitIdentifierSafe(expr.callee.name), args);
     }
+    const literalMetricCall = emitLiteralMetricCall(expr, positionalCallValues, calleeBinding);
+    if (literalMetricCall) return literalMetricCall;
     return emitIdentifierCallByName(
       expr.callee.name,
       positionalCallValues,
@@ -1057,6 +1332,11 @@ export function emitConstructExpression(expr: ConstructExpression, ctx: EmitCont
     typeName = `${typeName}<${typeArgStrs.join(", ")}>`;
   }
 
+  // Fields of generated classes are sinks; extern constructors keep copies.
+  const emitFieldValue = sym?.symbolKind === "class" && sym.extern_
+    ? (value: Expression, type: ResolvedType | undefined) => emitExpression(value, ctx, type)
+    : (value: Expression, type: ResolvedType | undefined) => emitMovableOperand(value, ctx, type);
+
   if (expr.named) {
     // Named construction: Type { field: value, ... }
     const props = expr.args as import("./ast.js").ObjectProperty[];
@@ -1068,7 +1348,7 @@ export function emitConstructExpression(expr: ConstructExpression, ctx: EmitCont
     const args = fields.map((field) => {
       const prop = propMap.get(field.name);
       if (prop) {
-        return prop.value ? emitExpression(prop.value, ctx, field.type) : emitIdentifierSafe(prop.name);
+        return prop.value ? emitFieldValue(prop.value, field.type) : emitIdentifierSafe(prop.name);
       }
       if (field.defaultValue) {
         return emitExpression(field.defaultValue, defaultCtx, field.type);
@@ -1084,7 +1364,7 @@ export function emitConstructExpression(expr: ConstructExpression, ctx: EmitCont
     : buildFieldTypeList(sym, shouldUseConstructorFactory(sym, ctx));
   const args = (expr.args as Expression[]).map((a, i) => {
     const fieldType = i < fieldTypes.length ? fieldTypes[i] : undefined;
-    return emitExpression(a, ctx, fieldType);
+    return emitFieldValue(a, fieldType);
   });
   const positionalArgs = buildPositionalConstructorArgList(
     sym,
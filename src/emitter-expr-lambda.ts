@@ -5,6 +5,7 @@
  * - Parameter and return type emission
  * - Capture list analysis (by-value vs by-reference)
  * - Pre-scan for `let` variables that must be heap-boxed (capturedMutables)
+ * - Escape analysis for function-typed parameters (borrowed callbacks)
  */
 
 import type {
@@ -15,14 +16,16 @@ import type {
   CallExpression,
   MemberExpression,
   Expression,
+  FunctionDeclaration,
   ObjectProperty,
   Block,
   Statement,
   SourceSpan,
 } from "./ast.js";
 import type { Binding } from "./checker-types.js";
+import { walkExpression, walkStatementListExpressions } from "./checker-stmt.js";
 import { emitClassCppName, emitType } from "./emitter-types.js";
-import type { EmitContext } from "./emitter-context.js";
+import { requireActorRuntime, type EmitContext } from "./emitter-context.js";
 import { emitExpression, emitBlockBody, indent } from "./emitter-expr.js";
 import { emitIdentifierSafe } from "./emitter-expr-literals.js";
 
@@ -31,6 +34,15 @@ import { emitIdentifierSafe } from "./emitter-expr-literals.js";
 // ============================================================================
 
 export function emitLambdaExpression(expr: LambdaExpression, ctx: EmitContext): string {
+  return wrapLambdaInCallback(emitLambdaFunctor(expr, ctx), expr, ctx);
+}
+
+/**
+ * Emit a lambda as a bare C++ closure, without the `doof::callback` wrapper.
+ * Only valid where the closure is invoked inline and never stored, so the
+ * actor-domain check the wrapper performs cannot fail.
+ */
+export function emitLambdaFunctor(expr: LambdaExpression, ctx: EmitContext): string {
   const params = expr.params.map((p) => {
     const pType = p.resolvedType ? emitType(p.resolvedType, ctx.module.path) : "auto";
     return `${pType} ${emitIdentifierSafe(p.name)}`;
@@ -54,13 +66,11 @@ export function emitLambdaExpression(expr: LambdaExpression, ctx: EmitContext):
 
   if (expr.body.kind === "block") {
     const bodyLines = emitBlockBody(expr.body as Block, bodyCtx);
-    const lambda = `[${captureList}](${params}) -> ${retType} {\n${bodyLines}\n${indent(ctx)}}`;
-    return wrapLambdaInCallback(lambda, expr, ctx);
+    return `[${captureList}](${params}) -> ${retType} {\n${bodyLines}\n${indent(ctx)}}`;
   }
 
   const body = emitExpression(expr.body as Expression, bodyCtx);
-  const lambda = `[${captureList}](${params}) -> ${retType} { return ${body}; }`;
-  return wrapLambdaInCallback(lambda, expr, ctx);
+  return `[${captureList}](${params}) -> ${retType} { return ${body}; }`;
 }
 
 function wrapLambdaInCallback(lambda: string, expr: LambdaExpression, ctx: EmitContext): string {
@@ -96,6 +106,7 @@ export function emitAsyncExpression(expr: AsyncExpression, ctx: EmitContext): st
 }
 
 export function emitRetireExpression(expr: RetireExpression, ctx: EmitContext): string {
+  requireActorRuntime(ctx);
   return `${emitExpression(expr.actor, ctx)}->retire()`;
 }
 
@@ -106,28 +117,35 @@ function emitActorAsyncCall(
   asyncExpr: AsyncExpression,
   ctx: EmitContext,
 ): string {
+  requireActorRuntime(ctx);
   const obj = emitExpression(memberExpr.object, ctx);
   const method = emitIdentifierSafe(memberExpr.property);
   const className = emitClassCppName(objType.innerClass.symbol, ctx.module.path);
-  const args = callExpr.args.map((a) => emitExpression(a.value, ctx)).join(", ");
 
   const promiseType = asyncExpr.resolvedType;
   const valueType = promiseType?.kind === "promise" ? promiseType.valueType : null;
   const cppRetType = valueType ? emitType(valueType, ctx.module.path) : "void";
+  const signature = cppRetType === "void" ? "" : ` -> ${cppRetType}`;
+  const invoke = (args: string) => cppRetType === "void" ? `_self.${method}(${args});` : `return _self.${method}(${args});`;
 
-  if (cppRetType === "void") {
-    if (args) {
-      return `${obj}->template call_async<void>([&](${className}& _self) { _self.${method}(${args}); })`;
-    }
-    return `${obj}->template call_async<void>([](${className}& _self) { _self.${method}(); })`;
+  if (callExpr.args.length === 0) {
+    return `${obj}->template call_async<${cppRetType}>([](${className}& _self)${signature} { ${invoke("")} })`;
   }
-  if (args) {
-    return `${obj}->template call_async<${cppRetType}>([&](${className}& _self) -> ${cppRetType} { return _self.${method}(${args}); })`;
-  }
-  return `${obj}->template call_async<${cppRetType}>([](${className}& _self) -> ${cppRetType} { return _self.${method}(); })`;
+
+  // Evaluate the receiver and arguments in order on the calling thread, then
+  // move the argument values into the message the actor runs later.
+  const id = ctx.tempCounter++;
+  const argNames = callExpr.args.map((_, index) => `_async_${id}_a${index}`);
+  const locals = callExpr.args.map((arg, index) => `auto ${argNames[index]} = ${emitExpression(arg.value, ctx)};`);
+  const captures = argNames.map((name) => `${name} = std::move(${name})`).join(", ");
+  const forwarded = argNames.map((name) => `std::move(${name})`).join(", ");
+  return `[&]() { auto&& _async_${id}_actor = ${obj}; ${locals.join(" ")} `
+    + `return _async_${id}_actor->template call_async<${cppRetType}>(`
+    + `[${captures}](${className}& _self) mutable${signature} { ${invoke(forwarded)} }); }()`;
 }
 
 export function emitActorCreationExpression(expr: ActorCreationExpression, ctx: EmitContext): string {
+  requireActorRuntime(ctx);
   const className = expr.resolvedType?.kind === "actor"
     ? emitClassCppName(expr.resolvedType.innerClass.symbol, ctx.module.path)
     : emitIdentifierSafe(expr.className);
@@ -897,3 +915,100 @@ function collectMutableCaptureNamesFromStmt(
       break;
   }
 }
+
+// ============================================================================
+// Non-escaping callback parameters
+// ============================================================================
+
+const borrowedCallbackParamCache = new WeakMap<FunctionDeclaration, ReadonlySet<string>>();
+
+/**
+ * Find the function-typed parameters of a top-level function that provably
+ * never escape the call: every use is a direct `f(x)` or `f.call(x)` outside
+ * any nested lambda or async expression, so the callable is never stored,
+ * captured, dispatched or passed on. These parameters are emitted as
+ * `doof::callback_ref`, and direct call sites pass inline lambdas for them as
+ * bare functors instead of allocating a `doof::callback`.
+ *
+ * Generic and mock functions are excluded, as are parameters with defaults,
+ * so declarations, prototypes and call sites always agree.
+ */
+export function getBorrowedCallbackParams(decl: FunctionDeclaration): ReadonlySet<string> {
+  const cached = borrowedCallbackParamCache.get(decl);
+  if (cached) return cached;
+  const result = findBorrowedCallbackParams(decl);
+  borrowedCallbackParamCache.set(decl, result);
+  return result;
+}
+
+function findBorrowedCallbackParams(decl: FunctionDeclaration): Set<string> {
+  const result = new Set<string>();
+  if (decl.typeParams.length > 0 || decl.bodyless || decl.mock_) return result;
+  if (decl.resolvedType?.kind === "function" && decl.resolvedType.mockCall) return result;
+
+  const candidates = new Map<number, string>();
+  for (const param of decl.params) {
+    if (param.resolvedType?.kind === "function" && !param.defaultValue) {
+      candidates.set(param.span.start.offset, param.name);
+    }
+  }
+  if (candidates.size === 0) return result;
+
+  const roots: Expression[] = [];
+  if (decl.body.kind === "block") {
+    // Nested declarations are not covered by the expression walk below.
+    if (decl.body.statements.some((stmt) => stmt.kind === "function-declaration" || stmt.kind === "class-declaration")) {
+      return result;
+    }
+    walkStatementListExpressions(decl.body.statements, (root) => roots.push(root));
+  } else {
+    roots.push(decl.body);
+  }
+
+  const candidateName = (expr: Expression): string | undefined => {
+    if (expr.kind !== "identifier" || expr.resolvedBinding?.kind !== "parameter") return undefined;
+    return candidates.get(expr.resolvedBinding.span.start.offset);
+  };
+
+  const directCallees = new Set<Expression>();
+  const nested = new Set<Expression>();
+  const references: Expression[] = [];
+  // `{ name }` shorthand properties carry no identifier node to walk.
+  const escaping = new Set<string>();
+  for (const root of roots) {
+    walkExpression(root, (expr) => {
+      if (expr.kind === "object-literal" || (expr.kind === "construct-expression" && expr.named)) {
+        const props = expr.kind === "object-literal" ? expr.properties : expr.args as ObjectProperty[];
+        for (const prop of props) {
+          if (!prop.value) escaping.add(prop.name);
+        }
+      }
+      if (expr.kind === "lambda-expression" || expr.kind === "async-expression") {
+        walkExpression(expr, (inner) => {
+          if (inner !== expr) nested.add(inner);
+        });
+        return;
+      }
+      if (expr.kind === "call-expression") {
+        const callee = expr.callee;
+        if (candidateName(callee)) {
+          directCallees.add(callee);
+        } else if (callee.kind === "member-expression" && callee.property === "call" && candidateName(callee.object)) {
+          directCallees.add(callee.object);
+        }
+        return;
+      }
+      if (candidateName(expr)) references.push(expr);
+    });
+  }
+
+  for (const reference of references) {
+    if (nested.has(reference) || !directCallees.has(reference)) {
+      escaping.add(candidateName(reference)!);
+    }
+  }
+  for (const name of candidates.values()) {
+    if (!escaping.has(name)) result.add(name);
+  }
+  return result;
+}
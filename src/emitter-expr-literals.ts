@@ -6,6 +6,7 @@
 import type { StringLiteral } from "./ast.js";
 import type { EmitContext } from "./emitter-context.js";
 import { emitExpression } from "./emitter-expr.js";
+import { emitStringType } from "./emitter-types.js";
 
 // ============================================================================
 // Numeric literal formatting
@@ -55,21 +56,27 @@ export function escapeString(s: string): string {
 export function emitStringLiteral(expr: StringLiteral, ctx: EmitContext): string {
   // Simple string without interpolation
   if (expr.parts.length === 0 || (expr.parts.length === 1 && typeof expr.parts[0] === "string")) {
-    return `std::string("${escapeString(expr.value)}")`;
+    return `${emitStringType()}("${escapeString(expr.value)}")`;
   }
 
-  // Interpolated string → doof::concat(...)
+  // Interpolated string → doof::concat(...), which formats each value
+  // straight into one pre-sized buffer.
   const parts: string[] = [];
+  const values: string[] = [];
   for (const part of expr.parts) {
     if (typeof part === "string") {
       if (part.length > 0) {
         parts.push(`"${escapeString(part)}"`);
       }
     } else {
-      parts.push(`doof::to_string(${emitExpression(part, ctx)})`);
+      const value = emitExpression(part, ctx);
+      values.push(value);
+      parts.push(value);
     }
   }
-  if (parts.length === 1) return parts[0];
+  if (parts.length === 1) {
+    return values.length === 1 ? `doof::to_string(${values[0]})` : parts[0];
+  }
   return `doof::concat(${parts.join(", ")})`;
 }
 
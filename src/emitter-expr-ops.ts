@@ -16,7 +16,10 @@ import { getResultShape, isJsonValueType, type ResolvedType } from "./checker-ty
 import { emitClassCppName, emitEnumHelperName, emitEnumVariantAccess, emitNullForType, emitType, isPointerType, isMonostateNullable, isOptionalNullable, isVariantUnionType } from "./emitter-types.js";
 import type { EmitContext } from "./emitter-context.js";
 import { emitExpression } from "./emitter-expr.js";
+import { emitInterfaceVisit } from "./emitter-expr-utils.js";
+import { emitStringViewOperand } from "./emitter-expr-calls.js";
 import { emitIdentifierSafe } from "./emitter-expr-literals.js";
+import { emitMovableOperand } from "./emitter-moves.js";
 import { emitPanicAt, emitPanicLocationArgs } from "./emitter-panic.js";
 import { emitQualifiedSymbolName, emitSymbolReferenceName } from "./emitter-names.js";
 
@@ -32,8 +35,8 @@ function getNamedClassStaticAccess(expr: MemberExpression, ctx: EmitContext): st
   if (expr.property === "metadata") {
     return `${className}::_metadata`;
   }
-  if (expr.property === "fromJsonValue") {
-    return `${className}::fromJsonValue`;
+  if (expr.property === "fromJsonValue" || expr.property === "fromJsonText") {
+    return `${className}::${expr.property}`;
   }
   const field = objectType.symbol.declaration.fields.find(
     (f) => f.names.includes(expr.property) && f.static_,
@@ -57,17 +60,17 @@ function getNamedInterfaceStaticAccess(expr: MemberExpression): string | null {
   const objectType = expr.object.resolvedType;
   if (!objectType || objectType.kind !== "interface") return null;
   if (binding?.kind !== "interface") return null;
-  if (expr.property !== "fromJsonValue") return null;
-  return emitQualifiedSymbolName(objectType.symbol, `${objectType.symbol.name}_fromJsonValue`);
+  if (expr.property !== "fromJsonValue" && expr.property !== "fromJsonText") return null;
+  return emitQualifiedSymbolName(objectType.symbol, `${objectType.symbol.name}_${expr.property}`);
 }
 
 function getNamedTypeAliasStaticAccess(expr: MemberExpression): string | null {
   if (expr.object.kind !== "identifier") return null;
 
   const binding = expr.object.resolvedBinding;
-  if (expr.property !== "fromJsonValue") return null;
+  if (expr.property !== "fromJsonValue" && expr.property !== "fromJsonText") return null;
   if (binding?.symbol?.symbolKind !== "type-alias") return null;
-  return emitQualifiedSymbolName(binding.symbol, `${binding.symbol.name}_fromJsonValue`);
+  return emitQualifiedSymbolName(binding.symbol, `${binding.symbol.name}_${expr.property}`);
 }
 
 function getQualifiedClassStaticAccess(expr: QualifiedMemberExpression, ctx: EmitContext): string | null {
@@ -77,8 +80,8 @@ function getQualifiedClassStaticAccess(expr: QualifiedMemberExpression, ctx: Emi
   if (expr.property === "metadata") {
     return `${className}::_metadata`;
   }
-  if (expr.property === "fromJsonValue") {
-    return `${className}::fromJsonValue`;
+  if (expr.property === "fromJsonValue" || expr.property === "fromJsonText") {
+    return `${className}::${expr.property}`;
   }
   const field = objectType.symbol.declaration.fields.find(
     (f) => f.names.includes(expr.property) && f.static_,
@@ -101,9 +104,9 @@ function getQualifiedTypeAliasStaticAccess(expr: QualifiedMemberExpression): str
   if (expr.object.kind !== "identifier") return null;
 
   const binding = expr.object.resolvedBinding;
-  if (expr.property !== "fromJsonValue") return null;
+  if (expr.property !== "fromJsonValue" && expr.property !== "fromJsonText") return null;
   if (binding?.symbol?.symbolKind !== "type-alias") return null;
-  return emitQualifiedSymbolName(binding.symbol, `${binding.symbol.name}_fromJsonValue`);
+  return emitQualifiedSymbolName(binding.symbol, `${binding.symbol.name}_${expr.property}`);
 }
 
 function isClassMetadataUnion(type: ResolvedType | undefined): type is Extract<ResolvedType, { kind: "union" }> {
@@ -219,8 +222,12 @@ export function emitBinaryExpression(expr: BinaryExpression, ctx: EmitContext):
   }
 
   const precedence = getBinaryPrecedence(expr.operator);
-  const left = emitBinaryOperand(expr.left, ctx, precedence, "left");
-  const right = emitBinaryOperand(expr.right, ctx, precedence, "right");
+  // String equality only reads its operands, so trimmed or sliced sides
+  // compare as views instead of building temporaries.
+  const viewOperands = (expr.operator === "==" || expr.operator === "!=")
+    && isStringType(expr.left.resolvedType) && isStringType(expr.right.resolvedType);
+  const left = emitBinaryOperand(expr.left, ctx, precedence, "left", viewOperands);
+  const right = emitBinaryOperand(expr.right, ctx, precedence, "right", viewOperands);
 
   // String concatenation: wrap non-string operands in doof::to_string()
   if (expr.operator === "+") {
@@ -288,10 +295,10 @@ export function emitUnaryExpression(expr: UnaryExpression, ctx: EmitContext): st
       if (result) {
         const failureMessage = result.errorType.kind === "void" ? '"try! failed"' : `"try! failed: " + doof::to_string(doof::failure_error(${tmp}))`;
         if (result.successType.kind === "void") {
-          return `[&]() -> void { auto ${tmp} = ${operand}; if (doof::is_failure(${tmp})) ${emitPanicAt(failureMessage, expr.span, ctx)}; }()`;
+          return `[&]() -> void { auto ${tmp} = ${operand}; if (DOOF_UNLIKELY(doof::is_failure(${tmp}))) ${emitPanicAt(failureMessage, expr.span, ctx)}; }()`;
         }
         const valType = emitType(result.successType, ctx.module.path);
-        return `[&]() -> ${valType} { auto ${tmp} = ${operand}; if (doof::is_failure(${tmp})) ${emitPanicAt(failureMessage, expr.span, ctx)}; return std::move(doof::success_value(${tmp})); }()`;
+        return `[&]() -> ${valType} { auto ${tmp} = ${operand}; if (DOOF_UNLIKELY(doof::is_failure(${tmp}))) ${emitPanicAt(failureMessage, expr.span, ctx)}; return std::move(doof::success_value(${tmp})); }()`;
       }
       throw new Error("try! operand is missing its canonical Result type during emission");
     }
@@ -342,7 +349,9 @@ export function emitAssignmentExpression(expr: AssignmentExpression, ctx: EmitCo
     target = emitExpression(expr.target, ctx);
   }
   const targetType: ResolvedType | undefined = expr.operator === "=" ? expr.target.resolvedType : undefined;
-  const value = emitExpression(expr.value, ctx, targetType);
+  const value = expr.operator === "="
+    ? emitMovableOperand(expr.value, ctx, targetType)
+    : emitExpression(expr.value, ctx, targetType);
 
   const directOps = new Set(["=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>="]);
   if (directOps.has(expr.operator)) {
@@ -369,6 +378,9 @@ export function emitAssignmentExpression(expr: AssignmentExpression, ctx: EmitCo
  */
 function emitMemberExpressionLValue(expr: MemberExpression, ctx: EmitContext): string {
   const prop = emitIdentifierSafe(expr.property);
+  if (expr.object.kind === "this-expression") {
+    return `this->${prop}`;
+  }
   const object = emitExpression(expr.object, ctx);
   const objType = expr.object.resolvedType;
 
@@ -406,8 +418,9 @@ function emitBinaryOperand(
   ctx: EmitContext,
   parentPrecedence: number,
   side: "left" | "right",
+  asStringView = false,
 ): string {
-  const text = emitExpression(expr, ctx);
+  const text = asStringView ? emitStringViewOperand(expr, ctx) : emitExpression(expr, ctx);
   const childPrecedence = getExpressionPrecedence(expr);
   if (childPrecedence < parentPrecedence) {
     return `(${text})`;
@@ -418,6 +431,10 @@ function emitBinaryOperand(
   return text;
 }
 
+function isStringType(type: ResolvedType | undefined): boolean {
+  return type?.kind === "primitive" && type.name === "string";
+}
+
 function emitUnaryOperand(expr: Expression, ctx: EmitContext): string {
   const text = emitExpression(expr, ctx);
   const childPrecedence = getExpressionPrecedence(expr);
@@ -550,7 +567,7 @@ export function emitMemberExpression(expr: MemberExpression, ctx: EmitContext):
 
   // String .length → .length()
   if (objType && objType.kind === "primitive" && objType.name === "string" && expr.property === "length") {
-    const object = emitExpression(expr.object, ctx);
+    const object = emitStringViewOperand(expr.object, ctx);
     return `(int32_t)${object}.length()`;
   }
 
@@ -583,7 +600,7 @@ export function emitMemberExpression(expr: MemberExpression, ctx: EmitContext):
 
   // Interface-typed field access → std::visit
   if (objType && objType.kind === "interface") {
-    return `std::visit([](auto&& _obj) { return _obj->${prop}; }, ${object})`;
+    return emitInterfaceVisit(objType, `[](auto&& _obj) { return _obj->${prop}; }`, object, ctx);
   }
 
   // Union field access is only accepted by the checker when every union member
@@ -21,6 +21,25 @@ import { emitClassInnerType, emitType } from "./emitter-types.js";
 type NominalObjectType = Extract<ResolvedType, { kind: "class" | "struct" }>;
 type NominalObjectSymbol = ClassSymbol | StructSymbol;
 
+/** Interfaces with more implementers than this dispatch through `doof::visit_table`. */
+export const INTERFACE_DISPATCH_TABLE_THRESHOLD = 8;
+
+/**
+ * Emit a visit of an interface value.  Small interfaces use `std::visit`;
+ * interfaces whose whole-program implementer set exceeds the threshold index
+ * one flat function table by the variant tag instead.
+ */
+export function emitInterfaceVisit(
+  interfaceType: Extract<ResolvedType, { kind: "interface" }>,
+  visitor: string,
+  object: string,
+  ctx: EmitContext,
+): string {
+  const impls = ctx.interfaceImpls.get(`${interfaceType.symbol.module}:${interfaceType.symbol.name}`);
+  const visit = impls && impls.length > INTERFACE_DISPATCH_TABLE_THRESHOLD ? "doof::visit_table" : "std::visit";
+  return `${visit}(${visitor}, ${object})`;
+}
+
 /**
  * Resolve a TypeAnnotation to a ResolvedType.
  * First checks if the analyzer has already resolved it (resolvedSymbol).
@@ -342,6 +361,10 @@ export function emitStreamValueHelperName(aliasName: string): string {
   return `__doof_stream_value_${aliasName.replace(/[^A-Za-z0-9]/g, "_")}`;
 }
 
+export function emitStreamPullHelperName(aliasName: string): string {
+  return `__doof_stream_pull_${aliasName.replace(/[^A-Za-z0-9]/g, "_")}`;
+}
+
 export function buildConstructorFieldInfoList(
   classSym: NominalObjectSymbol | undefined,
   allowFactory = true,
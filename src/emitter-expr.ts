@@ -239,10 +239,10 @@ function emitExpressionInner(expr: Expression, ctx: EmitContext, targetType?: Re
         const tmp = `_assert_${ctx.tempCounter++}`;
         const failureMessage = result.errorType.kind === "void" ? '"! failed"' : `"! failed: " + doof::to_string(doof::failure_error(${tmp}))`;
         if (result.successType.kind === "void") {
-          return `[&]() -> void { auto ${tmp} = ${inner}; if (doof::is_failure(${tmp})) ${emitPanicAt(failureMessage, expr.span, ctx)}; }()`;
+          return `[&]() -> void { auto ${tmp} = ${inner}; if (DOOF_UNLIKELY(doof::is_failure(${tmp}))) ${emitPanicAt(failureMessage, expr.span, ctx)}; }()`;
         }
         const valueType = emitType(result.successType, ctx.module.path);
-        return `[&]() -> ${valueType} { auto ${tmp} = ${inner}; if (doof::is_failure(${tmp})) ${emitPanicAt(failureMessage, expr.span, ctx)}; return std::move(doof::success_value(${tmp})); }()`;
+        return `[&]() -> ${valueType} { auto ${tmp} = ${inner}; if (DOOF_UNLIKELY(doof::is_failure(${tmp}))) ${emitPanicAt(failureMessage, expr.span, ctx)}; return std::move(doof::success_value(${tmp})); }()`;
       }
       // For std::optional<T>, unwrap with .value()
       if (innerType && isOptionalNullable(innerType)) {
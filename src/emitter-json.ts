@@ -1,9 +1,13 @@
 /**
- * C++ JSON serialization code generation — toJsonObject / fromJsonValue methods.
+ * C++ JSON serialization code generation — toJsonObject / fromJsonValue /
+ * fromJsonText methods.
  *
  * Generates doof::JsonValue-based serialization and deserialization code
  * for classes/structs, interface variant types, and discriminated class-union aliases. Handles nested nominal objects, arrays,
- * tuples, enums, nullable types, and const discriminator fields.
+ * tuples, enums, nullable types, and const discriminator fields. Classes and
+ * structs also get a doof::JsonReader path that decodes text without building
+ * the intermediate JsonValue tree. Interfaces and aliases decode text through
+ * an arena doof::JsonDocument, with doof::JsonNode overloads of fromJsonValue.
  */
 
 import type { AnalysisResult } from "./analyzer.js";
@@ -12,7 +16,7 @@ import { isJsonValueType, type ResolvedType } from "./checker-types.js";
 import type { EmitContext } from "./emitter-context.js";
 import { emitDefaultExpression } from "./emitter-defaults.js";
 import { indent, emitIdentifierSafe } from "./emitter-expr.js";
-import { emitClassCppName, emitEnumHelperName, emitType } from "./emitter-types.js";
+import { emitClassCppName, emitEnumHelperName, emitNullForType, emitStringType, emitType } from "./emitter-types.js";
 import type { ClassSymbol } from "./types.js";
 
 // ============================================================================
@@ -59,6 +63,7 @@ export function propagateJsonDemand(analysisResult: AnalysisResult): void {
     if (!impls) continue;
     for (const cls of impls) {
       cls.needsJson = true;
+      if (ifaceDecl.needsJsonDocument) cls.needsJsonDocument = true;
     }
   }
 
@@ -83,6 +88,25 @@ export function propagateJsonDemand(analysisResult: AnalysisResult): void {
       markReferencedClasses(field.resolvedType, classDecls, worklist);
     }
   }
+
+  // JsonDocument decoders call the JsonNode overload of every nested class.
+  const documentVisited = new Set<string>();
+  const documentWorklist: ClassDeclaration[] = [];
+  for (const [, decls] of classDecls) {
+    for (const decl of decls) {
+      if (decl.needsJsonDocument) documentWorklist.push(decl);
+    }
+  }
+  while (documentWorklist.length > 0) {
+    const cls = documentWorklist.pop()!;
+    if (documentVisited.has(cls.name)) continue;
+    documentVisited.add(cls.name);
+
+    for (const field of cls.fields) {
+      if (!field.resolvedType) continue;
+      markReferencedClasses(field.resolvedType, classDecls, documentWorklist, "needsJsonDocument");
+    }
+  }
 }
 
 /** Recursively find nominal object types within a ResolvedType and add them to the worklist. */
@@ -90,6 +114,7 @@ export function markReferencedClasses(
   type: ResolvedType,
   classDecls: Map<string, ClassDeclaration[]>,
   worklist: ClassDeclaration[],
+  flag: "needsJson" | "needsJsonDocument" = "needsJson",
 ): void {
   if (isJsonValueType(type)) {
     return;
@@ -100,8 +125,8 @@ export function markReferencedClasses(
       const decls = classDecls.get(type.symbol.name);
       if (decls) {
         for (const decl of decls) {
-          if (!decl.needsJson) {
-            decl.needsJson = true;
+          if (!decl[flag]) {
+            decl[flag] = true;
             worklist.push(decl);
           }
         }
@@ -112,8 +137,8 @@ export function markReferencedClasses(
       const decls = classDecls.get(type.symbol.name);
       if (decls) {
         for (const decl of decls) {
-          if (!decl.needsJson) {
-            decl.needsJson = true;
+          if (!decl[flag]) {
+            decl[flag] = true;
             worklist.push(decl);
           }
         }
@@ -121,23 +146,23 @@ export function markReferencedClasses(
       break;
     }
     case "array":
-      markReferencedClasses(type.elementType, classDecls, worklist);
+      markReferencedClasses(type.elementType, classDecls, worklist, flag);
       break;
     case "tuple":
       for (const element of type.elements) {
-        markReferencedClasses(element, classDecls, worklist);
+        markReferencedClasses(element, classDecls, worklist, flag);
       }
       break;
     case "union":
       for (const inner of type.types) {
-        markReferencedClasses(inner, classDecls, worklist);
+        markReferencedClasses(inner, classDecls, worklist, flag);
       }
       break;
     case "success":
-      markReferencedClasses(type.valueType, classDecls, worklist);
+      markReferencedClasses(type.valueType, classDecls, worklist, flag);
       break;
     case "failure":
-      markReferencedClasses(type.errorType, classDecls, worklist);
+      markReferencedClasses(type.errorType, classDecls, worklist, flag);
       break;
   }
 }
@@ -211,8 +236,19 @@ export function emitSerializeExpr(fieldExpr: string, type: ResolvedType): string
 }
 
 /**
- * Emit C++ code that deserializes a doof::JsonValue into the
- * given ResolvedType. `jsonExpr` is a C++ expression of type doof::JsonValue.
+ * Which parsed form a generated fromJsonValue reads: an owning doof::JsonValue
+ * tree, or a doof::JsonNode borrowed from an arena JsonDocument.
+ */
+export type JsonCarrier = "value" | "node";
+
+export function jsonCarrierType(carrier: JsonCarrier): string {
+  return carrier === "node" ? "doof::JsonNode" : "doof::JsonValue";
+}
+
+/**
+ * Emit C++ code that deserializes a doof::JsonValue (or, for the "node"
+ * carrier, a doof::JsonNode) into the given ResolvedType. `jsonExpr` is a C++
+ * expression of the carrier type.
  * Returns a C++ expression string that produces the target type.
  */
 export function emitDeserializeExpr(
@@ -220,9 +256,11 @@ export function emitDeserializeExpr(
   type: ResolvedType,
   ctx: EmitContext,
   lenientExpr = "false",
+  carrier: JsonCarrier = "value",
 ): string {
   if (isJsonValueType(type)) {
-    return jsonExpr;
+    // Nodes borrow from their document, so JsonValue fields take a copy.
+    return carrier === "node" ? `doof::JsonValue(${jsonExpr})` : jsonExpr;
   }
 
   switch (type.kind) {
@@ -247,12 +285,12 @@ export function emitDeserializeExpr(
 
     case "array": {
       const elementType = emitType(type.elementType, ctx.module.path);
-      return `[&]() { const auto* _arr = doof::json_as_array(${jsonExpr}); if (_arr == nullptr) { doof::panic("Expected JSON array"); } auto _vec = std::make_shared<std::vector<${elementType}>>(); _vec->reserve(_arr->size()); for (const auto& _el : *_arr) { _vec->push_back(${emitDeserializeExpr("_el", type.elementType, ctx, lenientExpr)}); } return _vec; }()`;
+      return `[&]() { const auto* _arr = doof::json_as_array(${jsonExpr}); if (_arr == nullptr) { doof::panic("Expected JSON array"); } auto _vec = std::make_shared<std::vector<${elementType}>>(); _vec->reserve(_arr->size()); for (const auto& _el : *_arr) { _vec->push_back(${emitDeserializeExpr("_el", type.elementType, ctx, lenientExpr, carrier)}); } return _vec; }()`;
     }
 
     case "tuple": {
       const parts = type.elements.map((element, index) =>
-        emitDeserializeExpr(`(*_arr)[${index}]`, element, ctx, lenientExpr),
+        emitDeserializeExpr(`(*_arr)[${index}]`, element, ctx, lenientExpr, carrier),
       );
       return `[&]() { const auto* _arr = doof::json_as_array(${jsonExpr}); if (_arr == nullptr) { doof::panic("Expected JSON array"); } return std::make_tuple(${parts.join(", ")}); }()`;
     }
@@ -269,9 +307,9 @@ export function emitDeserializeExpr(
       if (hasNull && nonNull.length === 1) {
         const inner = nonNull[0];
         if (inner.kind === "class") {
-          return `(doof::json_is_null(${jsonExpr}) ? ${emitType(type, ctx.module.path)}{nullptr} : ${emitDeserializeExpr(jsonExpr, inner, ctx, lenientExpr)})`;
+          return `(doof::json_is_null(${jsonExpr}) ? ${emitType(type, ctx.module.path)}{nullptr} : ${emitDeserializeExpr(jsonExpr, inner, ctx, lenientExpr, carrier)})`;
         }
-        return `(doof::json_is_null(${jsonExpr}) ? ${emitType(type, ctx.module.path)}{std::nullopt} : ${emitType(type, ctx.module.path)}{${emitDeserializeExpr(jsonExpr, inner, ctx, lenientExpr)}})`;
+        return `(doof::json_is_null(${jsonExpr}) ? ${emitType(type, ctx.module.path)}{std::nullopt} : ${emitType(type, ctx.module.path)}{${emitDeserializeExpr(jsonExpr, inner, ctx, lenientExpr, carrier)}})`;
       }
       throw new Error("General union JSON deserialization is not supported");
     }
@@ -383,7 +421,7 @@ export function emitToJSON(
 
   ctx.sourceLines.push("");
   ctx.sourceLines.push(`${memberInd}doof::JsonObject toJsonObject() const {`);
-  ctx.sourceLines.push(`${bodyInd}auto _j = std::make_shared<doof::ordered_map<std::string, doof::JsonValue>>();`);
+  ctx.sourceLines.push(`${bodyInd}auto _j = std::make_shared<doof::ordered_map<${emitStringType()}, doof::JsonValue>>();`);
 
   for (const field of decl.fields) {
     if (field.static_) continue;
@@ -408,17 +446,18 @@ export function emitFromJSON(
   decl: ClassDeclaration,
   cppName: string,
   ctx: EmitContext,
+  carrier: JsonCarrier = "value",
 ): void {
   const memberInd = indent({ indent: ctx.indent + 1 });
   const bodyInd = indent({ indent: ctx.indent + 2 });
   const isValueObject = decl.storage === "value";
   const resultValueType = isValueObject ? cppName : `std::shared_ptr<${cppName}>`;
-  const resultType = `doof::Result<${resultValueType}, std::string>`;
+  const resultType = `doof::Result<${resultValueType}, ${emitStringType()}>`;
   const successType = `doof::Success<${resultValueType}>`;
-  const failureType = "doof::Failure<std::string>";
+  const failureType = `doof::Failure<${emitStringType()}>`;
 
   ctx.sourceLines.push("");
-  ctx.sourceLines.push(`${memberInd}static ${resultType} fromJsonValue(const doof::JsonValue& _j, bool _lenient = false) {`);
+  ctx.sourceLines.push(`${memberInd}static ${resultType} fromJsonValue(const ${jsonCarrierType(carrier)}& _j, bool _lenient = false) {`);
   ctx.sourceLines.push(`${bodyInd}const auto* _obj = doof::json_as_object(_j);`);
   ctx.sourceLines.push(`${bodyInd}if (_obj == nullptr) {`);
   ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Expected JSON object"};`);
@@ -441,7 +480,7 @@ export function emitFromJSON(
       ctx.sourceLines.push(`${bodyInd}    if (!${emitJsonTypeCheck(`${iterName}->second`, fieldType, "_lenient")}) {`);
       ctx.sourceLines.push(`${bodyInd}        return ${failureType}{"Field \\"${constructorField.name}\\" expected ${jsonTypeName(fieldType)} but got " + std::string(doof::json_type_name(${iterName}->second))};`);
       ctx.sourceLines.push(`${bodyInd}    }`);
-      ctx.sourceLines.push(`${bodyInd}    _f_${safeName} = ${emitDeserializeExpr(`${iterName}->second`, fieldType, ctx, "_lenient")};`);
+      ctx.sourceLines.push(`${bodyInd}    _f_${safeName} = ${emitDeserializeExpr(`${iterName}->second`, fieldType, ctx, "_lenient", carrier)};`);
       ctx.sourceLines.push(`${bodyInd}} else {`);
       ctx.sourceLines.push(`${bodyInd}    _f_${safeName} = ${defaultValue};`);
       ctx.sourceLines.push(`${bodyInd}}`);
@@ -455,7 +494,7 @@ export function emitFromJSON(
     ctx.sourceLines.push(`${bodyInd}if (!${emitJsonTypeCheck(`${iterName}->second`, fieldType, "_lenient")}) {`);
     ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Field \\"${constructorField.name}\\" expected ${jsonTypeName(fieldType)} but got " + std::string(doof::json_type_name(${iterName}->second))};`);
     ctx.sourceLines.push(`${bodyInd}}`);
-    ctx.sourceLines.push(`${bodyInd}auto _f_${safeName} = ${emitDeserializeExpr(`${iterName}->second`, fieldType, ctx, "_lenient")};`);
+    ctx.sourceLines.push(`${bodyInd}auto _f_${safeName} = ${emitDeserializeExpr(`${iterName}->second`, fieldType, ctx, "_lenient", carrier)};`);
   }
 
   for (const field of decl.fields) {
@@ -494,6 +533,252 @@ export function emitFromJSON(
   ctx.sourceLines.push(`${memberInd}}`);
 }
 
+// ============================================================================
+// fromJsonText / fromJsonReader — streaming decode without a JsonValue tree
+// ============================================================================
+
+/** Nominal, array, and nullable-nominal/array fields are decoded in place; everything else is read as a scalar JsonValue. */
+function streamsFromReader(type: ResolvedType): boolean {
+  if (isJsonValueType(type)) return false;
+  switch (type.kind) {
+    case "class":
+    case "struct":
+    case "array":
+      return true;
+    case "union": {
+      const nonNull = type.types.filter((inner) => inner.kind !== "null");
+      return nonNull.length === 1 && type.types.length === 2 && streamsFromReader(nonNull[0]);
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * Emit statements that pull one value of `type` from `_reader` and hand the
+ * decoded C++ expression to `assign`. `expected` is the field-level mismatch
+ * prefix (`Field "x" expected number`); element-level values pass null and,
+ * like fromJsonValue, skip the shape check.
+ */
+function emitReaderDecode(
+  type: ResolvedType,
+  assign: (valueExpr: string) => string,
+  expected: string | null,
+  ctx: EmitContext,
+  ind: string,
+  depth: number,
+): string[] {
+  const failureType = `doof::Failure<${emitStringType()}>`;
+  const lines: string[] = [];
+
+  if (!streamsFromReader(type)) {
+    const valueName = `_v${depth}`;
+    lines.push(`${ind}auto ${valueName} = _reader.read_value();`);
+    lines.push(`${ind}if (_reader.failed()) {`);
+    lines.push(`${ind}    return ${failureType}{_reader.error()};`);
+    lines.push(`${ind}}`);
+    if (expected !== null) {
+      lines.push(`${ind}if (!${emitJsonTypeCheck(valueName, type, "_lenient")}) {`);
+      lines.push(`${ind}    return ${failureType}{"${expected} but got " + std::string(doof::json_type_name(${valueName}))};`);
+      lines.push(`${ind}}`);
+    }
+    lines.push(`${ind}${assign(emitDeserializeExpr(valueName, type, ctx, "_lenient"))}`);
+    return lines;
+  }
+
+  switch (type.kind) {
+    case "class":
+    case "struct": {
+      const resultName = `_r${depth}`;
+      if (expected !== null) {
+        lines.push(`${ind}if (_reader.peek() != doof::JsonToken::Object) {`);
+        lines.push(`${ind}    return ${failureType}{_reader.mismatch("${expected}")};`);
+        lines.push(`${ind}}`);
+      }
+      lines.push(`${ind}auto ${resultName} = ${emitClassCppName(type.symbol, ctx.module.path)}::fromJsonReader(_reader, _lenient);`);
+      lines.push(`${ind}if (!doof::is_success(${resultName})) {`);
+      lines.push(`${ind}    return ${failureType}{doof::failure_error(${resultName})};`);
+      lines.push(`${ind}}`);
+      lines.push(`${ind}${assign(`std::move(doof::success_value(${resultName}))`)}`);
+      return lines;
+    }
+
+    case "array": {
+      const vecName = `_vec${depth}`;
+      const message = expected !== null ? `"${expected}"` : `"Expected JSON array", false`;
+      lines.push(`${ind}if (_reader.peek() != doof::JsonToken::Array) {`);
+      lines.push(`${ind}    return ${failureType}{_reader.mismatch(${message})};`);
+      lines.push(`${ind}}`);
+      lines.push(`${ind}auto ${vecName} = std::make_shared<std::vector<${emitType(type.elementType, ctx.module.path)}>>();`);
+      lines.push(`${ind}_reader.begin_array();`);
+      lines.push(`${ind}while (_reader.next_element()) {`);
+      lines.push(...emitReaderDecode(
+        type.elementType,
+        (valueExpr) => `${vecName}->push_back(${valueExpr});`,
+        null,
+        ctx,
+        `${ind}    `,
+        depth + 1,
+      ));
+      lines.push(`${ind}}`);
+      lines.push(`${ind}if (_reader.failed()) {`);
+      lines.push(`${ind}    return ${failureType}{_reader.error()};`);
+      lines.push(`${ind}}`);
+      lines.push(`${ind}${assign(vecName)}`);
+      return lines;
+    }
+
+    case "union": {
+      const inner = type.types.find((member) => member.kind !== "null")!;
+      const cppType = emitType(type, ctx.module.path);
+      lines.push(`${ind}if (_reader.peek() == doof::JsonToken::Null) {`);
+      lines.push(`${ind}    _reader.read_null();`);
+      lines.push(`${ind}    ${assign(`${cppType}{${emitNullForType(type)}}`)}`);
+      lines.push(`${ind}} else {`);
+      lines.push(...emitReaderDecode(
+        inner,
+        (valueExpr) => assign(`${cppType}{${valueExpr}}`),
+        expected,
+        ctx,
+        `${ind}    `,
+        depth + 1,
+      ));
+      lines.push(`${ind}}`);
+      return lines;
+    }
+
+    default:
+      throw new Error(`Unsupported streaming JSON deserialization type "${type.kind}"`);
+  }
+}
+
+/**
+ * Generate fromJsonText() / fromJsonReader() for a class or struct.
+ *
+ * Decodes straight from JSON text into constructor fields, with the same
+ * field checks, lenient coercions and error messages as fromJsonValue().
+ */
+export function emitFromJSONText(
+  decl: ClassDeclaration,
+  cppName: string,
+  ctx: EmitContext,
+): void {
+  const memberInd = indent({ indent: ctx.indent + 1 });
+  const bodyInd = indent({ indent: ctx.indent + 2 });
+  const isValueObject = decl.storage === "value";
+  const resultValueType = isValueObject ? cppName : `std::shared_ptr<${cppName}>`;
+  const resultType = `doof::Result<${resultValueType}, ${emitStringType()}>`;
+  const successType = `doof::Success<${resultValueType}>`;
+  const failureType = `doof::Failure<${emitStringType()}>`;
+
+  ctx.sourceLines.push("");
+  ctx.sourceLines.push(`${memberInd}static ${resultType} fromJsonText(std::string_view _text, bool _lenient = false) {`);
+  ctx.sourceLines.push(`${bodyInd}doof::JsonReader _reader(_text);`);
+  ctx.sourceLines.push(`${bodyInd}auto _r = fromJsonReader(_reader, _lenient);`);
+  ctx.sourceLines.push(`${bodyInd}if (doof::is_success(_r) && !_reader.finish()) {`);
+  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{_reader.error()};`);
+  ctx.sourceLines.push(`${bodyInd}}`);
+  ctx.sourceLines.push(`${bodyInd}return _r;`);
+  ctx.sourceLines.push(`${memberInd}}`);
+
+  ctx.sourceLines.push("");
+  ctx.sourceLines.push(`${memberInd}static ${resultType} fromJsonReader(doof::JsonReader& _reader, bool _lenient = false) {`);
+  ctx.sourceLines.push(`${bodyInd}if (_reader.peek() != doof::JsonToken::Object) {`);
+  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{_reader.mismatch("Expected JSON object", false)};`);
+  ctx.sourceLines.push(`${bodyInd}}`);
+
+  const constructorFields = decl.fields
+    .filter((field) => !field.const_ && !field.static_ && field.resolvedType)
+    .flatMap((field) => field.names.map((name) => ({ name, field, type: field.resolvedType! })));
+
+  for (const { name, type } of constructorFields) {
+    ctx.sourceLines.push(`${bodyInd}std::optional<${emitType(type, ctx.module.path)}> _f_${emitIdentifierSafe(name)};`);
+  }
+
+  ctx.sourceLines.push(`${bodyInd}_reader.begin_object();`);
+  ctx.sourceLines.push(`${bodyInd}std::string_view _key;`);
+  ctx.sourceLines.push(`${bodyInd}while (_reader.next_key(_key)) {`);
+
+  const loopInd = `${bodyInd}    `;
+  const caseInd = `${loopInd}    `;
+  let keyword = "if";
+  for (const { name, type } of constructorFields) {
+    const safeName = emitIdentifierSafe(name);
+    ctx.sourceLines.push(`${loopInd}${keyword} (_key == "${name}") {`);
+    ctx.sourceLines.push(...emitReaderDecode(
+      type,
+      (valueExpr) => `_f_${safeName}.emplace(${valueExpr});`,
+      `Field \\"${name}\\" expected ${jsonTypeName(type)}`,
+      ctx,
+      caseInd,
+      0,
+    ));
+    keyword = "} else if";
+  }
+
+  for (const field of decl.fields) {
+    if (!field.const_ || !field.defaultValue) continue;
+    const literal = field.defaultValue;
+    if (literal.kind !== "string-literal" && literal.kind !== "int-literal") continue;
+    for (const fieldName of field.names) {
+      ctx.sourceLines.push(`${loopInd}${keyword} (_key == "${fieldName}") {`);
+      ctx.sourceLines.push(`${caseInd}auto _const = _reader.read_value();`);
+      ctx.sourceLines.push(`${caseInd}if (_reader.failed()) {`);
+      ctx.sourceLines.push(`${caseInd}    return ${failureType}{_reader.error()};`);
+      ctx.sourceLines.push(`${caseInd}}`);
+      if (literal.kind === "string-literal") {
+        const constValue = literal.parts
+          .filter((part): part is string => typeof part === "string")
+          .join("");
+        ctx.sourceLines.push(`${caseInd}if (doof::json_is_string(_const) && doof::json_as_string(_const) != "${constValue}") {`);
+        ctx.sourceLines.push(`${caseInd}    return ${failureType}{"Field \\"${fieldName}\\" must be \\"${constValue}\\" but got \\"" + doof::json_as_string(_const) + "\\""};`);
+        ctx.sourceLines.push(`${caseInd}}`);
+      } else {
+        const constValue = (literal as { value: number }).value;
+        ctx.sourceLines.push(`${caseInd}if (doof::json_is_number(_const) && doof::json_as_int(_const) != ${constValue}) {`);
+        ctx.sourceLines.push(`${caseInd}    return ${failureType}{"Field \\"${fieldName}\\" must be ${constValue}"};`);
+        ctx.sourceLines.push(`${caseInd}}`);
+      }
+      keyword = "} else if";
+    }
+  }
+
+  if (keyword === "if") {
+    ctx.sourceLines.push(`${loopInd}if (!_reader.skip_value()) {`);
+    ctx.sourceLines.push(`${loopInd}    break;`);
+    ctx.sourceLines.push(`${loopInd}}`);
+  } else {
+    ctx.sourceLines.push(`${loopInd}} else if (!_reader.skip_value()) {`);
+    ctx.sourceLines.push(`${loopInd}    break;`);
+    ctx.sourceLines.push(`${loopInd}}`);
+  }
+  ctx.sourceLines.push(`${bodyInd}}`);
+  ctx.sourceLines.push(`${bodyInd}if (_reader.failed()) {`);
+  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{_reader.error()};`);
+  ctx.sourceLines.push(`${bodyInd}}`);
+
+  for (const { name, field, type } of constructorFields) {
+    const safeName = emitIdentifierSafe(name);
+    if (field.defaultValue) {
+      const defaultValue = emitDefaultExpression(field.defaultValue, type, ctx.module.path);
+      ctx.sourceLines.push(`${bodyInd}if (!_f_${safeName}.has_value()) {`);
+      ctx.sourceLines.push(`${bodyInd}    _f_${safeName}.emplace(${defaultValue});`);
+      ctx.sourceLines.push(`${bodyInd}}`);
+      continue;
+    }
+    ctx.sourceLines.push(`${bodyInd}if (!_f_${safeName}.has_value()) {`);
+    ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Missing required field \\"${name}\\""};`);
+    ctx.sourceLines.push(`${bodyInd}}`);
+  }
+
+  const args = constructorFields.map(({ name }) => `std::move(*_f_${emitIdentifierSafe(name)})`).join(", ");
+  const constructed = isValueObject
+    ? (args ? `${cppName}(${args})` : `${cppName}{}`)
+    : `std::make_shared<${cppName}>(${args})`;
+  ctx.sourceLines.push(`${bodyInd}return ${successType}{${constructed}};`);
+  ctx.sourceLines.push(`${memberInd}}`);
+}
+
 // ============================================================================
 // Interface-level fromJsonValue dispatcher
 // ============================================================================
@@ -504,64 +789,70 @@ export function emitInterfaceFromJSON(
   _impls: ClassSymbol[],
   disc: { fieldName: string; valueMap: Map<string, ClassSymbol> },
   ctx: EmitContext,
+  withDocument = false,
 ): void {
+  emitDiscriminatedFromJSON(ifaceName, disc, ctx, withDocument);
+}
+
+/** Generate a free-function JsonValue dispatcher for type alias deserialization. */
+export function emitTypeAliasFromJSON(
+  aliasName: string,
+  disc: { fieldName: string; valueMap: Map<string, ClassSymbol> },
+  ctx: EmitContext,
+  withDocument = false,
+): void {
+  emitDiscriminatedFromJSON(aliasName, disc, ctx, withDocument);
+}
+
+/**
+ * Emit `<name>_fromJsonValue`, and with `withDocument` its JsonNode overload
+ * plus `<name>_fromJsonText`.  The discriminator has to be found before a
+ * variant can be chosen, so text is parsed into an arena JsonDocument rather
+ * than streamed; the document is released once the variant is decoded.
+ */
+function emitDiscriminatedFromJSON(
+  name: string,
+  disc: { fieldName: string; valueMap: Map<string, ClassSymbol> },
+  ctx: EmitContext,
+  withDocument: boolean,
+): void {
+  emitDiscriminatorDispatch(name, disc, "doof::JsonValue", ctx);
+  if (!withDocument) return;
+  emitDiscriminatorDispatch(name, disc, "doof::JsonNode", ctx);
+
   const ind = indent(ctx);
   const bodyInd = indent({ indent: ctx.indent + 1 });
-  const resultType = `doof::Result<${ifaceName}, std::string>`;
-  const successType = `doof::Success<${ifaceName}>`;
-  const failureType = "doof::Failure<std::string>";
-
   ctx.sourceLines.push("");
-  ctx.sourceLines.push(`${ind}inline ${resultType} ${ifaceName}_fromJsonValue(const doof::JsonValue& _j, bool _lenient = false) {`);
-  ctx.sourceLines.push(`${bodyInd}const auto* _obj = doof::json_as_object(_j);`);
-  ctx.sourceLines.push(`${bodyInd}if (_obj == nullptr) {`);
-  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Expected JSON object"};`);
-  ctx.sourceLines.push(`${bodyInd}}`);
-  ctx.sourceLines.push(`${bodyInd}auto _disc_it = _obj->find("${disc.fieldName}");`);
-  ctx.sourceLines.push(`${bodyInd}if (_disc_it == _obj->end() || !doof::json_is_string(_disc_it->second)) {`);
-  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Missing or invalid discriminator field \\"${disc.fieldName}\\""};`);
-  ctx.sourceLines.push(`${bodyInd}}`);
-  ctx.sourceLines.push(`${bodyInd}auto _disc = doof::json_as_string(_disc_it->second);`);
-
-  let first = true;
-  for (const [value, cls] of disc.valueMap.entries()) {
-    const keyword = first ? "if" : "} else if";
-    first = false;
-    ctx.sourceLines.push(`${bodyInd}${keyword} (_disc == "${value}") {`);
-    ctx.sourceLines.push(`${bodyInd}    auto _r = ${emitClassCppName(cls, ctx.module.path)}::fromJsonValue(_j, _lenient);`);
-    ctx.sourceLines.push(`${bodyInd}    if (doof::is_success(_r)) {`);
-    ctx.sourceLines.push(`${bodyInd}        return ${successType}{${ifaceName}(doof::success_value(_r))};`);
-    ctx.sourceLines.push(`${bodyInd}    } else {`);
-    ctx.sourceLines.push(`${bodyInd}        return ${failureType}{doof::failure_error(_r)};`);
-    ctx.sourceLines.push(`${bodyInd}    }`);
-  }
-  ctx.sourceLines.push(`${bodyInd}} else {`);
-  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Unknown ${disc.fieldName}: \\"" + _disc + "\\""};`);
+  ctx.sourceLines.push(`${ind}inline doof::Result<${name}, ${emitStringType()}> ${name}_fromJsonText(std::string_view _text, bool _lenient = false) {`);
+  ctx.sourceLines.push(`${bodyInd}auto _doc = doof::JsonDocument::parse_view(_text);`);
+  ctx.sourceLines.push(`${bodyInd}if (!doof::is_success(_doc)) {`);
+  ctx.sourceLines.push(`${bodyInd}    return doof::Failure<${emitStringType()}>{doof::failure_error(_doc)};`);
   ctx.sourceLines.push(`${bodyInd}}`);
+  ctx.sourceLines.push(`${bodyInd}return ${name}_fromJsonValue(doof::success_value(_doc).root(), _lenient);`);
   ctx.sourceLines.push(`${ind}}`);
 }
 
-/** Generate a free-function JsonValue dispatcher for type alias deserialization. */
-export function emitTypeAliasFromJSON(
-  aliasName: string,
+function emitDiscriminatorDispatch(
+  name: string,
   disc: { fieldName: string; valueMap: Map<string, ClassSymbol> },
+  carrier: string,
   ctx: EmitContext,
 ): void {
   const ind = indent(ctx);
   const bodyInd = indent({ indent: ctx.indent + 1 });
-  const resultType = `doof::Result<${aliasName}, std::string>`;
-  const successType = `doof::Success<${aliasName}>`;
-  const failureType = "doof::Failure<std::string>";
+  const resultType = `doof::Result<${name}, ${emitStringType()}>`;
+  const successType = `doof::Success<${name}>`;
+  const failureType = `doof::Failure<${emitStringType()}>`;
 
   ctx.sourceLines.push("");
-  ctx.sourceLines.push(`${ind}inline ${resultType} ${aliasName}_fromJsonValue(const doof::JsonValue& _j, bool _lenient = false) {`);
+  ctx.sourceLines.push(`${ind}inline ${resultType} ${name}_fromJsonValue(const ${carrier}& _j, bool _lenient = false) {`);
   ctx.sourceLines.push(`${bodyInd}const auto* _obj = doof::json_as_object(_j);`);
   ctx.sourceLines.push(`${bodyInd}if (_obj == nullptr) {`);
   ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Expected JSON object"};`);
   ctx.sourceLines.push(`${bodyInd}}`);
   ctx.sourceLines.push(`${bodyInd}auto _disc_it = _obj->find("${disc.fieldName}");`);
   ctx.sourceLines.push(`${bodyInd}if (_disc_it == _obj->end() || !doof::json_is_string(_disc_it->second)) {`);
-  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Missing or invalid discriminator field \\\"${disc.fieldName}\\\""};`);
+  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Missing or invalid discriminator field \\"${disc.fieldName}\\""};`);
   ctx.sourceLines.push(`${bodyInd}}`);
   ctx.sourceLines.push(`${bodyInd}auto _disc = doof::json_as_string(_disc_it->second);`);
 
@@ -572,13 +863,13 @@ export function emitTypeAliasFromJSON(
     ctx.sourceLines.push(`${bodyInd}${keyword} (_disc == "${value}") {`);
     ctx.sourceLines.push(`${bodyInd}    auto _r = ${emitClassCppName(cls, ctx.module.path)}::fromJsonValue(_j, _lenient);`);
     ctx.sourceLines.push(`${bodyInd}    if (doof::is_success(_r)) {`);
-    ctx.sourceLines.push(`${bodyInd}        return ${successType}{${aliasName}(doof::success_value(_r))};`);
+    ctx.sourceLines.push(`${bodyInd}        return ${successType}{${name}(doof::success_value(_r))};`);
     ctx.sourceLines.push(`${bodyInd}    } else {`);
     ctx.sourceLines.push(`${bodyInd}        return ${failureType}{doof::failure_error(_r)};`);
     ctx.sourceLines.push(`${bodyInd}    }`);
   }
   ctx.sourceLines.push(`${bodyInd}} else {`);
-  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Unknown ${disc.fieldName}: \\\"" + _disc + "\\\""};`);
+  ctx.sourceLines.push(`${bodyInd}    return ${failureType}{"Unknown ${disc.fieldName}: \\"" + _disc + "\\""};`);
   ctx.sourceLines.push(`${bodyInd}}`);
   ctx.sourceLines.push(`${ind}}`);
 }
@@ -16,7 +16,7 @@ import type { Statement } from "./ast.js";
 import { getResultShape, isJsonValueType, type ResolvedType } from "./checker-types.js";
 import { emitDefaultExpression } from "./emitter-defaults.js";
 import { indent, emitIdentifierSafe } from "./emitter-expr.js";
-import { emitType } from "./emitter-types.js";
+import { emitStringType, emitType } from "./emitter-types.js";
 import {
   emitSerializeExpr,
   emitDeserializeExpr,
@@ -281,7 +281,7 @@ function emitJsonLiteralValue(value: unknown): string {
 
   if (isPlainJsonObject(value)) {
     const entries = Object.entries(value).map(([key, inner]) => `{"${escapeStringLiteral(key)}", ${emitJsonLiteralValue(inner)}}`);
-    return `doof::json_value(std::make_shared<doof::ordered_map<std::string, doof::JsonValue>>(doof::ordered_map<std::string, doof::JsonValue>{${entries.join(", ")}}))`;
+    return `doof::json_value(std::make_shared<doof::ordered_map<${emitStringType()}, doof::JsonValue>>(doof::ordered_map<${emitStringType()}, doof::JsonValue>{${entries.join(", ")}}))`;
   }
 
   throw new Error(`Unsupported metadata JSON literal: ${String(value)}`);
@@ -33,15 +33,24 @@ import type {
 } from "./ast.js";
 import type { ModuleSymbolTable, ClassSymbol, StructSymbol, ModuleSymbol } from "./types.js";
 import { classDeclarationHasStreamShape, findSharedDiscriminator, getResultShape, isAssignableTo, isJSONSerializable, isJsonValueType, isStreamSensitiveType, substituteTypeParams, typeContainsTypeVar, type ResolvedType } from "./checker-types.js";
-import type { EmitContext } from "./emitter-context.js";
-import { emitStatement, emitBlockStatements, isConstexprValue } from "./emitter-stmt.js";
+import { beginRuntimeFeatureUse, currentRuntimeFeatureUse, type EmitContext } from "./emitter-context.js";
+import { COVERAGE_BITMAP_NAME, emitStatement, emitBlockStatements, isConstexprValue } from "./emitter-stmt.js";
 import { emitExpression, indent, emitIdentifierSafe, scanCapturedMutables } from "./emitter-expr.js";
-import { emitClassCppName, emitClassForwardDeclName, emitClassSharedPtrType, emitLocalClassCppName, emitPrivateClassCppName, emitType, emitInnerType, mangleTypeForCppName } from "./emitter-types.js";
+import { findStackAllocatedLocals } from "./emitter-escape.js";
+import { findLastUseMoves } from "./emitter-moves.js";
+import { getBorrowedCallbackParams } from "./emitter-expr-lambda.js";
+import type { StringRepresentation } from "./package-artifacts.js";
+import { emitBorrowedCallbackType, emitClassCppName, emitClassForwardDeclName, emitClassSharedPtrType, emitLocalClassCppName, emitPrivateClassCppName, emitStringType, emitType, emitInnerType, mangleTypeForCppName, setStringRepresentation } from "./emitter-types.js";
 import { assignModuleNamespaces, emitModuleNamespace, emitQualifiedHelperName, emitQualifiedSymbolName } from "./emitter-names.js";
 import { buildGenericFunctionKey, buildMonomorphizedFunctionName, functionDeclIsStreamSensitive } from "./emitter-monomorphize.js";
 import { emitClassMethodDefinitions } from "./emitter-decl.js";
 import { canEmitDefaultExpressionInHeader, emitDefaultExpression } from "./emitter-defaults.js";
-import { generateRuntimeHeader } from "./emitter-runtime.js";
+import {
+  generateRuntimeActorsHeader,
+  generateRuntimeHeader,
+  includeRuntimeFeatureHeaders,
+  RUNTIME_CORE_HEADER_FILE,
+} from "./emitter-runtime.js";
 import {
   emitDeserializeExpr,
   emitJsonTypeCheck,
@@ -51,6 +60,7 @@ import {
   jsonTypeName,
   propagateJsonDemand,
 } from "./emitter-json.js";
+import { emitProfileScope } from "./emitter-panic.js";
 import { propagateMetadataDemand } from "./emitter-metadata.js";
 import type { ResolvedDoofBuildTarget } from "./build-targets.js";
 import { createIOSAppSupportFiles } from "./ios-app-support.js";
@@ -60,7 +70,7 @@ import { getBundledStdlibSupportFiles } from "./stdlib.js";
 type NominalObjectSymbol = ClassSymbol | StructSymbol;
 import { BUNDLED_STDLIB_ROOT } from "./stdlib-constants.js";
 import { relativeFsPath, toPortablePath } from "./path-utils.js";
-import { emitStreamNextHelperName, emitStreamValueHelperName } from "./emitter-expr-utils.js";
+import { emitStreamNextHelperName, emitStreamPullHelperName, emitStreamValueHelperName } from "./emitter-expr-utils.js";
 
 // ============================================================================
 // Public types
@@ -93,7 +103,7 @@ export interface ProjectCopiedFile {
 
 /** Per-module coverage metadata returned alongside emitted C++ when coverage is enabled. */
 export interface CoverageModuleMetadata {
-  /** Stable integer ID used in emitted doof::coverage::cov_mark() calls. */
+  /** Stable integer ID passed to the module's emitted doof::coverage::ModuleBitmap. */
   moduleId: number;
   /** Absolute path of the Doof source file. */
   modulePath: string;
@@ -104,8 +114,10 @@ export interface CoverageModuleMetadata {
 export interface ProjectEmitResult {
   /** All module .hpp/.cpp pairs. */
   modules: ModuleEmitResult[];
-  /** doof_runtime.hpp content. */
+  /** doof_runtime_core.hpp content: the runtime every generated module includes. */
   runtime: string;
+  /** doof_runtime_actors.hpp content: actors, promises and parallel algorithms. */
+  runtimeActors: string;
   /** Additional generated support files. */
   supportFiles: ProjectSupportFile[];
   /** Native package files or trees copied into the output directory. */
@@ -128,12 +140,16 @@ export interface ProjectBuildMetadata {
   outputBinaryName?: string;
   buildTarget?: ResolvedDoofBuildTarget | null;
   packageOutputPaths?: PackageOutputPaths;
-  /** When true, emit doof::coverage::cov_mark() calls and populate coverageModules in the result. */
+  /** When true, emit per-module coverage bitmap marks and populate coverageModules in the result. */
   coverage?: boolean;
   /** When true, emit class create/dispose counter increments. */
   metricsClassLifecycle?: boolean;
   /** When true, start the local observer server from the generated entry point. */
   observe?: boolean;
+  /** When true, open a DOOF_PROFILE_SCOPE span at the top of every function in the .cpp files. */
+  profile?: boolean;
+  /** C++ representation of Doof `string`, from doof.json `build.strings`. Defaults to "std". */
+  strings?: StringRepresentation;
 }
 
 export interface NativeBuildOptions {
@@ -263,6 +279,7 @@ export function emitModuleSplit(
   coverageModuleId?: number,
   metricsClassLifecycle = false,
   observe = false,
+  profile = false,
 ): ModuleEmitResult {
   const table = analysisResult.modules.get(modulePath);
   if (!table) {
@@ -306,6 +323,7 @@ export function emitModuleSplit(
     coverageModuleId,
     metricsClassLifecycle,
     observe,
+    profile,
   );
 
   return {
@@ -332,6 +350,19 @@ export function emitProject(
   entryPath: string,
   analysisResult: AnalysisResult,
   buildMetadata: ProjectBuildMetadata = {},
+): ProjectEmitResult {
+  setStringRepresentation(buildMetadata.strings ?? "std");
+  try {
+    return emitProjectFiles(entryPath, analysisResult, buildMetadata);
+  } finally {
+    setStringRepresentation("std");
+  }
+}
+
+function emitProjectFiles(
+  entryPath: string,
+  analysisResult: AnalysisResult,
+  buildMetadata: ProjectBuildMetadata,
 ): ProjectEmitResult {
   // Propagate on-demand JSON flags before emission
   propagateJsonDemand(analysisResult);
@@ -370,6 +401,7 @@ export function emitProject(
       coverageModuleIdMap.get(modPath),
       buildMetadata.metricsClassLifecycle ?? false,
       buildMetadata.observe ?? false,
+      buildMetadata.profile ?? false,
     ));
   }
 
@@ -402,7 +434,11 @@ export function emitProject(
 
   return {
     modules,
-    runtime: generateRuntimeHeader({ observe: buildMetadata.observe ?? false }),
+    runtime: generateRuntimeHeader({
+      observe: buildMetadata.observe ?? false,
+      sharedStrings: buildMetadata.strings === "shared",
+    }),
+    runtimeActors: generateRuntimeActorsHeader(),
     supportFiles,
     outputNativeCopies: [],
     outputNativeIncludePaths: [],
@@ -567,11 +603,12 @@ function emitWasmSupportSource(
     throw new Error(`Module not found: ${entryPath}`);
   }
 
+  const runtimeFeatures = beginRuntimeFeatureUse();
   const interfaceImpls = buildInterfaceImplMap(analysisResult);
   const monomorphizedFunctions = collectDirectStreamFunctionInstantiations(analysisResult);
   const lines: string[] = [
     `#include "${modulePathToInclude(entryPath, baseDir, packageOutputPaths)}"`,
-    '#include "doof_runtime.hpp"',
+    `#include "${RUNTIME_CORE_HEADER_FILE}"`,
     '#include "__doof_stdlib__/std/json/native_json.hpp"',
     "#include <cstring>",
     "",
@@ -584,8 +621,8 @@ function emitWasmSupportSource(
     "    return out;",
     "}",
     "",
-    "doof::JsonValue __doof_wasm_object(std::initializer_list<std::pair<std::string, doof::JsonValue>> values) {",
-    "    return doof::json_value(std::make_shared<doof::ordered_map<std::string, doof::JsonValue>>(values));",
+    "doof::JsonValue __doof_wasm_object(std::initializer_list<std::pair<doof::string, doof::JsonValue>> values) {",
+    "    return doof::json_value(std::make_shared<doof::ordered_map<doof::string, doof::JsonValue>>(values));",
     "}",
     "",
     "char* __doof_wasm_success(const doof::JsonValue& value) {",
@@ -633,7 +670,7 @@ function emitWasmSupportSource(
   while (lines.length > 0 && lines[lines.length - 1].trim() === "") {
     lines.pop();
   }
-  return lines.join("\n") + "\n";
+  return includeRuntimeFeatureHeaders(lines.join("\n") + "\n", runtimeFeatures);
 }
 
 function emitWasmExportWrapper(
@@ -1913,6 +1950,7 @@ function emitHpp(
   packageOutputPaths?: PackageOutputPaths,
   metricsClassLifecycle = false,
 ): string {
+  const runtimeFeatures = beginRuntimeFeatureUse();
   const plan = buildHeaderPlan(
     table,
     analysisResult,
@@ -1936,7 +1974,7 @@ function emitHpp(
 
   // Inline template bodies, generated aliases, Result/JsonValue surfaces, and
   // default values all rely on runtime support types from this header.
-  lines.push(`#include "doof_runtime.hpp"`);
+  lines.push(`#include "${RUNTIME_CORE_HEADER_FILE}"`);
   lines.push("");
 
   if (plan.crossModuleForwardDecls.length > 0) {
@@ -2126,7 +2164,7 @@ function emitHpp(
     const disc = findSharedDiscriminator(impls);
     if (!disc) continue;
     const ctx = makeHeaderCtx(table, analysisResult, interfaceImpls, monomorphizedFunctions);
-    emitInterfaceFromJSON(emitIdentifierSafe(iface.decl.name), impls, disc, ctx);
+    emitInterfaceFromJSON(emitIdentifierSafe(iface.decl.name), impls, disc, ctx, iface.decl.needsJsonDocument === true);
     lines.push(...ctx.sourceLines);
     lines.push("");
   }
@@ -2140,7 +2178,7 @@ function emitHpp(
     const disc = findSharedDiscriminator(members);
     if (!disc) continue;
     const ctx = makeHeaderCtx(table, analysisResult, interfaceImpls, monomorphizedFunctions);
-    emitTypeAliasFromJSON(emitIdentifierSafe(alias.decl.name), disc, ctx);
+    emitTypeAliasFromJSON(emitIdentifierSafe(alias.decl.name), disc, ctx, alias.decl.needsJsonDocument === true);
     lines.push(...ctx.sourceLines);
     lines.push("");
   }
@@ -2235,7 +2273,7 @@ function emitHpp(
     lines.pop();
   }
 
-  return lines.join("\n") + "\n";
+  return includeRuntimeFeatureHeaders(lines.join("\n") + "\n", runtimeFeatures);
 }
 
 // ============================================================================
@@ -2254,26 +2292,31 @@ function emitCppFile(
   coverageModuleId?: number,
   metricsClassLifecycle = false,
   observe = false,
+  profile = false,
 ): { code: string; instrumentedLines: Set<number> } {
+  const runtimeFeatures = beginRuntimeFeatureUse();
   const lines: string[] = [];
   const coverageInstrumentedLines = coverageModuleId !== undefined ? new Set<number>() : undefined;
   // Partial context fields to spread on every EmitContext created within this function.
   const covCtx = coverageModuleId !== undefined
     ? { coverageEnabled: true as const, coverageModuleId, coverageInstrumentedLines }
     : {};
-  const instrumentationCtx = metricsClassLifecycle
-    ? { ...covCtx, metricsClassLifecycle: true as const }
-    : covCtx;
+  const instrumentationCtx = {
+    ...covCtx,
+    ...(metricsClassLifecycle ? { metricsClassLifecycle: true as const } : {}),
+    ...(profile ? { profileSpans: true as const } : {}),
+  };
   const { hppName } = modulePathToCppNames(table.path, baseDir, packageOutputPaths);
     const streamAliases = buildStreamImplMap(analysisResult, monomorphizedClasses);
 
   // Include own header and runtime
   lines.push(`#include "${hppName}"`);
-  lines.push(`#include "doof_runtime.hpp"`);
+  lines.push(`#include "${RUNTIME_CORE_HEADER_FILE}"`);
   for (const dependencyModule of collectCppReferencedModulePaths(table, analysisResult, monomorphizedClasses, interfaceImpls)) {
     lines.push(`#include "${modulePathToIncludeFromModule(table.path, dependencyModule, baseDir, packageOutputPaths)}"`);
   }
   lines.push("");
+  const coverageBitmapIndex = lines.length;
 
   const moduleNamespace = emitModuleNamespace(table.path, analysisResult.modules);
   const moduleNamespaceStart = lines.length;
@@ -2287,6 +2330,7 @@ function emitCppFile(
     if (!info) continue;
     emitStreamNextHelperDefinition(aliasName, info, lines);
     emitStreamValueHelperDefinition(aliasName, info, lines);
+    emitStreamPullHelperDefinition(aliasName, info, lines);
   }
   if (streamTypesForModule.length > 0) {
     lines.push("");
@@ -2490,7 +2534,18 @@ function emitCppFile(
     lines.pop();
   }
 
-  return { code: lines.join("\n") + "\n", instrumentedLines: coverageInstrumentedLines ?? new Set<number>() };
+  // The bitmap is sized by the highest marked line, so it is declared last.
+  if (coverageModuleId !== undefined && coverageInstrumentedLines && coverageInstrumentedLines.size > 0) {
+    const lastLine = Math.max(...coverageInstrumentedLines);
+    lines.splice(
+      coverageBitmapIndex,
+      0,
+      `static doof::coverage::ModuleBitmap<${lastLine}> ${COVERAGE_BITMAP_NAME}(${coverageModuleId});`,
+      "",
+    );
+  }
+
+  return { code: includeRuntimeFeatureHeaders(lines.join("\n") + "\n", runtimeFeatures), instrumentedLines: coverageInstrumentedLines ?? new Set<number>() };
 }
 
 function emitCppOnlyClassDeclarations(
@@ -2627,8 +2682,11 @@ function emitDoofMainFunction(
   // Emit doof_main function body
   if (mainDecl.body.kind === "block") {
     lines.push(`${retType} doof_main(${params}) {`);
+    if (ctx.profileSpans) lines.push(`    ${emitProfileScope(mainDecl.name, ctx)}`);
     const paramNameSet = new Set(mainDecl.params.map((p) => p.name));
     const capturedMutables = scanCapturedMutables(mainDecl.body, paramNameSet);
+    const lastUseMoves = findLastUseMoves(mainDecl, capturedMutables);
+    const stackAllocatedLocals = findStackAllocatedLocals(mainDecl, capturedMutables);
     emitBlockStatements(mainDecl.body, {
       ...ctx,
       indent: 1,
@@ -2637,6 +2695,8 @@ function emitDoofMainFunction(
         ? mainDecl.resolvedType.returnType
         : undefined,
       capturedMutables: capturedMutables.size > 0 ? capturedMutables : undefined,
+      lastUseMoves: lastUseMoves.size > 0 ? lastUseMoves : undefined,
+      stackAllocatedLocals: stackAllocatedLocals.size > 0 ? stackAllocatedLocals : undefined,
     });
     lines.push(...ctx.sourceLines);
     lines.push("}");
@@ -2646,6 +2706,7 @@ function emitDoofMainFunction(
       currentCallableName: mainDecl.name,
     });
     lines.push(`${retType} doof_main(${params}) {`);
+    if (ctx.profileSpans) lines.push(`    ${emitProfileScope(mainDecl.name, ctx)}`);
     lines.push(`    return ${body};`);
     lines.push("}");
   }
@@ -2688,8 +2749,8 @@ function emitExternCMainEntryWrapper(
 
   if (hasArgs) {
     lines.push("    auto args = argc > 1 && argv != nullptr");
-    lines.push("        ? std::make_shared<std::vector<std::string>>(argv + 1, argv + argc)");
-    lines.push("        : std::make_shared<std::vector<std::string>>();");
+    lines.push(`        ? std::make_shared<std::vector<${emitStringType()}>>(argv + 1, argv + argc)`);
+    lines.push(`        : std::make_shared<std::vector<${emitStringType()}>>();`);
     if (returnsInt) {
       lines.push(`    return static_cast<int>(${emitQualifiedHelperName(table.path, "doof_main", analysisResult.modules)}(args));`);
     } else {
@@ -2916,6 +2977,7 @@ function emitFunctionSignature(
   const retType = resolvedType && resolvedType.kind === "function"
     ? emitType(resolvedType.returnType, currentModulePath)
     : "auto";
+  const borrowed = getBorrowedCallbackParams(decl);
   const params = decl.params
     .map((p, index) => emitParamSignature(
       p,
@@ -2925,6 +2987,7 @@ function emitFunctionSignature(
       includeDefaults,
       currentModulePath,
       headerSafeDefaultsOnly,
+      borrowed.has(p.name),
     ))
     .join(", ");
   return `${retType} ${name}(${params})`;
@@ -2938,11 +3001,14 @@ function emitParamSignature(
   includeDefault = true,
   currentModulePath?: string,
   headerSafeDefaultsOnly = false,
+  borrowed = false,
 ): string {
   const resolvedType = param.resolvedType && typeSubstitution
     ? substituteTypeParams(param.resolvedType, typeSubstitution)
     : param.resolvedType;
-  const pType = resolvedType ? emitType(resolvedType, currentModulePath) : "auto";
+  const pType = !resolvedType ? "auto"
+    : borrowed && resolvedType.kind === "function" ? emitBorrowedCallbackType(resolvedType, currentModulePath)
+      : emitType(resolvedType, currentModulePath);
   const name = emitIdentifierSafe(param.name);
   if (shouldEmitSignatureDefault(params, index, includeDefault, headerSafeDefaultsOnly) && param.defaultValue) {
     const defaultVal = emitDefaultExpression(param.defaultValue, resolvedType ?? undefined, currentModulePath);
@@ -3098,6 +3164,7 @@ function emitStreamAliasHpp(
     .join(", ");
   const nextHelperName = emitStreamNextHelperName(aliasName);
   const valueHelperName = emitStreamValueHelperName(aliasName);
+  const pullHelperName = emitStreamPullHelperName(aliasName);
   const valueType = emitType(streamType.elementType);
   lines.push(`#ifndef ${guardName}`);
   lines.push(`#define ${guardName}`);
@@ -3106,6 +3173,7 @@ function emitStreamAliasHpp(
     lines.push(`using ${aliasName} = std::variant<std::monostate>;`);
     lines.push(`inline bool ${nextHelperName}(const ${aliasName}&) { return false; }`);
     lines.push(`inline ${valueType} ${valueHelperName}(const ${aliasName}&) { doof::panic("Stream alias ${aliasName} has no implementing classes in this build"); }`);
+    lines.push(`inline bool ${pullHelperName}(const ${aliasName}&, std::optional<${valueType}>&) { return false; }`);
     lines.push(`#endif`);
     return;
   }
@@ -3113,6 +3181,7 @@ function emitStreamAliasHpp(
   lines.push(`using ${aliasName} = std::variant<${variants}>;`);
   lines.push(`bool ${nextHelperName}(const ${aliasName}& stream);`);
   lines.push(`${valueType} ${valueHelperName}(const ${aliasName}& stream);`);
+  lines.push(`bool ${pullHelperName}(const ${aliasName}& stream, std::optional<${valueType}>& slot);`);
   lines.push(`#endif`);
 }
 
@@ -3141,6 +3210,26 @@ function emitStreamValueHelperDefinition(
   lines.push("");
 }
 
+// for-of pulls each element through one visit: the arm calls next() and
+// value() on the concrete class, so both can inline instead of dispatching
+// through the variant twice.
+function emitStreamPullHelperDefinition(
+  aliasName: string,
+  aliasInfo: StreamAliasInfo,
+  lines: string[],
+): void {
+  const helperName = emitStreamPullHelperName(aliasName);
+  const valueType = emitType(aliasInfo.streamType.elementType);
+  lines.push(`bool ${helperName}(const ${aliasName}& stream, std::optional<${valueType}>& slot) {`);
+  lines.push(`    return std::visit([&](auto&& _obj) {`);
+  lines.push(`        if (!_obj->next()) return false;`);
+  lines.push(`        slot.emplace(_obj->value());`);
+  lines.push(`        return true;`);
+  lines.push(`    }, stream);`);
+  lines.push("}");
+  lines.push("");
+}
+
 function canModuleDefineStreamHelper(
   aliasInfo: StreamAliasInfo,
   table: ModuleSymbolTable,
@@ -5294,6 +5383,7 @@ function makeHeaderCtx(
     emitParameterDefaults: true,
     emitHeaderSafeParameterDefaultsOnly: true,
     monomorphizedFunctionNames: new Map([...monomorphizedFunctions.entries()].map(([key, inst]) => [key, inst.emittedName])),
+    runtimeFeatures: currentRuntimeFeatureUse(),
     emitBlock: makeBlockHelper(table, analysisResult, interfaceImpls),
   };
 }
@@ -5315,6 +5405,7 @@ function makeCppCtx(
     inClass: false,
     emitParameterDefaults: true,
     monomorphizedFunctionNames: new Map([...monomorphizedFunctions.entries()].map(([key, inst]) => [key, inst.emittedName])),
+    runtimeFeatures: currentRuntimeFeatureUse(),
     emitBlock: makeBlockHelper(table, analysisResult, interfaceImpls),
   };
 }
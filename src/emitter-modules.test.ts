@@ -55,7 +55,7 @@ describe("emitter-module — hpp/cpp split", () => {
     const { cppCode } = emitSplit(`
       export function add(a: int, b: int): int => a + b
     `);
-    expect(cppCode).toContain('#include "doof_runtime.hpp"');
+    expect(cppCode).toContain('#include "doof_runtime_core.hpp"');
   });
 
   it("cpp has function implementation", () => {
@@ -363,6 +363,7 @@ describe("emitter-module — hpp/cpp split", () => {
     expect(streamModule!.cppCode).toContain("bool __doof_stream_next___doof_stream_int(const __doof_stream_int& stream)");
     expect(streamModule!.cppCode).toContain("int32_t __doof_stream_value___doof_stream_int(const __doof_stream_int& stream)");
     expect(streamModule!.hppCode).toContain("bool __doof_stream_next___doof_stream_int(const __doof_stream_int& stream);");
+    expect(streamModule!.hppCode).toContain("bool __doof_stream_pull___doof_stream_int(const __doof_stream_int& stream, std::optional<int32_t>& slot);");
   });
 
   it("does not leak unrelated stream aliases into imported headers", () => {
@@ -1440,7 +1441,7 @@ describe("emitter-module — multi-module hpp includes", () => {
     };
 
     expectBefore("#pragma once", "#include <cstdint>");
-    expectBefore('#include "doof_runtime.hpp"', '#include "native_thing.hpp"');
+    expectBefore('#include "doof_runtime_core.hpp"', '#include "native_thing.hpp"');
     expectBefore(`namespace ${emitModuleNamespace("/dep.do")} {`, '#include "native_thing.hpp"');
     expectBefore('#include "native_thing.hpp"', '#include "status.hpp"');
     expectBefore('#include "status.hpp"', "struct __doof_private_main_Impl :");
@@ -1912,7 +1913,7 @@ describe("emitter-module — emitProject", () => {
     const { hppCode } = emitSplit(`
       export class Point { x: int; y: int }
     `);
-    expect(hppCode).toContain('#include "doof_runtime.hpp"');
+    expect(hppCode).toContain('#include "doof_runtime_core.hpp"');
   });
 
   it("hpp relies on doof runtime when JSON is used", () => {
@@ -1920,7 +1921,7 @@ describe("emitter-module — emitProject", () => {
       export class Point { x: int; y: int }
       function test(p: Point): JsonObject => p.toJsonObject()
     `);
-    expect(hppCode).toContain('#include "doof_runtime.hpp"');
+    expect(hppCode).toContain('#include "doof_runtime_core.hpp"');
   });
 
   it("hpp includes imported nested class definitions for generated JSON", () => {
@@ -2009,7 +2010,7 @@ describe("emitter-module — function signature with defaults", () => {
     expect(hppCode).not.toContain("Transform::identity()");
     expect(hppCode).toContain(`Model(std::shared_ptr<::${transformNamespace}::Transform> transform)`);
     expect(hppCode).toContain(`int32_t valueOf(std::shared_ptr<::${transformNamespace}::Transform> transform);`);
-    expect(cppCode).toContain(`std::make_shared<Model>(::${transformNamespace}::Transform::identity())`);
+    expect(cppCode).toContain(`Model _stack_model(::${transformNamespace}::Transform::identity());`);
     expect(cppCode).toContain(`valueOf(::${transformNamespace}::Transform::identity())`);
   });
 
@@ -2607,6 +2608,43 @@ describe("Concurrency", () => {
     expect(cpp).toContain("std::make_shared<doof::Actor<Counter>>(0)");
   });
 
+  it("includes the actors runtime header only in modules that use actors", () => {
+    const withActor = emitSplit(`
+      class Worker { value: int }
+      export function start(): Actor<Worker> {
+        return Actor<Worker>(0)
+      }
+    `);
+    expect(withActor.hppCode).toContain('#include "doof_runtime_actors.hpp"');
+
+    const plain = emitSplit(`
+      export function add(a: int, b: int): int => a + b
+    `);
+    expect(plain.hppCode).not.toContain("doof_runtime_actors.hpp");
+    expect(plain.cppCode).not.toContain("doof_runtime_actors.hpp");
+  });
+
+  it("decides the actors runtime include from lowering, not emitted text", () => {
+    const chained = emitSplit(`
+      import function fetchCount(): Promise<int> from "fetch.hpp" as native::fetchCount
+      export function run(): void {
+        const doubled = fetchCount().continueWith((result: Result<int, string>): int => result.unwrapOr(0) * 2)
+      }
+    `);
+    expect(chained.cppCode).toContain('#include "doof_runtime_actors.hpp"');
+
+    const unrelatedPost = emitSplit(`
+      import class Mailer from "mailer.hpp" as native::Mailer {
+        post(text: string): void
+      }
+      export function send(mailer: Mailer): void {
+        mailer.post("hi")
+      }
+    `);
+    expect(unrelatedPost.hppCode).not.toContain("doof_runtime_actors.hpp");
+    expect(unrelatedPost.cppCode).not.toContain("doof_runtime_actors.hpp");
+  });
+
   it("emits Actor type annotation as shared_ptr<doof::Actor<T>>", () => {
     const cpp = emit(`
       class Worker { value: int }
@@ -2631,6 +2669,23 @@ describe("Concurrency", () => {
     expect(cpp).not.toContain("async_call");
   });
 
+  it("evaluates async call arguments at the call site and moves them into the message", () => {
+    const cpp = emit(`
+      class Worker {
+        value: int
+        compute(n: int, label: string): int { return value + n }
+      }
+      function next(): int => 7
+      function start(): Promise<int> {
+        const worker = Actor<Worker>(42)
+        return async worker.compute(next(), "x")
+      }
+    `);
+    expect(cpp).toMatch(/auto _async_(\d+)_a0 = next\(\); auto _async_\1_a1 = /);
+    expect(cpp).toMatch(/\[_async_(\d+)_a0 = std::move\(_async_\1_a0\), _async_\1_a1 = std::move\(_async_\1_a1\)\]\(Worker& _self\) mutable -> int32_t/);
+    expect(cpp).not.toContain("call_async<int32_t>([=]");
+  });
+
   it("emits retire actor expression", () => {
     const cpp = emit(`
       class Worker { value: int }
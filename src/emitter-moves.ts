@@ -0,0 +1,219 @@
+/**
+ * Last-use move insertion.
+ *
+ * Finds the reference to each parameter or mutable local that is provably its
+ * final use, so sink positions can emit `std::move(name)` instead of copying
+ * a string, struct, or shared container into its destination.
+ */
+
+import type { Block, Expression, FunctionDeclaration, Statement } from "./ast.js";
+import type { ResolvedType } from "./checker-types.js";
+import { walkExpression, walkStatementExpressions } from "./checker-stmt.js";
+import type { EmitContext } from "./emitter-context.js";
+import { emitExpression } from "./emitter-expr.js";
+import { emitIdentifierSafe } from "./emitter-expr-literals.js";
+
+interface Candidate {
+  name: string;
+  loopDepth: number;
+  references: Array<{ expr: Expression; root: Expression; loopDepth: number; nested: boolean }>;
+  excluded: boolean;
+}
+
+/** Types whose copies are as cheap as a move, so moving them gains nothing. */
+export function isTriviallyCopied(type: ResolvedType | undefined): boolean {
+  if (!type) return true;
+  switch (type.kind) {
+    case "primitive":
+      return type.name !== "string";
+    case "enum":
+    case "null":
+    case "void":
+    case "unknown":
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Scan a function body for last uses of movable bindings.  A reference is a
+ * last use when it is the textually final reference to its binding, sits in
+ * no loop the declaration is not also in, is the only reference in its
+ * statement (so argument evaluation order cannot observe the move), and is
+ * not inside a nested lambda, async call, or statement-bearing expression.
+ * Bindings captured by a lambda or named by a shorthand property are skipped.
+ */
+export function findLastUseMoves(
+  decl: FunctionDeclaration,
+  capturedMutables: ReadonlySet<string>,
+): Set<Expression> {
+  const result = new Set<Expression>();
+  if (decl.body.kind !== "block" || decl.bodyless) return result;
+
+  const candidates = new Map<number, Candidate>();
+  const shorthandNames = new Set<string>();
+  for (const param of decl.params) {
+    if (!isTriviallyCopied(param.resolvedType)) {
+      candidates.set(param.span.start.offset, { name: param.name, loopDepth: 0, references: [], excluded: false });
+    }
+  }
+
+  const scanRoot = (root: Expression, loopDepth: number): void => {
+    const nested = new Set<Expression>();
+    const captured = new Set<Expression>();
+    walkExpression(root, (expr) => {
+      switch (expr.kind) {
+        case "lambda-expression":
+        case "async-expression":
+          walkExpression(expr, (inner) => {
+            if (inner !== expr) captured.add(inner);
+          });
+          break;
+        case "yield-block-expression":
+        case "catch-expression":
+        case "case-expression":
+          walkExpression(expr, (inner) => {
+            if (inner !== expr) nested.add(inner);
+          });
+          break;
+        case "object-literal":
+          for (const prop of expr.properties) {
+            if (!prop.value) shorthandNames.add(prop.name);
+          }
+          break;
+        case "construct-expression":
+          if (expr.named) {
+            for (const prop of expr.args as import("./ast.js").ObjectProperty[]) {
+              if (!prop.value) shorthandNames.add(prop.name);
+            }
+          }
+          break;
+        case "identifier": {
+          const binding = expr.resolvedBinding;
+          if (binding?.kind !== "parameter" && binding?.kind !== "let" && binding?.kind !== "immutable-binding") break;
+          const candidate = candidates.get(binding.span.start.offset);
+          if (!candidate || candidate.name !== expr.name) break;
+          if (captured.has(expr)) candidate.excluded = true;
+          candidate.references.push({ expr, root, loopDepth, nested: nested.has(expr) });
+          break;
+        }
+        default:
+          break;
+      }
+    });
+  };
+
+  let supported = true;
+  const scanStatements = (stmts: readonly Statement[], loopDepth: number): void => {
+    for (const stmt of stmts) scanStatement(stmt, loopDepth);
+  };
+  const scanBlock = (block: Block | null, loopDepth: number): void => {
+    if (block) scanStatements(block.statements, loopDepth);
+  };
+  const scanStatement = (stmt: Statement, loopDepth: number): void => {
+    switch (stmt.kind) {
+      case "let-declaration":
+      case "immutable-binding":
+        scanRoot(stmt.value, loopDepth);
+        // `:=` locals are emitted `const` (so unmovable) except for structs.
+        if (
+          (stmt.kind === "let-declaration" || stmt.resolvedType?.kind === "struct")
+          && stmt.value.kind !== "catch-expression"
+          && !isTriviallyCopied(stmt.resolvedType)
+          && !capturedMutables.has(stmt.name)
+        ) {
+          candidates.set(stmt.span.start.offset, { name: stmt.name, loopDepth, references: [], excluded: false });
+        }
+        return;
+      case "if-statement":
+        scanRoot(stmt.condition, loopDepth);
+        scanBlock(stmt.body, loopDepth);
+        for (const elseIf of stmt.elseIfs) {
+          scanRoot(elseIf.condition, loopDepth);
+          scanBlock(elseIf.body, loopDepth);
+        }
+        scanBlock(stmt.else_, loopDepth);
+        return;
+      case "while-statement":
+        scanRoot(stmt.condition, loopDepth + 1);
+        scanBlock(stmt.body, loopDepth + 1);
+        scanBlock(stmt.then_, loopDepth);
+        return;
+      case "for-statement":
+        if (stmt.init) scanStatement(stmt.init, loopDepth);
+        if (stmt.condition) scanRoot(stmt.condition, loopDepth + 1);
+        for (const update of stmt.update) scanRoot(update, loopDepth + 1);
+        scanBlock(stmt.body, loopDepth + 1);
+        scanBlock(stmt.then_, loopDepth);
+        return;
+      case "for-of-statement":
+        scanRoot(stmt.iterable, loopDepth);
+        scanBlock(stmt.body, loopDepth + 1);
+        scanBlock(stmt.then_, loopDepth);
+        return;
+      case "with-statement":
+        for (const binding of stmt.bindings) scanRoot(binding.value, loopDepth);
+        scanBlock(stmt.body, loopDepth);
+        return;
+      case "case-statement":
+        scanRoot(stmt.subject, loopDepth);
+        for (const arm of stmt.arms) {
+          for (const pattern of arm.patterns) {
+            if (pattern.kind === "value-pattern") scanRoot(pattern.value, loopDepth);
+            if (pattern.kind === "range-pattern") {
+              if (pattern.start) scanRoot(pattern.start, loopDepth);
+              if (pattern.end) scanRoot(pattern.end, loopDepth);
+            }
+          }
+          if (arm.body.kind === "block") {
+            scanBlock(arm.body, loopDepth);
+          } else {
+            scanRoot(arm.body, loopDepth);
+          }
+        }
+        return;
+      case "else-narrow-statement":
+      case "result-else-statement":
+        scanRoot(stmt.subject, loopDepth);
+        scanBlock(stmt.elseBlock, loopDepth);
+        return;
+      case "block":
+        scanStatements(stmt.statements, loopDepth);
+        return;
+      case "function-declaration":
+      case "class-declaration":
+        // Nested declarations are not covered by the expression walk.
+        supported = false;
+        return;
+      default:
+        walkStatementExpressions(stmt, (root) => scanRoot(root, loopDepth));
+        return;
+    }
+  };
+  scanBlock(decl.body, 0);
+  if (!supported) return result;
+
+  for (const candidate of candidates.values()) {
+    if (candidate.excluded || shorthandNames.has(candidate.name) || candidate.references.length === 0) continue;
+    let last = candidate.references[0];
+    for (const reference of candidate.references) {
+      if (reference.expr.span.start.offset > last.expr.span.start.offset) last = reference;
+    }
+    if (last.nested || last.loopDepth !== candidate.loopDepth) continue;
+    if (candidate.references.some((reference) => reference !== last && reference.root === last.root)) continue;
+    result.add(last.expr);
+  }
+  return result;
+}
+
+/**
+ * Emit an expression in a sink position, moving it when it is the last use
+ * of a movable binding.  Narrowed or boxed references emit more than the bare
+ * name and are left as copies.
+ */
+export function emitMovableOperand(expr: Expression, ctx: EmitContext, targetType?: ResolvedType): string {
+  const text = emitExpression(expr, ctx, targetType);
+  if (expr.kind !== "identifier" || !ctx.lastUseMoves?.has(expr)) return text;
+  return text === emitIdentifierSafe(expr.name) ? `std::move(${text})` : text;
+}
@@ -44,6 +44,12 @@ export function emitPanicLocationArgs(span: SourceSpan, ctx: EmitContext): strin
   return `"${escapeCppString(fileName)}", ${span.start.line}`;
 }
 
+/** Profiler span opened at the top of a function body, labelled `module::callable`. */
+export function emitProfileScope(callableName: string, ctx: EmitContext): string {
+  const fileName = formatSourceModulePath(ctx.module.emittedDiagnosticPath ?? ctx.module.path, true);
+  return `DOOF_PROFILE_SCOPE("${escapeCppString(`${fileName}::${callableName}`)}");`;
+}
+
 export function emitPanicAt(messageExpr: string, span: SourceSpan, ctx: EmitContext): string {
   return `doof::panic_at(${emitPanicLocationArgs(span, ctx)}, ${messageExpr})`;
 }
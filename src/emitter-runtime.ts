@@ -1,35 +1,129 @@
 /**
  * Runtime support library content generation.
  *
- * Produces the contents of `doof_runtime.hpp` — a single C++ header
- * providing foundational types and utilities for transpiled Doof code.
+ * Produces the runtime headers for transpiled Doof code from the single
+ * checked-in template:
+ *
+ * - `doof_runtime_core.hpp` — foundational types and utilities that every
+ *   generated module includes
+ * - `doof_runtime_actors.hpp` — actors, promises and parallel algorithms, with
+ *   the `<future>` / `<thread>` includes they need; only modules that use them
+ *   include it
+ * - `doof_runtime.hpp` — the complete runtime, for hand-written native code
  */
 
-// ============================================================================
-// Public API
-// ============================================================================
-
-/**
- * Return the full contents of the doof_runtime.hpp header.
- */
+import { endRuntimeFeatureUse, type RuntimeFeatureUse } from "./emitter-context.js";
 import {
     buildObserverRuntimeSupport,
     loadObserverPlatformSupport,
     loadRuntimeHeader,
 } from "./runtime-assets.js";
 
+export const RUNTIME_HEADER_FILE = "doof_runtime.hpp";
+export const RUNTIME_CORE_HEADER_FILE = "doof_runtime_core.hpp";
+export const RUNTIME_ACTORS_HEADER_FILE = "doof_runtime_actors.hpp";
+
+// ============================================================================
+// Public API
+// ============================================================================
+
 export interface RuntimeHeaderOptions {
     observe?: boolean;
+    /** Define DOOF_SHARED_STRINGS so `doof::string` is the refcounted SharedString. */
+    sharedStrings?: boolean;
+}
+
+export interface RuntimeHeaderFile {
+    relativePath: string;
+    content: string;
 }
 
+/**
+ * Return the contents of the doof_runtime_core.hpp header.
+ */
 export function generateRuntimeHeader(options: RuntimeHeaderOptions = {}): string {
-    return RUNTIME_HEADER
-        .replace("/* __DOOF_OBSERVER_PLATFORM_SUPPORT__ */", options.observe ? loadObserverPlatformSupport() : "")
-        .replace("/* __DOOF_OBSERVER_RUNTIME_SUPPORT__ */", options.observe ? buildObserverRuntimeSupport() : "");
+    // The observer server runs on its own thread, so it brings <thread> back.
+    const platformSupport = options.observe ? `#include <thread>\n${loadObserverPlatformSupport()}` : "";
+    return RUNTIME_CORE_TEMPLATE
+        .replace("/* __DOOF_OBSERVER_PLATFORM_SUPPORT__ */", platformSupport)
+        .replace("/* __DOOF_OBSERVER_RUNTIME_SUPPORT__ */", options.observe ? buildObserverRuntimeSupport() : "")
+        .replace("/* __DOOF_STRING_REPRESENTATION__ */", options.sharedStrings ? "#define DOOF_SHARED_STRINGS 1" : "");
+}
+
+/**
+ * Return the contents of the doof_runtime_actors.hpp header.
+ */
+export function generateRuntimeActorsHeader(): string {
+    return [
+        "#pragma once",
+        "",
+        "// doof_runtime_actors.hpp — actors, promises and parallel algorithms",
+        "",
+        ...ACTOR_ONLY_INCLUDES,
+        "",
+        `#include "${RUNTIME_CORE_HEADER_FILE}"`,
+        "",
+        "namespace doof {",
+        "",
+        RUNTIME_ACTORS_SECTION,
+        "",
+        "} // namespace doof",
+        "",
+    ].join("\n");
+}
+
+/**
+ * All runtime header files of a project, in the order they should be written.
+ */
+export function runtimeHeaderFiles(project: { runtime: string; runtimeActors: string }): RuntimeHeaderFile[] {
+    return [
+        { relativePath: RUNTIME_CORE_HEADER_FILE, content: project.runtime },
+        { relativePath: RUNTIME_ACTORS_HEADER_FILE, content: project.runtimeActors },
+        { relativePath: RUNTIME_HEADER_FILE, content: RUNTIME_UMBRELLA_HEADER },
+    ];
+}
+
+/**
+ * Include the actors header after the core runtime include when the file's
+ * lowering used anything it defines, and close the file's record.
+ */
+export function includeRuntimeFeatureHeaders(code: string, features: RuntimeFeatureUse): string {
+    endRuntimeFeatureUse(features);
+    if (!features.actors) return code;
+    const coreInclude = `#include "${RUNTIME_CORE_HEADER_FILE}"`;
+    return code.replace(coreInclude, `${coreInclude}\n#include "${RUNTIME_ACTORS_HEADER_FILE}"`);
 }
 
 // ============================================================================
-// Observer-specific support layered onto the standalone header template
+// Template splitting
 // ============================================================================
 
-const RUNTIME_HEADER = loadRuntimeHeader();
+const ACTORS_BEGIN_MARKER = "/* __DOOF_RUNTIME_ACTORS_BEGIN__ */";
+const ACTORS_END_MARKER = "/* __DOOF_RUNTIME_ACTORS_END__ */";
+const ACTOR_ONLY_INCLUDES = ["#include <future>", "#include <thread>"];
+
+const RUNTIME_UMBRELLA_HEADER = [
+    "#pragma once",
+    "",
+    "// doof_runtime.hpp — complete Doof runtime for hand-written native code",
+    "",
+    `#include "${RUNTIME_CORE_HEADER_FILE}"`,
+    `#include "${RUNTIME_ACTORS_HEADER_FILE}"`,
+    "",
+].join("\n");
+
+const RUNTIME_TEMPLATE = loadRuntimeHeader();
+const ACTORS_BEGIN = RUNTIME_TEMPLATE.indexOf(ACTORS_BEGIN_MARKER);
+const ACTORS_END = RUNTIME_TEMPLATE.indexOf(ACTORS_END_MARKER);
+if (ACTORS_BEGIN < 0 || ACTORS_END < ACTORS_BEGIN) {
+    throw new Error("Runtime template is missing its actors section markers");
+}
+
+const RUNTIME_ACTORS_SECTION = RUNTIME_TEMPLATE
+    .slice(ACTORS_BEGIN + ACTORS_BEGIN_MARKER.length, ACTORS_END)
+    .trim();
+
+const RUNTIME_CORE_TEMPLATE = ACTOR_ONLY_INCLUDES.reduce(
+    (header, include) => header.replace(`${include}\n`, ""),
+    RUNTIME_TEMPLATE.slice(0, ACTORS_BEGIN) + RUNTIME_TEMPLATE.slice(ACTORS_END + ACTORS_END_MARKER.length),
+);
@@ -18,13 +18,15 @@ import type {
   ResultElseStatement,
 } from "./ast.js";
 import { getResultShape, type ResolvedType, type ResultShape } from "./checker-types.js";
-import { emitClassCppName, emitType, isPointerType, isVariantUnionType, isOptionalNullable, isMonostateNullable } from "./emitter-types.js";
+import { emitClassCppName, emitStringType, emitType, isPointerType, isVariantUnionType, isOptionalNullable, isMonostateNullable } from "./emitter-types.js";
 import { substituteEmitType } from "./emitter-monomorphize.js";
 import { emitExpression, indent, emitIdentifierSafe, emitBlockBody } from "./emitter-expr.js";
+import { emitMovableOperand } from "./emitter-moves.js";
+import { emitStackAllocatedLocal } from "./emitter-escape.js";
 import type { EmitContext } from "./emitter-context.js";
 import { emitPanicLocationArgs } from "./emitter-panic.js";
 import { emitExtractNarrowedValue } from "./emitter-narrowing.js";
-import { emitStreamNextHelperName, emitStreamValueHelperName, resolveTypeAnnotation } from "./emitter-expr-utils.js";
+import { emitStreamPullHelperName, resolveTypeAnnotation } from "./emitter-expr-utils.js";
 import { emitQualifiedHelperName } from "./emitter-names.js";
 import { emitYieldBlockIIFE } from "./emitter-expr-control.js";
 import {
@@ -59,6 +61,9 @@ const COVERAGE_NON_EXECUTABLE_KINDS = new Set([
   "block",
 ]);
 
+/** File-local bitmap that emitCppFile declares once it knows the highest marked line. */
+export const COVERAGE_BITMAP_NAME = "doof_coverage_lines";
+
 /**
  * Emit a C++ statement (one or more lines) for a Doof statement node.
  * Appends lines to ctx.sourceLines (or ctx.headerLines for declarations).
@@ -68,7 +73,7 @@ export function emitStatement(stmt: Statement, ctx: EmitContext): void {
   // Only emit inside function/block bodies (indent > 0); top-level C++ scope cannot contain bare calls.
   if (ctx.coverageEnabled && ctx.coverageModuleId !== undefined && ctx.indent > 0 && !COVERAGE_NON_EXECUTABLE_KINDS.has(stmt.kind)) {
     const line = stmt.span.start.line + 1; // convert 0-based to 1-based
-    ctx.sourceLines.push(`${indent(ctx)}doof::coverage::cov_mark(${ctx.coverageModuleId}, ${line});`);
+    ctx.sourceLines.push(`${indent(ctx)}::${COVERAGE_BITMAP_NAME}.mark(${line});`);
     ctx.coverageInstrumentedLines?.add(line);
   }
 
@@ -126,7 +131,9 @@ export function emitStatement(stmt: Statement, ctx: EmitContext): void {
         const valType = substituteEmitType(stmt.value.resolvedType, ctx);
         const fnResult = fnRet ? getResultShape(fnRet) : null;
         if (fnResult && valType && !getResultShape(valType) && valType.kind !== "success" && valType.kind !== "failure") {
-          ctx.sourceLines.push(`${ind}return ${emitType(fnResult.successArm, ctx.module.path)}{${val}};`);
+          // Brace-wrapping a local defeats the implicit move on return.
+          const wrapped = emitMovableOperand(stmt.value, ctx, fnRet);
+          ctx.sourceLines.push(`${ind}return ${emitType(fnResult.successArm, ctx.module.path)}{${wrapped}};`);
         } else {
           ctx.sourceLines.push(`${ind}return ${val};`);
         }
@@ -453,8 +460,9 @@ function emitImmutableBinding(
   const declType = substituteEmitType(stmt.resolvedType, ctx);
   const explicitCppType = stmt.type && declType ? emitType(declType, ctx.module.path) : null;
   const linkagePrefix = ctx.internalLinkage && ctx.indent === 0 ? "static " : "";
-  const val = emitExpression(stmt.value, ctx, declType);
+  const val = emitMovableOperand(stmt.value, ctx, declType);
   assertDeclarationTypeResolved(stmt.name, declType);
+  if (emitStackAllocatedLocal(stmt, val, ctx)) return;
 
   // := is shallow immutable. Struct values are mutable interiors, like class pointees.
   if (declType && declType.kind === "class") {
@@ -485,8 +493,9 @@ function emitLetDecl(
   const declType = substituteEmitType(stmt.resolvedType, ctx);
   const explicitCppType = stmt.type && declType ? emitType(declType, ctx.module.path) : null;
   const linkagePrefix = ctx.internalLinkage && ctx.indent === 0 ? "static " : "";
-  const val = emitExpression(stmt.value, ctx, declType);
+  const val = emitMovableOperand(stmt.value, ctx, declType);
   assertDeclarationTypeResolved(stmt.name, declType);
+  if (emitStackAllocatedLocal(stmt, val, ctx)) return;
 
   // Heap-box captured mutable variables so escaping lambdas don't dangle.
   if (ctx.capturedMutables?.has(stmt.name) && declType) {
@@ -543,8 +552,11 @@ function assertDeclarationTypeResolved(
  *
  * Generated pattern:
  *   auto _try_N = <rhs>;
- *   if (doof::is_failure(_try_N)) return doof::Failure<OutE>{std::move(doof::failure_error(_try_N))};
+ *   if (DOOF_UNLIKELY(doof::is_failure(_try_N))) return doof::propagate_failure<doof::Failure<OutE>>(doof::failure_error(_try_N));
  *   const auto x = std::move(doof::success_value(_try_N));
+ *
+ * `propagate_failure` is a cold, non-inlined runtime helper, so building the
+ * caller's failure arm stays out of the success path's code.
  */
 function emitTryStatement(stmt: TryStatement, ctx: EmitContext): void {
   const ind = indent(ctx);
@@ -567,9 +579,9 @@ function emitTryStatement(stmt: TryStatement, ctx: EmitContext): void {
   // Inside a catch expression: break instead of return, assign error to catch var
   if (ctx.catchVarName) {
     if (rhsResult?.errorType.kind === "void") {
-      ctx.sourceLines.push(`${ind}if (doof::is_failure(${tmp})) { break; }`);
+      ctx.sourceLines.push(`${ind}if (DOOF_UNLIKELY(doof::is_failure(${tmp}))) { break; }`);
     } else {
-      ctx.sourceLines.push(`${ind}if (doof::is_failure(${tmp})) { ${ctx.catchVarName} = std::move(doof::failure_error(${tmp})); break; }`);
+      ctx.sourceLines.push(`${ind}if (DOOF_UNLIKELY(doof::is_failure(${tmp}))) { ${ctx.catchVarName} = std::move(doof::failure_error(${tmp})); break; }`);
     }
   } else {
     // Emit the failure check with early return
@@ -577,15 +589,15 @@ function emitTryStatement(stmt: TryStatement, ctx: EmitContext): void {
     const fnRet = ctx.currentFunctionReturnType;
     const fnResult = fnRet ? getResultShape(fnRet) : null;
     if (fnResult) {
-      const failureValue = fnResult.errorType.kind === "void" ? "" : `std::move(doof::failure_error(${tmp}))`;
-      ctx.sourceLines.push(`${ind}if (doof::is_failure(${tmp})) return ${emitType(fnResult.failureArm, ctx.module.path)}{${failureValue}};`);
+      const propagated = emitPropagatedFailure(emitType(fnResult.failureArm, ctx.module.path), fnResult.errorType.kind === "void", tmp);
+      ctx.sourceLines.push(`${ind}if (DOOF_UNLIKELY(doof::is_failure(${tmp}))) return ${propagated};`);
     } else {
       // Fallback: use the RHS result type
       const rhsType = rhsExpr.resolvedType;
       const fallbackResult = rhsType ? getResultShape(rhsType) : null;
       if (fallbackResult) {
-        const failureValue = fallbackResult.errorType.kind === "void" ? "" : `std::move(doof::failure_error(${tmp}))`;
-        ctx.sourceLines.push(`${ind}if (doof::is_failure(${tmp})) return ${emitType(fallbackResult.failureArm)}{${failureValue}};`);
+        const propagated = emitPropagatedFailure(emitType(fallbackResult.failureArm), fallbackResult.errorType.kind === "void", tmp);
+        ctx.sourceLines.push(`${ind}if (DOOF_UNLIKELY(doof::is_failure(${tmp}))) return ${propagated};`);
       } else {
         ctx.sourceLines.push(`${ind}if (doof::is_failure(${tmp})) return std::move(doof::failure_error(${tmp}));`);
       }
@@ -604,6 +616,16 @@ function emitTryStatement(stmt: TryStatement, ctx: EmitContext): void {
   emitTryBinding(binding, tmp, ctx);
 }
 
+/**
+ * The failure arm a `try` returns. The callee's error (when there is one) is
+ * moved into the caller's arm inside the cold helper.
+ */
+function emitPropagatedFailure(failureArm: string, voidError: boolean, tmp: string): string {
+  return voidError
+    ? `doof::propagate_failure<${failureArm}>()`
+    : `doof::propagate_failure<${failureArm}>(doof::failure_error(${tmp}))`;
+}
+
 /** Extract the RHS expression from a TryBinding. */
 function getTryBindingRhs(binding: TryBinding): Expression | null {
   switch (binding.kind) {
@@ -1159,16 +1181,44 @@ function emitForOfStatement(
     ctx.sourceLines.push(`${ind}bool ${naturalCompletionFlag} = true;`);
   }
 
+  const loopCtx = {
+    ...ctx,
+    indent: ctx.indent + 1,
+    loopControls: [...(ctx.loopControls ?? []), { label: stmt.label, naturalCompletionFlag }],
+  };
+
+  // for-of directly over `text.split(delimiter)` walks the fields lazily
+  // instead of materialising the array. The range holds views, so source and
+  // delimiter are bound by reference only when the body cannot reassign them;
+  // anything else is copied into an owning string first.
+  const splitCall = getStringSplitCall(stmt.iterable);
+  if (splitCall && stmt.bindings.length === 1) {
+    const sourceVar = `_split_source_${ctx.tempCounter++}`;
+    const delimiterVar = `_split_delimiter_${ctx.tempCounter++}`;
+    ctx.sourceLines.push(`${ind}${splitOperandBinding(splitCall.source)} ${sourceVar} = ${emitExpression(splitCall.source, ctx)};`);
+    ctx.sourceLines.push(`${ind}${splitOperandBinding(splitCall.delimiter)} ${delimiterVar} = ${emitExpression(splitCall.delimiter, ctx)};`);
+    ctx.sourceLines.push(`${ind}for (const auto& ${emitIdentifierSafe(stmt.bindings[0])} : doof::string_split_range(${sourceVar}, ${delimiterVar})) {`);
+    emitBlockStatements(stmt.body, loopCtx);
+    ctx.sourceLines.push(`${ind}}`);
+    emitForOfCompletion(stmt, naturalCompletionFlag, ctx);
+    return;
+  }
+
   const iterable = emitExpression(stmt.iterable, ctx);
   const iterableType = substituteEmitType(stmt.iterable.resolvedType, ctx);
 
   if (iterableType?.kind === "stream") {
     const streamVar = `_stream_${ctx.tempCounter++}`;
-    const nextVar = `_stream_next_${ctx.tempCounter++}`;
     const valueVar = `_stream_value_${ctx.tempCounter++}`;
+    const pullHelper = emitQualifiedHelperName(
+      ctx.module.path,
+      emitStreamPullHelperName(emitType(iterableType, ctx.module.path)),
+      ctx.allModules,
+    );
 
     ctx.sourceLines.push(`${ind}auto ${streamVar} = ${iterable};`);
-    ctx.sourceLines.push(`${ind}while (true) {`);
+    ctx.sourceLines.push(`${ind}std::optional<${emitType(iterableType.elementType, ctx.module.path)}> ${valueVar};`);
+    ctx.sourceLines.push(`${ind}while (${pullHelper}(${streamVar}, ${valueVar})) {`);
 
     const innerCtx = {
       ...ctx,
@@ -1177,28 +1227,17 @@ function emitForOfStatement(
     };
     const innerInd = indent(innerCtx);
 
-    ctx.sourceLines.push(`${innerInd}auto ${nextVar} = ${emitQualifiedHelperName(ctx.module.path, emitStreamNextHelperName(emitType(iterableType, ctx.module.path)), ctx.allModules)}(${streamVar});`);
-    ctx.sourceLines.push(`${innerInd}if (!${nextVar}) break;`);
-    ctx.sourceLines.push(`${innerInd}auto ${valueVar} = ${emitQualifiedHelperName(ctx.module.path, emitStreamValueHelperName(emitType(iterableType, ctx.module.path)), ctx.allModules)}(${streamVar});`);
-
     if (stmt.bindings.length === 1) {
       const binding = emitIdentifierSafe(stmt.bindings[0]);
-      ctx.sourceLines.push(`${innerInd}const auto& ${binding} = ${valueVar};`);
+      ctx.sourceLines.push(`${innerInd}const auto& ${binding} = *${valueVar};`);
     } else {
       const bindings = stmt.bindings.map(emitIdentifierSafe).join(", ");
-      ctx.sourceLines.push(`${innerInd}const auto& [${bindings}] = ${valueVar};`);
+      ctx.sourceLines.push(`${innerInd}const auto& [${bindings}] = *${valueVar};`);
     }
 
     emitBlockStatements(stmt.body, innerCtx);
     ctx.sourceLines.push(`${ind}}`);
-    if (stmt.label) {
-      ctx.sourceLines.push(`${ind}${stmt.label}_break:;`);
-    }
-    if (naturalCompletionFlag && stmt.then_) {
-      ctx.sourceLines.push(`${ind}if (${naturalCompletionFlag}) {`);
-      emitBlockStatements(stmt.then_, { ...ctx, indent: ctx.indent + 1 });
-      ctx.sourceLines.push(`${ind}}`);
-    }
+    emitForOfCompletion(stmt, naturalCompletionFlag, ctx);
     return;
   }
 
@@ -1211,11 +1250,6 @@ function emitForOfStatement(
     ctx.sourceLines.push(`${ind}const auto& ${iterableVar} = ${iterable};`);
     iterExpr = `*${iterableVar}`;
   }
-  const loopCtx = {
-    ...ctx,
-    indent: ctx.indent + 1,
-    loopControls: [...(ctx.loopControls ?? []), { label: stmt.label, naturalCompletionFlag }],
-  };
 
   if (iterableType?.kind === "map" && stmt.bindings.length === 2) {
     // Map iteration: for (key, value) of map → for (const auto& [k, v] : *map)
@@ -1231,6 +1265,15 @@ function emitForOfStatement(
 
   emitBlockStatements(stmt.body, loopCtx);
   ctx.sourceLines.push(`${ind}}`);
+  emitForOfCompletion(stmt, naturalCompletionFlag, ctx);
+}
+
+function emitForOfCompletion(
+  stmt: import("./ast.js").ForOfStatement,
+  naturalCompletionFlag: string | null,
+  ctx: EmitContext,
+): void {
+  const ind = indent(ctx);
   if (stmt.label) {
     ctx.sourceLines.push(`${ind}${stmt.label}_break:;`);
   }
@@ -1241,6 +1284,33 @@ function emitForOfStatement(
   }
 }
 
+function getStringSplitCall(expr: Expression): { source: Expression; delimiter: Expression } | null {
+  if (expr.kind !== "call-expression" || expr.callee.kind !== "member-expression") return null;
+  const member = expr.callee;
+  const sourceType = member.object.resolvedType;
+  if (member.property !== "split" || member.optional || member.force || expr.args.length !== 1) return null;
+  if (sourceType?.kind !== "primitive" || sourceType.name !== "string") return null;
+  return { source: member.object, delimiter: expr.args[0].value };
+}
+
+/**
+ * Temporaries and immutable bindings cannot change while the split range
+ * reads them, so a reference is enough; mutable variables and member reads
+ * are copied.
+ */
+function splitOperandBinding(expr: Expression): string {
+  switch (expr.kind) {
+    case "string-literal":
+    case "call-expression":
+    case "binary-expression":
+      return "const auto&";
+    case "identifier":
+      return expr.resolvedBinding && !expr.resolvedBinding.mutable ? "const auto&" : `const ${emitStringType()}`;
+    default:
+      return `const ${emitStringType()}`;
+  }
+}
+
 function emitWithStatement(stmt: WithStatement, ctx: EmitContext): void {
   const ind = indent(ctx);
   ctx.sourceLines.push(`${ind}{`);
@@ -13,8 +13,10 @@
  *   - Nullable → std::optional for primitives, nullptr for pointers
  */
 
-import { isJsonValueType, type ResolvedType, type PrimitiveName } from "./checker-types.js";
+import { isJsonValueType, type FunctionResolvedType, type ResolvedType, type PrimitiveName } from "./checker-types.js";
 import type { ClassSymbol, StructSymbol } from "./types.js";
+import { noteActorRuntimeType } from "./emitter-context.js";
+import type { StringRepresentation } from "./package-artifacts.js";
 import { emitModuleNamespace, emitQualifiedModuleName } from "./emitter-names.js";
 
 function emitModuleOwnedName(
@@ -128,10 +130,40 @@ const PRIMITIVE_MAP: Record<PrimitiveName, string> = {
   bool: "bool",
 };
 
+let stringRepresentation: StringRepresentation = "std";
+
+/**
+ * Select the string representation for the project being emitted. emitType
+ * takes no emit context, so like actor-type tracking this is module state;
+ * emitProject sets it for the duration of one emission.
+ */
+export function setStringRepresentation(representation: StringRepresentation): void {
+  stringRepresentation = representation;
+}
+
+/** C++ spelling of Doof `string` under the current representation. */
+export function emitStringType(): string {
+  return stringRepresentation === "shared" ? "doof::string" : PRIMITIVE_MAP.string;
+}
+
 // ============================================================================
 // Public API
 // ============================================================================
 
+function emitCallbackSignature(type: FunctionResolvedType, currentModulePath?: string): string {
+  const params = type.params.map((p) => emitType(p.type, currentModulePath)).join(", ");
+  const ret = emitType(type.returnType, currentModulePath);
+  return `${ret}(${params})`;
+}
+
+/**
+ * Emit the non-owning `doof::callback_ref` type used for a function-typed
+ * parameter that never escapes its call.
+ */
+export function emitBorrowedCallbackType(type: FunctionResolvedType, currentModulePath?: string): string {
+  return `doof::callback_ref<${emitCallbackSignature(type, currentModulePath)}>`;
+}
+
 /**
  * Emit a C++ type string for a resolved Doof type.
  *
@@ -145,7 +177,7 @@ export function emitType(type: ResolvedType, currentModulePath?: string): string
 
   switch (type.kind) {
     case "primitive":
-      return PRIMITIVE_MAP[type.name];
+      return type.name === "string" ? emitStringType() : PRIMITIVE_MAP[type.name];
 
     case "builtin-namespace":
       throw new Error(`Cannot emit builtin namespace type "${type.name}" in value position`);
@@ -170,11 +202,8 @@ export function emitType(type: ResolvedType, currentModulePath?: string): string
     case "enum":
       return emitEnumTypeName(type, currentModulePath);
 
-    case "function": {
-      const params = type.params.map((p) => emitType(p.type, currentModulePath)).join(", ");
-      const ret = emitType(type.returnType, currentModulePath);
-      return `doof::callback<${ret}(${params})>`;
-    }
+    case "function":
+      return `doof::callback<${emitCallbackSignature(type, currentModulePath)}>`;
 
     case "mock-capture":
       return type.typeName;
@@ -227,9 +256,11 @@ export function emitType(type: ResolvedType, currentModulePath?: string): string
       throw new Error("Cannot emit namespace type in value position");
 
     case "actor":
+      noteActorRuntimeType();
       return `std::shared_ptr<doof::Actor<${emitInnerType(type.innerClass, currentModulePath)}>>`;
 
     case "promise":
+      noteActorRuntimeType();
       return `doof::Promise<${emitType(type.valueType, currentModulePath)}>`;
 
     case "success":
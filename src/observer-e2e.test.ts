@@ -127,6 +127,8 @@ describe("observer runtime e2e", () => {
       "/main.do": `
         function main(): void {
           metricsIncrement("requests_total", 2L)
+          metricsObserve("latency_us", 3L)
+          metricsObserve("latency_us", 100L)
           while true {}
         }
       `,
@@ -153,13 +155,43 @@ describe("observer runtime e2e", () => {
 
     const metricsResponse = await fetch(new URL("/api/metrics", url));
     const prometheusResponse = await fetch(new URL("/api/metrics/prometheus", url));
+    const traceResponse = await fetch(new URL("/api/trace", url));
     const dashboardResponse = await fetch(url);
 
     expect(metricsResponse.ok).toBe(true);
     expect(prometheusResponse.ok).toBe(true);
     expect(dashboardResponse.ok).toBe(true);
-    expect(await metricsResponse.json()).toEqual([{ name: "requests_total", value: 2 }]);
-    expect(await prometheusResponse.text()).toContain("requests_total 2");
+    expect(await metricsResponse.json()).toEqual([
+      { name: "requests_total", value: 2 },
+      {
+        name: "latency_us",
+        type: "histogram",
+        value: 2,
+        count: 2,
+        sum: 103,
+        p50: 3,
+        p99: 103,
+        buckets: [{ le: 3, count: 1 }, { le: 103, count: 1 }],
+      },
+    ]);
+    const prometheus = await prometheusResponse.text();
+    expect(prometheus).toContain("requests_total 2");
+    expect(prometheus).toContain('latency_us_bucket{le="103"} 2');
+    expect(prometheus).toContain("latency_us_count 2");
+    expect(await traceResponse.json()).toEqual({ displayTimeUnit: "ms", traceEvents: [] });
+
+    const streamResponse = await fetch(new URL("/api/metrics/stream", url));
+    expect(streamResponse.headers.get("content-type")).toBe("text/event-stream");
+    const reader = streamResponse.body!.getReader();
+    const decoder = new TextDecoder();
+    let streamed = "";
+    while (!/event: snapshot\ndata: .*\n\n/.test(streamed)) {
+      const { value, done } = await reader.read();
+      if (done) break;
+      streamed += decoder.decode(value, { stream: true });
+    }
+    await reader.cancel();
+    expect(streamed).toContain('event: snapshot\ndata: [{"name":"requests_total","value":2},');
     expect(await dashboardResponse.text()).toContain("Doof Observer");
   });
 });
@@ -6,6 +6,7 @@ import {
   copyExecutableResources,
   copyPackagedExecutable,
   packageArchiveName,
+  withBuildProfileDefaults,
   withReleaseBuildDefaults,
 } from "./package-artifacts.js";
 
@@ -25,6 +26,29 @@ describe("release package artifacts", () => {
     expect(withReleaseBuildDefaults({ ...base, compilerFlags: [] }, "emscripten").defines).toEqual(["NDEBUG", "CUSTOM"]);
   });
 
+  it("layers link-time optimisation onto the release profile", () => {
+    const base = {
+      cppStd: "c++17", includePaths: [], libraryPaths: [], linkLibraries: [], frameworks: [],
+      pkgConfigPackages: [], sourceFiles: [], objectFiles: [], compilerFlags: [], linkerFlags: ["-pthread"], defines: [],
+    };
+    expect(withBuildProfileDefaults(base, "gcc-like", "debug")).toEqual(base);
+    expect(withBuildProfileDefaults(base, "gcc-like", "release")).toEqual(withReleaseBuildDefaults(base, "gcc-like"));
+    expect(withBuildProfileDefaults(base, "gcc-like", "release-lto")).toMatchObject({
+      compilerFlags: ["-flto", "-O2"],
+      linkerFlags: ["-flto", "-pthread"],
+      defines: ["NDEBUG"],
+    });
+    expect(withBuildProfileDefaults(base, "gcc-like", "pgo").compilerFlags).toEqual(["-flto", "-O2"]);
+    expect(withBuildProfileDefaults(base, "msvc", "release-lto")).toMatchObject({
+      compilerFlags: ["/GL", "/O2"],
+      linkerFlags: ["/LTCG", "-pthread"],
+    });
+    expect(withBuildProfileDefaults(base, "emscripten", "release-lto")).toMatchObject({
+      compilerFlags: [],
+      linkerFlags: ["-pthread"],
+    });
+  });
+
   it("names platform archives with executable and version", () => {
     expect(packageArchiveName("DoofDemo", "1.2.3", "macos")).toBe("DoofDemo-1.2.3-macos.zip");
     expect(packageArchiveName("DoofDemo", "1.2.3", "ios")).toBe("DoofDemo-1.2.3-ios.ipa");
@@ -4,6 +4,48 @@ import type { CompilerToolchainKind } from "./cli-core.js";
 import type { NativeBuildOptions } from "./emitter-module.js";
 import { expandResourceFiles, type ResolvedDoofResource } from "./resource-patterns.js";
 
+export type BuildProfile = "debug" | "release" | "release-lto" | "pgo";
+
+export const BUILD_PROFILES: readonly BuildProfile[] = ["debug", "release", "release-lto", "pgo"];
+
+export function isBuildProfile(value: string): value is BuildProfile {
+  return (BUILD_PROFILES as readonly string[]).includes(value);
+}
+
+/**
+ * How Doof `string` is represented in C++: `std::string`, or the runtime's
+ * refcounted `doof::SharedString` when doof.json sets `build.strings` to
+ * `"shared"`.
+ */
+export type StringRepresentation = "std" | "shared";
+
+export const STRING_REPRESENTATIONS: readonly StringRepresentation[] = ["std", "shared"];
+
+export function isStringRepresentation(value: string): value is StringRepresentation {
+  return (STRING_REPRESENTATIONS as readonly string[]).includes(value);
+}
+
+/**
+ * Applies the optimisation defaults of a package build profile. `pgo` shares
+ * the `release-lto` flags; the instrumentation and profile-use flags are
+ * layered on per build by the PGO driver.
+ */
+export function withBuildProfileDefaults(
+  nativeBuild: NativeBuildOptions,
+  toolchainKind: CompilerToolchainKind,
+  profile: BuildProfile,
+): NativeBuildOptions {
+  if (profile === "debug") return nativeBuild;
+  const release = withReleaseBuildDefaults(nativeBuild, toolchainKind);
+  if (profile === "release") return release;
+  const lto = linkTimeOptimizationFlagsForToolchain(toolchainKind);
+  return {
+    ...release,
+    compilerFlags: uniqueStrings([...lto.compilerFlags, ...release.compilerFlags]),
+    linkerFlags: uniqueStrings([...lto.linkerFlags, ...release.linkerFlags]),
+  };
+}
+
 export function withReleaseBuildDefaults(
   nativeBuild: NativeBuildOptions,
   toolchainKind: CompilerToolchainKind,
@@ -24,6 +66,15 @@ function releaseCompilerFlagsForToolchain(toolchainKind: CompilerToolchainKind):
   return ["-O2"];
 }
 
+// Emscripten builds already compile and link with -flto by default.
+function linkTimeOptimizationFlagsForToolchain(
+  toolchainKind: CompilerToolchainKind,
+): { compilerFlags: string[]; linkerFlags: string[] } {
+  if (toolchainKind === "msvc") return { compilerFlags: ["/GL"], linkerFlags: ["/LTCG"] };
+  if (toolchainKind === "emscripten") return { compilerFlags: [], linkerFlags: [] };
+  return { compilerFlags: ["-flto"], linkerFlags: ["-flto"] };
+}
+
 export function copyPackagedExecutable(
   executablePath: string,
   distDir: string,
@@ -18,7 +18,14 @@ import {
 import { assembleMacOSAppBundle } from "./macos-app-target.js";
 import { archiveMacOSApp, signMacOSApp, type MacOSPackageSigningOptions } from "./macos-package.js";
 import { signAndArchiveIOSApp, type IOSAdHocSigningOverrides } from "./ios-package.js";
-import { copyPackagedExecutable, packageArchiveName, withReleaseBuildDefaults } from "./package-artifacts.js";
+import {
+  copyPackagedExecutable,
+  packageArchiveName,
+  withBuildProfileDefaults,
+  type BuildProfile,
+} from "./package-artifacts.js";
+import type { ResolvedDoofPgoConfig } from "./package-manifest.js";
+import { runProfileGuidedBuild } from "./package-pgo.js";
 
 export interface PackageCommandOptions {
   entry: string;
@@ -32,6 +39,10 @@ export interface PackageCommandOptions {
   macosSigning: MacOSPackageSigningOptions;
   iosSigning: IOSAdHocSigningOverrides;
   metricsClassLifecycle?: boolean;
+  /** Defaults to `release`. */
+  buildProfile?: BuildProfile;
+  /** Training workload, required by the `pgo` profile. */
+  pgo?: ResolvedDoofPgoConfig;
 }
 
 export interface PackageCommandReporter {
@@ -59,26 +70,54 @@ export async function runPackageCommand(
   const toolchain = buildTarget?.kind === "wasm"
     ? resolveWasmCompilerToolchain(options.compiler)
     : resolveCompilerToolchain(options.compiler);
-  const releaseNativeBuild = withReleaseBuildDefaults(nativeBuild, toolchain.kind);
-  buildManifest.compilerFlags = [...releaseNativeBuild.compilerFlags];
-  buildManifest.defines = [...releaseNativeBuild.defines];
+  const buildProfile = options.buildProfile ?? "release";
+  const profileNativeBuild = withBuildProfileDefaults(nativeBuild, toolchain.kind, buildProfile);
+  buildManifest.compilerFlags = [...profileNativeBuild.compilerFlags];
+  buildManifest.linkerFlags = [...profileNativeBuild.linkerFlags];
+  buildManifest.defines = [...profileNativeBuild.defines];
   const effectiveNativeBuild = buildTarget?.kind === "ios-app"
     ? buildIOSDeviceNativeBuild(
-      releaseNativeBuild,
+      profileNativeBuild,
       options.outDir,
       resolveIOSDeviceBuildSettings(buildTarget.config),
     )
-    : releaseNativeBuild;
-  const { outBinary: binary } = await runNativeBuildGraph(
+    : profileNativeBuild;
+  const buildBinary = async (buildOptions: NativeBuildOptions) => (await runNativeBuildGraph(
     options.outDir,
     project,
     toolchain,
-    effectiveNativeBuild,
+    buildOptions,
     options.verbose,
     outputBinaryName,
     provenance,
     buildManifest,
-  );
+  )).outBinary;
+
+  let binary: string;
+  if (buildProfile === "pgo") {
+    if (!options.pgo) {
+      throw new Error('The "pgo" build profile requires build.package.pgo training settings in doof.json');
+    }
+    if (buildTarget?.kind === "ios-app" || buildTarget?.kind === "wasm") {
+      throw new Error(`The "pgo" build profile cannot train ${buildTarget.kind} targets on the build host`);
+    }
+    binary = await runProfileGuidedBuild({
+      outDir: options.outDir,
+      toolchain,
+      nativeBuild: effectiveNativeBuild,
+      trainingNativeBuild: requestedNativeBuild,
+      config: options.pgo,
+      verbose: options.verbose,
+      build(buildOptions) {
+        buildManifest.compilerFlags = [...buildOptions.compilerFlags];
+        buildManifest.linkerFlags = [...buildOptions.linkerFlags];
+        return buildBinary(buildOptions);
+      },
+      log: reporter.log,
+    });
+  } else {
+    binary = await buildBinary(effectiveNativeBuild);
+  }
 
   if (buildTarget?.kind === "macos-app") {
     const bundle = assembleMacOSAppBundle({
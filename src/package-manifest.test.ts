@@ -195,6 +195,36 @@ describe("manifest build defaults", () => {
     });
     expect(() => resolvePackageBuildContext(fs, "/app")).toThrow("build.package.macos.signing");
   });
+
+  it("resolves the package build profile and PGO training suite", () => {
+    const fs = new VirtualFS({
+      "/app/doof.json": JSON.stringify({
+        name: "app",
+        build: { package: { profile: "pgo", pgo: { bench: "bench" } } },
+      }),
+      "/app/main.do": "function main(): void {}",
+    });
+    const config = resolvePackageReleaseConfig(resolvePackageBuildContext(fs, "/app"));
+
+    expect(config.profile).toBe("pgo");
+    expect(config.pgo).toEqual({ bench: "/app/bench", workingDir: "/app" });
+  });
+
+  it("rejects unknown build profiles and ambiguous PGO training", () => {
+    const manifest = (pkg: unknown) => new VirtualFS({
+      "/app/doof.json": JSON.stringify({ name: "app", build: { package: pkg } }),
+      "/app/main.do": "function main(): void {}",
+    });
+
+    expect(() => resolvePackageBuildContext(manifest({ profile: "fast" }), "/app"))
+      .toThrow("build.package.profile must be one of");
+    expect(() => resolvePackageBuildContext(manifest({ profile: "pgo" }), "/app"))
+      .toThrow('build.package.pgo is required for the "pgo" profile');
+    expect(() => resolvePackageBuildContext(manifest({ pgo: { args: [], bench: "bench" } }), "/app"))
+      .toThrow('build.package.pgo must declare exactly one of "args", "command", "bench"');
+    expect(() => resolvePackageBuildContext(manifest({ pgo: { command: [] } }), "/app"))
+      .toThrow("build.package.pgo.command must not be empty");
+  });
 });
 
 describe("local package graphs", () => {
@@ -2172,6 +2202,35 @@ describe("manifest-derived pipeline metadata", () => {
     expect(result.buildManifest.outputBinaryName).toBe(normalizeOutputBinaryName("doof"));
   });
 
+  it("lowers string to doof::string when build.strings is shared", () => {
+    const fs = new VirtualFS({
+      "/app/doof.json": JSON.stringify({ name: "app", build: { strings: "shared" } }),
+      "/app/main.do": "function greet(name: string): string => \"hi \" + name\nfunction main(): int => 0",
+    });
+
+    const result = runPipelineWithFs(
+      fs,
+      "/app/main.do",
+      false,
+      emptyNativeBuildOptions(),
+      () => {},
+      () => {},
+    );
+    const main = result.project.modules.find((mod) => mod.modulePath === "/app/main.do")!;
+
+    expect(main.cppCode).toContain("doof::string greet(doof::string name)");
+    expect(result.project.runtime).toContain("#define DOOF_SHARED_STRINGS 1");
+  });
+
+  it("rejects unknown build.strings representations", () => {
+    const fs = new VirtualFS({
+      "/app/doof.json": JSON.stringify({ name: "app", build: { strings: "rope" } }),
+      "/app/main.do": "function main(): int => 0",
+    });
+
+    expect(() => resolvePackageBuildContext(fs, "/app")).toThrow('build.strings must be one of "std", "shared"');
+  });
+
   it("makes scoped package names safe for default native output naming", () => {
     const fs = new VirtualFS({
       "/app/doof.json": JSON.stringify({ name: "tools/doof" }),
@@ -30,6 +30,14 @@ import {
   type ResolvedDoofIOSAppConfig,
   type ResolvedDoofMacOSAppConfig,
 } from "./build-targets.js";
+import {
+  BUILD_PROFILES,
+  isBuildProfile,
+  isStringRepresentation,
+  STRING_REPRESENTATIONS,
+  type BuildProfile,
+  type StringRepresentation,
+} from "./package-artifacts.js";
 import type { ResolvedDoofResource } from "./resource-patterns.js";
 import {
   dirnameFsPath,
@@ -89,6 +97,8 @@ export interface DoofBuildConfig {
   iosApp?: DoofIOSAppConfig;
   package?: DoofPackageConfig;
   native?: DoofNativeBuildConfig;
+  /** Runtime representation of `string`; defaults to `"std"`. */
+  strings?: StringRepresentation;
 }
 
 export type MacOSPackageSigning = "developer-id" | "ad-hoc";
@@ -105,14 +115,33 @@ export interface DoofIOSPackageConfig {
   provisioningProfile?: string;
 }
 
+/** Training workload for the `pgo` build profile; exactly one field is set. */
+export interface DoofPgoConfig {
+  /** Run the instrumented binary with these arguments. */
+  args?: string[];
+  /** Run this command; `DOOF_PGO_BINARY` names the instrumented binary. */
+  command?: string[];
+  /** Run the `doof bench` suite at this path (clang++ only). */
+  bench?: string;
+}
+
+export interface ResolvedDoofPgoConfig extends DoofPgoConfig {
+  /** Working directory for training runs: the package root. */
+  workingDir: string;
+}
+
 export interface DoofPackageConfig {
   distDir?: string;
+  profile?: BuildProfile;
+  pgo?: DoofPgoConfig;
   macos?: DoofMacOSPackageConfig;
   ios?: DoofIOSPackageConfig;
 }
 
 export interface ResolvedDoofPackageConfig {
   distDir: string;
+  profile?: BuildProfile;
+  pgo?: ResolvedDoofPgoConfig;
   macos: DoofMacOSPackageConfig & { entitlements?: string };
   ios: DoofIOSPackageConfig & { provisioningProfile?: string };
 }
@@ -132,6 +161,16 @@ export function resolvePackageReleaseConfig(context: ResolvedPackageBuildContext
   const config = context.manifest.build?.package;
   return {
     distDir: normalizePackagePath(config?.distDir ?? "dist", context.rootDir, context.manifestPath, "build.package.distDir"),
+    profile: config?.profile,
+    pgo: config?.pgo === undefined
+      ? undefined
+      : {
+        ...config.pgo,
+        bench: config.pgo.bench === undefined
+          ? undefined
+          : normalizePackagePath(config.pgo.bench, context.rootDir, context.manifestPath, "build.package.pgo.bench"),
+        workingDir: context.rootDir,
+      },
     macos: {
       ...config?.macos,
       entitlements: config?.macos?.entitlements === undefined
@@ -1148,7 +1187,25 @@ function parseBuildConfig(
 
   const resources = rootCompact.resources ?? buildCompact.resources;
 
-  return { entry, buildDir, target: targetValue, targetExecutableName, resources, macosApp, iosApp, package: packageConfig, native };
+  const strings = readOptionalString(buildValue.strings, manifestPath, "build.strings");
+  if (strings !== undefined && !isStringRepresentation(strings)) {
+    throw new Error(
+      `Invalid doof.json at ${manifestPath}: build.strings must be one of ${STRING_REPRESENTATIONS.map((name) => `"${name}"`).join(", ")}`,
+    );
+  }
+
+  return {
+    entry,
+    buildDir,
+    target: targetValue,
+    targetExecutableName,
+    resources,
+    macosApp,
+    iosApp,
+    package: packageConfig,
+    native,
+    strings,
+  };
 }
 
 function parsePackageConfig(value: unknown, manifestPath: string): DoofPackageConfig | undefined {
@@ -1157,15 +1214,49 @@ function parsePackageConfig(value: unknown, manifestPath: string): DoofPackageCo
     throw new Error(`Invalid doof.json at ${manifestPath}: build.package must be an object`);
   }
 
+  const profile = readOptionalString(value.profile, manifestPath, "build.package.profile");
+  if (profile !== undefined && !isBuildProfile(profile)) {
+    throw new Error(
+      `Invalid doof.json at ${manifestPath}: build.package.profile must be one of ${BUILD_PROFILES.map((name) => `"${name}"`).join(", ")}`,
+    );
+  }
+  const pgo = parsePgoConfig(value.pgo, manifestPath);
+  if (profile === "pgo" && pgo === undefined) {
+    throw new Error(`Invalid doof.json at ${manifestPath}: build.package.pgo is required for the "pgo" profile`);
+  }
   const macos = parseMacOSPackageConfig(value.macos, manifestPath);
   const ios = parseIOSPackageConfig(value.ios, manifestPath);
   return {
     distDir: readOptionalString(value.distDir, manifestPath, "build.package.distDir"),
+    profile,
+    pgo,
     macos,
     ios,
   };
 }
 
+function parsePgoConfig(value: unknown, manifestPath: string): DoofPgoConfig | undefined {
+  if (value === undefined) return undefined;
+  if (!isRecord(value)) {
+    throw new Error(`Invalid doof.json at ${manifestPath}: build.package.pgo must be an object`);
+  }
+  const config: DoofPgoConfig = {
+    args: readOptionalStringArray(value.args, manifestPath, "build.package.pgo.args"),
+    command: readOptionalStringArray(value.command, manifestPath, "build.package.pgo.command"),
+    bench: readOptionalString(value.bench, manifestPath, "build.package.pgo.bench"),
+  };
+  const declared = [config.args, config.command, config.bench].filter((entry) => entry !== undefined);
+  if (declared.length !== 1) {
+    throw new Error(
+      `Invalid doof.json at ${manifestPath}: build.package.pgo must declare exactly one of "args", "command", "bench"`,
+    );
+  }
+  if (config.command?.length === 0) {
+    throw new Error(`Invalid doof.json at ${manifestPath}: build.package.pgo.command must not be empty`);
+  }
+  return config;
+}
+
 function parseMacOSPackageConfig(value: unknown, manifestPath: string): DoofMacOSPackageConfig | undefined {
   if (value === undefined) return undefined;
   if (!isRecord(value)) {
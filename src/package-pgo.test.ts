@@ -0,0 +1,106 @@
+import * as fs from "node:fs";
+import * as os from "node:os";
+import * as path from "node:path";
+import { afterEach, describe, expect, it } from "vitest";
+import { resolveCompilerToolchain } from "./cli-core.js";
+import { runPackageCommand } from "./package-command.js";
+import {
+  hashProfileDirectory,
+  profileGenerateFlags,
+  profileUseFlags,
+  requirePgoCompilerFamily,
+} from "./package-pgo.js";
+
+const tempDirs: string[] = [];
+afterEach(() => tempDirs.splice(0).forEach((dir) => fs.rmSync(dir, { recursive: true, force: true })));
+
+describe("profile-guided package builds", () => {
+  it("selects instrumentation and profile-use flags per compiler family", () => {
+    expect(profileGenerateFlags("gcc", "/out/raw")).toEqual({
+      compilerFlags: ["-fprofile-generate=/out/raw", "-fprofile-update=atomic"],
+      linkerFlags: ["-fprofile-generate=/out/raw"],
+    });
+    expect(profileGenerateFlags("clang", "/out/raw")).toEqual({
+      compilerFlags: ["-fprofile-generate=/out/raw"],
+      linkerFlags: ["-fprofile-generate=/out/raw"],
+    });
+    expect(profileUseFlags("gcc", "/out/profile-1")).toEqual({
+      compilerFlags: ["-fprofile-use=/out/profile-1", "-Wno-missing-profile"],
+      linkerFlags: ["-fprofile-use=/out/profile-1"],
+    });
+    expect(profileUseFlags("clang", "/out/profile-1/default.profdata")).toEqual({
+      compilerFlags: ["-fprofile-use=/out/profile-1/default.profdata"],
+      linkerFlags: [],
+    });
+  });
+
+  it("requires a detected clang++ or g++", () => {
+    expect(requirePgoCompilerFamily({ kind: "gcc-like", command: "clang++", compilerFamily: "clang" })).toBe("clang");
+    expect(() => requirePgoCompilerFamily({ kind: "msvc", command: "cl.exe" })).toThrow("requires clang++ or g++");
+    expect(() => requirePgoCompilerFamily({ kind: "gcc-like", command: "c++" })).toThrow("requires clang++ or g++");
+  });
+
+  it("names profiles by their content", () => {
+    const dir = createTempDir();
+    fs.mkdirSync(path.join(dir, "nested"));
+    fs.writeFileSync(path.join(dir, "nested", "a.gcda"), "counts");
+    const first = hashProfileDirectory(dir);
+
+    expect(hashProfileDirectory(dir)).toBe(first);
+    fs.writeFileSync(path.join(dir, "nested", "a.gcda"), "other counts");
+    expect(hashProfileDirectory(dir)).not.toBe(first);
+  });
+
+  it("trains the instrumented binary and rebuilds with its profile", async () => {
+    let compiler;
+    try {
+      compiler = resolveCompilerToolchain(null);
+    } catch {
+      return;
+    }
+    if (compiler.kind !== "gcc-like" || !compiler.compilerFamily) return;
+
+    const dir = createTempDir();
+    fs.writeFileSync(path.join(dir, "doof.json"), JSON.stringify({ name: "pgo-demo" }));
+    fs.writeFileSync(path.join(dir, "main.do"), [
+      "function main(): void {",
+      "    let total = 0",
+      "    for i of 0..<1000 {",
+      "        total = total + i % 7",
+      "    }",
+      "    println(total)",
+      "}",
+      "",
+    ].join("\n"));
+    const outDir = path.join(dir, "build", "pgo");
+    const artifact = await runPackageCommand({
+      entry: path.join(dir, "main.do"),
+      outDir,
+      distDir: path.join(dir, "dist"),
+      version: "0.0.0",
+      compiler: compiler.command,
+      nativeBuild: {
+        cppStd: "c++17", includePaths: [], libraryPaths: [], linkLibraries: [], frameworks: [],
+        pkgConfigPackages: [], sourceFiles: [], objectFiles: [], compilerFlags: [], linkerFlags: [], defines: [],
+      },
+      targetOverride: null,
+      verbose: false,
+      macosSigning: { signing: "ad-hoc", sandbox: false },
+      iosSigning: {},
+      buildProfile: "pgo",
+      pgo: { args: [], workingDir: dir },
+    }, { log() {} });
+
+    expect(fs.existsSync(artifact)).toBe(true);
+    expect(fs.readdirSync(path.join(outDir, ".doof-pgo")).filter((entry) => entry.startsWith("profile-"))).toHaveLength(1);
+    const manifest = JSON.parse(fs.readFileSync(path.join(outDir, "doof-build.json"), "utf8"));
+    expect(manifest.compilerFlags).toContain("-flto");
+    expect(manifest.compilerFlags.some((flag: string) => flag.startsWith("-fprofile-use="))).toBe(true);
+  });
+});
+
+function createTempDir(): string {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), "doof-package-pgo-"));
+  tempDirs.push(dir);
+  return dir;
+}
@@ -0,0 +1,201 @@
+import { execFileSync } from "node:child_process";
+import { createHash } from "node:crypto";
+import * as fs from "node:fs";
+import * as path from "node:path";
+import { runBenchCommand } from "./bench-runner.js";
+import type { CompilerToolchain, GccLikeCompilerFamily } from "./cli-core.js";
+import type { NativeBuildOptions } from "./emitter-module.js";
+import type { ResolvedDoofPgoConfig } from "./package-manifest.js";
+
+export interface ProfileGuidedBuildOptions {
+  outDir: string;
+  toolchain: CompilerToolchain;
+  /** Native options with the `pgo` profile defaults already applied. */
+  nativeBuild: NativeBuildOptions;
+  /** Requested native options for `doof bench` training harnesses. */
+  trainingNativeBuild: NativeBuildOptions;
+  config: ResolvedDoofPgoConfig;
+  verbose: boolean;
+  /** Builds the package with the given native options and returns the binary. */
+  build(nativeBuild: NativeBuildOptions): Promise<string>;
+  log(message: string): void;
+}
+
+export interface ProfileFlags {
+  compilerFlags: string[];
+  linkerFlags: string[];
+}
+
+/**
+ * Builds an instrumented binary, runs the training workload, then rebuilds
+ * with the collected profile and returns the optimised binary.
+ *
+ * The merged profile is moved into a directory named by its content hash, so
+ * the profile-use flags — and with them the object cache and build task
+ * fingerprints — change exactly when the profile data does.
+ */
+export async function runProfileGuidedBuild(options: ProfileGuidedBuildOptions): Promise<string> {
+  const family = requirePgoCompilerFamily(options.toolchain);
+  if (options.config.bench !== undefined && family !== "clang") {
+    // GCC keys .gcda files by object path, so a profile collected from bench
+    // harness objects never matches the package's own objects.
+    throw new Error("PGO training with build.package.pgo.bench requires clang++; use args or command with g++");
+  }
+
+  const pgoRoot = path.join(options.outDir, ".doof-pgo");
+  const rawDir = path.join(pgoRoot, "raw");
+  fs.rmSync(rawDir, { recursive: true, force: true });
+  fs.mkdirSync(rawDir, { recursive: true });
+  const generateFlags = profileGenerateFlags(family, rawDir);
+  const trainingEnv = { ...process.env };
+  delete trainingEnv.LLVM_PROFILE_FILE;
+
+  if (options.config.bench !== undefined) {
+    options.log(`Training PGO profile with doof bench ${options.config.bench}`);
+    const result = await runBenchCommand({
+      targetPath: options.config.bench,
+      compiler: { ...options.toolchain, env: { ...options.toolchain.env, ...trainingEnv } },
+      nativeBuild: withProfileFlags(options.trainingNativeBuild, generateFlags),
+      filter: null,
+      listOnly: false,
+      verbose: options.verbose,
+      reporter: { log: options.verbose ? options.log : () => {}, error: options.log },
+      output: path.join(pgoRoot, "bench.json"),
+    });
+    if (result.failed > 0) {
+      throw new Error(`PGO training failed: ${result.failed} benchmark(s) failed`);
+    }
+  } else {
+    const binary = await options.build(withProfileFlags(options.nativeBuild, generateFlags));
+    const [command, ...args] = options.config.command ?? [binary, ...(options.config.args ?? [])];
+    options.log(`Training PGO profile: ${[command, ...args].join(" ")}`);
+    try {
+      execFileSync(command, args, {
+        cwd: options.config.workingDir,
+        stdio: options.verbose ? "inherit" : "pipe",
+        env: options.config.command ? { ...trainingEnv, DOOF_PGO_BINARY: binary } : trainingEnv,
+      });
+    } catch (e: any) {
+      const stderr = e.stderr?.toString()?.trimEnd();
+      throw new Error(`PGO training run failed: ${stderr || (e instanceof Error ? e.message : String(e))}`);
+    }
+  }
+
+  if (family === "clang") {
+    mergeClangProfiles(options.toolchain.command, rawDir);
+  }
+  const profileDir = adoptProfileDirectory(pgoRoot, rawDir);
+  const profilePath = family === "clang" ? path.join(profileDir, CLANG_PROFILE_FILE) : profileDir;
+  options.log(`Rebuilding with PGO profile ${profilePath}`);
+  return options.build(withProfileFlags(options.nativeBuild, profileUseFlags(family, profilePath)));
+}
+
+export function requirePgoCompilerFamily(toolchain: CompilerToolchain): GccLikeCompilerFamily {
+  if (toolchain.kind === "gcc-like" && toolchain.compilerFamily) return toolchain.compilerFamily;
+  throw new Error(`The "pgo" build profile requires clang++ or g++; ${toolchain.command} is not supported`);
+}
+
+export function profileGenerateFlags(family: GccLikeCompilerFamily, profileDir: string): ProfileFlags {
+  const generate = `-fprofile-generate=${profileDir}`;
+  // Actor programs update counters from several threads.
+  return family === "gcc"
+    ? { compilerFlags: [generate, "-fprofile-update=atomic"], linkerFlags: [generate] }
+    : { compilerFlags: [generate], linkerFlags: [generate] };
+}
+
+export function profileUseFlags(family: GccLikeCompilerFamily, profilePath: string): ProfileFlags {
+  const use = `-fprofile-use=${profilePath}`;
+  return family === "gcc"
+    ? { compilerFlags: [use, "-Wno-missing-profile"], linkerFlags: [use] }
+    : { compilerFlags: [use], linkerFlags: [] };
+}
+
+/** Digest of every file under `dir`, keyed by relative path. */
+export function hashProfileDirectory(dir: string): string {
+  const hash = createHash("sha1");
+  for (const file of listFiles(dir).sort()) {
+    hash.update(file).update("\0").update(fs.readFileSync(path.join(dir, file))).update("\0");
+  }
+  return hash.digest("hex").slice(0, 16);
+}
+
+const CLANG_PROFILE_FILE = "default.profdata";
+
+function withProfileFlags(nativeBuild: NativeBuildOptions, flags: ProfileFlags): NativeBuildOptions {
+  return {
+    ...nativeBuild,
+    compilerFlags: [...nativeBuild.compilerFlags, ...flags.compilerFlags],
+    linkerFlags: [...nativeBuild.linkerFlags, ...flags.linkerFlags],
+  };
+}
+
+function mergeClangProfiles(compilerCommand: string, rawDir: string): void {
+  const rawProfiles = listFiles(rawDir).filter((file) => file.endsWith(".profraw"));
+  if (rawProfiles.length === 0) {
+    throw new Error("PGO training produced no profile data");
+  }
+  const profdata = resolveLlvmProfdata(compilerCommand);
+  execFileSync(profdata, [
+    "merge",
+    `-output=${path.join(rawDir, CLANG_PROFILE_FILE)}`,
+    ...rawProfiles.map((file) => path.join(rawDir, file)),
+  ], { stdio: "pipe" });
+  for (const file of rawProfiles) {
+    fs.rmSync(path.join(rawDir, file));
+  }
+}
+
+// Prefer the llvm-profdata that ships with the compiler: the raw profile
+// format changes between LLVM releases.
+function resolveLlvmProfdata(compilerCommand: string): string {
+  const candidates: string[] = [];
+  if (path.basename(compilerCommand) !== compilerCommand) {
+    candidates.push(path.join(path.dirname(compilerCommand), "llvm-profdata"));
+  }
+  const versionSuffix = /^clang\+\+(-\d+)$/.exec(path.basename(compilerCommand))?.[1];
+  if (versionSuffix) candidates.push(`llvm-profdata${versionSuffix}`);
+  candidates.push("llvm-profdata");
+
+  for (const candidate of candidates) {
+    try {
+      execFileSync(candidate, ["--version"], { stdio: "pipe", timeout: 5000 });
+      return candidate;
+    } catch {
+      // Try the next candidate.
+    }
+  }
+  if (process.platform === "darwin") {
+    try {
+      return execFileSync("xcrun", ["-f", "llvm-profdata"], { encoding: "utf8", stdio: "pipe" }).trim();
+    } catch {
+      // Fall through to the error below.
+    }
+  }
+  throw new Error(`Could not find llvm-profdata for ${compilerCommand}; install LLVM tools or add them to PATH`);
+}
+
+function adoptProfileDirectory(pgoRoot: string, rawDir: string): string {
+  if (listFiles(rawDir).length === 0) {
+    throw new Error("PGO training produced no profile data");
+  }
+  const profileDir = path.join(pgoRoot, `profile-${hashProfileDirectory(rawDir)}`);
+  for (const entry of fs.readdirSync(pgoRoot)) {
+    const entryPath = path.join(pgoRoot, entry);
+    if (entry.startsWith("profile-") && entryPath !== profileDir) {
+      fs.rmSync(entryPath, { recursive: true, force: true });
+    }
+  }
+  if (fs.existsSync(profileDir)) {
+    fs.rmSync(rawDir, { recursive: true, force: true });
+  } else {
+    fs.renameSync(rawDir, profileDir);
+  }
+  return profileDir;
+}
+
+function listFiles(dir: string, prefix = ""): string[] {
+  return fs.readdirSync(path.join(dir, prefix), { withFileTypes: true }).flatMap((entry) => {
+    const relativePath = prefix ? path.join(prefix, entry.name) : entry.name;
+    return entry.isDirectory() ? listFiles(dir, relativePath) : [relativePath];
+  });
+}
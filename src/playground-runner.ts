@@ -14,6 +14,7 @@ import {
 } from "./cli-core.js";
 import { emitProject } from "./emitter-module.js";
 import type { NativeBuildOptions, ProjectEmitResult } from "./emitter-module.js";
+import { runtimeHeaderFiles } from "./emitter-runtime.js";
 import {
   collectSemanticDiagnostics,
   throwIfErrorDiagnostics,
@@ -123,8 +124,9 @@ export function runPlaygroundSource(
   const tempDir = host.createTempDir();
 
   try {
-    const runtimeFilePath = path.join(tempDir, "doof_runtime.hpp");
-    host.writeFile(runtimeFilePath, artifacts.project.runtime);
+    for (const runtimeFile of runtimeHeaderFiles(artifacts.project)) {
+      host.writeFile(path.join(tempDir, runtimeFile.relativePath), runtimeFile.content);
+    }
     for (const module of artifacts.project.modules) {
       host.writeFile(path.join(tempDir, module.hppPath), module.hppCode);
       host.writeFile(path.join(tempDir, module.cppPath), module.cppCode);
@@ -32,6 +32,11 @@ export function loadObserverPlatformSupport(): string {
   return loadRuntimeAsset("doof_observer_platform.h");
 }
 
+/** Load the measurement header that `doof bench` harnesses include. */
+export function loadBenchSupport(): string {
+  return loadRuntimeAsset("doof_bench.h");
+}
+
 export function buildObserverRuntimeSupport(): string {
   const assets = loadObserverAssets();
   const template = loadRuntimeAsset("doof_observer_runtime.h");
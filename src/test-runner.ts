@@ -19,10 +19,21 @@ import type { FileSystem } from "./resolver.js";
 import { createNodeBundledModuleResolver, withNodeBundledStdlib } from "./stdlib-node.js";
 import type { Diagnostic, FunctionSymbol, ModuleSymbolTable } from "./types.js";
 
-const TEST_FILE_SUFFIX = ".test.do";
-const TEST_PREFIX = "test";
 const HARNESS_FILENAME = "__doof_tests__.do";
 
+/** How a kind of discovered function is named: its file suffix, export prefix, and diagnostic label. */
+export interface DiscoveryConvention {
+  fileSuffix: string;
+  functionPrefix: string;
+  label: string;
+}
+
+export const TEST_CONVENTION: DiscoveryConvention = {
+  fileSuffix: ".test.do",
+  functionPrefix: "test",
+  label: "test",
+};
+
 export interface DiscoveredTest {
   id: string;
   name: string;
@@ -62,7 +73,7 @@ export interface RunTestCommandResult {
   failed: number;
 }
 
-class OverlayFS extends RealFS {
+export class OverlayFS extends RealFS {
   constructor(private readonly overlay: Map<string, string>) {
     super();
   }
@@ -76,7 +87,7 @@ class OverlayFS extends RealFS {
   }
 }
 
-export function findTestFiles(targetPath: string): string[] {
+export function findTestFiles(targetPath: string, convention: DiscoveryConvention = TEST_CONVENTION): string[] {
   const absoluteTargetPath = path.resolve(targetPath);
   if (!fs.existsSync(absoluteTargetPath)) {
     throw new Error(`File not found: ${absoluteTargetPath}`);
@@ -85,17 +96,17 @@ export function findTestFiles(targetPath: string): string[] {
   const stat = fs.statSync(absoluteTargetPath);
   if (stat.isDirectory()) {
     const results: string[] = [];
-    collectTestFiles(absoluteTargetPath, results);
+    collectTestFiles(absoluteTargetPath, convention.fileSuffix, results);
     results.sort();
     return results;
   }
 
   if (!stat.isFile()) {
-    throw new Error(`Unsupported test target: ${absoluteTargetPath}`);
+    throw new Error(`Unsupported ${convention.label} target: ${absoluteTargetPath}`);
   }
 
   if (!absoluteTargetPath.endsWith(".do")) {
-    throw new Error(`Test target must be a .do file or a directory: ${absoluteTargetPath}`);
+    throw new Error(`${capitalize(convention.label)} target must be a .do file or a directory: ${absoluteTargetPath}`);
   }
 
   return [absoluteTargetPath];
@@ -105,6 +116,7 @@ export function discoverTests(
   rootDir: string,
   testFiles: readonly string[],
   fileSystem: FileSystem = new RealFS(),
+  convention: DiscoveryConvention = TEST_CONVENTION,
 ): DiscoveredTest[] {
   const discovered: DiscoveredTest[] = [];
   const pipelineFileSystem = withNodeBundledStdlib(fileSystem);
@@ -126,15 +138,15 @@ export function discoverTests(
     const diagnostics = collectSemanticDiagnostics(analysisResult);
     const errors = diagnostics.filter((diagnostic) => diagnostic.severity === "error");
     if (errors.length > 0) {
-      throw new Error(renderDiscoveryFailure(testFile, errors));
+      throw new Error(renderDiscoveryFailure(testFile, errors, convention));
     }
 
     const table = analysisResult.modules.get(testFile);
     if (!table) {
-      throw new Error(`Test discovery failed for ${testFile}: module table not found`);
+      throw new Error(`${capitalize(convention.label)} discovery failed for ${testFile}: module table not found`);
     }
 
-    discovered.push(...collectTestsFromTable(rootDir, table));
+    discovered.push(...collectTestsFromTable(rootDir, table, convention));
   }
 
   discovered.sort((left, right) => left.id.localeCompare(right.id));
@@ -342,7 +354,7 @@ function parseTestTimeoutMs(): number {
   return Number.isFinite(configured) && configured > 0 ? configured : 30000;
 }
 
-function collectTestFiles(dirPath: string, results: string[]): void {
+function collectTestFiles(dirPath: string, fileSuffix: string, results: string[]): void {
   const entries = fs.readdirSync(dirPath, { withFileTypes: true }).sort((left, right) => left.name.localeCompare(right.name));
   for (const entry of entries) {
     const entryPath = path.join(dirPath, entry.name);
@@ -350,25 +362,29 @@ function collectTestFiles(dirPath: string, results: string[]): void {
       if (fs.existsSync(path.join(entryPath, "doof.json"))) {
         continue;
       }
-      collectTestFiles(entryPath, results);
+      collectTestFiles(entryPath, fileSuffix, results);
       continue;
     }
 
-    if (entry.isFile() && entry.name.endsWith(TEST_FILE_SUFFIX)) {
+    if (entry.isFile() && entry.name.endsWith(fileSuffix)) {
       results.push(entryPath);
     }
   }
 }
 
-function collectTestsFromTable(rootDir: string, table: ModuleSymbolTable): DiscoveredTest[] {
+function collectTestsFromTable(
+  rootDir: string,
+  table: ModuleSymbolTable,
+  convention: DiscoveryConvention,
+): DiscoveredTest[] {
   const tests: DiscoveredTest[] = [];
 
   for (const [name, symbol] of table.exports) {
     if (symbol.symbolKind !== "function") continue;
     if (symbol.module !== table.path) continue;
-    if (!name.startsWith(TEST_PREFIX)) continue;
+    if (!name.startsWith(convention.functionPrefix)) continue;
 
-    const failure = validateTestFunction(symbol, table.path);
+    const failure = validateTestFunction(symbol, table.path, convention.label);
     if (failure) {
       throw new Error(failure);
     }
@@ -385,38 +401,46 @@ function collectTestsFromTable(rootDir: string, table: ModuleSymbolTable): Disco
   return tests;
 }
 
-function validateTestFunction(symbol: FunctionSymbol, modulePath: string): string | null {
+function validateTestFunction(symbol: FunctionSymbol, modulePath: string, label: string): string | null {
   const declaration = symbol.declaration;
   const location = `${modulePath}:${declaration.span.start.line}:${declaration.span.start.column}`;
   if (declaration.params.length > 0) {
-    return `${location}: error: test \"${symbol.name}\" must not declare parameters`;
+    return `${location}: error: ${label} \"${symbol.name}\" must not declare parameters`;
   }
   if (declaration.typeParams.length > 0) {
-    return `${location}: error: test \"${symbol.name}\" must not declare type parameters`;
+    return `${location}: error: ${label} \"${symbol.name}\" must not declare type parameters`;
   }
 
   const resolvedType = declaration.resolvedType;
   if (!resolvedType || resolvedType.kind !== "function") {
-    return `${location}: error: test \"${symbol.name}\" could not be resolved as a function`;
+    return `${location}: error: ${label} \"${symbol.name}\" could not be resolved as a function`;
   }
   if (resolvedType.returnType.kind !== "void") {
-    return `${location}: error: test \"${symbol.name}\" must return void`;
+    return `${location}: error: ${label} \"${symbol.name}\" must return void`;
   }
 
   return null;
 }
 
-function renderDiscoveryFailure(testFile: string, diagnostics: readonly Diagnostic[]): string {
+function renderDiscoveryFailure(
+  testFile: string,
+  diagnostics: readonly Diagnostic[],
+  convention: DiscoveryConvention,
+): string {
   const detail = diagnostics.map((diagnostic) => formatDiagnostic(diagnostic)).join("\n");
-  return `Test discovery failed for ${testFile}:\n${detail}`;
+  return `${capitalize(convention.label)} discovery failed for ${testFile}:\n${detail}`;
+}
+
+function capitalize(value: string): string {
+  return value.charAt(0).toUpperCase() + value.slice(1);
 }
 
-function determineRootDir(targetPath: string): string {
+export function determineRootDir(targetPath: string): string {
   const stat = fs.statSync(targetPath);
   return stat.isDirectory() ? targetPath : path.dirname(targetPath);
 }
 
-function determineExecutionRoot(modulePath: string, fileSystem: FileSystem): string {
+export function determineExecutionRoot(modulePath: string, fileSystem: FileSystem): string {
   const manifestPath = findDoofManifestPath(fileSystem, modulePath);
   return manifestPath ? path.dirname(manifestPath) : path.dirname(modulePath);
 }
@@ -431,21 +455,21 @@ function buildTestOutputDir(executionRoot: string, moduleDisplayPath: string): s
   return path.join(executionRoot, "build", ".doof-tests", safeModulePath);
 }
 
-function toImportSpecifier(fromPath: string, toPath: string): string {
+export function toImportSpecifier(fromPath: string, toPath: string): string {
   const relativePath = normalizePath(path.relative(path.dirname(fromPath), toPath));
   const prefixedPath = relativePath.startsWith(".") ? relativePath : `./${relativePath}`;
   return prefixedPath.replace(/\.do$/, "");
 }
 
-function normalizePath(value: string): string {
+export function normalizePath(value: string): string {
   return value.replace(/\\/g, "/");
 }
 
-function escapeDoofString(value: string): string {
+export function escapeDoofString(value: string): string {
   return value.replace(/\\/g, "\\\\").replace(/"/g, "\\\"");
 }
 
-function indentBlock(value: string): string {
+export function indentBlock(value: string): string {
   return value.split("\n").map((line) => `  ${line}`).join("\n");
 }
 